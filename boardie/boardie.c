@@ -215,6 +215,12 @@ void addRadioPrims() {}
 void delay(int msecs) {}
 void processFileMessage(int msgType, int dataSize, char *data) {}
 void resetRadio() {}
+void resetHID() {}
+void sendQueuedHIDReports() {}
+void flushDataLog() {}
+void checkDataLogFlush() {}
+void stopDataLog() {}
+void armWakeTimer(uint64 wakeTime) {}
 
 // Stubs for code file (persistence) not yet used by Boardie
 
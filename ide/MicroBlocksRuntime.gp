@@ -1936,6 +1936,10 @@ method errorString SmallRuntime errID {
 #define cannotUseWithBLE		50	// Cannot use this feature when board is connected to IDE via Bluetooth
 #define bad8BitBitmap			51	// Needs an 8-bit bitmap: a list containing the bitmap width and contents (a byte array)
 #define badColorPalette			52	// Needs a color palette: a list of positive 24-bit integers representing RGB values
+#define hidQueueFull			56	// Keyboard and mouse queue is full; wait until hidQueueCount is lower
+#define badPinEventPin			57	// Pin events need a pin number of 0 or more
+#define pinEventSlotsFull		58	// Pin events can be captured on at most 8 pins at once
+#define pinHasNoInterrupt		59	// That pin does not support interrupts
 '
 	for line (lines defsFromHeaderFile) {
 		words = (words line)
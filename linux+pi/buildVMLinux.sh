@@ -19,8 +19,9 @@ gcc -m32 -std=c99 -Wall -Wno-unused-variable -Wno-unused-result -O3 \
 	-I/usr/local/include/SDL2 \
 	-I ../vm \
 	linux.c ../vm/*.c \
-	linuxFilePrims.c linuxIOPrims.c linuxNetPrims.c \
-	linuxOutputPrims.c linuxSensorPrims.c linuxTftPrims.c \
+	inputTrace.c simulatedADC.c vmHost.c wavSink.c \
+	linuxCameraPrims.c linuxFilePrims.c linuxIOPrims.c linuxNetPrims.c \
+	linuxOutputPrims.c linuxRadioPrims.c linuxSensorPrims.c linuxTftPrims.c \
 	libs/libSDL2.a \
 	libs/libSDL2_ttf.a \
 	libs/libfreetype.a \
@@ -10,7 +10,8 @@ gcc -std=c99 -O3 -Wall -Wno-unused-variable -Wno-unused-result \
 	-I/usr/local/include/SDL2 \
 	-I ../vm \
 	linux.c ../vm/*.c \
-	linuxSensorPrims.c linuxFilePrims.c linuxIOPrims.c linuxNetPrims.c \
+	inputTrace.c simulatedADC.c vmHost.c wavSink.c \
+	linuxCameraPrims.c linuxRadioPrims.c linuxSensorPrims.c linuxFilePrims.c linuxIOPrims.c linuxNetPrims.c \
 	linuxOutputPrims.c linuxTftPrims.c \
 	-lSDL2 -lSDL2_ttf \
 	-l wiringPi \
@@ -0,0 +1,389 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// inputTrace.c - Record and replay of external inputs for the Linux VM
+// agent, October 2026
+
+/*
+Input Trace
+
+When recording, the primitives that read external inputs (pins, the IDE serial stream,
+files, and sockets) pass each value through this module, which logs it with a timestamp.
+When replaying, the module returns the recorded values instead, so a program sees exactly
+the same inputs on every run. Together with virtual time (see linux.c), replay makes runs
+repeatable, so interpreter and garbage collector changes can be compared on identical
+workloads. Both recording and replaying require virtual time: samples and streams are
+matched by time, so a trace recorded on the real clock would replay its inputs at
+different points in the program. Since reading the virtual clock advances it, each input
+function reads it exactly once, whether recording or replaying and whether or not
+anything is written.
+
+Inputs are replayed in one of three ways, chosen by their kind (see inputTrace.h):
+
+  sample: the value recorded most recently before the current time. Only changes are
+    recorded, so polling a pin in a loop does not grow the trace.
+  stream: bytes become available at the time they were recorded. Reads that returned
+    nothing are not recorded. A zero-length record marks a closed stream.
+  result: the nth call gets the nth recorded result.
+
+Samples and streams are matched by time, so they replay correctly even if the program
+polls them a different number of times than when the trace was recorded.
+
+Trace file format: the header "MBTR" and a version byte, followed by records:
+
+	tag byte: (discipline << 5) | kind
+	time: usecs since the previous record (varint)
+	sample: id (varint), value (zigzag varint)
+	stream or result: byte count (varint), bytes
+	integer result: value (zigzag varint)
+
+Varints are unsigned, seven bits per byte, low bits first, with the top bit set on all
+but the last byte.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "inputTrace.h"
+
+#define TRACE_VERSION 1
+
+enum {
+	disc_Sample = 0,
+	disc_Stream = 1,
+	disc_Result = 2,
+	disc_ResultInt = 3
+};
+
+// Keys identify an input source: a kind plus, for samples, a pin or other id.
+
+#define MAX_KEYS 256
+
+typedef struct {
+	uint8 kind;
+	int id;
+	int cursor;		// replay: index of the next record for this key (-1 if none)
+	int offset;		// replay: bytes of the current stream record already delivered
+	int value;		// last sample value
+} TraceKey;
+
+typedef struct {
+	uint8 kind;
+	uint8 discipline;
+	uint64 time;
+	int id;
+	int value;
+	int dataOffset;	// index of the data bytes in replayData
+	int length;
+	int next;		// index of the next record with the same key (-1 if none)
+} TraceRecord;
+
+static int mode = trace_Off;
+static TraceKey keys[MAX_KEYS];
+static int keyCount = 0;
+
+// recording
+static FILE *traceFile = NULL;
+static uint64 lastRecordTime = 0;
+
+// replaying
+static uint8 *replayData = NULL;
+static TraceRecord *records = NULL;
+static int recordCount = 0;
+static int missingResults = 0;
+
+int inputTrace_mode() { return mode; }
+
+static TraceKey * keyFor(int kind, int id, int create) {
+	for (int i = 0; i < keyCount; i++) {
+		if ((keys[i].kind == kind) && (keys[i].id == id)) return &keys[i];
+	}
+	if (!create || (keyCount >= MAX_KEYS)) return NULL;
+	TraceKey *key = &keys[keyCount++];
+	memset(key, 0, sizeof(TraceKey));
+	key->kind = kind;
+	key->id = id;
+	key->cursor = -1;
+	return key;
+}
+
+// Recording
+
+static void writeVarint(uint64 n) {
+	while (n >= 0x80) {
+		fputc((n & 0x7F) | 0x80, traceFile);
+		n >>= 7;
+	}
+	fputc(n, traceFile);
+}
+
+static void writeSigned(int n) {
+	writeVarint(((uint32) n << 1) ^ (uint32) (n >> 31)); // zigzag encoding
+}
+
+static void writeHeader(int kind, int discipline, uint64 now) {
+	fputc((discipline << 5) | kind, traceFile);
+	writeVarint(now - lastRecordTime);
+	lastRecordTime = now;
+}
+
+static void writeBytes(uint8 *buf, int count) {
+	writeVarint(count);
+	if (count > 0) fwrite(buf, 1, count, traceFile);
+}
+
+int inputTrace_record(const char *fileName) {
+	inputTrace_finish();
+	if (!useVirtualTime) return false;
+	traceFile = fopen(fileName, "wb");
+	if (!traceFile) return false;
+	fwrite("MBTR", 1, 4, traceFile);
+	fputc(TRACE_VERSION, traceFile);
+	lastRecordTime = 0;
+	keyCount = 0;
+	mode = trace_Recording;
+	return true;
+}
+
+// Replaying
+
+static int readVarint(uint8 *data, int size, int *offset, uint64 *result) {
+	uint64 n = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (*offset >= size) return false;
+		int byte = data[(*offset)++];
+		n |= (uint64) (byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			*result = n;
+			return true;
+		}
+	}
+	return false;
+}
+
+static int readSigned(uint8 *data, int size, int *offset, int *result) {
+	uint64 n;
+	if (!readVarint(data, size, offset, &n)) return false;
+	*result = (int) (((uint32) n >> 1) ^ -((uint32) n & 1));
+	return true;
+}
+
+static int parseRecords(int size) {
+	// Parse the records in replayData. Return the number of records. A truncated final
+	// record is ignored.
+
+	int offset = 5; // skip header
+	int count = 0;
+	uint64 time = 0;
+	while (offset < size) {
+		TraceRecord *r = &records[count];
+		uint64 delta, n;
+		int tag = replayData[offset++];
+		memset(r, 0, sizeof(TraceRecord));
+		r->kind = tag & 0x1F;
+		r->discipline = (tag >> 5) & 3;
+		if (!readVarint(replayData, size, &offset, &delta)) break;
+		time += delta;
+		r->time = time;
+		if (disc_Sample == r->discipline) {
+			if (!readVarint(replayData, size, &offset, &n)) break;
+			r->id = n;
+			if (!readSigned(replayData, size, &offset, &r->value)) break;
+		} else if (disc_ResultInt == r->discipline) {
+			if (!readSigned(replayData, size, &offset, &r->value)) break;
+		} else {
+			if (!readVarint(replayData, size, &offset, &n)) break;
+			if (n > (uint64) (size - offset)) break;
+			r->dataOffset = offset;
+			r->length = n;
+			offset += n;
+		}
+		count++;
+	}
+	return count;
+}
+
+static void linkRecords() {
+	// Link the records for each key into a chain and point each key's cursor to the first one.
+
+	int last[MAX_KEYS];
+	keyCount = 0;
+	for (int i = recordCount - 1; i >= 0; i--) {
+		TraceRecord *r = &records[i];
+		TraceKey *key = keyFor(r->kind, r->id, true);
+		if (!key) {
+			r->next = -1;
+			continue;
+		}
+		int k = key - keys;
+		r->next = (key->cursor < 0) ? -1 : last[k];
+		last[k] = i;
+		key->cursor = i;
+	}
+	for (int i = 0; i < keyCount; i++) {
+		// the first recorded value of a sample is used until the time it was recorded
+		keys[i].value = records[keys[i].cursor].value;
+	}
+}
+
+int inputTrace_replay(const char *fileName) {
+	inputTrace_finish();
+	if (!useVirtualTime) return false;
+	FILE *f = fopen(fileName, "rb");
+	if (!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	replayData = malloc(size + 1);
+	if (!replayData) {
+		fclose(f);
+		return false;
+	}
+	size = fread(replayData, 1, size, f);
+	fclose(f);
+	if ((size < 5) || (0 != memcmp(replayData, "MBTR", 4)) || (TRACE_VERSION != replayData[4])) {
+		free(replayData);
+		replayData = NULL;
+		return false;
+	}
+
+	// every record takes at least three bytes, so this is enough room
+	records = malloc(((size / 3) + 1) * sizeof(TraceRecord));
+	if (!records) {
+		free(replayData);
+		replayData = NULL;
+		return false;
+	}
+	recordCount = parseRecords(size);
+	linkRecords();
+	missingResults = 0;
+	mode = trace_Replaying;
+	return true;
+}
+
+void inputTrace_finish() {
+	if (traceFile) {
+		fclose(traceFile);
+		traceFile = NULL;
+	}
+	if ((trace_Replaying == mode) && missingResults) {
+		printf("Input trace replay: %d results were not in the trace\n", missingResults);
+	}
+	free(records);
+	records = NULL;
+	recordCount = 0;
+	free(replayData);
+	replayData = NULL;
+	keyCount = 0;
+	mode = trace_Off;
+}
+
+// Input functions
+
+int inputTrace_sample(int kind, int id, int value) {
+	// Record or replay a sampled value, such as a pin reading.
+
+	if (trace_Off == mode) return value;
+	uint64 now = totalMicrosecs();
+	if (trace_Recording == mode) {
+		TraceKey *key = keyFor(kind, id, false);
+		if (key && (key->value == value)) return value; // unchanged
+		if (!key) key = keyFor(kind, id, true);
+		if (key) key->value = value;
+		writeHeader(kind, disc_Sample, now);
+		writeVarint(id);
+		writeSigned(value);
+	} else if (trace_Replaying == mode) {
+		TraceKey *key = keyFor(kind, id, false);
+		if (!key) return value; // never recorded
+		while ((key->cursor >= 0) && (records[key->cursor].time <= now)) {
+			key->value = records[key->cursor].value;
+			key->cursor = records[key->cursor].next;
+		}
+		return key->value;
+	}
+	return value;
+}
+
+int inputTrace_stream(int kind, uint8 *buf, int count, int maxCount) {
+	// Record or replay the result of reading from a stream. When recording, count is the
+	// result of the read: the number of bytes in buf, zero if the stream was closed, or
+	// negative if no data was available. When replaying, up to maxCount recorded bytes that
+	// are due are copied into buf; if none are due, errno is set to EAGAIN and -1 returned.
+
+	if (trace_Off == mode) return count;
+	uint64 now = totalMicrosecs();
+	if (trace_Recording == mode) {
+		if (count >= 0) {
+			writeHeader(kind, disc_Stream, now);
+			writeBytes(buf, count);
+		}
+	} else if (trace_Replaying == mode) {
+		TraceKey *key = keyFor(kind, 0, false);
+		if (!key || (key->cursor < 0) || (records[key->cursor].time > now)) {
+			errno = EAGAIN;
+			return -1;
+		}
+		TraceRecord *r = &records[key->cursor];
+		int n = r->length - key->offset;
+		if (n > maxCount) n = maxCount;
+		if (n > 0) memcpy(buf, &replayData[r->dataOffset + key->offset], n);
+		key->offset += n;
+		if (key->offset >= r->length) {
+			key->cursor = r->next;
+			key->offset = 0;
+		}
+		return n;
+	}
+	return count;
+}
+
+int inputTrace_result(int kind, uint8 *buf, int count, int maxCount) {
+	// Record or replay a result of count bytes in buf, such as a line read from a file.
+
+	if (trace_Off == mode) return count;
+	uint64 now = totalMicrosecs();
+	if (trace_Recording == mode) {
+		writeHeader(kind, disc_Result, now);
+		writeBytes(buf, (count > 0) ? count : 0);
+	} else if (trace_Replaying == mode) {
+		TraceKey *key = keyFor(kind, 0, false);
+		if (!key || (key->cursor < 0)) {
+			missingResults++;
+			return count;
+		}
+		TraceRecord *r = &records[key->cursor];
+		key->cursor = r->next;
+		int n = (r->length < maxCount) ? r->length : maxCount;
+		memcpy(buf, &replayData[r->dataOffset], n);
+		return n;
+	}
+	return count;
+}
+
+int inputTrace_resultInt(int kind, int value) {
+	// Record or replay an integer result, such as a file size.
+
+	if (trace_Off == mode) return value;
+	uint64 now = totalMicrosecs();
+	if (trace_Recording == mode) {
+		writeHeader(kind, disc_ResultInt, now);
+		writeSigned(value);
+	} else if (trace_Replaying == mode) {
+		TraceKey *key = keyFor(kind, 0, false);
+		if (!key || (key->cursor < 0)) {
+			missingResults++;
+			return value;
+		}
+		value = records[key->cursor].value;
+		key->cursor = records[key->cursor].next;
+	}
+	return value;
+}
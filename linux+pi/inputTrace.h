@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// inputTrace.h - Record and replay of external inputs for the Linux VM
+// agent, October 2026
+
+// Trace modes
+
+enum {
+	trace_Off = 0,
+	trace_Recording = 1,
+	trace_Replaying = 2
+};
+
+// Input kinds (at most 31). The kind determines how the input is replayed:
+//	sample: the value recorded most recently before the current time (pins, connection state)
+//	stream: bytes that become available at the time they were recorded (serial, sockets)
+//	result: the nth call gets the nth recorded result (file reads and file status)
+
+enum {
+	trace_DigitalRead = 1,		// sample; id is the pin number
+	trace_AnalogRead = 2,		// sample; id is the pin number
+	trace_IDEInput = 3,			// stream
+	trace_FileRead = 4,			// result (bytes)
+	trace_FileStatus = 5,		// result (integer)
+	trace_FileList = 6,			// result (bytes)
+	trace_HttpServerClient = 7,	// sample; true if a client is connected
+	trace_HttpServerInput = 8,	// stream
+	trace_HttpClientConnected = 9, // sample
+	trace_HttpClientInput = 10	// stream
+};
+
+// Recording and replaying require virtual time; they return false without it.
+
+int inputTrace_mode();
+int inputTrace_record(const char *fileName);
+int inputTrace_replay(const char *fileName);
+void inputTrace_finish();
+
+int inputTrace_sample(int kind, int id, int value);
+int inputTrace_stream(int kind, uint8 *buf, int count, int maxCount);
+int inputTrace_result(int kind, uint8 *buf, int count, int maxCount);
+int inputTrace_resultInt(int kind, int value);
@@ -17,9 +17,11 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h> // still needed?
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/time.h> // still needed?
+#include <sys/timerfd.h>
 #include <termios.h>
 #include <unistd.h>
 #include <signal.h>
@@ -32,32 +34,121 @@
 #include "mem.h"
 #include "interp.h"
 #include "persist.h"
+#include "inputTrace.h"
+#include "simulatedADC.h"
+#include "wavSink.h"
+#include "vmHost.h"
 
 // Keyboard
 int KEY_SCANCODE[255];
 
 // Timing Functions
 
+// With the --virtual-time option, the VM uses a simulated clock that advances only as the
+// VM runs (see "Virtual Time" in interp.c). Each clock reading also takes one usec of
+// virtual time, so busy-wait loops end. Runs are repeatable and long waits take no real
+// time. The --stop-after=<secs> option exits after the given number of virtual seconds.
+
 static int startSecs = 0;
 
+int useVirtualTime = false;
+static uint64 virtualMicros = 0;
+static uint64 virtualStopTime = 0; // zero means don't stop
+
 static void initTimers() {
 	struct timeval now;
 	gettimeofday(&now, NULL);
 	startSecs = now.tv_sec;
 }
 
-uint32 microsecs() {
+static uint64 realMicrosecs() {
 	struct timeval now;
 	gettimeofday(&now, NULL);
 
-	return (1000000 * (now.tv_sec - startSecs)) + now.tv_usec;
+	uint64 secs = now.tv_sec - startSecs;
+	return (1000000 * secs) + now.tv_usec;
+}
+
+static void checkVirtualStopTime() {
+	if (virtualStopTime && (virtualMicros >= virtualStopTime)) {
+		printf("Stopped after %.3f virtual seconds (%.3f real seconds)\n",
+			virtualMicros / 1000000.0, realMicrosecs() / 1000000.0);
+		exit(0);
+	}
+}
+
+void advanceVirtualTime(uint64 usecs) {
+	virtualMicros += usecs;
+	checkVirtualStopTime();
+}
+
+void setVirtualTime(uint64 usecs) {
+	if (usecs > virtualMicros) virtualMicros = usecs; // the clock never goes backward
+	checkVirtualStopTime();
+}
+
+// Each VM instance of a VM host has its own virtual clock (see vmHost.c)
+
+uint64 virtualClock() { return virtualMicros; }
+
+void setVirtualClock(uint64 usecs) {
+	virtualMicros = usecs;
+	checkVirtualStopTime();
+}
+
+uint64 totalMicrosecs() {
+	// Returns a 64-bit integer containing microseconds since start.
+
+	if (useVirtualTime) return ++virtualMicros;
+	return realMicrosecs();
+}
+
+uint32 microsecs() {
+	return (uint32) totalMicrosecs();
 }
 
 uint32 millisecs() {
-	struct timeval now;
-	gettimeofday(&now, NULL);
+	return (uint32) (totalMicrosecs() / 1000);
+}
+
+void handleMicosecondClockWrap() { } // not needed; totalMicrosecs() does not wrap
+
+// Wake Timer
+
+// A timerfd set to the absolute wake time ends a nap exactly on time; unlike usleep(), it is
+// not delayed by the kernel's timer slack. While tasks are running, the VM loop checks the
+// clock instead (see vmLoop() in interp.c).
+
+static int wakeTimerFD = -1;
+
+void armWakeTimer(uint64 wakeTime) {
+	if (useVirtualTime) return;
+	if (wakeTimerFD < 0) {
+		wakeTimerFD = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK);
+		if (wakeTimerFD < 0) return;
+	}
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = startSecs + (wakeTime / 1000000);
+	spec.it_value.tv_nsec = 1000 * (wakeTime % 1000000);
+	timerfd_settime(wakeTimerFD, TFD_TIMER_ABSTIME, &spec, NULL);
+}
 
-	return (1000 * (now.tv_sec - startSecs)) + (now.tv_usec / 1000);
+void napUntilWake(int usecs) {
+	// Sleep for the given number of usecs or until the wake timer fires.
+
+	if (wakeTimerFD < 0) {
+		usleep(usecs);
+		return;
+	}
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(wakeTimerFD, &fds);
+	struct timeval timeout = { 0, usecs };
+	if (select(wakeTimerFD + 1, &fds, NULL, NULL, &timeout) > 0) {
+		uint64 expirations;
+		if (read(wakeTimerFD, &expirations, sizeof(expirations)) > 0) wakeDue = true;
+	}
 }
 
 #ifndef ARDUINO_RASPBERRY_PI
@@ -108,7 +199,9 @@ static void openPseudoTerminal() {
 }
 
 int recvBytes(uint8 *buf, int count) {
+	if (hostingVMs) return 0; // no IDE connection when hosting VM instances
 	int readCount = read(pty, buf, count);
+	readCount = inputTrace_stream(trace_IDEInput, buf, readCount, count);
 	if (readCount < 0) readCount = 0;
 	return readCount;
 }
@@ -123,6 +216,14 @@ int sendByte(char aByte) {
 	return write(pty, &aByte, 1);
 }
 
+int sendBytes(uint8 *buf, int start, int end) {
+	// Send bytes buf[start] through buf[end - 1] and return the number of bytes sent.
+
+	if (hostingVMs) return end - start; // discard output when hosting VM instances
+	int byteCount = write(pty, &buf[start], end - start);
+	return (byteCount < 0) ? 0 : byteCount;
+}
+
 // System Functions
 
 const char * boardType() {
@@ -169,14 +270,19 @@ static void initPins(void) {
 OBJ primAnalogPins(OBJ *args) { return int2obj(ANALOG_PINS); }
 OBJ primDigitalPins(OBJ *args) { return int2obj(DIGITAL_PINS); }
 
-OBJ primAnalogRead(int argCount, OBJ *args) { return int2obj(0); } // no analog inputs
+OBJ primAnalogRead(int argCount, OBJ *args) { // no analog inputs unless simulated
+	int pinNum = obj2int(args[0]);
+	int value = simulatedADC_active() ? simulatedADC_read(pinNum, totalMicrosecs()) : 0;
+	return int2obj(inputTrace_sample(trace_AnalogRead, pinNum, value));
+}
 void primAnalogWrite(OBJ *args) { } // analog output is not supported
 
 OBJ primDigitalRead(int argCount, OBJ *args) {
 	int pinNum = obj2int(args[0]);
 	if ((pinNum < 0) || (pinNum >= TOTAL_PINS)) return falseObj;
 	SET_MODE(pinNum, INPUT);
-	return (HIGH == digitalRead(pinNum)) ? trueObj : falseObj;
+	int value = (HIGH == digitalRead(pinNum));
+	return inputTrace_sample(trace_DigitalRead, pinNum, value) ? trueObj : falseObj;
 }
 
 void primDigitalWrite(OBJ *args) {
@@ -191,29 +297,97 @@ void primDigitalSet(int pinNum, int flag) {
 	digitalWrite(pinNum, flag);
 };
 
+void pinWriteAt(int pinNum, int value, uint64 usecs) {
+	primDigitalSet(pinNum, (value >= 512));
+}
+
 #else // Regular Linux system (not a Raspberry Pi)
 
-// Stubs for IO primitives
+// Simulated IO pins. When hosting VM instances, pins can be wired to the pins of other
+// instances (see vmHost.c). Otherwise, the VM has mock pins that read back the last value
+// written to them (or the value from an input trace, if replaying one). Digital writes
+// store 0 or 1023, so digital and analog reads of the same pin agree.
 
-OBJ primAnalogPins(OBJ *args) { return int2obj(0); }
-OBJ primDigitalPins(OBJ *args) { return int2obj(0); }
-OBJ primAnalogRead(int argCount, OBJ *args) { return int2obj(0); }
-void primAnalogWrite(OBJ *args) { }
-OBJ primDigitalRead(int argCount, OBJ *args) { return int2obj(0); }
-void primDigitalWrite(OBJ *args) { }
-void primDigitalSet(int pinNum, int flag) { };
+// With the --pin-log=<file> option, each change of a mock output pin is written to a file
+// as a line "<usecs> <pin> <value>", so tests can check the exact sequence of transitions.
+
+// With the --adc=<file> option, analog reads return values from a WAV or CSV file instead
+// (see simulatedADC.c).
+
+#define MOCK_PINS 32
+
+static int mockPinValue[MOCK_PINS];
+static FILE *pinLogFile = NULL;
+
+static int pinRead(int pinNum) {
+	if (hostingVMs) return vmHost_pinRead(pinNum);
+	if ((pinNum < 0) || (pinNum >= MOCK_PINS)) return 0;
+	return mockPinValue[pinNum];
+}
+
+void pinWriteAt(int pinNum, int value, uint64 usecs) {
+	// Set a pin. If it changes, usecs is recorded as the time of the change in the pin log.
+	// Pulse trains pass the scheduled time of each step, so the log shows exact timing.
+
+	if (hostingVMs) {
+		vmHost_pinWrite(pinNum, value);
+		return;
+	}
+	if ((pinNum < 0) || (pinNum >= MOCK_PINS) || (value == mockPinValue[pinNum])) return;
+	int wasHigh = (mockPinValue[pinNum] >= 512);
+	mockPinValue[pinNum] = value;
+	if (pinLogFile) fprintf(pinLogFile, "%llu %d %d\n", (unsigned long long) usecs, pinNum, value);
+	if ((value >= 512) != wasHigh) simulatePinEdge(pinNum, (value >= 512), usecs);
+}
+
+static void pinWrite(int pinNum, int value) {
+	pinWriteAt(pinNum, value, pinLogFile ? totalMicrosecs() : 0);
+}
+
+static void closePinLog() {
+	if (pinLogFile) fclose(pinLogFile);
+	pinLogFile = NULL;
+}
+
+OBJ primAnalogPins(OBJ *args) { return int2obj(hostingVMs ? HOST_PINS : MOCK_PINS); }
+OBJ primDigitalPins(OBJ *args) { return int2obj(hostingVMs ? HOST_PINS : MOCK_PINS); }
+
+OBJ primAnalogRead(int argCount, OBJ *args) {
+	int pinNum = obj2int(args[0]);
+	int value = simulatedADC_active() ? simulatedADC_read(pinNum, totalMicrosecs()) : pinRead(pinNum);
+	return int2obj(inputTrace_sample(trace_AnalogRead, pinNum, value));
+}
+
+void primAnalogWrite(OBJ *args) {
+	pinWrite(obj2int(args[0]), obj2int(args[1]));
+}
+
+OBJ primDigitalRead(int argCount, OBJ *args) {
+	int pinNum = obj2int(args[0]);
+	int value = (pinRead(pinNum) >= 512);
+	return inputTrace_sample(trace_DigitalRead, pinNum, value) ? trueObj : falseObj;
+}
+
+void primDigitalWrite(OBJ *args) {
+	primDigitalSet(obj2int(args[0]), (trueObj == args[1]));
+}
+
+void primDigitalSet(int pinNum, int flag) {
+	pinWrite(pinNum, flag ? 1023 : 0);
+};
 #endif
 
 // Stubs for other functions not used on Linux
 
 void addSerialPrims() {}
 void addHIDPrims() {}
+void resetHID() {}
+void sendQueuedHIDReports() {}
 void addOneWirePrims() {}
 void processFileMessage(int msgType, int dataSize, char *data) {}
 void resetServos() {}
 void stopPWM() {}
 void systemReset() {}
-void turnOffPins() {}
 void stopServos() {}
 
 // Persistence support
@@ -221,7 +395,7 @@ void stopServos() {}
 char *codeFileName = "ublockscode";
 FILE *codeFile;
 
-void initCodeFile(uint8 *flash, int flashByteCount) {
+int initCodeFile(uint8 *flash, int flashByteCount) {
 	codeFile = fopen(codeFileName, "ab+");
 	fseek(codeFile, 0 , SEEK_END);
 	long fileSize = ftell(codeFile);
@@ -232,19 +406,25 @@ void initCodeFile(uint8 *flash, int flashByteCount) {
 	if (bytesRead != fileSize) {
 		outputString("initCodeFile did not read entire file");
 	}
+	return bytesRead;
 }
 
+// When hosting VM instances, code files are shared and only read (see vmHost.c).
+
 void writeCodeFile(uint8 *code, int byteCount) {
+	if (hostingVMs) return;
 	fwrite(code, 1, byteCount, codeFile);
 	fflush(codeFile);
 }
 
 void writeCodeFileWord(int word) {
+	if (hostingVMs) return;
 	fwrite(&word, 1, 4, codeFile);
 	fflush(codeFile);
 }
 
 void clearCodeFile(int ignore) {
+	if (hostingVMs) return;
 	fclose(codeFile);
 	remove(codeFileName);
 	codeFile = fopen(codeFileName, "ab+");
@@ -263,14 +443,88 @@ void segfault() {
 
 int main(int argc, char *argv[]) {
 	codeFileName = "ublockscode"; // to do: allow code file name from command line
-
-	if (argc > 1) {
-		codeFileName = argv[1];
-		printf("codeFileName: %s\n", codeFileName);
+	char *traceFileName = NULL;
+	int traceMode = trace_Off;
+	char *hostFileName = NULL;
+	char *pinLogFileName = NULL;
+	char *adcFileName = NULL;
+	char *audioFileName = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (0 == strcmp(argv[i], "--virtual-time")) {
+			useVirtualTime = true;
+		} else if (0 == strncmp(argv[i], "--stop-after=", 13)) {
+			useVirtualTime = true;
+			virtualStopTime = (uint64) (1000000.0 * atof(&argv[i][13]));
+		} else if (0 == strncmp(argv[i], "--record=", 9)) {
+			traceFileName = &argv[i][9];
+			traceMode = trace_Recording;
+			useVirtualTime = true; // so inputs replay at the same points in the program
+		} else if (0 == strncmp(argv[i], "--replay=", 9)) {
+			traceFileName = &argv[i][9];
+			traceMode = trace_Replaying;
+			useVirtualTime = true; // replay is only repeatable with virtual time
+		} else if (0 == strncmp(argv[i], "--host=", 7)) {
+			hostFileName = &argv[i][7];
+		} else if (0 == strncmp(argv[i], "--pin-log=", 10)) {
+			pinLogFileName = &argv[i][10];
+		} else if (0 == strncmp(argv[i], "--adc=", 6)) {
+			adcFileName = &argv[i][6];
+		} else if (0 == strncmp(argv[i], "--audio-out=", 12)) {
+			audioFileName = &argv[i][12];
+		} else {
+			codeFileName = argv[i];
+			printf("codeFileName: %s\n", codeFileName);
+		}
 	}
+	if (useVirtualTime) printf("Using virtual time\n");
 	signal(SIGSEGV, segfault);
 	signal(SIGINT, exit);
 	atexit(exitGracefully);
+	if (traceMode) {
+		int ok = (trace_Recording == traceMode) ?
+			inputTrace_record(traceFileName) : inputTrace_replay(traceFileName);
+		if (!ok) {
+			printf("Could not open input trace file: %s\n", traceFileName);
+			exit(-1);
+		}
+		printf("%s inputs: %s\n", (trace_Recording == traceMode) ? "Recording" : "Replaying", traceFileName);
+		atexit(inputTrace_finish); // registered last so it runs first
+	}
+	if (pinLogFileName) {
+#ifdef ARDUINO_RASPBERRY_PI
+		printf("Pin logging is only supported with mock pins\n");
+#else
+		pinLogFile = fopen(pinLogFileName, "w");
+		if (!pinLogFile) {
+			printf("Could not open pin log file: %s\n", pinLogFileName);
+			exit(-1);
+		}
+		atexit(closePinLog);
+#endif
+	}
+	if (adcFileName) {
+		if (!simulatedADC_load(adcFileName)) {
+			printf("Could not read analog input file: %s\n", adcFileName);
+			exit(-1);
+		}
+		printf("Analog inputs: %s\n", adcFileName);
+	}
+	if (audioFileName) {
+		if (!wavSink_open(audioFileName)) {
+			printf("Could not open audio output file: %s\n", audioFileName);
+			exit(-1);
+		}
+		atexit(wavSink_close);
+	}
+	if (hostFileName) {
+		// run many VM instances; there is no IDE connection
+		initTimers();
+		primsInit();
+		if (!vmHost_start(hostFileName)) exit(-1);
+		vmLoop();
+		return 0;
+	}
 	openPseudoTerminal();
 	printf(
 		"Starting Linux MicroBlocks... Connect on %s\n",
@@ -0,0 +1,390 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// linuxCameraPrims.c - Stand-in camera for the Linux VM.
+// agent, October 2026
+
+/*
+The stand-in camera replays frames from the files in a directory so that camera programs
+can be tested and benchmarked without camera hardware. The directory is "camera" in the
+current directory unless the MB_CAMERA_DIR environment variable names another one.
+
+Frames are replayed in file name order, starting over after the last file. Files ending
+in ".jpg" or ".jpeg" are JPEG frames; their width and height are read from the JPEG header.
+Other files are raw frames with the width and height set by the setSize primitive and the
+encoding set by setEncoding.
+
+Frame handles and continuous capture behave as they do on the ESP32: each held frame
+occupies one of frameBufferCount simulated driver buffers. In continuous capture mode, the
+camera produces frames at FRAMES_PER_SECOND; if the queue keeps only the latest frames, the
+frames produced while the program was busy are skipped.
+*/
+
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+
+#define MAX_FRAMES 4
+#define FRAMES_PER_SECOND 25
+
+typedef struct {
+	uint8 *data;
+	int byteCount;
+	int width;
+	int height;
+	const char *encoding;
+	int handle;
+	uint32 timestamp; // msecs when the frame was grabbed
+} FrameEntry;
+
+static FrameEntry frames[MAX_FRAMES];
+static int frameSerial = 0;
+
+static struct dirent **frameFiles = NULL;
+static int frameFileCount = -1; // -1 means the directory has not been scanned
+static int nextFrameFile = 0;
+
+static int rawWidth = 640;
+static int rawHeight = 480;
+static const char *rawEncoding = "jpeg";
+static int frameBufferCount = 1;
+static int keepLatest = false;
+static uint32 captureStartTime = 0;
+static uint32 framesProduced = 0;
+
+// Frame files
+
+static const char *frameDirectory() {
+	char *dir = getenv("MB_CAMERA_DIR");
+	return (dir && dir[0]) ? dir : "camera";
+}
+
+static int isFrameFile(const struct dirent *entry) {
+	return '.' != entry->d_name[0];
+}
+
+static void scanFrameFiles() {
+	if (frameFileCount >= 0) return;
+	frameFileCount = scandir(frameDirectory(), &frameFiles, isFrameFile, alphasort);
+	if (frameFileCount < 0) frameFileCount = 0; // directory not found
+	nextFrameFile = 0;
+}
+
+static int isJPEGFile(const char *fileName) {
+	const char *ext = strrchr(fileName, '.');
+	return ext && ((0 == strcasecmp(ext, ".jpg")) || (0 == strcasecmp(ext, ".jpeg")));
+}
+
+static void readJPEGSize(FrameEntry *entry) {
+	// Set the frame width and height from the start-of-frame marker of a JPEG image.
+
+	uint8 *p = entry->data;
+	uint8 *end = entry->data + entry->byteCount;
+	entry->width = entry->height = 0;
+	if ((entry->byteCount < 4) || (0xFF != p[0]) || (0xD8 != p[1])) return; // not a JPEG
+	p += 2;
+	while ((p + 9) < end) {
+		if (0xFF != p[0]) return; // corrupt
+		int marker = p[1];
+		int segmentSize = (p[2] << 8) | p[3];
+		if ((0xC0 <= marker) && (marker <= 0xCF) && (0xC4 != marker) && (0xC8 != marker) && (0xCC != marker)) {
+			entry->height = (p[5] << 8) | p[6];
+			entry->width = (p[7] << 8) | p[8];
+			return;
+		}
+		p += 2 + segmentSize;
+	}
+}
+
+static int loadFrame(FrameEntry *entry, int fileIndex) {
+	// Read the given frame file into a newly allocated buffer. Return true if successful.
+
+	char path[1024];
+	const char *fileName = frameFiles[fileIndex]->d_name;
+	snprintf(path, sizeof(path), "%s/%s", frameDirectory(), fileName);
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	uint8 *data = malloc((size > 0) ? size : 1);
+	if (!data || (fread(data, 1, size, f) != size)) {
+		free(data);
+		fclose(f);
+		return false;
+	}
+	fclose(f);
+
+	entry->data = data;
+	entry->byteCount = size;
+	if (isJPEGFile(fileName)) {
+		entry->encoding = "jpeg";
+		readJPEGSize(entry);
+	} else {
+		entry->encoding = rawEncoding;
+		entry->width = rawWidth;
+		entry->height = rawHeight;
+	}
+	return true;
+}
+
+static int nextFileIndex() {
+	// Return the index of the next frame file to replay. In continuous capture mode with
+	// keepLatest, skip the frames that the camera produced since the last grab.
+
+	if (frameBufferCount > 1) {
+		uint32 produced = ((millisecs() - captureStartTime) * FRAMES_PER_SECOND) / 1000;
+		if (keepLatest && (produced > (framesProduced + 1))) {
+			nextFrameFile += produced - (framesProduced + 1); // frames dropped by the driver
+		}
+		framesProduced = produced;
+	}
+	int result = nextFrameFile % frameFileCount;
+	nextFrameFile = result + 1;
+	return result;
+}
+
+// Frame handles
+
+static int heldFrameCount() {
+	int count = 0;
+	for (int i = 0; i < MAX_FRAMES; i++) {
+		if (frames[i].data) count++;
+	}
+	return count;
+}
+
+static void releaseFrame(FrameEntry *entry) {
+	free(entry->data);
+	entry->data = NULL;
+	entry->handle = 0;
+}
+
+static void releaseAllFrames() {
+	for (int i = 0; i < MAX_FRAMES; i++) {
+		if (frames[i].data) releaseFrame(&frames[i]);
+	}
+}
+
+static FrameEntry *frameFor(OBJ handleObj) {
+	// Return the entry for the given frame handle. Fail if the handle is not valid.
+
+	if (isInt(handleObj) && (obj2int(handleObj) > 0)) {
+		int handle = obj2int(handleObj);
+		FrameEntry *entry = &frames[handle % MAX_FRAMES];
+		if (entry->data && (entry->handle == handle)) return entry;
+	}
+	fail(badFrameHandle);
+	return NULL;
+}
+
+// Camera primitives
+
+static OBJ primHasCamera(int argCount, OBJ *args) {
+	scanFrameFiles();
+	return (frameFileCount > 0) ? trueObj : falseObj;
+}
+
+static OBJ primTakePhoto(int argCount, OBJ *args) {
+	scanFrameFiles();
+	if (!frameFileCount) {
+		outputString("Photo capture failed");
+		return falseObj;
+	}
+	FrameEntry frame;
+	if (!loadFrame(&frame, nextFileIndex())) return falseObj;
+
+	OBJ result = newObj(ByteArrayType, (frame.byteCount + 3) / 4, falseObj);
+	if (result) {
+		memcpy((uint8 *) &FIELD(result, 0), frame.data, frame.byteCount);
+		setByteCountAdjust(result, frame.byteCount);
+	}
+	free(frame.data);
+	return result ? result : fail(insufficientMemoryError);
+}
+
+static OBJ primSetSize(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	int w, h;
+	if (2 == sscanf(obj2str(args[0]), "%dx%d", &w, &h)) {
+		rawWidth = w;
+		rawHeight = h;
+	}
+	releaseAllFrames();
+	return falseObj;
+}
+
+static OBJ primSetEncoding(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	char *encoding = obj2str(args[0]);
+	rawEncoding = "jpeg"; // default
+	if (strcmp(encoding, "rgb565") == 0) rawEncoding = "rgb565";
+	if (strcmp(encoding, "grayscale") == 0) rawEncoding = "grayscale";
+	releaseAllFrames();
+	return falseObj;
+}
+
+// Frame primitives
+
+static OBJ primGrabFrame(int argCount, OBJ *args) {
+	scanFrameFiles();
+	if (!frameFileCount) return falseObj;
+	if (heldFrameCount() >= frameBufferCount) return falseObj; // all frame buffers are held
+
+	int i;
+	for (i = 0; i < MAX_FRAMES; i++) {
+		if (!frames[i].data) break;
+	}
+	if (i >= MAX_FRAMES) return falseObj; // no free entry
+	if (!loadFrame(&frames[i], nextFileIndex())) return falseObj;
+
+	frameSerial = (frameSerial % 1000000) + 1;
+	frames[i].handle = (frameSerial * MAX_FRAMES) + i;
+	frames[i].timestamp = millisecs();
+	return int2obj(frames[i].handle);
+}
+
+static OBJ primReleaseFrame(int argCount, OBJ *args) {
+	if (argCount < 1) {
+		releaseAllFrames();
+		return falseObj;
+	}
+	FrameEntry *entry = frameFor(args[0]);
+	if (entry) releaseFrame(entry);
+	return falseObj;
+}
+
+static OBJ primFrameInfo(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+
+	OBJ result = newObj(ListType, 6, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	tempGCRoot = result;
+	OBJ encoding = newString(strlen(entry->encoding));
+	tempGCRoot = NULL;
+	if (!encoding) return fail(insufficientMemoryError);
+	strcpy(obj2str(encoding), entry->encoding);
+
+	FIELD(result, 0) = int2obj(5);
+	FIELD(result, 1) = int2obj(entry->byteCount);
+	FIELD(result, 2) = int2obj(entry->width);
+	FIELD(result, 3) = int2obj(entry->height);
+	FIELD(result, 4) = encoding;
+	FIELD(result, 5) = int2obj(entry->timestamp & 0x3FFFFFFF);
+	return result;
+}
+
+static OBJ primFrameBytes(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+
+	int startIndex = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 1;
+	if ((startIndex < 1) || (startIndex > (entry->byteCount + 1))) return fail(indexOutOfRangeError);
+	int count = entry->byteCount - (startIndex - 1);
+	if ((argCount > 2) && isInt(args[2]) && (obj2int(args[2]) < count)) count = obj2int(args[2]);
+	if (count < 0) count = 0;
+
+	OBJ result = newObj(ByteArrayType, (count + 3) / 4, falseObj);
+	if (!result) return fail(insufficientMemoryError);
+	memcpy((uint8 *) &FIELD(result, 0), entry->data + (startIndex - 1), count);
+	setByteCountAdjust(result, count);
+	return result;
+}
+
+static OBJ primReadFrameInto(int argCount, OBJ *args) {
+	if (argCount < 3) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	if (!IS_TYPE(args[2], ByteArrayType)) return fail(needsByteArray);
+
+	int startIndex = obj2int(args[1]);
+	if ((startIndex < 1) || (startIndex > (entry->byteCount + 1))) return fail(indexOutOfRangeError);
+	int count = entry->byteCount - (startIndex - 1);
+	if (count > BYTES(args[2])) count = BYTES(args[2]);
+	memcpy((uint8 *) &FIELD(args[2], 0), entry->data + (startIndex - 1), count);
+	return int2obj(count);
+}
+
+static OBJ primFrameToFile(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+
+	char *fileName = obj2str(args[1]);
+	if (!fileName[0] || (0 == strcmp(fileName, "ublockscode"))) return falseObj;
+	FILE *f = fopen(fileName, "ab");
+	if (!f) return falseObj;
+	int byteCount = fwrite(entry->data, 1, entry->byteCount, f);
+	fclose(f);
+	return int2obj(byteCount);
+}
+
+static OBJ primFrameToHttpClient(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	int keepAlive = ((argCount > 1) && (trueObj == args[1]));
+
+	const char *contentType = (0 == strcmp(entry->encoding, "jpeg")) ? "image/jpeg" : "application/octet-stream";
+	int sent = httpRespondWithData(contentType, entry->data, entry->byteCount, keepAlive);
+	return (sent < 0) ? falseObj : int2obj(sent);
+}
+
+static OBJ primStartCapture(int argCount, OBJ *args) {
+	int count = ((argCount > 0) && isInt(args[0])) ? obj2int(args[0]) : 2;
+	if (count < 2) count = 2;
+	if (count > MAX_FRAMES) count = MAX_FRAMES;
+	releaseAllFrames();
+	frameBufferCount = count;
+	keepLatest = ((argCount > 1) && (trueObj == args[1]));
+	captureStartTime = millisecs();
+	framesProduced = 0;
+	return falseObj;
+}
+
+static OBJ primStopCapture(int argCount, OBJ *args) {
+	releaseAllFrames();
+	frameBufferCount = 1;
+	keepLatest = false;
+	return falseObj;
+}
+
+// Primitives
+
+static PrimEntry entries[] = {
+	{"hasCamera", primHasCamera},
+	{"takePhoto", primTakePhoto},
+	{"setSize", primSetSize},
+	{"setEncoding", primSetEncoding},
+	{"grabFrame", primGrabFrame},
+	{"releaseFrame", primReleaseFrame},
+	{"frameInfo", primFrameInfo},
+	{"frameBytes", primFrameBytes},
+	{"readFrameInto", primReadFrameInto},
+	{"frameToFile", primFrameToFile},
+	{"frameToHttpClient", primFrameToHttpClient},
+	{"startCapture", primStartCapture},
+	{"stopCapture", primStopCapture},
+};
+
+void addCameraPrims() {
+	addPrimitiveSet(CameraPrims, "camera", sizeof(entries) / sizeof(PrimEntry), entries);
+}
@@ -20,6 +20,8 @@
 
 #include "mem.h"
 #include "interp.h"
+#include "inputTrace.h"
+#include "dataLog.h"
 
 typedef struct {
 	char fileName[100];
@@ -140,9 +142,8 @@ static OBJ primEndOfFile(int argCount, OBJ *args) {
 	extractFilename(args[0], fileName);
 
 	int i = entryFor(fileName);
-	if (i < 0) return trueObj;
-
-	return feof(fileEntry[i].file) ? trueObj : falseObj;
+	int atEnd = (i < 0) || feof(fileEntry[i].file);
+	return inputTrace_resultInt(trace_FileStatus, atEnd) ? trueObj : falseObj;
 }
 
 static OBJ primReadLine(int argCount, OBJ *args) {
@@ -151,13 +152,12 @@ static OBJ primReadLine(int argCount, OBJ *args) {
 	extractFilename(args[0], fileName);
 
 	int i = entryFor(fileName);
-	if (i < 0) return newString(0);
-
 	char buf[800];
-	uint32 byteCount = 0;
+	int byteCount = 0;
 
-	if (fgets(buf, 800, fileEntry[i].file) != NULL) {
-		byteCount = strlen(buf);
+	if ((i >= 0) && (fgets(buf, 800, fileEntry[i].file) != NULL)) byteCount = strlen(buf);
+	byteCount = inputTrace_result(trace_FileRead, (uint8 *) buf, byteCount, sizeof(buf));
+	if (byteCount > 0) {
 		OBJ result = newString(byteCount);
 		if (result) {
 			memcpy(obj2str(result), buf, byteCount);
@@ -175,20 +175,23 @@ static OBJ primReadBytes(int argCount, OBJ *args) {
 	extractFilename(args[1], fileName);
 
 	int i = entryFor(fileName);
+	uint8 buf[800];
+	if (byteCount > sizeof(buf)) byteCount = sizeof(buf);
 	if (i >= 0) {
-		uint8 buf[800];
-		if (byteCount > sizeof(buf)) byteCount = sizeof(buf);
 		if ((argCount > 2) && isInt(args[2])) {
 			fseek(fileEntry[i].file, obj2int(args[2]), SEEK_SET);
 		}
 		byteCount = fread(buf, 1, byteCount, fileEntry[i].file);
-		int wordCount = (byteCount + 3) / 4;
-		OBJ result = newObj(ByteArrayType, wordCount, falseObj);
-		if (result) {
-			setByteCountAdjust(result, byteCount);
-			memcpy(&FIELD(result, 0), buf, byteCount);
-			return result;
-		}
+	} else {
+		byteCount = 0;
+	}
+	byteCount = inputTrace_result(trace_FileRead, buf, byteCount, sizeof(buf));
+	int wordCount = (byteCount + 3) / 4;
+	OBJ result = newObj(ByteArrayType, wordCount, falseObj);
+	if (result) {
+		setByteCountAdjust(result, byteCount);
+		memcpy(&FIELD(result, 0), buf, byteCount);
+		return result;
 	}
 	return newObj(ByteArrayType, 0 ,falseObj);
 }
@@ -198,6 +201,7 @@ static OBJ primAppendLine(int argCount, OBJ *args) {
 	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
 	char fileName[100];
 	extractFilename(args[1], fileName);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	OBJ arg = args[0];
 
 	int i = entryFor(fileName);
@@ -256,8 +260,8 @@ static OBJ primFileSize(int argCount, OBJ *args) {
 	extractFilename(args[0], fileName);
 	if (!fileName[0]) return int2obj(0);
 	struct stat st;
-	stat(fileName, &st);
-	return int2obj(st.st_size);
+	if (0 != stat(fileName, &st)) st.st_size = 0;
+	return int2obj(inputTrace_resultInt(trace_FileStatus, st.st_size));
 }
 
 static OBJ primStartFileList(int argCount, OBJ *args) {
@@ -286,6 +290,7 @@ static OBJ primNextFileInList(int argCount, OBJ *args) {
 		closedir(directory);
 		directory = NULL;
 	}
+	length = inputTrace_result(trace_FileList, (uint8 *) fileName, length, 99);
 	return newStringFromBytes(fileName, length);
 }
 
@@ -298,6 +303,168 @@ static OBJ primSystemInfo(int argCount, OBJ *args) {
 	return newStringFromBytes(result, strlen(result));
 }
 
+// Data logging (see dataLog.c)
+
+#define DATA_LOG_BLOCK_BYTES 4096
+
+static DataLog dataLog;
+static FILE *logFile = NULL;
+static uint32 maxLogWriteUsecs = 0;
+
+static int logReadHeader(char *fileName, uint8 *buf, int byteCount) {
+	FILE *file = fopen(fileName, "rb");
+	if (!file) return 0;
+	int result = fread(buf, 1, byteCount, file);
+	fclose(file);
+	return result;
+}
+
+static int logCreate(char *fileName) {
+	logFile = fopen(fileName, "wb");
+	return (logFile != NULL);
+}
+
+static int logAppend(uint8 *data, int byteCount) {
+	uint32 startUsecs = microsecs();
+	int result = fwrite(data, 1, byteCount, logFile);
+	fflush(logFile);
+	uint32 usecs = microsecs() - startUsecs;
+	if (usecs > maxLogWriteUsecs) maxLogWriteUsecs = usecs;
+	return result;
+}
+
+static void logClose() {
+	fclose(logFile);
+	logFile = NULL;
+}
+
+static DataLogDriver logDriver = { logReadHeader, logCreate, logAppend, logClose };
+
+void flushDataLog() {
+	dataLog_flush(&dataLog, &logDriver);
+}
+
+void checkDataLogFlush() {
+	dataLog_flushIfDue(&dataLog, millisecs(), &logDriver);
+}
+
+void stopDataLog() {
+	dataLog_stop(&dataLog, &logDriver);
+}
+
+static OBJ primStartLog(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	char *baseName = obj2str(args[0]);
+	int valueCount = obj2int(args[1]);
+	int fileCount = ((argCount > 2) && isInt(args[2])) ? obj2int(args[2]) : 4;
+	int fileKBytes = ((argCount > 3) && isInt(args[3])) ? obj2int(args[3]) : 64;
+	int valueBytes = ((argCount > 4) && isInt(args[4])) ? obj2int(args[4]) : 4;
+	if ((fileKBytes < 1) || (fileKBytes > 0x1FFFFF)) return fail(indexOutOfRangeError);
+
+	maxLogWriteUsecs = 0;
+	int ok = dataLog_start(&dataLog, baseName, valueCount, valueBytes,
+		fileCount, fileKBytes * 1024, DATA_LOG_BLOCK_BYTES, &logDriver);
+	return ok ? trueObj : falseObj;
+}
+
+static OBJ primLogRecord(int argCount, OBJ *args) {
+	int values[DATA_LOG_MAX_VALUES];
+	int count = 0;
+	OBJ *items = args;
+	if ((1 == argCount) && !ensureListCopy(args, 0)) return falseObj;
+	if ((1 == argCount) && IS_TYPE(args[0], ListType)) {
+		argCount = obj2int(FIELD(args[0], 0));
+		items = &FIELD(args[0], 1);
+	}
+	for (int i = 0; (i < argCount) && (count < DATA_LOG_MAX_VALUES); i++) {
+		OBJ item = items[i];
+		if (isInt(item)) {
+			values[count++] = obj2int(item);
+		} else if (isBoolean(item)) {
+			values[count++] = (trueObj == item);
+		} else {
+			return fail(needsIntegerError);
+		}
+	}
+	dataLog_add(&dataLog, millisecs(), values, count, &logDriver);
+	return falseObj;
+}
+
+static OBJ primFlushLog(int argCount, OBJ *args) {
+	flushDataLog();
+	return falseObj;
+}
+
+static OBJ primStopLog(int argCount, OBJ *args) {
+	stopDataLog();
+	return falseObj;
+}
+
+static OBJ primLogFiles(int argCount, OBJ *args) {
+	int indices[DATA_LOG_MAX_FILES];
+	int count = dataLog_filesInOrder(&dataLog, indices);
+	tempGCRoot = newObj(ListType, count + 1, zeroObj);
+	if (!tempGCRoot) return fail(insufficientMemoryError);
+	FIELD(tempGCRoot, 0) = int2obj(count);
+	for (int i = 0; i < count; i++) {
+		char fileName[32];
+		dataLog_fileName(&dataLog, indices[i], fileName, sizeof(fileName));
+		OBJ s = newStringFromBytes(fileName, strlen(fileName));
+		if (!s) break;
+		FIELD(tempGCRoot, i + 1) = s;
+	}
+	OBJ result = tempGCRoot;
+	tempGCRoot = NULL;
+	return result;
+}
+
+static OBJ primLogStats(int argCount, OBJ *args) {
+	OBJ result = newObj(ListType, 5, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(4);
+	FIELD(result, 1) = int2obj(dataLog.recordsLogged & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(dataLog.recordsDropped & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(dataLog.blocksWritten & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(maxLogWriteUsecs & 0x3FFFFFFF);
+	return result;
+}
+
+// VM Instances (see vmHost.c)
+// Each instance has its own data log. Other open files are shared by all instances.
+
+typedef struct {
+	DataLog dataLog;
+	FILE *logFile;
+	uint32 maxLogWriteUsecs;
+} FileState;
+
+void fileSaveState(VMState *state) {
+	if (!state->fileState) state->fileState = malloc(sizeof(FileState));
+	FileState *fs = state->fileState;
+	if (!fs) vmPanic("Could not save VM instance file state");
+	fs->dataLog = dataLog;
+	fs->logFile = logFile;
+	fs->maxLogWriteUsecs = maxLogWriteUsecs;
+}
+
+void fileRestoreState(VMState *state) {
+	FileState *fs = state->fileState;
+	if (!fs) return;
+	dataLog = fs->dataLog;
+	logFile = fs->logFile;
+	maxLogWriteUsecs = fs->maxLogWriteUsecs;
+}
+
+void fileClearState() {
+	// Reset the data log for a new instance. Its buffer and file belong to the saved instance.
+
+	memset(&dataLog, 0, sizeof(dataLog));
+	logFile = NULL;
+	maxLogWriteUsecs = 0;
+}
+
 // Primitives
 
 static PrimEntry entries[] = {
@@ -317,6 +484,13 @@ static PrimEntry entries[] = {
 	{"nextInList", primNextFileInList},
 
 	{"systemInfo", primSystemInfo},
+
+	{"startLog", primStartLog},
+	{"logRecord", primLogRecord},
+	{"flushLog", primFlushLog},
+	{"stopLog", primStopLog},
+	{"logFiles", primLogFiles},
+	{"logStats", primLogStats},
 };
 
 void addFilePrims() {
@@ -10,9 +10,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include "mem.h"
 #include "interp.h"
+#include "pinBus.h"
+#include "adcSampler.h"
+#include "pulseTrain.h"
+#include "pinEvents.h"
+#include "audioOut.h"
+#include "wavSink.h"
+#include "simulatedADC.h"
 #include <math.h>
 #include <SDL2/SDL.h>
 
@@ -109,6 +117,383 @@ OBJ primSetServo(int argCount, OBJ *args) { return falseObj; }
 OBJ primDACInit(int argCount, OBJ *args) { return falseObj; }
 OBJ primDACWrite(int argCount, OBJ *args) { return falseObj; }
 
+// Pin Groups and Bus Output (see pinBus.c)
+// Uses the pin functions of linux.c, so bus traffic appears in the pin log of the mock pins.
+
+#define PIN_GROUP_COUNT 4
+
+static PinGroup pinGroups[PIN_GROUP_COUNT];
+
+static void busSetPin(int pin, int value) { primDigitalSet(pin, value); }
+
+static int busGetPin(int pin) {
+	OBJ pinArg = int2obj(pin);
+	return (trueObj == primDigitalRead(1, &pinArg));
+}
+
+static PinBusDriver busDriver = { busSetPin, busGetPin, NULL, NULL, NULL };
+
+static PinGroup * pinGroupArg(OBJ arg) {
+	if (!isInt(arg)) { fail(needsIntegerError); return NULL; }
+	int id = obj2int(arg);
+	if ((id < 1) || (id > PIN_GROUP_COUNT)) { fail(indexOutOfRangeError); return NULL; }
+	return &pinGroups[id - 1];
+}
+
+static uint8 * busDataArg(OBJ arg, int *count) {
+	if (IS_TYPE(arg, ByteArrayType)) {
+		*count = BYTES(arg);
+		return (uint8 *) &FIELD(arg, 0);
+	} else if (IS_TYPE(arg, StringType)) {
+		*count = strlen(obj2str(arg));
+		return (uint8 *) obj2str(arg);
+	}
+	fail(needsByteArray);
+	return NULL;
+}
+
+static OBJ primPinGroupDefine(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	if (!ensureListCopy(args, 1)) return falseObj;
+	OBJ pinList = args[1];
+	if (!IS_TYPE(pinList, ListType)) return fail(needsListOfIntegers);
+	int count = obj2int(FIELD(pinList, 0));
+	if ((count < 1) || (count > PIN_GROUP_MAX_PINS)) return fail(indexOutOfRangeError);
+
+	int pins[PIN_GROUP_MAX_PINS];
+	for (int i = 0; i < count; i++) {
+		OBJ item = FIELD(pinList, i + 1);
+		if (!isInt(item)) return fail(needsListOfIntegers);
+		pins[i] = obj2int(item);
+	}
+	pinBus_define(group, pins, count, &busDriver);
+	return falseObj;
+}
+
+static OBJ primPinGroupWrite(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	pinBus_write(group, obj2int(args[1]), &busDriver);
+	return falseObj;
+}
+
+static OBJ primPinGroupRead(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return zeroObj;
+	return int2obj(pinBus_read(group, &busDriver) & 0x3FFFFFFF);
+}
+
+static OBJ primPinGroupWriteBytes(int argCount, OBJ *args) {
+	if (argCount < 3) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	int count;
+	uint8 *data = busDataArg(args[1], &count);
+	if (!data) return falseObj;
+	if (!isInt(args[2])) return fail(needsIntegerError);
+	int strobeLevel = (argCount > 3) ? (falseObj != args[3]) : true;
+	pinBus_writeBytes(group, data, count, obj2int(args[2]), strobeLevel, &busDriver);
+	return falseObj;
+}
+
+static OBJ primShiftOutBytes(int argCount, OBJ *args) {
+	if (argCount < 3) return fail(notEnoughArguments);
+	if (!isInt(args[0]) || !isInt(args[1])) return fail(needsIntegerError);
+	int count;
+	uint8 *data = busDataArg(args[2], &count);
+	if (!data) return falseObj;
+	int msbFirst = (argCount > 3) ? (falseObj != args[3]) : true;
+	pinBus_shiftOut(obj2int(args[0]), obj2int(args[1]), data, count, msbFirst, &busDriver);
+	return falseObj;
+}
+
+// Timed Analog Sampling (see adcSampler.c)
+// With the simulated ADC (--adc=<file>), each sample is the file's value at its scheduled
+// time, so the samples are exact even when the VM loop takes them late.
+
+int adcSampling = false;
+
+static ADCSampler adcSampler;
+
+static int adcReadPin(int pin, uint64 sampleTime) {
+	if (simulatedADC_active()) return simulatedADC_read(pin, sampleTime);
+	OBJ pinArg = int2obj(pin);
+	return obj2int(primAnalogRead(1, &pinArg));
+}
+
+static ADCDriver adcDriver = { adcReadPin };
+
+void sampleADC() {
+	adcSampler_run(&adcSampler, totalMicrosecs(), &adcDriver);
+	adcSampling = adcSampler.running;
+}
+
+static void stopPulseTrains(); // forward reference
+static void stopAudio(); // forward reference
+
+void turnOffPins() {
+	adcSampler_stop(&adcSampler);
+	adcSampling = false;
+	stopPulseTrains();
+	stopAudio();
+}
+
+static OBJ primADCSample(int argCount, OBJ *args) {
+	if (argCount < 3) return fail(notEnoughArguments);
+	int pins[ADC_MAX_CHANNELS];
+	int channelCount = 0;
+	if (!ensureListCopy(args, 0)) return falseObj;
+	OBJ pinArg = args[0];
+	if (isInt(pinArg)) {
+		pins[channelCount++] = obj2int(pinArg);
+	} else if (IS_TYPE(pinArg, ListType)) {
+		int count = obj2int(FIELD(pinArg, 0));
+		if ((count < 1) || (count > ADC_MAX_CHANNELS)) return fail(indexOutOfRangeError);
+		for (int i = 0; i < count; i++) {
+			OBJ item = FIELD(pinArg, i + 1);
+			if (!isInt(item)) return fail(needsListOfIntegers);
+			pins[channelCount++] = obj2int(item);
+		}
+	} else {
+		return fail(needsListOfIntegers);
+	}
+	if (!isInt(args[1]) || !isInt(args[2])) return fail(needsIntegerError);
+	int rate = obj2int(args[1]);
+	int frames = obj2int(args[2]);
+	if ((rate < 1) || (rate > ADC_MAX_RATE) || (frames < 1) ||
+		((2 * frames * channelCount) > ADC_MAX_BUFFER_BYTES)) return fail(indexOutOfRangeError);
+	int continuous = (argCount > 3) && (trueObj == args[3]);
+
+	adcSampling = adcSampler_start(&adcSampler, pins, channelCount, rate, frames, continuous, totalMicrosecs());
+	return adcSampling ? trueObj : falseObj;
+}
+
+static OBJ primADCDone(int argCount, OBJ *args) {
+	return adcSampler_ready(&adcSampler) ? trueObj : falseObj;
+}
+
+static OBJ primADCRead(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	return int2obj(adcSampler_read(&adcSampler, (uint8 *) &FIELD(buf, 0), BYTES(buf)));
+}
+
+static OBJ primADCStop(int argCount, OBJ *args) {
+	turnOffPins();
+	return falseObj;
+}
+
+static OBJ primADCStats(int argCount, OBJ *args) {
+	OBJ result = newObj(ListType, 5, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(4);
+	FIELD(result, 1) = int2obj(adcSampler.framesTaken & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(adcSampler.buffersDropped & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(adcSampler.maxLateUsecs & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(adcSampler.framesMissed & 0x3FFFFFFF);
+	return result;
+}
+
+// Pulse Trains (see pulseTrain.c)
+// The steps are taken by the VM loop. Each pin change is written to the pin log (see the
+// --pin-log option in linux.c) with the scheduled time of its step, so tests can check the
+// exact timing of the generated waveform.
+
+int pulseTrainsActive = false;
+
+static PulseTrain pulseTrains[PULSE_TRAIN_COUNT];
+
+static void pulseSetPins(PulseTrain *train, uint32 levels, uint32 changed, uint64 edgeTime) {
+	for (int i = 0; i < train->pinCount; i++) {
+		if ((changed >> i) & 1) pinWriteAt(train->pins[i], ((levels >> i) & 1) ? 1023 : 0, edgeTime);
+	}
+}
+
+static PulseDriver pulseDriver = { pulseSetPins };
+
+void updatePulseTrains() {
+	uint64 nextEdge;
+	int activeCount = pulseTrain_update(pulseTrains, PULSE_TRAIN_COUNT, totalMicrosecs(), &pulseDriver, &nextEdge);
+	pulseTrainsActive = (activeCount > 0);
+}
+
+static void stopPulseTrains() {
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) pulseTrain_stop(&pulseTrains[i]);
+	pulseTrainsActive = false;
+}
+
+static int pulsePinsArg(OBJ arg, int *pins) {
+	int count = 0;
+	if (isInt(arg)) {
+		pins[count++] = obj2int(arg);
+	} else if (IS_TYPE(arg, ListType)) {
+		count = obj2int(FIELD(arg, 0));
+		if ((count < 1) || (count > PULSE_TRAIN_MAX_PINS)) { fail(indexOutOfRangeError); return 0; }
+		for (int i = 0; i < count; i++) {
+			OBJ item = FIELD(arg, i + 1);
+			if (!isInt(item)) { fail(needsListOfIntegers); return 0; }
+			pins[i] = obj2int(item);
+		}
+	} else {
+		fail(needsListOfIntegers);
+		return 0;
+	}
+	for (int i = 0; i < count; i++) {
+		if (pins[i] < 0) return 0;
+	}
+	return count;
+}
+
+static int trainHasPin(PulseTrain *train, int pin) {
+	for (int i = 0; i < train->pinCount; i++) {
+		if (pin == train->pins[i]) return true;
+	}
+	return false;
+}
+
+static OBJ primPulsePlay(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0) || !ensureListCopy(args, 1)) return falseObj;
+	int pins[PULSE_TRAIN_MAX_PINS];
+	int pinCount = pulsePinsArg(args[0], pins);
+	if (!pinCount) return falseObj;
+	OBJ steps = args[1];
+	int stepCount;
+	if (IS_TYPE(steps, ByteArrayType)) {
+		stepCount = BYTES(steps) / 4;
+	} else if (IS_TYPE(steps, ListType)) {
+		stepCount = obj2int(FIELD(steps, 0)) / 2;
+		for (int i = 1; i <= (2 * stepCount); i++) {
+			if (!isInt(FIELD(steps, i))) return fail(needsListOfIntegers);
+		}
+	} else {
+		return fail(needsByteArray);
+	}
+	if ((stepCount < 1) || (stepCount > PULSE_TRAIN_MAX_STEPS)) return fail(indexOutOfRangeError);
+	int repeatCount = 1;
+	if (argCount > 2) {
+		if (trueObj == args[2]) repeatCount = 0; // repeat until stopped
+		if (isInt(args[2])) repeatCount = obj2int(args[2]);
+		if (repeatCount < 0) return fail(indexOutOfRangeError);
+	}
+
+	// use the train already playing the first pin or an idle one
+	PulseTrain *train = NULL;
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		if (trainHasPin(&pulseTrains[i], pins[0])) train = &pulseTrains[i];
+	}
+	for (int i = 0; !train && (i < PULSE_TRAIN_COUNT); i++) {
+		if (!pulseTrains[i].active) train = &pulseTrains[i];
+	}
+	if (!train) return falseObj; // all trains are busy
+
+	if (!pulseTrain_load(train, pins, pinCount, stepCount)) return falseObj;
+	for (int i = 0; i < stepCount; i++) {
+		if (IS_TYPE(steps, ByteArrayType)) {
+			uint8 *p = (uint8 *) &FIELD(steps, 0) + (4 * i);
+			pulseTrain_setStep(train, i, p[0], p[1] | (p[2] << 8) | (p[3] << 16));
+		} else {
+			pulseTrain_setStep(train, i, obj2int(FIELD(steps, (2 * i) + 1)), obj2int(FIELD(steps, (2 * i) + 2)));
+		}
+	}
+	if (!pulseTrain_play(train, repeatCount, totalMicrosecs() + 20)) return falseObj;
+	pulseTrainsActive = true;
+	return trueObj;
+}
+
+static OBJ primPulseBusy(int argCount, OBJ *args) {
+	int pin = ((argCount > 0) && isInt(args[0])) ? obj2int(args[0]) : -1;
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		PulseTrain *train = &pulseTrains[i];
+		if (train->active && ((pin < 0) || trainHasPin(train, pin))) return trueObj;
+	}
+	return falseObj;
+}
+
+static OBJ primPulseStop(int argCount, OBJ *args) {
+	if ((argCount < 1) || !isInt(args[0])) {
+		stopPulseTrains();
+		return falseObj;
+	}
+	int pin = obj2int(args[0]);
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		if (trainHasPin(&pulseTrains[i], pin)) pulseTrain_stop(&pulseTrains[i]);
+	}
+	return falseObj;
+}
+
+// Buffered Audio Output (see audioOut.c)
+// The VM loop passes each sample at its scheduled time to the WAV file sink, if the
+// --audio-out=<file> option was given; otherwise, samples are discarded. Either way,
+// the audio statistics show the throughput and underruns of a program.
+
+int audioPlaying = false;
+
+static AudioOut audioOut;
+
+static int audioWriteSink(int sample, uint64 sampleTime) {
+	wavSink_write(sample, audioOut.rate);
+	return true;
+}
+
+static AudioDriver audioDriver = { false, audioWriteSink };
+
+void updateAudio() {
+	audioOut_run(&audioOut, totalMicrosecs(), &audioDriver);
+	audioPlaying = audioOut.running;
+}
+
+static void stopAudio() {
+	audioOut_stop(&audioOut);
+	audioPlaying = false;
+}
+
+static OBJ primAudioStart(int argCount, OBJ *args) {
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!isInt(args[0]) || !isInt(args[1])) return fail(needsIntegerError);
+	int rate = obj2int(args[1]);
+	int bits = ((argCount > 2) && isInt(args[2])) ? obj2int(args[2]) : 8;
+	if (!audioOut_start(&audioOut, rate, bits)) return fail(indexOutOfRangeError);
+	audioPlaying = true;
+	return trueObj;
+}
+
+static OBJ primAudioQueue(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	if (BYTES(buf) > AUDIO_MAX_BUFFER_BYTES) return fail(indexOutOfRangeError);
+	int ok = audioOut_queue(&audioOut, (uint8 *) &FIELD(buf, 0), BYTES(buf), totalMicrosecs());
+	return ok ? trueObj : falseObj;
+}
+
+static OBJ primAudioSpace(int argCount, OBJ *args) {
+	return int2obj(audioOut_space(&audioOut));
+}
+
+static OBJ primAudioStop(int argCount, OBJ *args) {
+	stopAudio();
+	return falseObj;
+}
+
+static OBJ primAudioStats(int argCount, OBJ *args) {
+	OBJ result = newObj(ListType, 6, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(5);
+	FIELD(result, 1) = int2obj(audioOut.samplesPlayed & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(audioOut.buffersPlayed & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(audioOut.underruns & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(audioOut.maxLateUsecs & 0x3FFFFFFF);
+	FIELD(result, 5) = int2obj(audioOut.samplesDropped & 0x3FFFFFFF);
+	return result;
+}
+
 static PrimEntry entries[] = {
 	{"hasTone", primHasTone},
 	{"playTone", primPlayTone},
@@ -116,8 +501,114 @@ static PrimEntry entries[] = {
 	{"setServo", primSetServo},
 	{"dacInit", primDACInit},
 	{"dacWrite", primDACWrite},
+	{"pinGroupDefine", primPinGroupDefine},
+	{"pinGroupWrite", primPinGroupWrite},
+	{"pinGroupRead", primPinGroupRead},
+	{"pinGroupWriteBytes", primPinGroupWriteBytes},
+	{"shiftOutBytes", primShiftOutBytes},
+	{"adcSample", primADCSample},
+	{"adcDone", primADCDone},
+	{"adcRead", primADCRead},
+	{"adcStop", primADCStop},
+	{"adcStats", primADCStats},
+	{"pulsePlay", primPulsePlay},
+	{"pulseBusy", primPulseBusy},
+	{"pulseStop", primPulseStop},
+	{"audioStart", primAudioStart},
+	{"audioQueue", primAudioQueue},
+	{"audioSpace", primAudioSpace},
+	{"audioStop", primAudioStop},
+	{"audioStats", primAudioStats},
 };
 
 void addIOPrims() {
-	addPrimitiveSet("io", sizeof(entries) / sizeof(PrimEntry), entries);
+	addPrimitiveSet(IOPrims, "io", sizeof(entries) / sizeof(PrimEntry), entries);
+}
+
+// Pin Events (see pinEvents.c)
+// Mock pins have no interrupts. Instead, pinWriteAt() in linux.c calls simulatePinEdge()
+// when a mock pin changes, so a pulse train or a script driving a pin serves as a
+// simulated signal with exact edge times. The primitives are in pinEvents.c. (The
+// quadrature encoder primitives are not supported.)
+
+void simulatePinEdge(int pinNum, int level, uint64 usecs) {
+	PinEvents *pe = pinEvents_forPin(pinNum);
+	if (!pe) return; // pin not being captured
+	if (!usecs) usecs = totalMicrosecs();
+	pinEvents_record(pe, level, (uint32) usecs);
+}
+
+static PrimEntry encoderEntries[] = {
+	{"pinEventsStart", primPinEventsStart},
+	{"pinEventsStop", primPinEventsStop},
+	{"pinEventCount", primPinEventCount},
+	{"pinEventIntervals", primPinEventIntervals},
+	{"pinPeriod", primPinPeriod},
+	{"pinPulseWidth", primPinPulseWidth},
+	{"pinFrequency", primPinFrequency},
+};
+
+void addEncoderPrims() {
+	addPrimitiveSet(EncoderPrims, "encoder", sizeof(encoderEntries) / sizeof(PrimEntry), encoderEntries);
+}
+
+// VM Instances (see vmHost.c)
+// Each instance has its own pin groups, ADC sampler, pulse trains, audio output, and pin
+// event slots. The simulated ADC input file, the WAV sink, and the tone generator are
+// shared by all instances.
+
+typedef struct {
+	PinGroup pinGroups[PIN_GROUP_COUNT];
+	ADCSampler adcSampler;
+	int adcSampling;
+	PulseTrain pulseTrains[PULSE_TRAIN_COUNT];
+	int pulseTrainsActive;
+	AudioOut audioOut;
+	int audioPlaying;
+	PinEvents pinEvents[PIN_EVENT_SLOTS];
+} IOState;
+
+void ioSaveState(VMState *state) {
+	if (!state->ioState) state->ioState = malloc(sizeof(IOState));
+	IOState *io = state->ioState;
+	if (!io) vmPanic("Could not save VM instance I/O state");
+	memcpy(io->pinGroups, pinGroups, sizeof(pinGroups));
+	io->adcSampler = adcSampler;
+	io->adcSampling = adcSampling;
+	memcpy(io->pulseTrains, pulseTrains, sizeof(pulseTrains));
+	io->pulseTrainsActive = pulseTrainsActive;
+	io->audioOut = audioOut;
+	io->audioPlaying = audioPlaying;
+	for (int i = 0; i < PIN_EVENT_SLOTS; i++) {
+		memcpy(&io->pinEvents[i], (void *) pinEvents_slot(i), sizeof(PinEvents));
+	}
+}
+
+void ioRestoreState(VMState *state) {
+	IOState *io = state->ioState;
+	if (!io) return;
+	memcpy(pinGroups, io->pinGroups, sizeof(pinGroups));
+	adcSampler = io->adcSampler;
+	adcSampling = io->adcSampling;
+	memcpy(pulseTrains, io->pulseTrains, sizeof(pulseTrains));
+	pulseTrainsActive = io->pulseTrainsActive;
+	audioOut = io->audioOut;
+	audioPlaying = io->audioPlaying;
+	for (int i = 0; i < PIN_EVENT_SLOTS; i++) {
+		memcpy((void *) pinEvents_slot(i), &io->pinEvents[i], sizeof(PinEvents));
+	}
+}
+
+void ioClearState() {
+	// Reset the I/O state for a new instance. Buffers belong to the saved instance, so
+	// they are not freed.
+
+	memset(pinGroups, 0, sizeof(pinGroups));
+	memset(&adcSampler, 0, sizeof(adcSampler));
+	adcSampling = false;
+	memset(pulseTrains, 0, sizeof(pulseTrains));
+	pulseTrainsActive = false;
+	memset(&audioOut, 0, sizeof(audioOut));
+	audioPlaying = false;
+	for (int i = 0; i < PIN_EVENT_SLOTS; i++) pinEvents_stop(pinEvents_slot(i));
 }
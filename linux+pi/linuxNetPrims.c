@@ -22,6 +22,8 @@
 #include "mem.h"
 #include "tinyJSON.h"
 #include "interp.h"
+#include "inputTrace.h"
+#include "httpResponse.h"
 
 #include <ifaddrs.h>
 #include <net/if.h>
@@ -29,6 +31,7 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -51,6 +54,8 @@ int serverSocket = -1;
 int serverRequestSocket = -1; // Client currently connected to the server.
 int serverPort = 8080; // Default port. Can be changed on a request basis.
 
+static HttpResponse httpResponse; // decoder state for the streaming response primitives
+
 static OBJ primHasWiFi(int argCount, OBJ *args) { return trueObj; }
 
 static OBJ primStartWiFi(int argCount, OBJ *args) {
@@ -258,9 +263,11 @@ static OBJ primHttpServerGetRequest(int argCount, OBJ *args) {
 
 	OBJ result = useBinary ? newObj(ByteArrayType, 0, falseObj) : newString(0);
 
-	if (serverHasClient() && socketConnected(serverRequestSocket)) {
+	int hasClient = serverHasClient() && socketConnected(serverRequestSocket);
+	if (inputTrace_sample(trace_HttpServerClient, 0, hasClient)) {
 		char buf[800];
 		int byteCount = recv(serverRequestSocket, buf, 800, 0);
+		byteCount = inputTrace_stream(trace_HttpServerInput, (uint8 *) buf, byteCount, 800);
 		if (byteCount > 0) {
 			if (useBinary) {
 				result = newObj(ByteArrayType, (byteCount + 3) / 4, falseObj);
@@ -348,6 +355,45 @@ static OBJ primRespondToHttpRequest(int argCount, OBJ *args) {
 	return falseObj;
 }
 
+#define HTTP_SEND_TIMEOUT_MSECS 2000 // give up on a client that accepts no data for this long
+
+int httpRespondWithData(const char *contentType, uint8 *data, int byteCount, int keepAlive) {
+	// Respond to the current HTTP request with the given data as the body, writing it
+	// directly from data. Return the number of body bytes sent or -1 if there is no client.
+	// If the client stops accepting data, the rest of the body is dropped and the
+	// connection is closed.
+
+	char headers[256];
+
+	if (serverRequestSocket < 0) return -1;
+
+	snprintf(headers, sizeof(headers),
+		"HTTP/1.0 200 OK\r\nAccess-Control-Allow-Origin: *\r\n%sContent-Type: %s\r\nContent-Length: %d\r\n\r\n",
+		keepAlive ? "Connection: keep-alive\r\n" : "", contentType, byteCount);
+	send(serverRequestSocket, headers, strlen(headers), 0);
+
+	int sent = 0;
+	while (sent < byteCount) {
+		int n = send(serverRequestSocket, &data[sent], byteCount - sent, 0);
+		if (n <= 0) {
+			if ((n < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno))) {
+				// non-blocking socket is full; wait until the client accepts more data
+				struct pollfd pfd = { serverRequestSocket, POLLOUT, 0 };
+				if (poll(&pfd, 1, HTTP_SEND_TIMEOUT_MSECS) > 0) continue;
+				keepAlive = false; // client stalled; close the connection
+			}
+			break; // connection closed
+		}
+		sent += n;
+	}
+
+	if (!keepAlive) {
+		close(serverRequestSocket);
+		serverRequestSocket = -1;
+	}
+	return sent;
+}
+
 // HTTP Client
 
 static int lookupHost(char *hostName, struct sockaddr_in *result) {
@@ -402,7 +448,8 @@ static OBJ primHttpConnect(int argCount, OBJ *args) {
 
 
 static OBJ primHttpIsConnected(int argCount, OBJ *args) {
-	return socketConnected(clientSocket) ? trueObj : falseObj;
+	int connected = socketConnected(clientSocket);
+	return inputTrace_sample(trace_HttpClientConnected, 0, connected) ? trueObj : falseObj;
 }
 
 static OBJ primHttpRequest(int argCount, OBJ *args) {
@@ -437,6 +484,7 @@ Accept: */*\r\n",
 	} else {
 		write(clientSocket, "\r\n", 2);
 	}
+	http_initResponse(&httpResponse); // start decoding a new response
 
 	return falseObj;
 }
@@ -447,7 +495,9 @@ static OBJ primHttpResponse(int argCount, OBJ *args) {
 	char buffer[800];
 	int n, byteCount = 0;
 
-	while ((byteCount < (799 - 64)) && (n = (read(clientSocket, &buffer[byteCount], 64))) > 0) {
+	while ((byteCount < (799 - 64)) &&
+		(n = inputTrace_stream(trace_HttpClientInput, (uint8 *) &buffer[byteCount],
+			read(clientSocket, &buffer[byteCount], 64), 64)) > 0) {
 		byteCount += n;
 		processMessage(); // process messages now
 	}
@@ -457,6 +507,90 @@ static OBJ primHttpResponse(int argCount, OBJ *args) {
 	return response;
 }
 
+// Streaming HTTP Response
+
+static int readHttpBody(uint8 *buf, int bufSize) {
+	// Read and decode response bytes into buf until some body bytes arrive or no more data
+	// is available. Return the number of body bytes or -1 if the response is complete.
+
+	if (clientSocket < 0) return -1;
+	int bodyCount = 0;
+	while (!bodyCount && !http_isDone(&httpResponse)) {
+		int readCount = bufSize;
+		if ((http_Body == httpResponse.phase) && (httpResponse.contentLength >= 0) &&
+			(httpResponse.remaining < readCount)) {
+				readCount = httpResponse.remaining; // don't read past the end of the body
+		}
+		int byteCount = read(clientSocket, buf, readCount);
+		byteCount = inputTrace_stream(trace_HttpClientInput, buf, byteCount, readCount);
+		if (0 == byteCount) return -1; // closed by server
+		if (byteCount < 0) {
+			if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) break; // no data available yet
+			return -1; // socket error
+		}
+		bodyCount = http_decode(&httpResponse, buf, byteCount);
+	}
+	if (!bodyCount && http_isDone(&httpResponse)) return -1;
+	return bodyCount;
+}
+
+static OBJ primHttpReadInto(int argCount, OBJ *args) {
+	// Read response body bytes into the given ByteArray, starting at the optional index.
+	// Return the number of bytes stored (possibly zero) or -1 when the body is complete.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	int startIndex = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 1;
+	if ((startIndex < 1) || (startIndex > BYTES(buf))) return fail(indexOutOfRangeError);
+
+	uint8 *dst = (uint8 *) &FIELD(buf, 0) + (startIndex - 1);
+	return int2obj(readHttpBody(dst, BYTES(buf) - (startIndex - 1)));
+}
+
+static OBJ primHttpStatus(int argCount, OBJ *args) {
+	return int2obj(httpResponse.status);
+}
+
+static OBJ primHttpContentLength(int argCount, OBJ *args) {
+	return int2obj(httpResponse.contentLength);
+}
+
+static OBJ primHttpHeader(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	char value[100];
+	http_header(&httpResponse, obj2str(args[0]), value, sizeof(value));
+	return newStringFromBytes(value, strlen(value));
+}
+
+static OBJ primHttpResponseToFile(int argCount, OBJ *args) {
+	// Append the available response body bytes to the given file.
+	// Return the number of bytes written or -1 when the body is complete.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	char *fileName = obj2str(args[0]);
+	if (!fileName[0] || strstr(fileName, "ublockscode")) return falseObj;
+
+	uint8 buf[4096];
+	int totalBytes = 0;
+	int byteCount = 0;
+	FILE *file = NULL;
+	while (totalBytes < 65536) { // limit work per call so other tasks can run
+		byteCount = readHttpBody(buf, sizeof(buf));
+		if (byteCount <= 0) break;
+		if (!file) file = fopen(fileName, "a");
+		if (!file) break;
+		fwrite(buf, 1, byteCount, file);
+		totalBytes += byteCount;
+	}
+	if (file) fclose(file);
+	if ((byteCount < 0) && !totalBytes) return int2obj(-1);
+	return int2obj(totalBytes);
+}
+
 // Not yet implemented
 
 static OBJ primStartSSIDscan(int argCount, OBJ *args) { return fail(noWiFi); }
@@ -480,6 +614,11 @@ static PrimEntry entries[] = {
 	{"httpIsConnected", primHttpIsConnected},
 	{"httpRequest", primHttpRequest},
 	{"httpResponse", primHttpResponse},
+	{"httpReadInto", primHttpReadInto},
+	{"httpStatus", primHttpStatus},
+	{"httpContentLength", primHttpContentLength},
+	{"httpHeader", primHttpHeader},
+	{"httpResponseToFile", primHttpResponseToFile},
 	{"webSocketStart", primWebSocketStart},
 	{"webSocketLastEvent", primWebSocketLastEvent},
 	{"webSocketSendToClient", primWebSocketSendToClient},
@@ -0,0 +1,338 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// linuxRadioPrims.c - Simulated micro:bit radio for VM instances hosted by the Linux VM
+// agent, October 2026
+
+// Implements the "radio" primitives of radioPrims.cpp on a simulated radio medium shared
+// by the VM instances of a VM host (see vmHost.c). Packets use the same 32-byte MakeCode
+// format as the micro:bit, so code behaves the same as on real boards. A sent packet is
+// queued at every other instance whose radio is on the same group and channel. When not
+// hosting, sent packets are dropped.
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "vmHost.h"
+
+// MakeCode Packet Types
+
+#define MAKECODE_PACKET_INTEGER 0
+#define MAKECODE_PACKET_PAIR 1
+#define MAKECODE_PACKET_STRING 2
+#define MAKECODE_PACKET_DOUBLE 4
+#define MAKECODE_PACKET_DOUBLE_PAIR 5
+
+#define SIMULATED_SIGNAL_STRENGTH -50
+
+static RadioState * myRadio() {
+	RadioState *r = vmHost_radio(vmHost_currentInstance());
+	r->enabled = true;
+	return r;
+}
+
+// Radio Functions
+
+static int receivePacket(uint8 *packet) {
+	RadioState *r = myRadio();
+	if (r->packetCount <= 0) return false;
+
+	int readIndex = (r->packetIndex - r->packetCount) & (RADIO_MAX_PACKETS - 1);
+	memcpy(packet, &r->packets[readIndex * RADIO_PACKET_SIZE], RADIO_PACKET_SIZE);
+	r->packetCount--;
+	return true;
+}
+
+static void sendPacket(uint8 *packet) {
+	// Queue the given 32-byte packet at all other instances listening on our group and
+	// channel. As on the micro:bit, a packet arriving at a full queue replaces the oldest one.
+
+	int sender = vmHost_currentInstance();
+	RadioState *src = myRadio();
+	for (int i = 0; i < vmHost_instanceCount(); i++) {
+		RadioState *r = vmHost_radio(i);
+		if ((i == sender) || !r->enabled || (r->group != src->group) || (r->channel != src->channel)) {
+			continue;
+		}
+		memcpy(&r->packets[r->packetIndex * RADIO_PACKET_SIZE], packet, RADIO_PACKET_SIZE);
+		r->packetIndex = (r->packetIndex + 1) & (RADIO_MAX_PACKETS - 1);
+		if (r->packetCount < RADIO_MAX_PACKETS) r->packetCount++;
+		r->signalStrength = SIMULATED_SIGNAL_STRENGTH;
+	}
+}
+
+static int receiveMakeCodeMessage() {
+	// Read the next incoming packet, if any. If a packet is received and it is a MakeCode
+	// message, extract the data from it and return true. Otherwise, return false.
+
+	uint8 packet[32];
+	if (!receivePacket(packet)) return false; // no packet received
+
+	int len = packet[0];
+	if ((len < 12) || (1 != packet[1]) || (1 != packet[3])) return false; // not a MakeCode packet
+
+	// clear old received values
+	RadioState *r = myRadio();
+	r->receivedInteger = 0;
+	r->receivedString[0] = '\0';
+	char *src = NULL;
+	int maxStringLen = 19;
+	int stringLength = 0;
+	double dbl;
+
+	r->receivedMessageType = packet[4];
+	r->receivedMessageSenderID = (packet[12] << 24) | (packet[11] << 16) | (packet[10] << 8) | packet[9];
+
+	if (MAKECODE_PACKET_INTEGER == r->receivedMessageType) { // integer
+		r->receivedInteger = (packet[16] << 24) | (packet[15] << 16) | (packet[14] << 8) | packet[13];
+	} else if (MAKECODE_PACKET_PAIR == r->receivedMessageType) { // string-integer pair
+		r->receivedInteger = (packet[16] << 24) | (packet[15] << 16) | (packet[14] << 8) | packet[13];
+		stringLength = packet[17];
+		src = (char *) &packet[18];
+		maxStringLen = 32 - 18;
+	} else if (MAKECODE_PACKET_STRING == r->receivedMessageType) { // string
+		stringLength = packet[13];
+		src = (char *) &packet[14];
+		maxStringLen = 32 - 14;
+	} else if (MAKECODE_PACKET_DOUBLE == r->receivedMessageType) { // double
+		memcpy(&dbl, &packet[13], sizeof(dbl));
+		r->receivedInteger = (int) rint(dbl);
+	} else if (MAKECODE_PACKET_DOUBLE_PAIR == r->receivedMessageType) { // string-double pair
+		memcpy(&dbl, &packet[13], sizeof(dbl));
+		r->receivedInteger = (int) rint(dbl);
+		stringLength = packet[21];
+		src = (char *) &packet[22];
+		maxStringLen = 32 - 22;
+	}
+
+	// copy string into receivedString
+	if (stringLength > maxStringLen) stringLength = maxStringLen;
+	if (stringLength > 19) stringLength = 19;
+	for (int i = 0; i < stringLength; i++) r->receivedString[i] = *src++;
+	r->receivedString[stringLength] = '\0'; // null terminator
+
+	return true;
+}
+
+static void initMakeCodePacket(uint8 *packet, int makeCodePacketType, int packetLength) {
+	uint32 timestamp = millisecs();
+	uint32 id = myRadio()->deviceID;
+
+	memset(packet, 0, RADIO_PACKET_SIZE);
+	packet[0] = packetLength;
+	packet[1] = 1; // protocol
+	packet[2] = 0; // group (always 0)
+	packet[3] = 1; // version
+	packet[4] = makeCodePacketType;
+
+	// 4-byte timestamp, LSB byte order
+	packet[5] = timestamp & 255;
+	packet[6] = (timestamp >> 8) & 255;
+	packet[7] = (timestamp >> 16) & 255;
+	packet[8] = (timestamp >> 24) & 255;
+
+	// 4-byte device ID, LSB byte order
+	packet[9] = id & 255;
+	packet[10] = (id >> 8) & 255;
+	packet[11] = (id >> 16) & 255;
+	packet[12] = (id >> 24) & 255;
+}
+
+void resetRadio() {
+	// called by softReset to restore radio defaults
+
+	RadioState *r = vmHost_radio(vmHost_currentInstance());
+	if (!r) return;
+	r->group = 0;
+	r->channel = 7;
+}
+
+// primitives
+
+static OBJ primDisableRadio(int argCount, OBJ *args) {
+	RadioState *r = myRadio();
+	r->enabled = false;
+	r->packetCount = 0;
+	return falseObj;
+}
+
+static OBJ primMessageReceived(int argCount, OBJ *args) {
+	return receiveMakeCodeMessage() ? trueObj : falseObj;
+}
+
+static OBJ primPacketReceive(int argCount, OBJ *args) {
+	// If a packet has been received, copy it into supplied 32 element list and return true.
+	// Otherwise, return false.
+
+	if ((argCount > 0) && !ensureList(args, 0)) return falseObj;
+	if ((argCount > 0) && IS_TYPE(args[0], ListType) && (obj2int(FIELD(args[0], 0)) >= 32)) {
+		OBJ arg0 = args[0];
+		uint8 packet[32];
+		int gotData = receivePacket(packet);
+		if (!gotData) return falseObj; // no packet received
+		int packetLen = packet[0];
+		for (int i = 0; i < 32; i++) {
+			FIELD(arg0, i + 1) = (i <= packetLen) ? int2obj(packet[i]) : int2obj(0);
+		}
+		myRadio()->receivedMessageSenderID =
+			(packet[12] << 24) | (packet[11] << 16) | (packet[10] << 8) | packet[9];
+		return trueObj;
+	}
+	return falseObj;
+}
+
+static OBJ primPacketSend(int argCount, OBJ *args) {
+	// Send the given 32-element list as a 32-byte packet.
+
+	if ((argCount > 0) && !ensureListCopy(args, 0)) return falseObj;
+	if ((argCount > 0) && IS_TYPE(args[0], ListType) && (obj2int(FIELD(args[0], 0)) >= 32)) {
+		OBJ arg0 = args[0];
+		uint8 packet[32];
+		for (int i = 0; i < 32; i++) {
+			OBJ item = FIELD(arg0, i + 1);
+			packet[i] = isInt(item) ? obj2int(item) : 0;
+		}
+		sendPacket(packet);
+	}
+	return falseObj;
+}
+
+static OBJ primSendMakeCodeInteger(int argCount, OBJ *args) {
+	if ((argCount > 0) && isInt(args[0])) {
+		int n = obj2int(args[0]);
+		uint8 packet[32];
+		initMakeCodePacket(packet, MAKECODE_PACKET_INTEGER, 16);
+		packet[13] = n & 255;
+		packet[14] = (n >> 8) & 255;
+		packet[15] = (n >> 16) & 255;
+		packet[16] = (n >> 24) & 255;
+		sendPacket(packet);
+	}
+	return falseObj;
+}
+
+static OBJ primSendMakeCodePair(int argCount, OBJ *args) {
+	if ((argCount > 1) && IS_TYPE(args[0], StringType) && isInt(args[1])) {
+		char *s = obj2str(args[0]);
+		int n = obj2int(args[1]);
+		int len = strlen(s);
+		if (len > 14) len = 14;
+		uint8 packet[32];
+		initMakeCodePacket(packet, MAKECODE_PACKET_PAIR, 17 + len);
+		packet[13] = n & 255;
+		packet[14] = (n >> 8) & 255;
+		packet[15] = (n >> 16) & 255;
+		packet[16] = (n >> 24) & 255;
+		packet[17] = len;
+		for (int i = 0; i < len; i++) {
+			packet[18 + i] = s[i];
+		}
+		sendPacket(packet);
+	}
+	return falseObj;
+}
+
+static OBJ primSendMakeCodeString(int argCount, OBJ *args) {
+	if ((argCount > 0) && IS_TYPE(args[0], StringType)) {
+		char *s = obj2str(args[0]);
+		int len = strlen(s);
+		if (len > 18) len = 18;
+		uint8 packet[32];
+		initMakeCodePacket(packet, MAKECODE_PACKET_STRING, 13 + len);
+		packet[13] = len;
+		for (int i = 0; i < len; i++) {
+			packet[14 + i] = s[i];
+		}
+		sendPacket(packet);
+	}
+	return falseObj;
+}
+
+static OBJ primSetChannel(int argCount, OBJ *args) {
+	if ((argCount > 0) && isInt(args[0])) {
+		int channel = obj2int(args[0]);
+		if ((channel >= 0) && (channel <= 83)) myRadio()->channel = channel;
+	}
+	return falseObj;
+}
+
+static OBJ primSetGroup(int argCount, OBJ *args) {
+	if ((argCount > 0) && isInt(args[0])) {
+		int group = obj2int(args[0]);
+		if ((group >= 0) && (group <= 255)) myRadio()->group = group;
+	}
+	return falseObj;
+}
+
+static OBJ primSetPower(int argCount, OBJ *args) {
+	myRadio(); // all instances are in range; power level is ignored
+	return falseObj;
+}
+
+static OBJ primDeviceID(int argCount, OBJ *args) {
+	char s[10];
+	sprintf(s, "%08x", myRadio()->deviceID);
+	return newStringFromBytes(s, 8);
+}
+
+static OBJ primReceivedInteger(int argCount, OBJ *args) {
+	return int2obj(myRadio()->receivedInteger);
+}
+
+static OBJ primReceivedMessageType(int argCount, OBJ *args) {
+	int receivedMessageType = myRadio()->receivedMessageType;
+	const char *s = "other";
+	if (-1 == receivedMessageType) s = "none";
+	if (MAKECODE_PACKET_INTEGER == receivedMessageType) s = "number";
+	if (MAKECODE_PACKET_PAIR == receivedMessageType) s = "pair";
+	if (MAKECODE_PACKET_STRING == receivedMessageType) s = "string";
+	if (MAKECODE_PACKET_DOUBLE == receivedMessageType) s = "number";
+	if (MAKECODE_PACKET_DOUBLE_PAIR == receivedMessageType) s = "pair";
+
+	return newStringFromBytes(s, strlen(s));
+}
+
+static OBJ primReceivedString(int argCount, OBJ *args) {
+	char *s = myRadio()->receivedString;
+	return newStringFromBytes(s, strlen(s));
+}
+
+static OBJ primSignalStrength(int argCount, OBJ *args) {
+	return int2obj(myRadio()->signalStrength);
+}
+
+static OBJ primMessageSenderID(int argCount, OBJ *args) {
+	char s[10];
+	sprintf(s, "%08x", myRadio()->receivedMessageSenderID);
+	return newStringFromBytes(s, 8);
+}
+
+static PrimEntry entries[] = {
+	{"disableRadio", primDisableRadio},
+	{"messageReceived", primMessageReceived},
+	{"packetReceive", primPacketReceive},
+	{"packetSend", primPacketSend},
+	{"receivedInteger", primReceivedInteger},
+	{"receivedMessageType", primReceivedMessageType},
+	{"receivedString", primReceivedString},
+	{"sendInteger", primSendMakeCodeInteger},
+	{"sendPair", primSendMakeCodePair},
+	{"sendString", primSendMakeCodeString},
+	{"setChannel", primSetChannel},
+	{"setGroup", primSetGroup},
+	{"setPower", primSetPower},
+	{"signalStrength", primSignalStrength},
+	{"deviceID", primDeviceID},
+	{"lastMessageID", primMessageSenderID},
+};
+
+void addRadioPrims() {
+	addPrimitiveSet(RadioPrims, "radio", sizeof(entries) / sizeof(PrimEntry), entries);
+}
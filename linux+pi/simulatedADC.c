@@ -0,0 +1,176 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// simulatedADC.c - Analog inputs played from a WAV or CSV file for the Linux VM
+// agent, October 2026
+
+/*
+Simulated ADC
+
+With the --adc=<file> option, the analog inputs of the Linux VM are played from a file,
+so programs that sample signals (audio, vibration, power line monitoring) can be tested
+with known waveforms. The value of an input is its value in the file at the time it is
+read, measured on the VM clock, so timed sampling (see adcSampler.c) gets the samples of
+the file at exactly the requested rate, even with virtual time.
+
+Two file formats are supported:
+
+  WAV: PCM with 8 or 16 bits per sample and any number of channels. Samples are scaled
+	to the range 0-1023 (silence is 512). The file loops.
+  CSV: one row per line: the time in seconds followed by a value (0-1023) per channel.
+	Each value is held until the next row; the last row is held forever. Lines that do
+	not start with a number (such as a header) are skipped.
+
+Pin n reads channel (n % channelCount).
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "simulatedADC.h"
+
+#define MAX_CSV_CHANNELS 8
+
+static short *samples = NULL;	// values 0-1023, channels interleaved
+static uint64 *rowTimes = NULL;	// CSV only: time of each row in usecs
+static int channelCount = 0;
+static int frameCount = 0;
+static int wavRate = 0;			// WAV only: frames per second
+
+int simulatedADC_active() { return frameCount > 0; }
+
+// WAV files
+
+static int readShort(uint8 *p) { return p[0] | (p[1] << 8); }
+static uint32 readInt(uint8 *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32) p[3] << 24); }
+
+static int loadWAV(uint8 *data, long size) {
+	if ((size < 12) || (0 != memcmp(data + 8, "WAVE", 4))) return false;
+	int bitsPerSample = 0;
+	uint8 *pcm = NULL;
+	uint32 pcmBytes = 0;
+
+	// find the format and data chunks
+	long i = 12;
+	while ((i + 8) <= size) {
+		uint32 chunkSize = readInt(data + i + 4);
+		uint8 *body = data + i + 8;
+		if (chunkSize > (size - (i + 8))) chunkSize = size - (i + 8); // truncated file
+		if ((0 == memcmp(data + i, "fmt ", 4)) && (chunkSize >= 16)) {
+			if (1 != readShort(body)) return false; // not PCM
+			channelCount = readShort(body + 2);
+			wavRate = readInt(body + 4);
+			bitsPerSample = readShort(body + 14);
+		} else if (0 == memcmp(data + i, "data", 4)) {
+			pcm = body;
+			pcmBytes = chunkSize;
+		}
+		i += 8 + chunkSize + (chunkSize & 1); // chunks are padded to an even size
+	}
+	if (!pcm || (channelCount < 1) || (wavRate < 1)) return false;
+	if ((8 != bitsPerSample) && (16 != bitsPerSample)) return false;
+
+	int bytesPerSample = bitsPerSample / 8;
+	int count = pcmBytes / bytesPerSample;
+	frameCount = count / channelCount;
+	samples = (short *) malloc(count * sizeof(short));
+	if (!samples) return false;
+	for (int j = 0; j < count; j++) {
+		if (1 == bytesPerSample) {
+			samples[j] = pcm[j] << 2; // unsigned 8-bit
+		} else {
+			short s = (short) readShort(pcm + (2 * j)); // signed 16-bit
+			samples[j] = (s + 32768) >> 6;
+		}
+	}
+	return true;
+}
+
+// CSV files
+
+static int loadCSV(char *text) {
+	int allocated = 0;
+	char *line = text;
+	while (line && *line) {
+		char *next = strchr(line, '\n');
+		if (next) *next++ = 0;
+		char *p = line;
+		while (isspace((int) *p)) p++;
+		if (isdigit((int) *p) || ('.' == *p)) {
+			double values[MAX_CSV_CHANNELS + 1];
+			int count = 0;
+			while (*p && (count <= MAX_CSV_CHANNELS)) {
+				char *end;
+				values[count] = strtod(p, &end);
+				if (end == p) break;
+				count++;
+				p = end;
+				while (isspace((int) *p) || (',' == *p) || (';' == *p)) p++;
+			}
+			if (!channelCount) channelCount = count - 1; // first row sets the channel count
+			if ((channelCount > 0) && ((count - 1) >= channelCount)) {
+				if (frameCount >= allocated) {
+					allocated = allocated ? (2 * allocated) : 1000;
+					samples = (short *) realloc(samples, allocated * channelCount * sizeof(short));
+					rowTimes = (uint64 *) realloc(rowTimes, allocated * sizeof(uint64));
+					if (!samples || !rowTimes) return false;
+				}
+				rowTimes[frameCount] = (uint64) (1000000.0 * values[0]);
+				for (int ch = 0; ch < channelCount; ch++) {
+					double v = values[ch + 1];
+					samples[(frameCount * channelCount) + ch] = (v < 0) ? 0 : ((v > 1023) ? 1023 : (int) v);
+				}
+				frameCount++;
+			}
+		}
+		line = next;
+	}
+	return (frameCount > 0);
+}
+
+int simulatedADC_load(const char *fileName) {
+	// Load a WAV or CSV file. Return false if the file could not be read.
+
+	FILE *f = fopen(fileName, "rb");
+	if (!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	uint8 *data = (uint8 *) malloc(size + 1);
+	if (!data) { fclose(f); return false; }
+	size = fread(data, 1, size, f);
+	fclose(f);
+	data[size] = 0;
+
+	int ok = ((size >= 4) && (0 == memcmp(data, "RIFF", 4))) ?
+		loadWAV(data, size) : loadCSV((char *) data);
+	free(data);
+	if (!ok) frameCount = 0;
+	return ok;
+}
+
+int simulatedADC_read(int pin, uint64 usecs) {
+	// Return the value of the given pin at the given time.
+
+	if (frameCount <= 0) return 0;
+	int ch = ((pin < 0) ? 0 : pin) % channelCount;
+	int frame;
+	if (wavRate) {
+		frame = ((usecs * wavRate) / 1000000) % frameCount;
+	} else {
+		// find the last row at or before usecs
+		int low = 0, high = frameCount - 1;
+		while (low < high) {
+			int mid = (low + high + 1) / 2;
+			if (rowTimes[mid] <= usecs) low = mid; else high = mid - 1;
+		}
+		frame = low;
+	}
+	return samples[(frame * channelCount) + ch];
+}
@@ -0,0 +1,12 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// simulatedADC.h - Analog inputs played from a WAV or CSV file for the Linux VM
+// agent, October 2026
+
+int simulatedADC_load(const char *fileName);
+int simulatedADC_active();
+int simulatedADC_read(int pin, uint64 usecs);
@@ -0,0 +1,335 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// vmHost.c - Runs many VM instances in one Linux process
+// agent, October 2026
+
+/*
+VM Host
+
+With the --host=<file> option, the Linux VM runs many independent VM instances in one
+process, for example to simulate a classroom of boards or a sensor network. Each instance
+has its own object store, variables, tasks, scripts, pins, radio, random number generator,
+pin groups, ADC sampler, pulse trains, audio output, pin event slots, and data log.
+
+The VM state lives in globals, so only one instance is active at a time. The vmLoop()
+switches to another instance when the current one is idle or has used its time slice
+(see vmHost_switch()). Switching saves the state of the current instance into its VMState
+record and restores the state of the next one (see "VM Instances" in interp.h).
+
+Instances are scheduled round-robin. With virtual time, each instance has its own virtual
+clock and the host runs the instance that is furthest behind, so radio messages and pin
+changes between instances happen in a consistent, repeatable order. An idle instance
+jumps ahead to its next task wake time.
+
+Pins of different instances can be connected by wires. All pins on a wire share one value:
+reading a pin returns the value most recently written to any pin on its wire. Unwired pins
+read back the value written to them. Digital writes store 0 or 1023, so digital and
+analog reads of the same pin agree.
+
+All instances share a radio medium. A packet sent by one instance is received by every
+other instance whose radio is on the same group and channel (see linuxRadioPrims.c).
+
+Configuration file, one command per line (# starts a comment):
+
+	instance <codeFile> [count]			add count instances (default 1) running the given code file
+	wire <i>:<pin> <i>:<pin> ...		connect pins; instances are numbered from 0 in the order added
+
+Instances running the same code file share one open code file. It is only read, when an
+instance is created; since there is no IDE connection while hosting, the code store of an
+instance never changes, and linux.c does not write code files while hosting.
+
+Limitations: there is no IDE connection while hosting; output from instances is discarded.
+Primitives with process-wide state, such as files (other than the data log), network,
+display, tone, and the simulated ADC input and WAV output files, are shared by all
+instances.
+*/
+
+#define _DEFAULT_SOURCE // for usleep() and strdup()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "persist.h"
+#include "vmHost.h"
+
+#define MAX_LINE 1000
+
+typedef struct {
+	VMState state;
+	char *codeFileName;
+	FILE *codeFile;
+	uint64 clock;			// virtual time of this instance
+	uint64 wakeTime;		// if idle, the earliest task wake time (zero if none)
+	int idle;				// true if no task was runnable at the end of the last time slice
+	int pinWire[HOST_PINS];	// wire index of each pin or -1 if not wired
+	int pinValue[HOST_PINS];
+	RadioState radio;
+} VMInstance;
+
+int hostingVMs = false;
+
+static VMInstance *instances = NULL;
+static int instanceCount = 0;
+static int current = 0;				// index of the running instance
+static int idleSwitches = 0;		// number of switches in a row from an idle instance
+
+static int *wireValues = NULL;
+static int wireCount = 0;
+
+static RadioState radio = { // used when not hosting
+	.channel = 7, .signalStrength = -999, .receivedMessageType = -1 };
+
+// Instance Switching
+
+static void saveInstance(VMInstance *inst) {
+	memSaveState(&inst->state);
+	persistSaveState(&inst->state);
+	interpSaveState(&inst->state);
+	miscSaveState(&inst->state);
+	ioSaveState(&inst->state);
+	fileSaveState(&inst->state);
+	inst->codeFileName = codeFileName;
+	inst->codeFile = codeFile;
+	if (useVirtualTime) inst->clock = virtualClock();
+}
+
+static void restoreInstance(VMInstance *inst) {
+	memRestoreState(&inst->state);
+	persistRestoreState(&inst->state);
+	interpRestoreState(&inst->state);
+	miscRestoreState(&inst->state);
+	ioRestoreState(&inst->state);
+	fileRestoreState(&inst->state);
+	codeFileName = inst->codeFileName;
+	codeFile = inst->codeFile;
+	if (useVirtualTime) setVirtualClock(inst->clock);
+}
+
+static int nextVirtualInstance() {
+	// Return the index of the instance that is furthest behind in virtual time and update
+	// its clock. An idle instance is ready at its next task wake time; one with no waiting
+	// tasks is not scheduled. Ties go to the first instance after the current one, so
+	// instances take turns.
+
+	int next = -1;
+	uint64 nextTime = 0;
+	for (int n = 1; n <= instanceCount; n++) {
+		int i = (current + n) % instanceCount;
+		VMInstance *inst = &instances[i];
+		uint64 readyTime = inst->clock;
+		if (inst->idle) {
+			if (!inst->wakeTime) continue; // nothing to do
+			if (inst->wakeTime > readyTime) readyTime = inst->wakeTime;
+		}
+		if ((next < 0) || (readyTime < nextTime)) {
+			next = i;
+			nextTime = readyTime;
+		}
+	}
+	if (next < 0) {
+		// no instance has anything to do; let some time pass
+		usleep(500);
+		next = (current + 1) % instanceCount;
+		nextTime = instances[next].clock + 500;
+	}
+	instances[next].clock = nextTime;
+	return next;
+}
+
+static int nextRealInstance() {
+	// Return the index of the next instance, round-robin. If every instance was idle in
+	// its last time slice, nap until the earliest task wake time (at most 500 usecs) to
+	// relinquish the CPU.
+
+	if (idleSwitches >= instanceCount) {
+		uint64 usecs = totalMicrosecs();
+		int sleepUSecs = 500;
+		for (int i = 0; i < instanceCount; i++) {
+			uint64 wakeTime = instances[i].wakeTime;
+			if (wakeTime && (wakeTime > (usecs + 5))) {
+				uint64 usecsUntilWake = (wakeTime - usecs) - 5; // leave 5 extra usecs
+				if (usecsUntilWake < (uint64) sleepUSecs) sleepUSecs = usecsUntilWake;
+			} else if (wakeTime) {
+				sleepUSecs = 0; // a task is ready
+			}
+		}
+		if (sleepUSecs > 5) usleep(sleepUSecs);
+		idleSwitches = 0;
+	}
+	return (current + 1) % instanceCount;
+}
+
+void vmHost_switch(int idle) {
+	// Called by vmLoop() when the current instance is idle or at the end of its time slice.
+	// Switch to the next instance to run.
+
+	VMInstance *inst = &instances[current];
+	inst->idle = idle;
+	inst->wakeTime = idle ? nextTaskWakeTime() : 0;
+	if (useVirtualTime) inst->clock = virtualClock();
+	idleSwitches = idle ? idleSwitches + 1 : 0;
+
+	int next = useVirtualTime ? nextVirtualInstance() : nextRealInstance();
+	if (next == current) {
+		if (useVirtualTime) setVirtualClock(inst->clock);
+		return;
+	}
+	saveInstance(inst);
+	current = next;
+	restoreInstance(&instances[current]);
+}
+
+// Pins
+
+int vmHost_pinRead(int pin) {
+	if ((pin < 0) || (pin >= HOST_PINS)) return 0;
+	VMInstance *inst = &instances[current];
+	int wire = inst->pinWire[pin];
+	return (wire >= 0) ? wireValues[wire] : inst->pinValue[pin];
+}
+
+void vmHost_pinWrite(int pin, int value) {
+	if ((pin < 0) || (pin >= HOST_PINS)) return;
+	VMInstance *inst = &instances[current];
+	int wire = inst->pinWire[pin];
+	if (wire >= 0) wireValues[wire] = value;
+	inst->pinValue[pin] = value;
+}
+
+// Instances
+
+int vmHost_currentInstance() { return current; }
+int vmHost_instanceCount() { return instanceCount; }
+
+RadioState * vmHost_radio(int instanceIndex) {
+	if (!hostingVMs) return &radio;
+	if ((instanceIndex < 0) || (instanceIndex >= instanceCount)) return NULL;
+	return &instances[instanceIndex].radio;
+}
+
+static void initRadioState(RadioState *r, uint32 deviceID) {
+	memset(r, 0, sizeof(RadioState));
+	r->channel = 7;
+	r->deviceID = deviceID;
+	r->signalStrength = -999;
+	r->receivedMessageType = -1;
+}
+
+static int addInstance(char *fileName) {
+	// Create a new instance, load its code file, and start its tasks.
+
+	VMInstance *newInstances = realloc(instances, (instanceCount + 1) * sizeof(VMInstance));
+	if (!newInstances) return false;
+	instances = newInstances;
+	VMInstance *inst = &instances[instanceCount];
+	memset(inst, 0, sizeof(VMInstance));
+	uint32 deviceID = 0x4D420000 + instanceCount;
+	for (int i = 0; i < HOST_PINS; i++) inst->pinWire[i] = -1;
+	initRadioState(&inst->radio, deviceID);
+
+	if (instanceCount > 0) saveInstance(&instances[current]);
+	current = instanceCount++;
+
+	codeFileName = fileName;
+	if (useVirtualTime) setVirtualClock(0);
+	persistClearState();
+	interpClearState();
+	ioClearState();
+	fileClearState();
+	setRandomSeed(deviceID); // repeatable, but different for each instance
+	memInit();
+	restoreScripts();
+	startAll();
+
+	// instances running the same code share one open code file
+	for (int i = 0; i < current; i++) {
+		if (0 == strcmp(instances[i].codeFileName, fileName)) {
+			fclose(codeFile);
+			codeFile = instances[i].codeFile;
+			break;
+		}
+	}
+	inst->codeFileName = codeFileName;
+	inst->codeFile = codeFile;
+	if (useVirtualTime) inst->clock = virtualClock();
+	return true;
+}
+
+static int addWire(char *endpoints, int lineNum) {
+	// Connect the pins listed in endpoints (e.g. "0:3 1:4") with a new wire.
+
+	int *newValues = realloc(wireValues, (wireCount + 1) * sizeof(int));
+	if (!newValues) return false;
+	wireValues = newValues;
+	wireValues[wireCount] = 0;
+
+	char *endpoint = strtok(endpoints, " \t\r\n");
+	while (endpoint) {
+		int i, pin;
+		if ((2 != sscanf(endpoint, "%d:%d", &i, &pin)) ||
+			(i < 0) || (i >= instanceCount) || (pin < 0) || (pin >= HOST_PINS)) {
+				printf("Line %d: bad wire endpoint: %s\n", lineNum, endpoint);
+				return false;
+		}
+		instances[i].pinWire[pin] = wireCount;
+		endpoint = strtok(NULL, " \t\r\n");
+	}
+	wireCount++;
+	return true;
+}
+
+int vmHost_start(const char *configFileName) {
+	// Create the instances and wires described in the given configuration file and make
+	// the first instance current. Return false if there is an error.
+
+	FILE *f = fopen(configFileName, "r");
+	if (!f) {
+		printf("Could not open VM host file: %s\n", configFileName);
+		return false;
+	}
+	hostingVMs = true;
+
+	char line[MAX_LINE];
+	char name[MAX_LINE];
+	int lineNum = 0;
+	int ok = true;
+	while (ok && fgets(line, sizeof(line), f)) {
+		lineNum++;
+		char *comment = strchr(line, '#');
+		if (comment) *comment = '\0';
+		int count = 1;
+		if (sscanf(line, " instance %s %d", name, &count) >= 1) {
+			char *fileName = strdup(name);
+			for (int i = 0; ok && (i < count); i++) ok = (fileName && addInstance(fileName));
+			if (!ok) printf("Line %d: could not create instance\n", lineNum);
+		} else if (0 == strncmp(line + strspn(line, " \t"), "wire", 4)) {
+			ok = addWire(line + strspn(line, " \t") + 4, lineNum);
+		} else if (line[strspn(line, " \t\r\n")]) {
+			printf("Line %d: unknown command: %s", lineNum, line);
+			ok = false;
+		}
+	}
+	fclose(f);
+	if (ok && (0 == instanceCount)) {
+		printf("No instances in VM host file: %s\n", configFileName);
+		ok = false;
+	}
+	if (!ok) return false;
+
+	// make the first instance current
+	if (current != 0) {
+		saveInstance(&instances[current]);
+		current = 0;
+		restoreInstance(&instances[0]);
+	}
+	printf("Hosting %d VM instances with %d wires\n", instanceCount, wireCount);
+	return true;
+}
@@ -0,0 +1,49 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// vmHost.h - Runs many VM instances in one Linux process
+// agent, October 2026
+
+#define HOST_PINS 32			// simulated pins per instance
+#define RADIO_PACKET_SIZE 32
+#define RADIO_MAX_PACKETS 4		// packets in each receive queue; must be a power of 2
+
+// Radio state of one instance (see linuxRadioPrims.c)
+
+typedef struct {
+	int enabled;
+	int group;
+	int channel;
+	uint32 deviceID;
+	uint8 packets[RADIO_MAX_PACKETS * RADIO_PACKET_SIZE];
+	int packetCount;
+	int packetIndex;			// index of the next packet buffer to receive into
+	int signalStrength;
+	uint32 receivedMessageSenderID;
+	int receivedMessageType;
+	int receivedInteger;
+	char receivedString[20];
+} RadioState;
+
+// Host
+
+int vmHost_start(const char *configFileName);
+int vmHost_currentInstance();
+int vmHost_instanceCount();
+RadioState * vmHost_radio(int instanceIndex);
+
+// Pins of the current instance
+
+int vmHost_pinRead(int pin);
+void vmHost_pinWrite(int pin, int value);
+
+// Defined in linux.c
+
+extern char *codeFileName;
+extern FILE *codeFile;
+
+uint64 virtualClock();
+void setVirtualClock(uint64 usecs);
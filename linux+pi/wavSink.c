@@ -0,0 +1,73 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// wavSink.c - Audio output written to a WAV file for the Linux VM
+// agent, October 2026
+
+// With the --audio-out=<file> option, the samples played by the audio output primitives
+// (see audioOut.c) are written to a 16-bit mono WAV file. The file's sample rate is the
+// rate of the first sample written. Samples are written as they are played, so the file
+// shows any gaps in playback and the audio statistics can be checked against it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "wavSink.h"
+
+static FILE *wavFile = NULL;
+static int wavRate = 0;
+static uint32 wavSampleCount = 0;
+
+static void putInt(uint8 *p, uint32 n) {
+	p[0] = n & 0xFF;
+	p[1] = (n >> 8) & 0xFF;
+	p[2] = (n >> 16) & 0xFF;
+	p[3] = (n >> 24) & 0xFF;
+}
+
+static void writeHeader() {
+	// Write the WAV header for the samples written so far.
+
+	uint8 header[44];
+	uint32 dataBytes = 2 * wavSampleCount;
+	memcpy(&header[0], "RIFF", 4);
+	memcpy(&header[8], "WAVEfmt ", 8);
+	memcpy(&header[36], "data", 4);
+	putInt(&header[4], 36 + dataBytes);
+	putInt(&header[16], 16); // format chunk size
+	putInt(&header[20], 1 | (1 << 16)); // PCM, one channel
+	putInt(&header[24], wavRate);
+	putInt(&header[28], 2 * wavRate); // bytes per second
+	putInt(&header[32], 2 | (16 << 16)); // bytes per frame, bits per sample
+	putInt(&header[40], dataBytes);
+	fseek(wavFile, 0, SEEK_SET);
+	fwrite(header, 1, sizeof(header), wavFile);
+	fseek(wavFile, 0, SEEK_END);
+}
+
+int wavSink_open(const char *fileName) {
+	wavFile = fopen(fileName, "wb");
+	if (!wavFile) return false;
+	writeHeader();
+	return true;
+}
+
+void wavSink_write(int sample, int rate) {
+	if (!wavFile) return;
+	if (!wavRate) wavRate = rate;
+	uint8 bytes[2] = { sample & 0xFF, (sample >> 8) & 0xFF };
+	fwrite(bytes, 1, 2, wavFile);
+	wavSampleCount++;
+}
+
+void wavSink_close() {
+	if (!wavFile) return;
+	writeHeader();
+	fclose(wavFile);
+	wavFile = NULL;
+}
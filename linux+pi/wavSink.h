@@ -0,0 +1,12 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// wavSink.h - Audio output written to a WAV file for the Linux VM
+// agent, October 2026
+
+int wavSink_open(const char *fileName);
+void wavSink_write(int sample, int rate);
+void wavSink_close();
@@ -0,0 +1,147 @@
+// adcSamplerTests.c - Tests for timed analog sampling
+//
+// Runs the ADC sampler on a simulated clock against a mock driver whose value is a
+// function of the pin and the sample's scheduled time, so each sample shows when it was
+// scheduled. The clock is advanced in irregular steps, as the VM loop would poll it.
+//
+// A real ADC returns the value at the time it is read, not at the scheduled time, so frames
+// that are overdue by more than one frame period must be skipped rather than taken late.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "adcSampler.h"
+#include "testHarness.h"
+
+static int readCount = 0;
+
+static int mockRead(int pin, uint64 sampleTime) {
+	// value encodes the pin and the scheduled time in units of 10 usecs
+	readCount++;
+	return (pin * 1000) + ((sampleTime / 10) % 1000);
+}
+
+static ADCDriver mockDriver = { mockRead };
+
+static int sampleAt(uint8 *bytes, int index) {
+	return (short) (bytes[2 * index] | (bytes[(2 * index) + 1] << 8));
+}
+
+static uint64 runUntilReady(ADCSampler *s, uint64 now, uint64 limit, int step) {
+	// Advance the clock in irregular steps of up to step usecs until a buffer is ready.
+
+	int i = 0;
+	while (!adcSampler_ready(s) && (now < limit)) {
+		now += 1 + ((i++ * 7919) % step);
+		adcSampler_run(s, now, &mockDriver);
+	}
+	return now;
+}
+
+int main() {
+	ADCSampler sampler;
+	memset(&sampler, 0, sizeof(sampler));
+	uint8 bytes[ADC_MAX_BUFFER_BYTES];
+	char what[200];
+
+	// a single burst of 100 frames of two pins at 10 kHz (100 usecs per frame)
+	int pins[] = {2, 5};
+	uint64 start = 1000000;
+	check(adcSampler_start(&sampler, pins, 2, 10000, 100, false, start), "start a burst of 100 frames on two pins");
+	uint64 now = runUntilReady(&sampler, start, start + 1000000, 95);
+	int byteCount = adcSampler_read(&sampler, bytes, sizeof(bytes));
+	int scheduledOK = (400 == byteCount);
+	for (int i = 0; scheduledOK && (i < 100); i++) {
+		uint64 t = start + (100 * i);
+		scheduledOK = (sampleAt(bytes, 2 * i) == mockRead(2, t)) && (sampleAt(bytes, (2 * i) + 1) == mockRead(5, t));
+	}
+	snprintf(what, sizeof(what), "burst: %d bytes, every frame sampled at its scheduled time (max lateness %d usecs)",
+		byteCount, (int) sampler.maxLateUsecs);
+	check(scheduledOK && (sampler.maxLateUsecs > 0), what);
+	check(!sampler.running && (100 == sampler.framesTaken) && (0 == sampler.framesMissed) &&
+		(sampler.maxLateUsecs < 100) && !adcSampler_ready(&sampler),
+		"burst: sampling stops after exactly 100 frames and the buffer is released when read");
+
+	// when the VM falls behind, only the newest due frame is taken; the others are missed
+	adcSampler_start(&sampler, pins, 1, 1000, 500, false, 0);
+	adcSampler_run(&sampler, 199999, &mockDriver); // frames 0..199 are due
+	int firstCall = sampler.framesTaken;
+	for (int i = 0; i < 10; i++) adcSampler_run(&sampler, 199999, &mockDriver);
+	adcSampler_run(&sampler, 200000, &mockDriver); // frame 200
+	snprintf(what, sizeof(what), "falling behind: %d frame(s) taken, %d missed, max lateness %d usecs",
+		(int) sampler.framesTaken, (int) sampler.framesMissed, (int) sampler.maxLateUsecs);
+	check((1 == firstCall) && (2 == sampler.framesTaken) && (199 == sampler.framesMissed) &&
+		(sampler.maxLateUsecs < 1000), what);
+	check((201 == sampler.fillCount) && (sampleAt((uint8 *) sampler.buffers[0], 199) == mockRead(2, 199000)) &&
+		(sampleAt((uint8 *) sampler.buffers[0], 200) == mockRead(2, 200000)),
+		"falling behind: the frames taken are the ones due now, not stale ones");
+	adcSampler_stop(&sampler);
+
+	// missed frames repeat the last frame taken, so a frame's index still gives its time
+	adcSampler_start(&sampler, pins, 1, 1000, 10, false, 0);
+	adcSampler_run(&sampler, 0, &mockDriver);
+	adcSampler_run(&sampler, 5000, &mockDriver); // frames 1..4 missed
+	for (now = 6000; now <= 20000; now += 1000) adcSampler_run(&sampler, now, &mockDriver);
+	byteCount = adcSampler_read(&sampler, bytes, sizeof(bytes));
+	int heldOK = (20 == byteCount);
+	for (int i = 1; heldOK && (i <= 4); i++) heldOK = (sampleAt(bytes, i) == mockRead(2, 0));
+	check(heldOK && (sampleAt(bytes, 5) == mockRead(2, 5000)) && (sampleAt(bytes, 9) == mockRead(2, 9000)) &&
+		(6 == sampler.framesTaken) && (4 == sampler.framesMissed),
+		"missed frames hold the last value; the buffer ends with frame 9");
+
+	// continuous mode: a long stall fills whole buffers without writing each frame
+	adcSampler_start(&sampler, pins, 1, 1000, 10, true, 0);
+	adcSampler_run(&sampler, 0, &mockDriver);
+	adcSampler_run(&sampler, 1000003000, &mockDriver); // a million frames later
+	int stallReady = adcSampler_ready(&sampler);
+	adcSampler_read(&sampler, bytes, sizeof(bytes));
+	snprintf(what, sizeof(what), "continuous stall: fill count %d, %d buffers dropped",
+		sampler.fillCount, (int) sampler.buffersDropped);
+	check(stallReady && (4 == sampler.fillCount) && (sampleAt(bytes, 9) == mockRead(2, 0)) &&
+		(sampleAt((uint8 *) sampler.buffers[sampler.fillIndex], 3) == mockRead(2, 1000003000)) &&
+		((1000003 / 10) - 1 == sampler.buffersDropped), what);
+	adcSampler_stop(&sampler);
+	check(!sampler.buffers[0] && !sampler.buffers[1] && !adcSampler_ready(&sampler), "stop frees the buffers");
+
+	// continuous mode: each buffer continues the schedule of the previous one
+	adcSampler_start(&sampler, pins, 1, 8000, 64, true, 0);
+	int continuousOK = true;
+	now = 0;
+	for (int b = 0; continuousOK && (b < 5); b++) {
+		now = runUntilReady(&sampler, now, 10000000, 40);
+		continuousOK = (128 == adcSampler_read(&sampler, bytes, sizeof(bytes)));
+		for (int i = 0; continuousOK && (i < 64); i++) {
+			uint64 t = ((uint64) ((b * 64) + i) * 1000000) / 8000;
+			continuousOK = (sampleAt(bytes, i) == mockRead(2, t));
+		}
+	}
+	check(continuousOK && sampler.running && (0 == sampler.buffersDropped),
+		"continuous: five buffers read in time, consecutive and exact");
+
+	// continuous mode: buffers not read in time are counted as dropped
+	uint64 end = now + 10 * 8000; // 640 frames = 10 buffers
+	while (now < end) {
+		now += 100;
+		adcSampler_run(&sampler, now, &mockDriver);
+	}
+	int frames = sampler.framesTaken;
+	adcSampler_read(&sampler, bytes, sizeof(bytes));
+	int lastIndex = (frames / 64) * 64 - 1; // last frame of the newest full buffer
+	int newest = (sampleAt(bytes, 63) == mockRead(2, ((uint64) lastIndex * 1000000) / 8000));
+	snprintf(what, sizeof(what), "continuous: %d of %d unread buffers dropped; the newest one is kept",
+		(int) sampler.buffersDropped, (frames / 64) - 5);
+	check(newest && (sampler.buffersDropped == (uint32) ((frames / 64) - 5 - 1)), what);
+
+	adcSampler_stop(&sampler);
+	int before = readCount;
+	adcSampler_run(&sampler, now + 1000000, &mockDriver);
+	check(before == readCount, "stop: no more samples are taken");
+
+	// argument checks
+	check(!adcSampler_start(&sampler, pins, 2, 10000, ADC_MAX_BUFFER_BYTES, false, 0), "buffer too large is rejected");
+	check(!adcSampler_start(&sampler, pins, 0, 10000, 10, false, 0), "no pins is rejected");
+
+	return testSummary();
+}
@@ -0,0 +1,152 @@
+// audioOutTests.c - Tests for buffered sample playback
+//
+// Plays queued buffers through two mock drivers: an unclocked one that records each
+// sample with its scheduled time, and a clocked one with a small buffer, like a
+// timer-driven DAC. The clock is advanced in irregular steps, as the VM loop would.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "audioOut.h"
+#include "testHarness.h"
+
+#define MAX_OUTPUT 20000
+
+static int output[MAX_OUTPUT];
+static uint64 outputTimes[MAX_OUTPUT];
+static int outputCount = 0;
+static int deviceRoom = 0; // clocked mock: samples its buffer can take
+
+static int mockWrite(int sample, uint64 sampleTime) {
+	if (outputCount < MAX_OUTPUT) {
+		output[outputCount] = sample;
+		outputTimes[outputCount++] = sampleTime;
+	}
+	return true;
+}
+
+static int mockClockedWrite(int sample, uint64 sampleTime) {
+	if (deviceRoom <= 0) return false;
+	deviceRoom--;
+	return mockWrite(sample, sampleTime);
+}
+
+static AudioDriver pacedDriver = { false, mockWrite };
+static AudioDriver clockedDriver = { true, mockClockedWrite };
+
+static void fill16(uint8 *buf, int sampleCount, int first) {
+	// fill buf with 16-bit samples first, first + 1, ...
+	for (int i = 0; i < sampleCount; i++) {
+		int sample = first + i;
+		buf[2 * i] = sample & 0xFF;
+		buf[(2 * i) + 1] = (sample >> 8) & 0xFF;
+	}
+}
+
+int main() {
+	AudioOut player;
+	memset(&player, 0, sizeof(player));
+	uint8 buf[AUDIO_MAX_BUFFER_BYTES];
+	char what[200];
+
+	// a program that refills the queue whenever there is space: no gaps, exact times
+	audioOut_start(&player, 8000, 16);
+	uint64 now = 5000;
+	int nextFirst = 0, queued = 0;
+	outputCount = 0;
+	for (int i = 0; queued < 10; i++) {
+		while ((queued < 10) && audioOut_space(&player)) {
+			fill16(buf, 100, nextFirst);
+			audioOut_queue(&player, buf, 200, now);
+			nextFirst += 100;
+			queued++;
+		}
+		now += 1 + ((i * 7919) % 120); // less than one sample period (125 usecs)
+		audioOut_run(&player, now, &pacedDriver);
+	}
+	while (outputCount < 1000) audioOut_run(&player, now += 100, &pacedDriver);
+	int exact = (1000 == outputCount);
+	for (int i = 0; exact && (i < 1000); i++) {
+		exact = (output[i] == i) && (outputTimes[i] == (5000 + (((uint64) i * 1000000) / 8000)));
+	}
+	snprintf(what, sizeof(what), "10 queued buffers: 1000 samples in order at exact times, %d underruns, max lateness %d usecs",
+		(int) player.underruns, (int) player.maxLateUsecs);
+	check(exact && (0 == player.underruns) && (0 == player.samplesDropped) && (10 == (int) player.buffersPlayed), what);
+
+	// when the caller falls behind, late samples are dropped, not written in a burst
+	audioOut_start(&player, 10000, 16);
+	fill16(buf, 100, 0);
+	audioOut_queue(&player, buf, 200, 0);
+	outputCount = 0;
+	audioOut_run(&player, 0, &pacedDriver); // sample 0
+	audioOut_run(&player, 1050, &pacedDriver); // samples 1..10 are due
+	audioOut_run(&player, 1100, &pacedDriver); // sample 11
+	snprintf(what, sizeof(what), "falling behind: %d samples written, %d dropped, %d underruns, max lateness %d usecs",
+		outputCount, (int) player.samplesDropped, (int) player.underruns, (int) player.maxLateUsecs);
+	check((3 == outputCount) && (0 == output[0]) && (10 == output[1]) && (1000 == outputTimes[1]) && (11 == output[2]) &&
+		(9 == player.samplesDropped) && (1 == player.underruns) && (player.maxLateUsecs < 100), what);
+
+	// the queue holds a limited number of buffers
+	audioOut_start(&player, 8000, 8);
+	memset(buf, 128, 100);
+	int accepted = 0;
+	for (int i = 0; i < 10; i++) accepted += audioOut_queue(&player, buf, 100, 0);
+	check((AUDIO_QUEUE_SIZE == accepted) && (0 == audioOut_space(&player)), "a full queue refuses more buffers");
+
+	// 8-bit samples are unsigned, centered on 128
+	audioOut_start(&player, 8000, 8);
+	uint8 eightBit[] = {0, 128, 255};
+	audioOut_queue(&player, eightBit, 3, 0);
+	outputCount = 0;
+	for (int t = 0; t <= 250; t += 125) audioOut_run(&player, t, &pacedDriver);
+	check((3 == outputCount) && (-32768 == output[0]) && (0 == output[1]) && (32512 == output[2]),
+		"8-bit samples are converted to signed 16-bit");
+
+	// a program that queues too late: playback stalls and resumes, counting underruns
+	audioOut_start(&player, 10000, 16);
+	fill16(buf, 100, 0);
+	now = 0;
+	outputCount = 0;
+	for (int i = 0; i < 5; i++) {
+		audioOut_queue(&player, buf, 200, now);
+		now += 15000; // 150 samples of time per 100 samples queued
+		for (uint64 t = now - 15000; t <= now; t += 50) audioOut_run(&player, t, &pacedDriver);
+	}
+	snprintf(what, sizeof(what), "buffers queued too slowly: %d samples played, %d underruns",
+		outputCount, (int) player.underruns);
+	check((500 == outputCount) && (4 == player.underruns), what);
+
+	// a clocked driver takes samples as fast as its buffer allows, regardless of time
+	audioOut_start(&player, 44100, 16);
+	fill16(buf, 1000, 0);
+	audioOut_queue(&player, buf, 2000, 0);
+	outputCount = 0;
+	int calls = 0;
+	while ((outputCount < 1000) && (calls < 1000)) {
+		deviceRoom = 64; // the device played 64 samples since the last call
+		audioOut_run(&player, 0, &clockedDriver);
+		calls++;
+	}
+	int inOrder = (1000 == outputCount);
+	for (int i = 0; inOrder && (i < 1000); i++) inOrder = (output[i] == i);
+	snprintf(what, sizeof(what), "clocked driver: 1000 samples in %d calls, never more than its buffer takes", calls);
+	check(inOrder && (16 == calls) && (0 == player.underruns), what);
+
+	// stopping
+	audioOut_queue(&player, buf, 2000, 0);
+	audioOut_stop(&player);
+	outputCount = 0;
+	deviceRoom = 64;
+	audioOut_run(&player, 0, &clockedDriver);
+	int freed = true;
+	for (int i = 0; i < AUDIO_QUEUE_SIZE; i++) freed = freed && !player.buffers[i];
+	check((0 == outputCount) && !audioOut_queue(&player, buf, 2, 0) && freed,
+		"a stopped player outputs and accepts nothing and has freed its buffers");
+
+	check(!audioOut_start(&player, 8000, 12) && !audioOut_start(&player, AUDIO_MAX_RATE + 1, 8),
+		"unsupported formats are rejected");
+
+	return testSummary();
+}
@@ -0,0 +1,180 @@
+// bleLinkTests.c - Tests for the BLE IDE link buffering and pacing
+//
+// Checks the receive ring buffer, then streams data through bleLink_send() over a simulated
+// BLE link with a configurable MTU, connection interval, latency, stack buffer count, and
+// packet loss, verifying that every byte arrives in order and reporting the throughput.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "bleLink.h"
+#include "testHarness.h"
+
+static uint8 pattern(uint32 i) { return (i * 7) + (i >> 8); }
+
+// Receive ring buffer
+
+static void testRingBuffer() {
+	static BLELink link;
+	uint8 chunk[300], buf[BLE_LINK_RECV_SIZE];
+	uint32 written = 0, read = 0;
+	int ok = true;
+
+	bleLink_init(&link, 4, 10);
+	for (int round = 0; round < 60; round++) {
+		// write 300 bytes, read back 280, so the contents wrap around several times
+		for (int i = 0; i < 300; i++) chunk[i] = pattern(written + i);
+		if (bleLink_received(&link, chunk, 300) != 300) ok = false;
+		written += 300;
+		int n = bleLink_read(&link, buf, 280);
+		for (int i = 0; i < n; i++) {
+			if (buf[i] != pattern(read + i)) ok = false;
+		}
+		read += n;
+	}
+	check(ok && (link.overruns == 0), "ring buffer preserves order across wrap-around");
+
+	int free = BLE_LINK_RECV_SIZE - bleLink_available(&link);
+	for (int i = 0; i < 300; i++) chunk[i] = 0;
+	while (free >= 300) {
+		bleLink_received(&link, chunk, 300);
+		free -= 300;
+	}
+	int stored = bleLink_received(&link, chunk, 300);
+	check((stored == free) && (link.overruns == 1) && (bleLink_available(&link) == BLE_LINK_RECV_SIZE),
+		"ring buffer stores what fits and counts the overrun");
+}
+
+// Simulated link
+
+typedef struct {
+	const char *name;
+	int mtu;				// negotiated ATT MTU
+	int interval;			// msecs between connection events
+	int packetsPerEvent;	// notifications the radio can carry per connection event
+	int latency;			// msecs from transmission to delivery and confirmation
+	int stackBuffers;		// notifications the BLE stack can queue
+	int lossPercent;		// chance that a packet is lost and must be retransmitted
+	int confirms;			// true if the stack reports sent notifications
+	int minKBPerSec;		// throughput required to pass
+} SimConfig;
+
+#define MAX_PENDING 64
+#define TRANSFER_SIZE 65536
+
+typedef struct {
+	int length;
+	uint32 dueTime;
+	uint8 data[BLE_LINK_MAX_PAYLOAD];
+} Packet;
+
+typedef struct {
+	SimConfig *config;
+	Packet queue[MAX_PENDING];	// stack buffers (not yet transmitted)
+	int queueCount;
+	Packet inAir[MAX_PENDING];	// transmitted but not yet delivered
+	int inAirCount;
+	int confirmations;			// sent notifications to report to the sender
+} SimLink;
+
+static int simNotify(const uint8 *data, int byteCount, void *context) {
+	SimLink *sim = context;
+	if (sim->queueCount >= sim->config->stackBuffers) return false;
+	if (byteCount > (sim->config->mtu - 3)) return false; // would violate the MTU
+	Packet *p = &sim->queue[sim->queueCount++];
+	memcpy(p->data, data, byteCount);
+	p->length = byteCount;
+	return true;
+}
+
+static void connectionEvent(SimLink *sim, uint32 now) {
+	// Transmit queued packets. A lost packet is retransmitted in the next event, so later
+	// packets must wait for it.
+
+	int sent = 0;
+	while ((sent < sim->config->packetsPerEvent) && (sent < sim->queueCount)) {
+		if ((rand() % 100) < sim->config->lossPercent) break;
+		Packet *p = &sim->inAir[sim->inAirCount++];
+		*p = sim->queue[sent++];
+		p->dueTime = now + sim->config->latency;
+	}
+	memmove(sim->queue, &sim->queue[sent], (sim->queueCount - sent) * sizeof(Packet));
+	sim->queueCount -= sent;
+}
+
+static int deliver(SimLink *sim, BLELink *receiver, uint8 *expected, uint32 now) {
+	// Deliver packets that have arrived to the receiver and check their contents.
+	// Return the number of bytes delivered or -1 if the data was wrong.
+
+	static uint8 buf[BLE_LINK_MAX_PAYLOAD];
+	int delivered = 0, byteCount = 0;
+	while ((delivered < sim->inAirCount) && ((int) (now - sim->inAir[delivered].dueTime) >= 0)) {
+		Packet *p = &sim->inAir[delivered++];
+		bleLink_received(receiver, p->data, p->length);
+		int n = bleLink_read(receiver, buf, sizeof(buf));
+		if (0 != memcmp(buf, &expected[byteCount], n)) byteCount = -TRANSFER_SIZE;
+		byteCount += n;
+		if (sim->config->confirms) sim->confirmations++;
+	}
+	memmove(sim->inAir, &sim->inAir[delivered], (sim->inAirCount - delivered) * sizeof(Packet));
+	sim->inAirCount -= delivered;
+	return (byteCount < 0) ? -1 : byteCount;
+}
+
+static void runSimulation(SimConfig *config) {
+	static uint8 data[TRANSFER_SIZE];
+	static BLELink sender, receiver;
+	SimLink sim;
+
+	for (int i = 0; i < TRANSFER_SIZE; i++) data[i] = pattern(i);
+	memset(&sim, 0, sizeof(sim));
+	sim.config = config;
+	bleLink_init(&sender, BLE_LINK_MAX_WINDOW, 8);
+	bleLink_setMTU(&sender, config->mtu);
+	bleLink_init(&receiver, 1, 1);
+
+	uint32 start = 0xFFFFF000; // start just before the clock wraps
+	uint32 now = start;
+	int sent = 0, received = 0;
+	while ((received < TRANSFER_SIZE) && ((now - start) < 60000)) {
+		// the VM sends whatever bleLink_send() accepts each millisecond
+		while (sim.confirmations > 0) {
+			bleLink_sendComplete(&sender);
+			sim.confirmations--;
+		}
+		sent += bleLink_send(&sender, &data[sent], TRANSFER_SIZE - sent, now, simNotify, &sim);
+
+		if (0 == ((now - start) % config->interval)) connectionEvent(&sim, now);
+		int n = deliver(&sim, &receiver, &data[received], now);
+		if (n < 0) break;
+		received += n;
+		now++;
+	}
+	int msecs = now - start;
+	int kbPerSec = (received * 1000) / (1024 * msecs);
+	char what[200];
+	snprintf(what, sizeof(what), "%s: %d bytes in %d msecs (%d KB/s), %d packets, %d refusals, window %d",
+		config->name, received, msecs, kbPerSec, sender.packetsSent, sender.refusals, sender.window);
+	check((received == TRANSFER_SIZE) && (receiver.overruns == 0) && (kbPerSec >= config->minKBPerSec), what);
+}
+
+static SimConfig configs[] = {
+	// name								mtu	interval	pkts	latency	buffers	loss	confirms	min KB/s
+	{ "default MTU, slow interval",		23,		30,		4,		30,		4,		0,		false,		0 },
+	{ "large MTU, confirmations",		247,	8,		4,		8,		8,		0,		true,		50 },
+	{ "large MTU, time-based credits",	247,	8,		4,		8,		8,		0,		false,		50 },
+	{ "large MTU, few stack buffers",	247,	8,		4,		8,		2,		0,		false,		15 },
+	{ "max MTU, 10% loss",				517,	15,		6,		15,		6,		10,		true,		40 },
+};
+
+int main() {
+	testRingBuffer();
+	srand(12345);
+	printf("(the former fixed pacing of 250 bytes per 20 msecs allows at most 12 KB/s)\n");
+	for (int i = 0; i < (int) (sizeof(configs) / sizeof(SimConfig)); i++) {
+		runSimulation(&configs[i]);
+	}
+	return testSummary();
+}
@@ -0,0 +1,205 @@
+// dataLogTests.c - Tests for buffered binary data logging
+//
+// Logs records into a mock file system held in memory. The mock counts the writes, so the
+// tests can check that records are written in large blocks, and it can be made to fail
+// writes, like a full flash file system.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "dataLog.h"
+#include "testHarness.h"
+
+#define MOCK_FILES 20
+#define MOCK_FILE_BYTES 20000
+
+typedef struct {
+	char name[32];
+	uint8 data[MOCK_FILE_BYTES];
+	int size;
+} MockFile;
+
+static MockFile files[MOCK_FILES];
+static MockFile *openFile = NULL;
+static int appendCount = 0;
+static int writesFail = false;
+
+static MockFile *findFile(char *fileName) {
+	for (int i = 0; i < MOCK_FILES; i++) {
+		if (0 == strcmp(files[i].name, fileName)) return &files[i];
+	}
+	return NULL;
+}
+
+static int mockReadHeader(char *fileName, uint8 *buf, int byteCount) {
+	MockFile *f = findFile(fileName);
+	if (!f) return 0;
+	if (byteCount > f->size) byteCount = f->size;
+	memcpy(buf, f->data, byteCount);
+	return byteCount;
+}
+
+static int mockCreate(char *fileName) {
+	MockFile *f = findFile(fileName);
+	if (!f) f = findFile(""); // unused entry
+	if (!f || writesFail) return false;
+	strcpy(f->name, fileName);
+	f->size = 0;
+	openFile = f;
+	return true;
+}
+
+static int mockAppend(uint8 *data, int byteCount) {
+	if (!openFile || writesFail) return 0;
+	if ((openFile->size + byteCount) > MOCK_FILE_BYTES) byteCount = MOCK_FILE_BYTES - openFile->size;
+	memcpy(&openFile->data[openFile->size], data, byteCount);
+	openFile->size += byteCount;
+	appendCount++;
+	return byteCount;
+}
+
+static void mockClose() {
+	openFile = NULL;
+}
+
+static DataLogDriver mockDriver = { mockReadHeader, mockCreate, mockAppend, mockClose };
+
+static int getInt(uint8 *src, int byteCount) {
+	// read a signed little-endian integer
+	uint32 n = 0;
+	for (int i = byteCount - 1; i >= 0; i--) n = (n << 8) | src[i];
+	if (2 == byteCount) return (short) n;
+	return (int) n;
+}
+
+static int checkRecords(MockFile *f, int valueCount, int valueBytes, int firstRecord, int *recordCount) {
+	// Check that the records in f hold timestamp = record number and values
+	// (record number * 3) + value index. Set recordCount and return the number of
+	// records that are wrong.
+
+	int recordBytes = 4 + (valueCount * valueBytes);
+	int errors = 0;
+	*recordCount = (f->size - DATA_LOG_HEADER_BYTES) / recordBytes;
+	for (int r = 0; r < *recordCount; r++) {
+		uint8 *p = &f->data[DATA_LOG_HEADER_BYTES + (r * recordBytes)];
+		int n = firstRecord + r;
+		int ok = (getInt(p, 4) == n);
+		for (int v = 0; v < valueCount; v++) {
+			if (getInt(p + 4 + (v * valueBytes), valueBytes) != ((n * 3) + v)) ok = false;
+		}
+		if (!ok) errors++;
+	}
+	return errors;
+}
+
+static void logRecords(DataLog *log, int first, int count) {
+	int values[DATA_LOG_MAX_VALUES];
+	for (int n = first; n < (first + count); n++) {
+		for (int v = 0; v < DATA_LOG_MAX_VALUES; v++) values[v] = (n * 3) + v;
+		dataLog_add(log, n, values, DATA_LOG_MAX_VALUES, &mockDriver);
+	}
+}
+
+int main() {
+	DataLog log;
+	memset(&log, 0, sizeof(log));
+	memset(files, 0, sizeof(files));
+	char what[200];
+
+	// records are buffered in RAM and written in whole blocks
+	check(dataLog_start(&log, "log", 3, 4, 4, 10000, 1024, &mockDriver), "start a log of three 4-byte values in four files");
+	appendCount = 0;
+	logRecords(&log, 0, 100); // 100 records of 16 bytes; 64 records per block
+	MockFile *f = findFile("log0.bin");
+	int recordCount;
+	int errors = checkRecords(f, 3, 4, 0, &recordCount);
+	snprintf(what, sizeof(what), "100 records: %d write(s), %d records in the file before flushing", appendCount, recordCount);
+	check((1 == appendCount) && (64 == recordCount) && (0 == errors), what);
+	dataLog_flush(&log, &mockDriver);
+	errors = checkRecords(f, 3, 4, 0, &recordCount);
+	check((100 == recordCount) && (0 == errors), "after flushing, all 100 records are in the file");
+
+	uint8 *h = f->data;
+	check((0 == memcmp(h, "MBLG", 4)) && (1 == h[4]) && (3 == h[5]) && (4 == h[6]) && (1 == getInt(&h[8], 4)) && (16 == getInt(&h[12], 4)),
+		"the file header describes the record layout");
+
+	// a record waits in RAM no longer than flushMsecs
+	appendCount = 0;
+	logRecords(&log, 100, 1);
+	logRecords(&log, 100 + DATA_LOG_FLUSH_MSECS, 1);
+	check(1 == appendCount, "a slow log is flushed when its oldest record is flushMsecs old");
+
+	// the VM loop flushes a log that has stopped adding records
+	appendCount = 0;
+	logRecords(&log, 200, 1);
+	dataLog_flushIfDue(&log, 200 + DATA_LOG_FLUSH_MSECS - 1, &mockDriver);
+	int waited = (0 == appendCount);
+	dataLog_flushIfDue(&log, 200 + DATA_LOG_FLUSH_MSECS, &mockDriver);
+	check(waited && (1 == appendCount), "flushIfDue writes the buffer once its oldest record is flushMsecs old");
+	dataLog_stop(&log, &mockDriver);
+
+	// files rotate, replacing the oldest; records are never split across files
+	memset(files, 0, sizeof(files));
+	dataLog_start(&log, "log", 2, 2, 3, 16 + (4 * 800), 800, &mockDriver); // 8-byte records, 4 blocks per file
+	logRecords(&log, 0, 5000);
+	dataLog_stop(&log, &mockDriver);
+	int indices[DATA_LOG_MAX_FILES];
+	int fileCount = dataLog_filesInOrder(&log, indices);
+	int total = 0, consecutive = (3 == fileCount);
+	int next = -1;
+	for (int i = 0; consecutive && (i < fileCount); i++) {
+		char fileName[32];
+		dataLog_fileName(&log, indices[i], fileName, sizeof(fileName));
+		f = findFile(fileName);
+		int start = getInt(&f->data[DATA_LOG_HEADER_BYTES], 4);
+		if ((next >= 0) && (start != next)) consecutive = false;
+		if (checkRecords(f, 2, 2, start, &recordCount)) consecutive = false;
+		next = start + recordCount;
+		total += recordCount;
+	}
+	snprintf(what, sizeof(what), "5000 records in three rotating files: the newest %d kept, consecutive, ending with the last", total);
+	check(consecutive && (5000 == next) && (total >= 800), what);
+
+	// 16-bit values are clipped
+	memset(files, 0, sizeof(files));
+	dataLog_start(&log, "clip", 2, 2, 1, 1000, 100, &mockDriver);
+	int big[] = {100000, -100000};
+	dataLog_add(&log, 0, big, 2, &mockDriver);
+	dataLog_stop(&log, &mockDriver);
+	f = findFile("clip0.bin");
+	check((32767 == getInt(&f->data[20], 2)) && (-32768 == getInt(&f->data[22], 2)), "16-bit values are clipped");
+
+	// restarting continues after the newest file
+	memset(files, 0, sizeof(files));
+	dataLog_start(&log, "log", 1, 4, 4, 1000, 100, &mockDriver);
+	logRecords(&log, 0, 10);
+	dataLog_stop(&log, &mockDriver);
+	dataLog_start(&log, "log", 1, 4, 4, 1000, 100, &mockDriver);
+	logRecords(&log, 10, 10);
+	dataLog_stop(&log, &mockDriver);
+	fileCount = dataLog_filesInOrder(&log, indices);
+	check((2 == fileCount) && (0 == indices[0]) && (1 == indices[1]) && (2 == getInt(&findFile("log1.bin")->data[8], 4)),
+		"restarting starts a new file after the newest one");
+
+	// failed writes drop records, but logging continues
+	memset(files, 0, sizeof(files));
+	dataLog_start(&log, "log", 1, 4, 2, 10000, 80, &mockDriver); // 10 records per block
+	writesFail = true;
+	logRecords(&log, 0, 25);
+	writesFail = false;
+	logRecords(&log, 25, 15);
+	dataLog_stop(&log, &mockDriver);
+	snprintf(what, sizeof(what), "while writes fail, records are dropped (%d of 40) and logging continues",
+		(int) log.recordsDropped);
+	check((20 == log.recordsDropped) && (40 == log.recordsLogged), what);
+
+	check(!dataLog_start(&log, "log", 0, 4, 2, 10000, 100, &mockDriver) &&
+		!dataLog_start(&log, "log", 2, 3, 2, 10000, 100, &mockDriver) &&
+		!dataLog_start(&log, "log", 2, 4, 2, 100, 1000, &mockDriver) &&
+		!dataLog_add(&log, 0, big, 2, &mockDriver),
+		"bad arguments are rejected; a stopped log records nothing");
+
+	return testSummary();
+}
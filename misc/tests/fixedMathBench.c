@@ -0,0 +1,105 @@
+// fixedMathBench.c - Accuracy and speed of the integer math used by the vector primitives
+//
+// Compares fixedSine(), fixedSqrt(), and fixedAtan2() against the floating point formulas
+// used by the scalar misc:sin, misc:sqrt, and misc:atan2 primitives.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fixedMath.h"
+#include "testHarness.h"
+
+// Reference versions (same formulas as the scalar primitives in miscPrims.c)
+
+static int floatSine(int angle) {
+	const float hundrethsToRadians = 6.2831853071795864769 / 36000.0;
+	return (int) round(16384.0 * sin(angle * hundrethsToRadians));
+}
+
+static int floatSqrt(int n) {
+	if (n < 0) n = -n;
+	return (int) round(sqrt(n));
+}
+
+static int floatAtan2(int y, int x) {
+	return (int) round((18000.0 * atan2((double) y, (double) x)) / 3.141592653589793238463);
+}
+
+static double seconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1.0e9);
+}
+
+#define N 2000000
+static int xs[N], ys[N], out[N];
+static volatile int sink;
+
+static int maxError(int *a, int *b, int count) {
+	int result = 0;
+	for (int i = 0; i < count; i++) {
+		int d = abs(a[i] - b[i]);
+		if (d > result) result = d;
+	}
+	return result;
+}
+
+int main() {
+	char what[200];
+	int *ref = malloc(N * sizeof(int));
+	double t0, fixedTime, floatTime;
+	int err;
+
+	srand(42);
+
+	// sine over several full turns, both directions
+	for (int i = 0; i < N; i++) xs[i] = (i % 144001) - 72000;
+	t0 = seconds();
+	for (int i = 0; i < N; i++) out[i] = fixedSine(xs[i]);
+	fixedTime = seconds() - t0;
+	t0 = seconds();
+	for (int i = 0; i < N; i++) ref[i] = floatSine(xs[i]);
+	floatTime = seconds() - t0;
+	err = maxError(out, ref, N);
+	snprintf(what, sizeof(what), "sine:  max error %d, fixed %.1f ns/op, float %.1f ns/op",
+		err, 1.0e9 * fixedTime / N, 1.0e9 * floatTime / N);
+	check((err <= 1), what);
+
+	// square root over the full positive integer range
+	for (int i = 0; i < N; i++) xs[i] = (int) ((1073741823.0 * i) / N);
+	t0 = seconds();
+	for (int i = 0; i < N; i++) out[i] = fixedSqrt(xs[i]);
+	fixedTime = seconds() - t0;
+	t0 = seconds();
+	for (int i = 0; i < N; i++) ref[i] = floatSqrt(xs[i]);
+	floatTime = seconds() - t0;
+	err = maxError(out, ref, N);
+	snprintf(what, sizeof(what), "sqrt:  max error %d, fixed %.1f ns/op, float %.1f ns/op",
+		err, 1.0e9 * fixedTime / N, 1.0e9 * floatTime / N);
+	check((err == 0), what);
+
+	// arctangent of random vectors (+/-18000 both mean the negative x axis)
+	for (int i = 0; i < N; i++) {
+		xs[i] = (rand() % 2000001) - 1000000;
+		ys[i] = (rand() % 2000001) - 1000000;
+	}
+	t0 = seconds();
+	for (int i = 0; i < N; i++) out[i] = fixedAtan2(ys[i], xs[i]);
+	fixedTime = seconds() - t0;
+	t0 = seconds();
+	for (int i = 0; i < N; i++) ref[i] = floatAtan2(ys[i], xs[i]);
+	floatTime = seconds() - t0;
+	for (int i = 0; i < N; i++) {
+		if ((abs(out[i]) == 18000) && (abs(ref[i]) == 18000)) out[i] = ref[i];
+	}
+	err = maxError(out, ref, N);
+	snprintf(what, sizeof(what), "atan2: max error %d, fixed %.1f ns/op, float %.1f ns/op",
+		err, 1.0e9 * fixedTime / N, 1.0e9 * floatTime / N);
+	check((err <= 1), what);
+
+	sink = out[N / 2];
+	free(ref);
+	return testSummary();
+}
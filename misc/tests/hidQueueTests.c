@@ -0,0 +1,151 @@
+// hidQueueTests.c - Tests for the HID report queue and scheduler
+//
+// Runs the queue against a mock HID sink that simulates a USB host polling the HID endpoint
+// once per millisecond. The sink records every report with its time and checks that no
+// report is sent before the previous one was taken by the host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "hidQueue.h"
+#include "testHarness.h"
+
+#define POLL_INTERVAL 1000 // usecs between host polls of the HID endpoint
+#define MAX_REPORTS 2000
+
+typedef struct {
+	HIDAction action;
+	uint32 time;
+} Report;
+
+static Report reports[MAX_REPORTS];
+static int reportCount = 0;
+static uint32 now = 0;			// simulated time in usecs
+static uint32 nextPoll = 0;		// time when the host takes the pending report
+static int pending = false;		// true if a report is waiting for the host
+static int overruns = 0;		// reports sent while the previous one was still pending
+
+static int mockReady() {
+	if (pending && ((int) (now - nextPoll) >= 0)) pending = false; // host took the report
+	return !pending;
+}
+
+static void mockSend(HIDAction *action) {
+	if (pending) overruns++;
+	if (reportCount < MAX_REPORTS) {
+		reports[reportCount].action = *action;
+		reports[reportCount].time = now;
+		reportCount++;
+	}
+	pending = true;
+	nextPoll = now + POLL_INTERVAL;
+}
+
+static HIDSink mockSink = { mockReady, mockSend };
+
+static void reset(HIDQueue *q) {
+	hidQueue_init(q, POLL_INTERVAL);
+	reportCount = 0;
+	pending = false;
+	overruns = 0;
+}
+
+static void drain(HIDQueue *q) {
+	// Run the scheduler every 100 usecs, as the VM loop does, until the queue is empty.
+
+	while (q->count > 0) {
+		hidQueue_run(q, now, &mockSink);
+		now += 100;
+	}
+}
+
+static int isKey(int i, int type, int key) {
+	return (i < reportCount) && (reports[i].action.type == type) && (reports[i].action.key == key);
+}
+
+int main() {
+	static HIDQueue q;
+	char what[200];
+
+	// typing produces a press and a release per character, including repeated characters
+	reset(&q);
+	int queued = hidQueue_typeString(&q, "aab", 0);
+	drain(&q);
+	check((3 == queued) && (6 == reportCount) &&
+		isKey(0, hid_KeyPress, 'a') && isKey(1, hid_KeyRelease, 'a') &&
+		isKey(2, hid_KeyPress, 'a') && isKey(3, hid_KeyRelease, 'a') &&
+		isKey(4, hid_KeyPress, 'b') && isKey(5, hid_KeyRelease, 'b'),
+		"repeated characters are separate key strokes");
+
+	// the count is in characters, as used by the library's text functions
+	reset(&q);
+	queued = hidQueue_typeString(&q, "a\xC3\xA9" "b", 0); // "aéb"
+	drain(&q);
+	check((3 == queued) && (4 == reportCount) && isKey(0, hid_KeyPress, 'a') && isKey(2, hid_KeyPress, 'b'),
+		"typing returns a character count; non-ASCII characters are skipped");
+
+	// a modifier is held for the whole string
+	reset(&q);
+	hidQueue_typeString(&q, "cv", 0x80);
+	drain(&q);
+	check((6 == reportCount) && isKey(0, hid_KeyPress, 0x80) &&
+		isKey(1, hid_KeyPress, 'c') && isKey(4, hid_KeyRelease, 'v') &&
+		(reports[5].action.type == hid_ReleaseAllKeys),
+		"modifier key is pressed first and released last");
+
+	// long mouse moves are split into steps that fit into a report
+	reset(&q);
+	hidQueue_mouseMove(&q, 300, -50);
+	hidQueue_mouseMove(&q, 5, 5);
+	drain(&q);
+	int sumX = 0, sumY = 0, fits = true;
+	for (int i = 0; i < 3; i++) {
+		sumX += reports[i].action.dx;
+		sumY += reports[i].action.dy;
+		if ((abs(reports[i].action.dx) > 127) || (abs(reports[i].action.dy) > 127)) fits = false;
+	}
+	check((4 == reportCount) && fits && (300 == sumX) && (-50 == sumY) &&
+		(5 == reports[3].action.dx) && (5 == reports[3].action.dy),
+		"mouse path is split into report-sized steps in order");
+
+	// typing speed is limited only by the host polling rate
+	reset(&q);
+	char text[101];
+	for (int i = 0; i < 100; i++) text[i] = 'a' + (i % 3);
+	text[100] = '\0';
+	text[50] = text[51] = 'x'; // one repeated character
+	uint32 start = now;
+	hidQueue_typeString(&q, text, 0);
+	drain(&q);
+	uint32 elapsed = now - start;
+	int minGap = 1000000;
+	for (int i = 1; i < reportCount; i++) {
+		int gap = reports[i].time - reports[i - 1].time;
+		if (gap < minGap) minGap = gap;
+	}
+	snprintf(what, sizeof(what),
+		"100 characters: %d reports in %d msecs, min gap %d usecs, %d overruns (was over 1200 msecs)",
+		reportCount, elapsed / 1000, minGap, overruns);
+	check((200 == reportCount) && (0 == overruns) && (minGap >= POLL_INTERVAL) && (elapsed < 250000), what);
+
+	// a string that doesn't fit is queued in part; the rest can be queued later
+	reset(&q);
+	char longText[401];
+	memset(longText, 'z', 400);
+	longText[400] = '\0';
+	int first = hidQueue_typeString(&q, longText, 0);
+	drain(&q);
+	int second = hidQueue_typeString(&q, &longText[first], 0);
+	drain(&q);
+	snprintf(what, sizeof(what), "queue full: %d then %d characters queued, %d reports", first, second, reportCount);
+	check((first < 400) && ((first + second) == 400) && (800 == reportCount), what);
+
+	// the queue is allocated once
+	HIDAction *actions = q.actions;
+	reset(&q);
+	check(actions && (q.actions == actions), "reinitializing the queue keeps its actions");
+
+	return testSummary();
+}
@@ -0,0 +1,128 @@
+// httpResponseTests.c - Tests for the streaming HTTP response decoder
+//
+// Runs a tiny HTTP stand-in server on the loopback interface and reads its responses
+// through http_decode() using a small buffer, as the httpReadInto primitive does.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "httpResponse.h"
+#include "testHarness.h"
+
+static const char *responses[] = {
+	// Content-Length body followed by junk that must be ignored
+	"HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 13\r\n\r\nHello, World!JUNK",
+
+	// chunked body with a chunk extension and a trailer
+	"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nX-Test: yes\r\n\r\n"
+	"7\r\nHello, \r\n6;ext=1\r\nWorld!\r\n0\r\nX-Trailer: done\r\n\r\n",
+
+	// interim response followed by a body that ends when the connection closes
+	"HTTP/1.1 100 Continue\r\n\r\nHTTP/1.0 404 Not Found\r\nServer: stand-in\r\n\r\nNo such page",
+
+	// empty body
+	"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n",
+};
+
+static const char *expectedBodies[] = { "Hello, World!", "Hello, World!", "No such page", "" };
+static const int expectedStatus[] = { 200, 200, 404, 204 };
+
+#define RESPONSE_COUNT (sizeof(responses) / sizeof(char *))
+
+static void runServer(int serverSocket) {
+	// Serve each canned response once, a few bytes at a time to exercise partial reads.
+
+	for (int i = 0; i < RESPONSE_COUNT; i++) {
+		int client = accept(serverSocket, NULL, NULL);
+		if (client < 0) exit(1);
+		const char *p = responses[i];
+		int remaining = strlen(p);
+		while (remaining > 0) {
+			int n = (remaining < 5) ? remaining : 5;
+			if (write(client, p, n) != n) break;
+			p += n;
+			remaining -= n;
+			usleep(200);
+		}
+		close(client);
+	}
+	exit(0);
+}
+
+static int openServer(int *port) {
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0; // let the system pick a port
+	if (bind(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) return -1;
+	listen(s, RESPONSE_COUNT);
+	socklen_t len = sizeof(addr);
+	getsockname(s, (struct sockaddr *) &addr, &len);
+	*port = ntohs(addr.sin_port);
+	return s;
+}
+
+static int fetch(int port, HttpResponse *r, char *body, int bodySize) {
+	// Read one response into body using a 7-byte buffer. Return the body size.
+
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (connect(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) return -1;
+
+	unsigned char buf[7];
+	int total = 0;
+	http_initResponse(r);
+	while (!http_isDone(r)) {
+		int n = read(s, buf, sizeof(buf));
+		if (n <= 0) break; // closed by server
+		int bodyCount = http_decode(r, buf, n);
+		if ((total + bodyCount) < bodySize) memcpy(&body[total], buf, bodyCount);
+		total += bodyCount;
+	}
+	close(s);
+	body[(total < bodySize) ? total : bodySize - 1] = '\0';
+	return total;
+}
+
+int main() {
+	int port;
+	int serverSocket = openServer(&port);
+	if (serverSocket < 0) {
+		printf("Could not start stand-in server\n");
+		return 1;
+	}
+	pid_t server = fork();
+	if (0 == server) runServer(serverSocket);
+	close(serverSocket);
+
+	char what[200];
+	for (int i = 0; i < RESPONSE_COUNT; i++) {
+		HttpResponse r;
+		char body[100];
+		fetch(port, &r, body, sizeof(body));
+		snprintf(what, sizeof(what), "response %d: status %d, content length %d, body \"%s\"",
+			i + 1, r.status, r.contentLength, body);
+		check((r.status == expectedStatus[i]) && (0 == strcmp(body, expectedBodies[i])), what);
+		if (1 == i) {
+			char value[20];
+			http_header(&r, "x-test", value, sizeof(value));
+			snprintf(what, sizeof(what), "response 2: X-Test header: %s", value);
+			check(0 == strcmp(value, "yes"), what);
+		}
+	}
+	waitpid(server, NULL, 0);
+
+	return testSummary();
+}
@@ -0,0 +1,153 @@
+// inputTraceTests.c - Tests for recording and replaying VM inputs
+//
+// Records pin samples, a byte stream, and file results against a simulated clock, then
+// replays the trace while polling at a different rate and checks that the program sees
+// the same inputs at the same times. A round trip with a virtual clock that advances on
+// every read, as in linux.c, checks that a program sees each input at the same point.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mem.h"
+#include "inputTrace.h"
+#include "testHarness.h"
+
+#define TRACE_FILE "/tmp/inputTraceTest.trace"
+
+static uint64 now = 0; // simulated time in usecs
+static int ticking = false; // true to advance the clock on every read, like virtual time
+
+int useVirtualTime = true;
+
+uint64 totalMicrosecs() { return ticking ? ++now : now; }
+
+static int pinValue(uint64 t) { return (t >= 5000) && (t < 8000); }
+
+static const char *streamData(uint64 t) {
+	// data that arrives on the simulated serial port at time t, if any
+	if (2000 == t) return "hello";
+	if (7000 == t) return "world!";
+	return NULL;
+}
+
+static void record() {
+	inputTrace_record(TRACE_FILE);
+	for (now = 0; now <= 10000; now += 100) {
+		inputTrace_sample(trace_DigitalRead, 3, pinValue(now));
+		inputTrace_sample(trace_AnalogRead, 1, 512);
+		const char *s = streamData(now);
+		inputTrace_stream(trace_IDEInput, (uint8 *) s, s ? (int) strlen(s) : -1, 100);
+		if (3000 == now) {
+			inputTrace_result(trace_FileRead, (uint8 *) "line 1\n", 7, 800);
+			inputTrace_result(trace_FileRead, (uint8 *) "", 0, 800);
+			inputTrace_resultInt(trace_FileStatus, 12345);
+		}
+	}
+	inputTrace_finish();
+}
+
+static uint32 runProgram(int live) {
+	// A program whose path depends on its inputs: it reads a second pin only while the first
+	// one is high. Return a checksum of the values it saw. live selects the live pin values:
+	// a signal that changes over time, or a constant.
+
+	uint32 sum = 0;
+	for (int i = 0; i < 500; i++) {
+		int button = inputTrace_sample(trace_DigitalRead, 4, live ? ((now / 100) & 1) : 0);
+		if (button) sum = (sum * 31) + inputTrace_sample(trace_AnalogRead, 2, live ? (int) (now % 1024) : 0);
+		sum = (sum * 31) + button;
+	}
+	return sum;
+}
+
+static long fileSize(const char *fileName) {
+	FILE *f = fopen(fileName, "rb");
+	if (!f) return -1;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+int main() {
+	char what[200];
+
+	record();
+	long size = fileSize(TRACE_FILE);
+	snprintf(what, sizeof(what), "trace of 101 polls of two pins, a stream, and file results is %ld bytes", size);
+	check((size > 0) && (size < 80), what);
+
+	// replay, polling at a different rate and with different live values
+	check(inputTrace_replay(TRACE_FILE), "trace can be opened for replay");
+	int samplesOK = true;
+	char received[100];
+	int receivedCount = 0;
+	uint64 helloTime = 0, worldTime = 0;
+	for (now = 0; now <= 10000; now += 37) {
+		if (inputTrace_sample(trace_DigitalRead, 3, 99) != pinValue(now)) samplesOK = false;
+		if (inputTrace_sample(trace_AnalogRead, 1, 0) != 512) samplesOK = false;
+		uint8 buf[4];
+		errno = 0;
+		int n = inputTrace_stream(trace_IDEInput, buf, 0, sizeof(buf));
+		if (n > 0) {
+			if (!helloTime) helloTime = now;
+			if ((receivedCount >= 5) && !worldTime) worldTime = now;
+			memcpy(&received[receivedCount], buf, n);
+			receivedCount += n;
+		} else if ((n < 0) && (EAGAIN != errno)) {
+			samplesOK = false;
+		}
+	}
+	check(samplesOK, "pin samples replay the recorded value at each time");
+	received[receivedCount] = '\0';
+	snprintf(what, sizeof(what), "stream replays \"%s\", starting at %d and %d usecs",
+		received, (int) helloTime, (int) worldTime);
+	check((0 == strcmp(received, "helloworld!")) && (helloTime >= 2000) && (helloTime < 2037) &&
+		(worldTime >= 7000) && (worldTime < 7037), what);
+
+	uint8 line[800];
+	int n1 = inputTrace_result(trace_FileRead, line, 0, sizeof(line));
+	int ok1 = (7 == n1) && (0 == memcmp(line, "line 1\n", 7));
+	int n2 = inputTrace_result(trace_FileRead, line, 5, sizeof(line));
+	int status = inputTrace_resultInt(trace_FileStatus, -1);
+	int n3 = inputTrace_result(trace_FileRead, line, 9, sizeof(line)); // not in the trace
+	check(ok1 && (0 == n2) && (12345 == status) && (9 == n3), "results replay in order; extra calls get live values");
+	inputTrace_finish();
+
+	// a trace cut off in the middle of a record still replays the complete records
+	FILE *f = fopen(TRACE_FILE, "r+b");
+	if (f) {
+		if (0 != ftruncate(fileno(f), size - 2)) size = 0;
+		fclose(f);
+	}
+	check(inputTrace_replay(TRACE_FILE), "truncated trace can be opened");
+	now = 6000;
+	check(1 == inputTrace_sample(trace_DigitalRead, 3, 0), "truncated trace replays earlier records");
+	inputTrace_finish();
+
+	// round trip with virtual time: the program sees the same inputs at the same points
+	ticking = true;
+	now = 0;
+	inputTrace_record(TRACE_FILE);
+	uint32 recorded = runProgram(true);
+	inputTrace_finish();
+	now = 0;
+	inputTrace_replay(TRACE_FILE);
+	uint32 replayed = runProgram(false);
+	inputTrace_finish();
+	check((recorded == replayed) && (recorded != runProgram(false)),
+		"round trip with virtual time: the program sees the recorded inputs at the same points");
+	ticking = false;
+
+	// recording and replaying require virtual time
+	useVirtualTime = false;
+	int realClockRejected = !inputTrace_record(TRACE_FILE) && !inputTrace_replay(TRACE_FILE);
+	useVirtualTime = true;
+	check(realClockRejected && (trace_Off == inputTrace_mode()), "recording and replaying without virtual time are rejected");
+
+	remove(TRACE_FILE);
+	return testSummary();
+}
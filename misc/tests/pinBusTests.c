@@ -0,0 +1,208 @@
+// pinBusTests.c - Tests for pin groups and parallel and shifted bus output
+//
+// Runs the pin bus against a mock driver with 64 pins on two 32-bit ports. The mock
+// records pin transitions and samples the bus on each rising clock or strobe edge, as a
+// shift register or parallel LCD would.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "pinBus.h"
+#include "testHarness.h"
+
+#define MOCK_PINS 64
+#define MAX_SAMPLES 1000
+
+static int level[MOCK_PINS];
+static int mode[MOCK_PINS];			// 1 = output, 2 = input
+static int transitions = 0;
+static int driverCalls = 0;			// setPin, getPin, writePort, and readPort calls
+
+static int clockPin = -1;			// sample on rising edges of this pin
+static PinGroup *sampledGroup;		// if not NULL, sample this group; otherwise dataPin
+static int dataPin = -1;
+static int samples[MAX_SAMPLES];
+static int sampleCount = 0;
+
+static void resetMock() {
+	memset(level, 0, sizeof(level));
+	memset(mode, 0, sizeof(mode));
+	transitions = driverCalls = sampleCount = 0;
+	clockPin = dataPin = -1;
+	sampledGroup = NULL;
+}
+
+static int groupValue(PinGroup *group) {
+	int result = 0;
+	for (int i = 0; i < group->pinCount; i++) result |= level[group->pins[i]] << i;
+	return result;
+}
+
+static void setLevel(int pin, int value) {
+	if (value == level[pin]) return;
+	level[pin] = value;
+	transitions++;
+	if ((pin == clockPin) && value && (sampleCount < MAX_SAMPLES)) {
+		samples[sampleCount++] = sampledGroup ? groupValue(sampledGroup) : level[dataPin];
+	}
+}
+
+static void setMode(int pin, int newMode) {
+	// Like the platform, report pin mode changes to the pin bus.
+
+	if (newMode == mode[pin]) return;
+	mode[pin] = newMode;
+	pinBus_modeChanged();
+}
+
+static void mockSetPin(int pin, int value) {
+	driverCalls++;
+	setMode(pin, 1);
+	setLevel(pin, value);
+}
+
+static int mockGetPin(int pin) {
+	driverCalls++;
+	setMode(pin, 2);
+	return level[pin];
+}
+
+static int mockMapPort(PinGroup *group) {
+	// pins 0-31 are on port 0 and 32-63 on port 1
+	int port = group->pins[0] / 32;
+	for (int i = 0; i < group->pinCount; i++) {
+		if ((group->pins[i] / 32) != port) return false;
+		group->bitMasks[i] = 1U << (group->pins[i] % 32);
+	}
+	group->port = (void *) (long) port;
+	return true;
+}
+
+static void mockWritePort(PinGroup *group, uint32 setMask, uint32 clearMask) {
+	driverCalls++;
+	int base = 32 * (int) (long) group->port;
+	for (int i = 0; i < 32; i++) {
+		if ((setMask >> i) & 1) setLevel(base + i, 1);
+	}
+	for (int i = 0; i < 32; i++) {
+		if ((clearMask >> i) & 1) setLevel(base + i, 0);
+	}
+}
+
+static uint32 mockReadPort(PinGroup *group) {
+	driverCalls++;
+	int base = 32 * (int) (long) group->port;
+	uint32 result = 0;
+	for (int i = 0; i < 32; i++) result |= level[base + i] << i;
+	return result;
+}
+
+static PinBusDriver pinDriver = { mockSetPin, mockGetPin, NULL, NULL, NULL };
+static PinBusDriver portDriver = { mockSetPin, mockGetPin, mockMapPort, mockWritePort, mockReadPort };
+
+int main() {
+	PinGroup group;
+	char what[200];
+
+	// a group of scattered pins, written and read one pin at a time
+	resetMock();
+	int scattered[] = {3, 5, 7, 2};
+	pinBus_define(&group, scattered, 4, &pinDriver);
+	pinBus_write(&group, 10, &pinDriver);
+	check(!level[3] && level[5] && !level[7] && level[2] && (10 == (int) pinBus_read(&group, &pinDriver)),
+		"bit i of the value goes to the ith pin of the group");
+
+	// consecutive port pins are written with a single shifted port write
+	resetMock();
+	int lcdBus[] = {8, 9, 10, 11, 12, 13, 14, 15};
+	pinBus_define(&group, lcdBus, 8, &portDriver);
+	pinBus_write(&group, 0xA5, &portDriver); // first write sets the pin modes
+	int modesSet = (1 == mode[8]) && (1 == mode[15]);
+	driverCalls = 0;
+	pinBus_write(&group, 0x3C, &portDriver);
+	snprintf(what, sizeof(what), "consecutive pins use shift %d and %d driver call(s) per write", group.shift, driverCalls);
+	check(group.usePort && (8 == group.shift) && modesSet && (1 == driverCalls) && (0x3C == groupValue(&group)), what);
+
+	level[9] = 1; // an external device drives the bus
+	int value = pinBus_read(&group, &portDriver);
+	check((0x3E == value) && (2 == mode[8]), "reading a port group switches its pins to inputs");
+
+	// a plain digital read or write of a group pin changes its mode behind the group's back
+	resetMock();
+	pinBus_define(&group, lcdBus, 8, &portDriver);
+	pinBus_write(&group, 0xFF, &portDriver);
+	mockGetPin(10); // digitalRead
+	pinBus_write(&group, 0x0F, &portDriver);
+	int afterRead = (1 == mode[10]) && (0x0F == groupValue(&group));
+	pinBus_read(&group, &portDriver);
+	mockSetPin(12, 1); // digitalWrite
+	level[12] = 0; // an external device drives the bus
+	int afterWrite = (0 == (pinBus_read(&group, &portDriver) & 0x10)) && (2 == mode[12]);
+	check(afterRead && afterWrite, "a group sets its pin modes again after a plain digital read or write of one of its pins");
+
+	// out of order pins on one port use per-bit masks
+	resetMock();
+	int reordered[] = {4, 2, 9};
+	pinBus_define(&group, reordered, 3, &portDriver);
+	pinBus_write(&group, 5, &portDriver);
+	check(group.usePort && (group.shift < 0) && level[4] && !level[2] && level[9] &&
+		(5 == (int) pinBus_read(&group, &portDriver)), "out of order pins use per-bit port masks");
+
+	// pins on two ports can't use a port write
+	resetMock();
+	int twoPorts[] = {30, 31, 32, 33};
+	pinBus_define(&group, twoPorts, 4, &portDriver);
+	pinBus_write(&group, 9, &portDriver);
+	check(!group.usePort && level[30] && !level[31] && !level[32] && level[33],
+		"group spanning two ports falls back to pin writes");
+
+	// writing a byte array with a strobe
+	resetMock();
+	uint8 text[] = "Hello, LCD!";
+	int textLen = strlen((char *) text);
+	pinBus_define(&group, lcdBus, 8, &portDriver);
+	clockPin = 20;
+	sampledGroup = &group;
+	pinBus_writeBytes(&group, text, textLen, 20, 1, &portDriver);
+	int strobedOK = (textLen == sampleCount) && !level[20];
+	for (int i = 0; strobedOK && (i < textLen); i++) strobedOK = (samples[i] == text[i]);
+	snprintf(what, sizeof(what), "parallel write of %d bytes: each byte is on the bus at its strobe (%d driver calls)",
+		textLen, driverCalls);
+	check(strobedOK, what);
+
+	// shifting out bytes, most significant bit first and least significant bit first
+	for (int msbFirst = 1; msbFirst >= 0; msbFirst--) {
+		resetMock();
+		uint8 bytes[] = {0x81, 0x5A, 0x00, 0xFF};
+		clockPin = 40;
+		dataPin = 41;
+		pinBus_shiftOut(41, 40, bytes, 4, msbFirst, &portDriver);
+		int shiftedOK = (32 == sampleCount) && !level[40];
+		for (int i = 0; shiftedOK && (i < 32); i++) {
+			int bitIndex = msbFirst ? (7 - (i % 8)) : (i % 8);
+			shiftedOK = (samples[i] == ((bytes[i / 8] >> bitIndex) & 1));
+		}
+		snprintf(what, sizeof(what), "shift out %s first: 32 bits clocked in order, clock left low (%d driver calls)",
+			msbFirst ? "MSB" : "LSB", driverCalls);
+		check(shiftedOK, what);
+	}
+
+	// driver calls for 100 bytes on an 8-bit parallel bus, compared with pin writes
+	uint8 data[100];
+	for (int i = 0; i < 100; i++) data[i] = i * 37;
+	resetMock();
+	pinBus_define(&group, lcdBus, 8, &portDriver);
+	pinBus_writeBytes(&group, data, 100, 20, 1, &portDriver);
+	int portCalls = driverCalls;
+	resetMock();
+	pinBus_define(&group, lcdBus, 8, &pinDriver);
+	pinBus_writeBytes(&group, data, 100, 20, 1, &pinDriver);
+	int pinCalls = driverCalls;
+	snprintf(what, sizeof(what), "100 bytes on an 8-bit bus: %d driver calls with port masks, %d with pin writes",
+		portCalls, pinCalls);
+	check(portCalls < (pinCalls / 3), what);
+
+	return testSummary();
+}
@@ -0,0 +1,230 @@
+// pinEventsTests.c - Tests for interrupt-safe edge counting and timestamps
+//
+// A simulated pin driver generates square waves and other signals, calling
+// pinEvents_record() at each edge as a pin interrupt handler would. To check that
+// snapshots are safe without disabling interrupts, one test records edges from a second
+// thread, standing in for the interrupt handler, while the main thread takes snapshots.
+// The primitives are checked with a mock PinEventDriver. See runTests.sh.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "pinEvents.h"
+#include "testHarness.h"
+
+// Stubs for the parts of the VM used by the primitives
+
+static uint8 lastError = noError;
+
+OBJ fail(uint8 errCode) { lastError = errCode; return falseObj; }
+OBJ newObj(int typeID, int wordCount, OBJ fill) { return NULL; }
+char* obj2str(OBJ obj) { return ""; }
+uint32 microsecs() { return 0; }
+
+// Mock driver
+
+static int attachedPin = -1;
+static int attachedSlot = -1;
+static int attachAllowed = true;
+
+static int mockAttach(int slot, int pin, int edges) {
+	if (!attachAllowed) return false;
+	attachedSlot = slot;
+	attachedPin = pin;
+	return true;
+}
+
+static void mockDetach(int pin) {
+	if (pin == attachedPin) attachedPin = attachedSlot = -1;
+}
+
+static PinEventDriver mockDriver = { mockAttach, mockDetach };
+
+// Simulated pin driver
+
+static int pinLevel = 0;
+
+static void setPin(PinEvents *pe, int level, uint32 usecs) {
+	// Change the simulated pin. Like a pin interrupt, report only actual changes.
+
+	if (level == pinLevel) return;
+	pinLevel = level;
+	pinEvents_record(pe, level, usecs);
+}
+
+static uint32 squareWave(PinEvents *pe, uint32 start, int cycles, int highUsecs, int lowUsecs) {
+	// Generate cycles of a square wave starting with a rising edge at start. Return the time
+	// after the last cycle.
+
+	uint32 t = start;
+	for (int i = 0; i < cycles; i++) {
+		setPin(pe, 1, t);
+		t += highUsecs;
+		setPin(pe, 0, t);
+		t += lowUsecs;
+	}
+	return t;
+}
+
+// Writer thread for the concurrency test
+
+#define WRITER_EDGES 20000000
+#define WRITER_STEP 10
+
+static volatile int writerDone = false;
+
+static void *writeEdges(void *arg) {
+	PinEvents *pe = (PinEvents *) arg;
+	for (uint32 i = 1; i <= WRITER_EDGES; i++) pinEvents_record(pe, i & 1, i * WRITER_STEP);
+	writerDone = true;
+	return NULL;
+}
+
+int main() {
+	PinEvents pe;
+	char what[200];
+
+	// both edges: period, frequency, and pulse widths
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	uint32 t = squareWave(&pe, 1000, 100, 300, 700);
+	snprintf(what, sizeof(what), "1 kHz, 30%% duty, both edges: %d edges, period %d, %d Hz, %d mHz, high %d, low %d",
+		pe.count, pinEvents_period(&pe, t), pinEvents_frequency(&pe, 1, t),
+		pinEvents_frequency(&pe, 1000, t), pinEvents_width(&pe, 1), pinEvents_width(&pe, 0));
+	check((200 == pe.count) && (1000 == pinEvents_period(&pe, t)) && (1000 == pinEvents_frequency(&pe, 1, t)) &&
+		(1000000 == pinEvents_frequency(&pe, 1000, t)) &&
+		(300 == pinEvents_width(&pe, 1)) && (700 == pinEvents_width(&pe, 0)), what);
+
+	// rising edges only: counts cycles; no pulse widths
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_RISING);
+	t = squareWave(&pe, 0, 50, 100, 400);
+	snprintf(what, sizeof(what), "rising edges only: %d edges, period %d, width %d",
+		pe.count, pinEvents_period(&pe, t), pinEvents_width(&pe, 1));
+	check((50 == pe.count) && (500 == pinEvents_period(&pe, t)) && (0 == pinEvents_width(&pe, 1)), what);
+
+	// falling edges only, a slow signal measured in cycles per minute (RPM)
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_FALLING);
+	t = squareWave(&pe, 0, 10, 10000, 30000); // 25 Hz
+	snprintf(what, sizeof(what), "falling edges only: %d edges, %d per minute", pe.count, pinEvents_frequency(&pe, 60, t));
+	check((10 == pe.count) && (1500 == pinEvents_frequency(&pe, 60, t)), what);
+
+	// jittered edges are averaged
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_RISING);
+	t = 0;
+	for (int i = 0; i < 40; i++) {
+		int jitter = ((i * 7919) % 21) - 10; // -10..10 usecs
+		setPin(&pe, 1, t + jitter);
+		setPin(&pe, 0, t + 500);
+		t += 2000;
+	}
+	int period = pinEvents_period(&pe, t);
+	snprintf(what, sizeof(what), "jittered 500 Hz signal: period %d", period);
+	check((period >= 1998) && (period <= 2002), what);
+
+	// a stopped signal reads as zero, but its last pulse width is kept
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	t = squareWave(&pe, 0, 20, 250, 750);
+	int running = (1000 == pinEvents_period(&pe, t + 1000));
+	check(running && (0 == pinEvents_period(&pe, t + 3000)) && (0 == pinEvents_frequency(&pe, 1, t + 3000)) &&
+		(250 == pinEvents_width(&pe, 1)), "a signal that stopped for over two periods reads as zero; widths are kept");
+
+	// the microsecond clock may wrap
+	pinLevel = 0;
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	t = squareWave(&pe, 0xFFFFFFFF - 5000, 10, 200, 800);
+	snprintf(what, sizeof(what), "clock wrap: period %d, high %d", pinEvents_period(&pe, t), pinEvents_width(&pe, 1));
+	check((t < 10000) && (1000 == pinEvents_period(&pe, t)) && (200 == pinEvents_width(&pe, 1)), what);
+
+	// with both edges, a repeated level (a glitch shorter than the interrupt latency) is ignored
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	pinEvents_record(&pe, 1, 0);
+	pinEvents_record(&pe, 1, 50);
+	pinEvents_record(&pe, 0, 100);
+	pinEvents_record(&pe, 1, 1000);
+	check((3 == pe.count) && (100 == pinEvents_width(&pe, 1)), "repeated levels are ignored when capturing both edges");
+
+	// too few edges, and a stopped capture
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	pinEvents_record(&pe, 1, 0);
+	int oneEdge = (0 == pinEvents_period(&pe, 10)) && (0 == pinEvents_width(&pe, 1));
+	pinEvents_stop(&pe);
+	pinEvents_record(&pe, 0, 20);
+	check(oneEdge && (1 == pe.count), "one edge gives no measurement; a stopped capture ignores edges");
+
+	// snapshots taken while edges arrive are consistent
+	pinEvents_start(&pe, 5, PIN_EVENT_BOTH);
+	pthread_t writer;
+	pthread_create(&writer, NULL, writeEdges, &pe);
+	int snapshots = 0, bad = 0;
+	uint32 times[PIN_EVENT_HISTORY];
+	uint8 levels[PIN_EVENT_HISTORY];
+	while (!writerDone) {
+		uint32 count;
+		int n = pinEvents_snapshot(&pe, times, levels, &count);
+		for (int i = 0; i < n; i++) {
+			uint32 edge = count - n + i + 1; // edge numbers start at 1
+			if ((times[i] != (edge * WRITER_STEP)) || (levels[i] != (edge & 1))) {
+				bad++;
+				break;
+			}
+		}
+		snapshots++;
+	}
+	pthread_join(writer, NULL);
+	snprintf(what, sizeof(what), "%d snapshots taken while %d edges were recorded: %d inconsistent",
+		snapshots, WRITER_EDGES, bad);
+	check((snapshots > 0) && (0 == bad) && (WRITER_EDGES == pe.count), what);
+
+	// the primitives attach and detach through the driver
+	pinEvents_setDriver(&mockDriver);
+	OBJ args[1] = { int2obj(7) };
+	primPinEventsStart(1, args);
+	PinEvents *slot = pinEvents_forPin(7);
+	int attached = (7 == attachedPin) && slot && (slot == pinEvents_slot(attachedSlot));
+	pinEvents_record(slot, 1, 0);
+	pinEvents_record(slot, 0, 10);
+	int counted = (int2obj(2) == primPinEventCount(1, args));
+	primPinEventsStop(1, args);
+	check(attached && counted && (-1 == attachedPin) && !pinEvents_forPin(7) && (noError == lastError),
+		"pinEventsStart attaches the driver to a free slot; pinEventsStop detaches it");
+
+	// a pin without interrupts fails and does not keep its slot
+	attachAllowed = false;
+	primPinEventsStart(1, args);
+	check((pinHasNoInterrupt == lastError) && !pinEvents_forPin(7), "pinEventsStart fails if the driver cannot attach");
+	attachAllowed = true;
+
+	// a negative pin and a ninth pin are rejected with their own errors
+	lastError = noError;
+	args[0] = int2obj(-1);
+	primPinEventsStart(1, args);
+	int negativeRejected = (badPinEventPin == lastError);
+	lastError = noError;
+	for (int pin = 10; pin < (10 + PIN_EVENT_SLOTS); pin++) {
+		args[0] = int2obj(pin);
+		primPinEventsStart(1, args);
+	}
+	int allStarted = (noError == lastError);
+	args[0] = int2obj(30);
+	primPinEventsStart(1, args);
+	check(negativeRejected && allStarted && (pinEventSlotsFull == lastError),
+		"pinEventsStart reports a negative pin and a full set of slots");
+
+	// stopping all tasks detaches the handlers and frees the slots
+	stopPinEvents();
+	int allFree = true;
+	for (int pin = 10; pin < (10 + PIN_EVENT_SLOTS); pin++) {
+		if (pinEvents_forPin(pin)) allFree = false;
+	}
+	check(allFree && (-1 == attachedPin), "stopPinEvents detaches every slot");
+
+	return testSummary();
+}
@@ -0,0 +1,138 @@
+// pulseTrainTests.c - Tests for timed pulse and waveform generation
+//
+// Plays pulse trains against a mock driver that records each pin change with its
+// scheduled time. The clock is advanced in irregular steps, as the VM loop or a timer
+// interrupt would call the update function.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "pulseTrain.h"
+#include "testHarness.h"
+
+#define MAX_EDGES 1000
+
+typedef struct {
+	int pin;
+	int level;
+	uint64 time;
+} Edge;
+
+static Edge edges[MAX_EDGES];
+static int edgeCount = 0;
+
+static void mockSetPins(PulseTrain *train, uint32 levels, uint32 changed, uint64 edgeTime) {
+	for (int i = 0; i < train->pinCount; i++) {
+		if (((changed >> i) & 1) && (edgeCount < MAX_EDGES)) {
+			Edge *e = &edges[edgeCount++];
+			e->pin = train->pins[i];
+			e->level = (levels >> i) & 1;
+			e->time = edgeTime;
+		}
+	}
+}
+
+static PulseDriver mockDriver = { mockSetPins };
+
+static uint64 runUntil(PulseTrain *trains, uint64 now, uint64 endTime) {
+	// Advance the clock in irregular steps of up to 97 usecs, updating the trains.
+
+	uint64 next;
+	int i = 0;
+	while (now < endTime) {
+		now += 1 + ((i++ * 7919) % 97);
+		pulseTrain_update(trains, PULSE_TRAIN_COUNT, now, &mockDriver, &next);
+	}
+	return now;
+}
+
+static void loadSteps(PulseTrain *train, int *pins, int pinCount, int *steps, int stepCount) {
+	// steps holds (levels, usecs) pairs
+	pulseTrain_load(train, pins, pinCount, stepCount);
+	for (int i = 0; i < stepCount; i++) pulseTrain_setStep(train, i, steps[2 * i], steps[(2 * i) + 1]);
+}
+
+int main() {
+	PulseTrain trains[PULSE_TRAIN_COUNT];
+	memset(trains, 0, sizeof(trains));
+	uint64 next;
+	char what[200];
+
+	// an IR remote style burst on one pin: each edge at its exact scheduled time
+	int irPin[] = {3};
+	int irSteps[] = {1, 9000, 0, 4500, 1, 560, 0, 560, 1, 560, 0, 1690, 1, 560, 0, 0};
+	loadSteps(&trains[0], irPin, 1, irSteps, 8);
+	pulseTrain_play(&trains[0], 1, 1000);
+	edgeCount = 0;
+	runUntil(trains, 0, 30000);
+	uint64 t = 1000;
+	int exact = (8 == edgeCount);
+	for (int i = 0; exact && (i < 8); i++) {
+		exact = (3 == edges[i].pin) && (edges[i].level == irSteps[2 * i]) && (edges[i].time == t);
+		t += irSteps[(2 * i) + 1];
+	}
+	check(exact && !trains[0].active, "one pin: 8 edges at their scheduled times, then done");
+
+	// several pins change together; unchanged pins are not written
+	int stepperPins[] = {10, 11, 12, 13};
+	int stepperSteps[] = {0x3, 2000, 0x6, 2000, 0xC, 2000, 0x9, 2000};
+	loadSteps(&trains[1], stepperPins, 4, stepperSteps, 4);
+	pulseTrain_play(&trains[1], 3, 50000);
+	edgeCount = 0;
+	runUntil(trains, 49000, 80000);
+	int together = ((4 + (11 * 2)) == edgeCount); // the first step sets all four pins
+	for (int i = 0; together && (i < edgeCount); i++) {
+		uint64 offset = edges[i].time - 50000;
+		together = (0 == (offset % 2000));
+	}
+	snprintf(what, sizeof(what), "four pins: 3 passes of 4 steps, %d pin changes, all on step boundaries", edgeCount);
+	check(together && !trains[1].active && (3 == trains[1].passes), what);
+
+	// two trains at once; edges come out in time order
+	int pinA[] = {1}, pinB[] = {2};
+	int squareA[] = {1, 300, 0, 300};
+	int squareB[] = {1, 500, 0, 500};
+	loadSteps(&trains[0], pinA, 1, squareA, 2);
+	loadSteps(&trains[1], pinB, 1, squareB, 2);
+	pulseTrain_play(&trains[0], 0, 100000);
+	pulseTrain_play(&trains[1], 0, 100000);
+	edgeCount = 0;
+	uint64 now = runUntil(trains, 99000, 130000);
+	int inOrder = true;
+	int countA = 0, countB = 0;
+	for (int i = 0; i < edgeCount; i++) {
+		if ((i > 0) && (edges[i].time < edges[i - 1].time)) inOrder = false;
+		if (1 == edges[i].pin) countA++; else countB++;
+	}
+	snprintf(what, sizeof(what), "two repeating trains: %d and %d edges in 30 msecs, in time order", countA, countB);
+	check(inOrder && (countA >= 100) && (countA <= 101) && (countB >= 60) && (countB <= 61), what);
+
+	// stopping a repeating train
+	pulseTrain_stop(&trains[0]);
+	pulseTrain_stop(&trains[1]);
+	edgeCount = 0;
+	int stillActive = pulseTrain_update(trains, PULSE_TRAIN_COUNT, now + 100000, &mockDriver, &next);
+	check((0 == edgeCount) && (0 == stillActive), "stopped trains set no more edges");
+
+	// very short steps are taken in batches, so one update cannot run forever
+	int fast[] = {1, 1, 0, 1};
+	loadSteps(&trains[0], pinA, 1, fast, 2);
+	pulseTrain_play(&trains[0], 0, 0);
+	edgeCount = 0;
+	pulseTrain_update(trains, PULSE_TRAIN_COUNT, 1000000, &mockDriver, &next);
+	snprintf(what, sizeof(what), "an update takes at most a batch of steps (%d); the next one is already due", edgeCount);
+	check((edgeCount < 100) && (next < 1000000), what);
+
+	// a train that repeats forever must take some time
+	int zero[] = {1, 0, 0, 0};
+	loadSteps(&trains[0], pinA, 1, zero, 2);
+	check(!pulseTrain_play(&trains[0], 0, 0) && pulseTrain_play(&trains[0], 2, 0),
+		"a zero-length train can be played a fixed number of times but not forever");
+
+	check(!pulseTrain_load(&trains[0], pinA, 9, 2) && !pulseTrain_load(&trains[0], pinA, 1, PULSE_TRAIN_MAX_STEPS + 1),
+		"too many pins or steps are rejected");
+
+	return testSummary();
+}
@@ -0,0 +1,134 @@
+// rangeArgsTests.c - Tests that primitives taking a List also accept a Range
+//
+// Runs the simulated radio primitives of linuxRadioPrims.c, which read a List (packetSend)
+// or fill one in (packetReceive), on the real object memory (mem.c) and Range support
+// (dataPrims.c). Arguments live on a task stack, as they do when the interpreter calls a
+// primitive, so that converting a Range into a List in place updates them.
+//
+// Must be built as a 32-bit program (see runTests.sh).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "vmHost.h"
+#include "testHarness.h"
+
+// Stubs for the parts of the VM not under test
+
+OBJ vars[MAX_VARS];
+OBJ lastBroadcast;
+Task tasks[MAX_TASKS];
+int taskCount = 0;
+
+static uint8 lastError = noError;
+
+OBJ fail(uint8 errCode) { lastError = errCode; return falseObj; }
+int failure() { return lastError != noError; }
+uint32 microsecs() { return 0; }
+uint32 millisecs() { return 0; }
+uint32 randomBelow(uint32 n) { return 0; }
+void captureIncomingBytes() { }
+void outputString(const char *s) { }
+void processMessage() { }
+void updateMicrobitDisplay() { }
+
+// Primitive lookup
+
+OBJ primRange(int argCount, OBJ *args); // in dataPrims.c
+
+static PrimEntry *radioEntries;
+static int radioEntryCount;
+
+void addPrimitiveSet(PrimitiveSetIndex primSetIndex, const char *setName, int entryCount, PrimEntry *entries) {
+	if (0 == strcmp(setName, "radio")) {
+		radioEntries = entries;
+		radioEntryCount = entryCount;
+	}
+}
+
+static PrimitiveFunction radioPrim(const char *name) {
+	for (int i = 0; i < radioEntryCount; i++) {
+		if (0 == strcmp(radioEntries[i].primName, name)) return radioEntries[i].primFunc;
+	}
+	printf("Missing primitive: %s\n", name);
+	exit(1);
+}
+
+// Simulated VM host with two instances
+
+static RadioState radios[2];
+static int currentInstance = 0;
+
+int vmHost_currentInstance() { return currentInstance; }
+int vmHost_instanceCount() { return 2; }
+RadioState * vmHost_radio(int instanceIndex) { return &radios[instanceIndex]; }
+
+// Calling primitives
+
+static OBJ *taskArgs(OBJ arg) {
+	// Put arg on the stack of a running task and return a pointer to it.
+
+	Task *task = &tasks[0];
+	task->status = running;
+	task->stack[0] = arg;
+	task->sp = 1;
+	taskCount = 1;
+	return &task->stack[0];
+}
+
+static OBJ range(int first, int last) {
+	OBJ args[2] = { int2obj(first), int2obj(last) };
+	return primRange(2, args);
+}
+
+static int listEquals(OBJ list, int first, int step, int count) {
+	// Return true if list is a List of count items starting at first and increasing by step.
+
+	if (!IS_TYPE(list, ListType) || (obj2int(FIELD(list, 0)) != count)) return false;
+	for (int i = 0; i < count; i++) {
+		if (FIELD(list, i + 1) != int2obj(first + (i * step))) return false;
+	}
+	return true;
+}
+
+int main() {
+	memInit();
+	addRadioPrims();
+	PrimitiveFunction packetSend = radioPrim("packetSend");
+	PrimitiveFunction packetReceive = radioPrim("packetReceive");
+	radios[0].enabled = radios[1].enabled = true;
+
+	// send a Range (packet byte 0 is the length, 31, so receivers copy all 32 bytes)
+	currentInstance = 0;
+	OBJ *args = taskArgs(range(31, 0));
+	check(IS_TYPE(args[0], RangeType), "range returns a Range");
+	packetSend(1, args);
+	check(IS_TYPE(args[0], RangeType) && (1 == radios[1].packetCount) && (noError == lastError),
+		"packetSend accepts a Range without changing it");
+
+	// receive into a List
+	currentInstance = 1;
+	OBJ list = newObj(ListType, 33, zeroObj);
+	FIELD(list, 0) = int2obj(32);
+	args = taskArgs(list);
+	check((trueObj == packetReceive(1, args)) && listEquals(args[0], 31, -1, 32),
+		"packetReceive fills a List with the packet sent from a Range");
+
+	// receive into a Range; it becomes a List
+	currentInstance = 0;
+	packetSend(1, taskArgs(range(31, 0)));
+	currentInstance = 1;
+	args = taskArgs(range(1, 32));
+	check((trueObj == packetReceive(1, args)) && listEquals(args[0], 31, -1, 32),
+		"packetReceive converts a Range argument into a List in place and fills it");
+
+	// a Range that is too short is ignored, like a short List
+	currentInstance = 0;
+	packetSend(1, taskArgs(range(1, 10)));
+	check((0 == radios[1].packetCount) && (noError == lastError), "packetSend ignores a Range of fewer than 32 items");
+
+	return testSummary();
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Build and run the tests in this folder. Exits with a nonzero status if any test fails.
+#
+# Tests of code that uses MicroBlocks objects must be 32-bit programs, like the Linux VM.
+# They are skipped if this system cannot build 32-bit programs (to build them on 64-bit
+# Linux: sudo apt install gcc-multilib).
+#
+# Usage: ./runTests.sh
+
+cd "$(dirname "$0")"
+VM=../../vm
+LINUX=../../linux+pi
+OUT=${TMPDIR:-/tmp}/microBlocksTests
+mkdir -p $OUT
+failed=""
+
+runTest() {
+	# runTest name [gcc args...]
+	name=$1; shift
+	echo "--- $name"
+	if gcc -std=gnu99 -I $VM "$@" -o $OUT/$name && $OUT/$name; then
+		return
+	fi
+	failed="$failed $name"
+}
+
+runTest adcSamplerTests adcSamplerTests.c $VM/adcSampler.c
+runTest audioOutTests audioOutTests.c $VM/audioOut.c
+runTest bleLinkTests bleLinkTests.c $VM/bleLink.c
+runTest dataLogTests dataLogTests.c $VM/dataLog.c
+runTest fixedMathBench -O2 fixedMathBench.c $VM/fixedMath.c -lm
+runTest hidQueueTests hidQueueTests.c $VM/hidQueue.c
+runTest httpResponseTests httpResponseTests.c $VM/httpResponse.c
+runTest inputTraceTests -DGNUBLOCKS -I $LINUX inputTraceTests.c $LINUX/inputTrace.c
+runTest pinBusTests pinBusTests.c $VM/pinBus.c
+runTest pinEventsTests pinEventsTests.c $VM/pinEvents.c -lpthread
+runTest pulseTrainTests pulseTrainTests.c $VM/pulseTrain.c
+runTest timeSeriesTests timeSeriesTests.c $VM/timeSeries.c
+
+# 32-bit tests
+echo 'int main() { return 0; }' > $OUT/m32.c
+if gcc -m32 $OUT/m32.c -o $OUT/m32 2> /dev/null; then
+	runTest rangeArgsTests -m32 -D GNUBLOCKS -I $LINUX rangeArgsTests.c \
+		$VM/mem.c $VM/dataPrims.c $LINUX/linuxRadioPrims.c -lm
+else
+	echo "--- Skipping 32-bit tests (cannot build 32-bit programs)"
+fi
+
+if [ -n "$failed" ]; then
+	echo "FAILED:$failed"
+	exit 1
+fi
+echo "All tests passed"
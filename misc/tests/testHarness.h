@@ -0,0 +1,18 @@
+// testHarness.h - PASS/FAIL reporting shared by the tests in this folder
+//
+// A test calls check() for each result and returns testSummary() from main(), so its exit
+// status is nonzero if any check failed. See runTests.sh.
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) failures++;
+}
+
+static int testSummary() {
+	printf("%d failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
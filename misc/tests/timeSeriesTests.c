@@ -0,0 +1,220 @@
+// timeSeriesTests.c - Tests for fixed-capacity time series with downsampling
+//
+// Adds pseudo-random and worst-case (steadily rising or falling) values to time series and
+// compares every statistic and export with a simple model that keeps all entries and
+// recomputes each result from scratch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "timeSeries.h"
+#include "testHarness.h"
+
+#define MAX_VALUES 50000
+
+// Model: every entry of every tier, oldest first
+
+typedef struct {
+	int mean, min, max;
+} Entry;
+
+static Entry modelEntries[TS_MAX_TIERS][MAX_VALUES];
+static int modelCounts[TS_MAX_TIERS];
+
+static int roundedMean(long long sum, int n) {
+	if (sum >= 0) return (int) ((sum + (n / 2)) / n);
+	return (int) -((-sum + (n / 2)) / n);
+}
+
+static void modelAdd(int value, int tierCount, int *ratios, int valueBytes) {
+	if (2 == valueBytes) {
+		if (value > 32767) value = 32767;
+		if (value < -32768) value = -32768;
+	}
+	Entry e = { value, value, value };
+	modelEntries[0][modelCounts[0]++] = e;
+	for (int tier = 1; tier < tierCount; tier++) {
+		// a new entry is due when the tier below has a multiple of ratio entries
+		int ratio = ratios[tier - 1];
+		int below = modelCounts[tier - 1];
+		if ((0 == below) || (0 != (below % ratio))) break;
+		Entry *group = &modelEntries[tier - 1][below - ratio];
+		long long sum = 0;
+		Entry combined = group[0];
+		for (int i = 0; i < ratio; i++) {
+			sum += group[i].mean;
+			if (group[i].min < combined.min) combined.min = group[i].min;
+			if (group[i].max > combined.max) combined.max = group[i].max;
+		}
+		combined.mean = roundedMean(sum, ratio);
+		modelEntries[tier][modelCounts[tier]++] = combined;
+	}
+}
+
+static int modelStat(int tier, int capacity, int stat) {
+	int count = (modelCounts[tier] < capacity) ? modelCounts[tier] : capacity;
+	if (TS_COUNT == stat) return count;
+	if (0 == count) return 0;
+	Entry *window = &modelEntries[tier][modelCounts[tier] - count];
+	long long sum = 0;
+	int min = window[0].min, max = window[0].max;
+	for (int i = 0; i < count; i++) {
+		sum += window[i].mean;
+		if (window[i].min < min) min = window[i].min;
+		if (window[i].max > max) max = window[i].max;
+	}
+	switch (stat) {
+	case TS_MIN: return min;
+	case TS_MAX: return max;
+	case TS_MEAN: return roundedMean(sum, count);
+	case TS_LAST: return window[count - 1].mean;
+	}
+	return 0;
+}
+
+static int fieldOf(Entry *e, int field) {
+	if (TS_FIELD_MIN == field) return e->min;
+	if (TS_FIELD_MAX == field) return e->max;
+	return e->mean;
+}
+
+static int modelExport(int tier, int capacity, int field, int width, int *out) {
+	int count = (modelCounts[tier] < capacity) ? modelCounts[tier] : capacity;
+	Entry *window = &modelEntries[tier][modelCounts[tier] - count];
+	if (count <= width) {
+		for (int i = 0; i < count; i++) out[i] = fieldOf(&window[i], field);
+		return count;
+	}
+	for (int p = 0; p < width; p++) {
+		int start = (p * count) / width, end = ((p + 1) * count) / width;
+		long long sum = 0;
+		int result = fieldOf(&window[start], field);
+		for (int i = start; i < end; i++) {
+			int v = fieldOf(&window[i], field);
+			sum += v;
+			if ((TS_FIELD_MIN == field) && (v < result)) result = v;
+			if ((TS_FIELD_MAX == field) && (v > result)) result = v;
+		}
+		out[p] = (TS_FIELD_MEAN == field) ? roundedMean(sum, end - start) : result;
+	}
+	return width;
+}
+
+static TimeSeries *newSeries(int capacity, int valueBytes, int tierCount, int *ratios, int *byteCount) {
+	*byteCount = ts_bytesNeeded(capacity, valueBytes, tierCount);
+	TimeSeries *ts = (TimeSeries *) malloc(*byteCount);
+	if (!ts_init(ts, *byteCount, capacity, valueBytes, tierCount, ratios)) {
+		free(ts);
+		return NULL;
+	}
+	memset(modelCounts, 0, sizeof(modelCounts));
+	return ts;
+}
+
+static int compareAll(TimeSeries *ts, int capacity) {
+	// Compare all statistics of all tiers with the model. Return the number of mismatches.
+
+	int mismatches = 0;
+	for (int tier = 0; tier < ts->tierCount; tier++) {
+		for (int stat = TS_MIN; stat <= TS_LAST; stat++) {
+			if (ts_stat(ts, tier, stat) != modelStat(tier, capacity, stat)) mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+static uint32 rng = 12345;
+
+static int randomValue(int range) {
+	rng = (rng * 1103515245) + 12345;
+	return ((int) ((rng >> 8) % (2 * range + 1))) - range;
+}
+
+static void runScenario(const char *name, int capacity, int valueBytes, int tierCount, int *ratios, int valueCount, int (*nextValue)(int i)) {
+	// Add values, comparing statistics after every value and exports at the end.
+
+	int byteCount;
+	TimeSeries *ts = newSeries(capacity, valueBytes, tierCount, ratios, &byteCount);
+	if (!ts) {
+		check(false, name);
+		return;
+	}
+	int mismatches = 0;
+	for (int i = 0; i < valueCount; i++) {
+		int v = nextValue(i);
+		ts_add(ts, v);
+		modelAdd(v, tierCount, ratios, valueBytes);
+		mismatches += compareAll(ts, capacity);
+	}
+	static int out[TS_MAX_CAPACITY], expected[TS_MAX_CAPACITY];
+	int widths[] = {1, 7, 64, capacity, capacity + 10};
+	for (int tier = 0; tier < tierCount; tier++) {
+		for (int field = TS_FIELD_MEAN; field <= TS_FIELD_MAX; field++) {
+			for (int w = 0; w < 5; w++) {
+				int n = ts_export(ts, tier, field, widths[w], out);
+				int m = modelExport(tier, capacity, field, widths[w], expected);
+				if ((n != m) || memcmp(out, expected, n * sizeof(int))) mismatches++;
+			}
+		}
+	}
+	char what[200];
+	snprintf(what, sizeof(what), "%s: %d values, tier counts %d/%d/%d, %d mismatches", name, valueCount,
+		ts_stat(ts, 0, TS_COUNT), (tierCount > 1) ? ts_stat(ts, 1, TS_COUNT) : 0,
+		(tierCount > 2) ? ts_stat(ts, 2, TS_COUNT) : 0, mismatches);
+	check(ts_isValid(ts, byteCount) && (0 == mismatches), what);
+	free(ts);
+}
+
+static int randomSensor(int i) { return 500 + randomValue(300); }
+static int bigRandom(int i) { return randomValue(1000000000); }
+static int rising(int i) { return i; }
+static int falling(int i) { return -i; }
+static int sawtooth(int i) { return (i % 37) * 1000 - 18000; }
+
+int main() {
+	int ratios[] = {10, 6, 4};
+
+	runScenario("random sensor readings, 16-bit, three tiers", 120, 2, 3, ratios, 20000, randomSensor);
+	runScenario("large random values, 32-bit, four tiers", 50, 4, 4, ratios, 20000, bigRandom);
+	runScenario("16-bit values clipped", 30, 2, 2, ratios, 3000, bigRandom);
+	runScenario("rising values (worst case for the minimum)", 100, 4, 3, ratios, 10000, rising);
+	runScenario("falling values (worst case for the maximum)", 100, 4, 3, ratios, 10000, falling);
+	runScenario("sawtooth, capacity 1", 1, 2, 3, ratios, 2000, sawtooth);
+
+	// a large, full series
+	int byteCount;
+	TimeSeries *ts = newSeries(TS_MAX_CAPACITY, 4, 3, ratios, &byteCount);
+	for (int i = 0; i < (3 * TS_MAX_CAPACITY); i++) ts_add(ts, i % 1000);
+	int count = ts_stat(ts, 0, TS_COUNT);
+	int mean = ts_stat(ts, 0, TS_MEAN);
+	check((TS_MAX_CAPACITY == count) && (mean >= 495) && (mean <= 505) &&
+		(0 == ts_stat(ts, 0, TS_MIN)) && (999 == ts_stat(ts, 0, TS_MAX)),
+		"a full series of the largest capacity: count, mean, min, and max");
+
+	// clearing
+	ts_clear(ts);
+	check((0 == ts_stat(ts, 0, TS_COUNT)) && (0 == ts_stat(ts, 2, TS_COUNT)) && ts_isValid(ts, byteCount),
+		"clearing removes all entries");
+
+	// damaged headers are rejected
+	ts->tiers[1].head = TS_MAX_CAPACITY;
+	int badHead = !ts_isValid(ts, byteCount);
+	ts_clear(ts);
+	int tooSmall = !ts_isValid(ts, byteCount - 4);
+	ts->magic = 0;
+	check(badHead && tooSmall && !ts_isValid(ts, byteCount), "damaged or truncated series are rejected");
+	free(ts);
+
+	// argument checks
+	int zeroRatio[] = {0};
+	uint32 buf[500];
+	check(!ts_init((TimeSeries *) buf, sizeof(buf), 100, 3, 1, ratios) &&
+		!ts_init((TimeSeries *) buf, sizeof(buf), 100, 2, 2, zeroRatio) &&
+		!ts_init((TimeSeries *) buf, sizeof(buf), 1000, 2, 1, ratios) &&
+		ts_init((TimeSeries *) buf, sizeof(buf), 100, 2, 2, ratios),
+		"bad arguments and too little memory are rejected");
+
+	return testSummary();
+}
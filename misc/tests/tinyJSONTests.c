@@ -91,10 +91,50 @@ static void test4() {
 	}
 }
 
+static void test5() {
+	// test compiled paths
+
+	char json[] = "{ \"shape\": { \"points\": [ { \"x\": 1, \"y\": 2 }, { \"x\": 3, \"xx\": 5, \"y\": 4 } ]}}";
+	unsigned char path[50];
+
+	printf("\nTesting tjr_atCompiledPath():\n");
+	char *paths[] = { "shape.points", "shape.points.2.y", "shape.points.2.xx", "shape.points.3", "shape.nope" };
+	for (int i = 0; i < 5; i++) {
+		int size = tjr_compilePath(paths[i], path, sizeof(path));
+		printf("  %s (%d bytes): ", paths[i], size);
+		printThing(tjr_atCompiledPath(json, path, size));
+	}
+}
+
+static void test6() {
+	// test cursor enumeration
+
+	char json[] = " [ \"a\", [1, 2], {\"k\": \"v\"}, 42 ] ";
+	printf("\nArray cursor:\n");
+	char *entry, *value;
+	char *p = json + 2; // after '['
+	while ((p = tjr_cursorNext(p, &entry, &value))) {
+		printf("  ");
+		printThing(entry);
+	}
+
+	char json2[] = " {\"foo\": 1, \"bar\": [true] , \"baz\" : \"qux\" } ";
+	printf("\nObject cursor:\n");
+	p = json2 + 2; // after '{'
+	while ((p = tjr_cursorNext(p, &entry, &value))) {
+		char key[20];
+		tjr_readStringInto(entry, key, sizeof(key));
+		printf("  %s: ", key);
+		printThing(value);
+	}
+}
+
 int main() {
  	test1();
  	test2();
  	test3();
  	test4();
+ 	test5();
+ 	test6();
 	return 0;
 }
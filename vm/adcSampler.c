@@ -0,0 +1,175 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// adcSampler.c - Timed sampling of analog pins into buffers
+// agent, October 2026
+
+/*
+ADC Sampler
+
+Samples one or more analog pins at a fixed rate into int16 buffers owned by the sampler.
+Each sample frame holds one sample per pin. The VM loop calls adcSampler_run() on every
+cycle; it takes the frame whose scheduled time has come. Frame k is scheduled at
+startTime + (k * 1000000) / rate, so the sample rate stays exact over long runs even
+though individual frames may be taken a little late; maxLateUsecs records the worst delay.
+
+If the VM falls behind (for example, during a long primitive) so that several frames are
+due at once, only the newest one is taken. The ADC can only read the pins as they are now,
+so taking the older frames would record present values as if they had been sampled
+earlier, distorting the signal. The skipped frames are counted in framesMissed and filled
+with the values of the last frame taken, so frame k of a buffer is still the frame
+scheduled k frame periods after the buffer's first one.
+
+In single mode, sampling stops when the buffer is full. In continuous mode, two buffers
+are used: while one is filled, the other can be read. If a full buffer has not been read
+by the time the next one fills, it is overwritten and buffersDropped is incremented.
+
+Samples are kept in buffers outside the object heap (see mem.h) until adcSampler_read().
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "adcSampler.h"
+
+static void freeBuffers(ADCSampler *s) {
+	free(s->buffers[0]);
+	free(s->buffers[1]);
+	s->buffers[0] = s->buffers[1] = NULL;
+}
+
+int adcSampler_start(ADCSampler *s, int *pins, int channelCount, int rate, int frames, int continuous, uint64 now) {
+	// Start sampling the given pins. Return false if the arguments are out of range or
+	// the buffers could not be allocated.
+
+	if ((channelCount < 1) || (channelCount > ADC_MAX_CHANNELS)) return false;
+	if ((rate < 1) || (rate > ADC_MAX_RATE) || (frames < 1)) return false;
+	int bufferBytes = 2 * frames * channelCount;
+	if (bufferBytes > ADC_MAX_BUFFER_BYTES) return false;
+
+	s->running = false;
+	freeBuffers(s);
+	s->buffers[0] = (short *) malloc(bufferBytes);
+	if (continuous) s->buffers[1] = (short *) malloc(bufferBytes);
+	if (!s->buffers[0] || (continuous && !s->buffers[1])) {
+		freeBuffers(s);
+		return false;
+	}
+
+	s->channelCount = channelCount;
+	memcpy(s->pins, pins, channelCount * sizeof(int));
+	s->rate = rate;
+	s->continuous = continuous;
+	s->capacity = frames;
+	s->fillIndex = 0;
+	s->fillCount = 0;
+	s->readyIndex = -1;
+	s->startTime = now;
+	s->frameIndex = 0;
+	s->framesTaken = 0;
+	s->framesMissed = 0;
+	s->buffersDropped = 0;
+	s->maxLateUsecs = 0;
+	s->running = true;
+	return true;
+}
+
+void adcSampler_stop(ADCSampler *s) {
+	// Stop sampling and free the buffers, discarding any unread samples.
+
+	s->running = false;
+	s->readyIndex = -1;
+	freeBuffers(s);
+}
+
+static void bufferFull(ADCSampler *s) {
+	if (!s->continuous) {
+		s->readyIndex = s->fillIndex;
+		s->running = false;
+		return;
+	}
+	// the other buffer, if still unread, is overwritten next
+	if (s->readyIndex >= 0) s->buffersDropped++;
+	s->readyIndex = s->fillIndex;
+	s->fillIndex = !s->fillIndex;
+	s->fillCount = 0;
+}
+
+static void putFrame(ADCSampler *s, short *frame) {
+	short *dst = s->buffers[s->fillIndex] + (s->fillCount * s->channelCount);
+	memcpy(dst, frame, s->channelCount * sizeof(short));
+	if (++s->fillCount >= s->capacity) bufferFull(s);
+}
+
+static void fillMissedFrames(ADCSampler *s, uint64 missed, short *frame) {
+	// Fill the buffers with copies of frame in place of missed frames. In continuous mode,
+	// pairs of buffers that would only be filled with copies and overwritten are skipped.
+
+	if (s->continuous && (missed >= (uint64) (4 * s->capacity))) {
+		uint32 pairs = (missed - (2 * s->capacity)) / (2 * s->capacity); // at least one
+		if (s->readyIndex < 0) { // the first skipped buffer would have become ready
+			s->readyIndex = !s->fillIndex;
+			s->buffersDropped--;
+		}
+		s->buffersDropped += 2 * pairs;
+		missed -= (uint64) pairs * 2 * s->capacity;
+	}
+	while (s->running && (missed-- > 0)) putFrame(s, frame);
+}
+
+static inline uint64 frameTime(ADCSampler *s, uint64 frameIndex) {
+	return s->startTime + ((frameIndex * 1000000) / s->rate);
+}
+
+void adcSampler_run(ADCSampler *s, uint64 now, ADCDriver *driver) {
+	// Take the newest sample frame that is due, skipping any older ones that were missed.
+
+	if (!s->running || (frameTime(s, s->frameIndex) > now)) return;
+
+	// find the newest frame that is due
+	uint64 newest = ((now - s->startTime) * s->rate) / 1000000;
+	if (newest < s->frameIndex) newest = s->frameIndex;
+	while (frameTime(s, newest + 1) <= now) newest++;
+	uint64 missed = newest - s->frameIndex;
+	s->framesMissed += missed;
+	s->frameIndex = newest;
+
+	uint64 scheduled = frameTime(s, s->frameIndex);
+	uint64 late = now - scheduled;
+	if (late > s->maxLateUsecs) s->maxLateUsecs = late;
+
+	short frame[ADC_MAX_CHANNELS];
+	for (int i = 0; i < s->channelCount; i++) {
+		frame[i] = driver->read(s->pins[i], scheduled);
+	}
+	if (missed) fillMissedFrames(s, missed, s->framesTaken ? s->lastFrame : frame);
+	memcpy(s->lastFrame, frame, sizeof(frame));
+	s->frameIndex++;
+	s->framesTaken++;
+	if (s->running) putFrame(s, frame);
+}
+
+int adcSampler_ready(ADCSampler *s) {
+	return (s->readyIndex >= 0);
+}
+
+int adcSampler_read(ADCSampler *s, uint8 *dst, int dstBytes) {
+	// Copy the full buffer, if any, to dst as little-endian int16 values and release it.
+	// Return the number of bytes copied.
+
+	if (s->readyIndex < 0) return 0;
+	short *src = s->buffers[s->readyIndex];
+	int sampleCount = s->capacity * s->channelCount;
+	if (sampleCount > (dstBytes / 2)) sampleCount = dstBytes / 2;
+	for (int i = 0; i < sampleCount; i++) {
+		int sample = src[i];
+		*dst++ = sample & 0xFF;
+		*dst++ = (sample >> 8) & 0xFF;
+	}
+	s->readyIndex = -1;
+	return 2 * sampleCount;
+}
@@ -0,0 +1,54 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// adcSampler.h - Timed sampling of analog pins into buffers
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_MAX_CHANNELS 4
+#define ADC_MAX_BUFFER_BYTES 8192	// per buffer; continuous mode uses two buffers
+#define ADC_MAX_RATE 100000		// sample frames per second
+
+// The driver reads one analog pin, returning a value in the range 0-1023. sampleTime is
+// the scheduled time of the sample in usecs; a simulated ADC can use it to return the
+// value at that time.
+
+typedef struct {
+	int (*read)(int pin, uint64 sampleTime);
+} ADCDriver;
+
+typedef struct {
+	int channelCount;
+	int pins[ADC_MAX_CHANNELS];
+	int rate;				// sample frames per second
+	int continuous;			// true for continuous, double-buffered sampling
+	int running;
+	short *buffers[2];		// int16 samples, channels interleaved
+	int capacity;			// frames per buffer
+	int fillIndex;			// buffer being filled
+	int fillCount;			// frames in the buffer being filled
+	int readyIndex;			// full buffer waiting to be read, or -1
+	uint64 startTime;		// usecs
+	uint64 frameIndex;		// index of the next frame since start
+	short lastFrame[ADC_MAX_CHANNELS]; // the last frame taken
+	uint32 framesTaken;
+	uint32 framesMissed;	// frames skipped because the VM loop fell behind (filled with lastFrame)
+	uint32 buffersDropped;	// continuous mode: full buffers overwritten before being read
+	uint32 maxLateUsecs;	// largest delay between a frame's scheduled time and its sampling (less than one frame period)
+} ADCSampler;
+
+int adcSampler_start(ADCSampler *s, int *pins, int channelCount, int rate, int frames, int continuous, uint64 now);
+void adcSampler_stop(ADCSampler *s);
+void adcSampler_run(ADCSampler *s, uint64 now, ADCDriver *driver);
+int adcSampler_ready(ADCSampler *s);
+int adcSampler_read(ADCSampler *s, uint8 *dst, int dstBytes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,161 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// audioOut.c - Buffered sample playback
+// agent, October 2026
+
+/*
+Audio Output
+
+Plays 8-bit (unsigned) or 16-bit (signed, little-endian) mono PCM samples at a fixed rate.
+The program queues buffers of samples; while one buffer plays, the next ones can be
+filled and queued, so playback continues without gaps as long as the program keeps up.
+Queued samples are copied into the player's buffers, outside the object heap (see mem.h).
+
+audioOut_run() is called on every VM loop cycle. With a clocked driver (one with its own
+sample clock and buffer, such as a timer-driven DAC), it passes samples to the driver
+until the driver's buffer is full. Otherwise, it passes each sample at its scheduled
+time, startTime + (n * 1000000) / rate, so the rate stays exact over time. If several
+samples are due at once because the VM loop fell behind, only the newest one is written;
+the older ones are dropped rather than written in a burst, which would distort the sound.
+
+When the queue runs empty, playback stalls and its clock stops. When the next buffer is
+queued, playback resumes from that moment and the stall is counted as an underrun.
+Dropping late samples also counts as an underrun. A program that always queues its next
+buffer in time sees no underruns. (A pause between two sounds also counts as one, unless
+playback is restarted for the second sound.)
+
+The queue buffers are allocated as needed and freed when playback stops.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "audioOut.h"
+
+#define MAX_SAMPLES_PER_RUN 256 // limits the time spent in one call
+
+int audioOut_start(AudioOut *a, int rate, int bits) {
+	// Start playback with the given format and an empty queue. Return false if the format
+	// is not supported.
+
+	a->running = false;
+	if ((rate < 1) || (rate > AUDIO_MAX_RATE)) return false;
+	if ((8 != bits) && (16 != bits)) return false;
+	a->rate = rate;
+	a->bits = bits;
+	a->head = a->count = a->readIndex = 0;
+	a->stalled = true; // waiting for the first buffer
+	a->startTime = a->sampleIndex = 0;
+	a->samplesPlayed = a->buffersPlayed = a->underruns = a->samplesDropped = a->maxLateUsecs = 0;
+	a->running = true;
+	return true;
+}
+
+void audioOut_stop(AudioOut *a) {
+	// Stop playback and free the queue buffers.
+
+	a->running = false;
+	a->count = 0;
+	for (int i = 0; i < AUDIO_QUEUE_SIZE; i++) {
+		free(a->buffers[i]);
+		a->buffers[i] = NULL;
+		a->capacities[i] = 0;
+	}
+}
+
+int audioOut_space(AudioOut *a) {
+	// Return the number of buffers that can be queued now.
+
+	return a->running ? (AUDIO_QUEUE_SIZE - a->count) : 0;
+}
+
+int audioOut_queue(AudioOut *a, uint8 *data, int byteCount, uint64 now) {
+	// Copy the given samples to the end of the queue. Return false if the queue is full,
+	// playback is not running, or there is not enough memory.
+
+	if (!a->running || (a->count >= AUDIO_QUEUE_SIZE)) return false;
+	if (16 == a->bits) byteCount &= ~1; // whole samples only
+	if (byteCount > AUDIO_MAX_BUFFER_BYTES) byteCount = AUDIO_MAX_BUFFER_BYTES;
+	if (byteCount <= 0) return true; // nothing to play
+
+	int i = (a->head + a->count) % AUDIO_QUEUE_SIZE;
+	if (byteCount > a->capacities[i]) {
+		free(a->buffers[i]);
+		a->buffers[i] = (uint8 *) malloc(byteCount);
+		a->capacities[i] = a->buffers[i] ? byteCount : 0;
+		if (!a->buffers[i]) return false;
+	}
+	memcpy(a->buffers[i], data, byteCount);
+	a->byteCounts[i] = byteCount;
+	a->count++;
+
+	if (a->stalled) { // resume playback
+		if (a->samplesPlayed) a->underruns++;
+		a->stalled = false;
+		a->startTime = now;
+		a->sampleIndex = 0;
+	}
+	return true;
+}
+
+static int nextSample(AudioOut *a) {
+	uint8 *p = a->buffers[a->head] + a->readIndex;
+	if (8 == a->bits) return (p[0] - 128) << 8;
+	return (short) (p[0] | (p[1] << 8));
+}
+
+static void advance(AudioOut *a) {
+	a->readIndex += a->bits / 8;
+	a->sampleIndex++;
+	if (a->readIndex >= a->byteCounts[a->head]) { // finished this buffer
+		a->head = (a->head + 1) % AUDIO_QUEUE_SIZE;
+		a->count--;
+		a->readIndex = 0;
+		a->buffersPlayed++;
+		if (0 == a->count) a->stalled = true;
+	}
+}
+
+static inline uint64 sampleTime(AudioOut *a, uint64 sampleIndex) {
+	return a->startTime + ((sampleIndex * 1000000) / a->rate);
+}
+
+void audioOut_run(AudioOut *a, uint64 now, AudioDriver *driver) {
+	// Pass the sample that is due (or the samples that a clocked driver can take) to the driver.
+
+	if (driver->clocked) {
+		for (int n = 0; a->running && !a->stalled && (n < MAX_SAMPLES_PER_RUN); n++) {
+			if (!driver->write(nextSample(a), sampleTime(a, a->sampleIndex))) return; // driver buffer is full
+			advance(a);
+			a->samplesPlayed++;
+		}
+		return;
+	}
+
+	if (!a->running || a->stalled || (sampleTime(a, a->sampleIndex) > now)) return;
+
+	// drop the samples that are overdue by more than one sample period
+	uint32 dropped = 0;
+	while (sampleTime(a, a->sampleIndex + 1) <= now) {
+		advance(a);
+		dropped++;
+		if (a->stalled) break;
+	}
+	if (dropped) {
+		a->samplesDropped += dropped;
+		a->underruns++;
+	}
+	if (a->stalled) return;
+
+	uint64 scheduled = sampleTime(a, a->sampleIndex);
+	uint64 late = now - scheduled;
+	if (late > a->maxLateUsecs) a->maxLateUsecs = late;
+	driver->write(nextSample(a), scheduled);
+	advance(a);
+	a->samplesPlayed++;
+}
@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// audioOut.h - Buffered sample playback
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_QUEUE_SIZE 3				// buffers: one playing, the rest waiting
+#define AUDIO_MAX_BUFFER_BYTES 8192
+#define AUDIO_MAX_RATE 48000
+
+// The driver outputs one sample, a signed 16-bit value. If clocked is true, the output
+// has its own sample clock and buffer (such as a timer-driven DAC); write() returns false
+// when that buffer is full. Otherwise, write() is called at each sample's scheduled time
+// (sampleTime, in usecs) and must accept the sample.
+
+typedef struct {
+	int clocked;
+	int (*write)(int sample, uint64 sampleTime);
+} AudioDriver;
+
+typedef struct {
+	int running;
+	int rate;						// samples per second
+	int bits;						// 8 (unsigned) or 16 (signed, little-endian)
+	uint8 *buffers[AUDIO_QUEUE_SIZE];
+	int capacities[AUDIO_QUEUE_SIZE];	// allocated bytes
+	int byteCounts[AUDIO_QUEUE_SIZE];
+	int head;						// buffer playing
+	int count;						// buffers queued, including the one playing
+	int readIndex;					// byte index in the buffer playing
+	int stalled;					// true when waiting for a buffer
+	uint64 startTime;				// usecs; restarts when playback resumes after a stall
+	uint64 sampleIndex;				// samples since startTime
+	uint32 samplesPlayed;
+	uint32 buffersPlayed;
+	uint32 underruns;				// times playback ran out of samples or dropped late ones
+	uint32 samplesDropped;			// unclocked drivers: samples too late to play
+	uint32 maxLateUsecs;			// unclocked drivers: largest delay of a sample played
+} AudioOut;
+
+int audioOut_start(AudioOut *a, int rate, int bits);
+void audioOut_stop(AudioOut *a);
+int audioOut_queue(AudioOut *a, uint8 *data, int byteCount, uint64 now);
+int audioOut_space(AudioOut *a);
+void audioOut_run(AudioOut *a, uint64 now, AudioDriver *driver);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,157 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// bleLink.c - Transport-independent buffering and pacing for the BLE IDE link
+// agent, October 2026
+
+/*
+BLE Link
+
+This module holds the parts of the BLE IDE connection that do not depend on the BLE stack,
+so they can be shared by the NimBLE (ESP32) and BTstack (Pico W) versions and tested on
+Linux against a simulated link.
+
+Receiving: Incoming bytes are stored in a ring buffer. The BLE stack callback is the only
+writer of recvIn and the VM is the only reader of recvOut, so no locking is needed as long
+as each count is updated after its bytes have been copied. If the buffer is full, the excess
+bytes are dropped and counted in overruns.
+
+Sending: Outgoing data is split into notifications of up to payloadSize bytes (the negotiated
+ATT MTU minus the 3-byte ATT header). Each notification uses a credit; at most window
+notifications can be in flight. A credit is returned when the stack reports that the
+notification was sent (bleLink_sendComplete) or, for stacks that don't report that, when
+creditTime msecs have passed. The window adapts: if the stack refuses a notification because
+it is out of buffers, the window is halved and sending pauses for creditTime msecs. After a
+full window of notifications has been confirmed, the window grows by one, up to maxWindow.
+
+Times are msecs and compared with wrap-safe subtraction.
+*/
+
+#include <string.h>
+
+#include "mem.h"
+#include "bleLink.h"
+
+void bleLink_init(BLELink *link, int maxWindow, int creditTime) {
+	memset(link, 0, sizeof(BLELink));
+	if (maxWindow < 1) maxWindow = 1;
+	if (maxWindow > BLE_LINK_MAX_WINDOW) maxWindow = BLE_LINK_MAX_WINDOW;
+	link->maxWindow = maxWindow;
+	link->creditTime = (creditTime > 0) ? creditTime : 1;
+	bleLink_reset(link);
+}
+
+void bleLink_reset(BLELink *link) {
+	// Discard buffered and in-flight data, e.g. when a new connection is made.
+	// The pacing configuration is kept but the MTU goes back to the BLE default.
+
+	link->recvIn = link->recvOut = 0;
+	link->payloadSize = BLE_LINK_MIN_PAYLOAD;
+	link->window = (link->maxWindow < 2) ? link->maxWindow : 2;
+	link->inFlight = 0;
+	link->oldest = 0;
+	link->successes = 0;
+	link->holdUntil = 0;
+}
+
+void bleLink_setMTU(BLELink *link, int mtu) {
+	int payload = mtu - 3;
+	if (payload < BLE_LINK_MIN_PAYLOAD) payload = BLE_LINK_MIN_PAYLOAD;
+	if (payload > BLE_LINK_MAX_PAYLOAD) payload = BLE_LINK_MAX_PAYLOAD;
+	link->payloadSize = payload;
+}
+
+// Receiving
+
+int bleLink_received(BLELink *link, const uint8 *data, int byteCount) {
+	// Append incoming bytes to the receive buffer. Return the number of bytes stored.
+
+	uint32 in = link->recvIn;
+	int available = BLE_LINK_RECV_SIZE - (in - link->recvOut);
+	if (byteCount > available) {
+		link->overruns++;
+		byteCount = available;
+	}
+	int start = in & (BLE_LINK_RECV_SIZE - 1);
+	int n = BLE_LINK_RECV_SIZE - start; // bytes before the end of the buffer
+	if (n > byteCount) n = byteCount;
+	memcpy(&link->recvBuf[start], data, n);
+	memcpy(link->recvBuf, data + n, byteCount - n);
+	link->recvIn = in + byteCount;
+	return byteCount;
+}
+
+int bleLink_available(BLELink *link) {
+	return link->recvIn - link->recvOut;
+}
+
+int bleLink_read(BLELink *link, uint8 *buf, int count) {
+	// Move up to count received bytes into buf. Return the number of bytes read.
+
+	uint32 out = link->recvOut;
+	int available = link->recvIn - out;
+	if (count > available) count = available;
+	if (count <= 0) return 0;
+	int start = out & (BLE_LINK_RECV_SIZE - 1);
+	int n = BLE_LINK_RECV_SIZE - start;
+	if (n > count) n = count;
+	memcpy(buf, &link->recvBuf[start], n);
+	memcpy(buf + n, link->recvBuf, count - n);
+	link->recvOut = out + count;
+	return count;
+}
+
+// Sending
+
+static void returnCredit(BLELink *link) {
+	if (link->inFlight <= 0) return;
+	link->oldest = (link->oldest + 1) % BLE_LINK_MAX_WINDOW;
+	link->inFlight--;
+	if ((++link->successes >= link->window) && (link->window < link->maxWindow)) {
+		link->window++;
+		link->successes = 0;
+	}
+}
+
+void bleLink_sendComplete(BLELink *link) {
+	// Called when the BLE stack reports that a notification has been sent. Must be called
+	// from the same task that calls bleLink_send().
+
+	returnCredit(link);
+}
+
+int bleLink_send(BLELink *link, const uint8 *data, int byteCount, uint32 now, BLESendFunction send, void *context) {
+	// Send as much of the given data as the current window allows. Return the number of
+	// bytes sent; the caller retries the rest later.
+
+	while ((link->inFlight > 0) && ((int) (now - link->sendTimes[link->oldest]) >= link->creditTime)) {
+		returnCredit(link); // confirmation is overdue; assume the notification was sent
+	}
+	if (link->holdUntil) {
+		if ((int) (now - link->holdUntil) < 0) return 0; // backing off
+		link->holdUntil = 0;
+	}
+
+	int sent = 0;
+	while ((sent < byteCount) && (link->inFlight < link->window)) {
+		int n = byteCount - sent;
+		if (n > link->payloadSize) n = link->payloadSize;
+		if (!send(data + sent, n, context)) {
+			// the stack is out of buffers; shrink the window and back off
+			link->refusals++;
+			link->window = (link->window > 1) ? link->window / 2 : 1;
+			link->successes = 0;
+			link->holdUntil = (now + link->creditTime) | 1; // never zero
+			break;
+		}
+		link->sendTimes[(link->oldest + link->inFlight) % BLE_LINK_MAX_WINDOW] = now;
+		link->inFlight++;
+		link->packetsSent++;
+		sent += n;
+	}
+	link->bytesSent += sent;
+	return sent;
+}
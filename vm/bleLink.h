@@ -0,0 +1,61 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// bleLink.h - Transport-independent buffering and pacing for the BLE IDE link
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_LINK_RECV_SIZE 2048		// receive ring buffer size (must be a power of two)
+#define BLE_LINK_MIN_PAYLOAD 20		// payload of the default 23-byte ATT MTU
+#define BLE_LINK_MAX_PAYLOAD 512	// largest attribute value allowed by BLE
+#define BLE_LINK_MAX_WINDOW 8		// maximum notifications in flight
+
+// A send function queues one notification with the BLE stack. It returns true if the
+// notification was accepted or false if the stack is out of buffers.
+
+typedef int (*BLESendFunction)(const uint8 *data, int byteCount, void *context);
+
+typedef struct {
+	// receive ring buffer; recvIn and recvOut are free-running byte counts
+	uint8 recvBuf[BLE_LINK_RECV_SIZE];
+	volatile uint32 recvIn;
+	volatile uint32 recvOut;
+	int overruns;			// number of times incoming bytes were dropped
+
+	// send pacing
+	int payloadSize;		// maximum bytes per notification (negotiated MTU - 3)
+	int window;				// current limit on notifications in flight
+	int maxWindow;
+	int creditTime;			// msecs after which an unconfirmed notification returns its credit
+	int inFlight;			// notifications sent but not yet confirmed
+	int oldest;				// index of the oldest in-flight entry in sendTimes
+	int successes;			// notifications confirmed since the window last changed
+	uint32 sendTimes[BLE_LINK_MAX_WINDOW];
+	uint32 holdUntil;		// after a refusal, do not send again before this time (0 if not holding)
+
+	// statistics
+	uint32 bytesSent;
+	uint32 packetsSent;
+	uint32 refusals;
+} BLELink;
+
+void bleLink_init(BLELink *link, int maxWindow, int creditTime);
+void bleLink_reset(BLELink *link);
+void bleLink_setMTU(BLELink *link, int mtu);
+
+int bleLink_received(BLELink *link, const uint8 *data, int byteCount);
+int bleLink_available(BLELink *link);
+int bleLink_read(BLELink *link, uint8 *buf, int count);
+
+int bleLink_send(BLELink *link, const uint8 *data, int byteCount, uint32 now, BLESendFunction send, void *context);
+void bleLink_sendComplete(BLELink *link);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,6 +18,7 @@
 
 #include "esp_camera.h"
 #include "soc/rtc_cntl_reg.h"  // for brownout control
+#include "fileSys.h"
 
 // The following pin definitions depend on the specific camera board.
 // To support additional cameras, use #ifdefs to define the pins for each camera.
@@ -49,12 +50,67 @@ static camera_fb_t *fb = NULL;
 static framesize_t frameSize = FRAMESIZE_VGA;
 static pixformat_t pixelFormat = PIXFORMAT_JPEG;
 static int jpegQuality = 10;
+static int frameBufferCount = 1; // more than one puts the driver into continuous capture mode
+static camera_grab_mode_t grabMode = CAMERA_GRAB_WHEN_EMPTY;
+
+// Frame Handles
+//
+// A frame handle gives access to a frame buffer owned by the camera driver without copying
+// it into the object store. The frame stays valid until it is released, so it can be read in
+// pieces or streamed to a file or HTTP client. Since the driver has only frameBufferCount
+// buffers, at most that many frames can be held at once.
+
+#define MAX_FRAMES 4
+
+typedef struct {
+	camera_fb_t *fb;
+	int handle;
+	uint32 timestamp; // msecs when the frame was grabbed
+} FrameEntry;
+
+static FrameEntry frames[MAX_FRAMES];
+static int frameSerial = 0;
+
+static int heldFrameCount() {
+	int count = fb ? 1 : 0;
+	for (int i = 0; i < MAX_FRAMES; i++) {
+		if (frames[i].fb) count++;
+	}
+	return count;
+}
 
-static void updateConfiguration() {
+static void releaseFrame(FrameEntry *entry) {
+	esp_camera_fb_return(entry->fb);
+	entry->fb = NULL;
+	entry->handle = 0;
+}
+
+static void releaseAllFrames() {
 	if (fb) {
 		esp_camera_fb_return(fb);
 		fb = NULL;
 	}
+	for (int i = 0; i < MAX_FRAMES; i++) {
+		if (frames[i].fb) releaseFrame(&frames[i]);
+	}
+}
+
+static FrameEntry *frameFor(OBJ handleObj) {
+	// Return the entry for the given frame handle. Fail if the handle is not valid.
+
+	if (isInt(handleObj) && (obj2int(handleObj) > 0)) {
+		int handle = obj2int(handleObj);
+		FrameEntry *entry = &frames[handle % MAX_FRAMES];
+		if (entry->fb && (entry->handle == handle)) return entry;
+	}
+	fail(badFrameHandle);
+	return NULL;
+}
+
+static void updateConfiguration() {
+	releaseAllFrames();
+	config.fb_count = frameBufferCount;
+	config.grab_mode = grabMode;
  	if (cameraIsInitialized) {
 		esp_camera_deinit(); // stop camera
 		gpio_uninstall_isr_service();
@@ -95,9 +151,9 @@ static void initCamera() {
 	// Does locating the framebuffer in PSRAM increase sync errors?
 	config.fb_location = CAMERA_FB_IN_PSRAM;
 
-	// buffer only one image
-	config.fb_count = 1;
-	config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+	// buffer only one image unless continuous capture has been started
+	config.fb_count = frameBufferCount;
+	config.grab_mode = grabMode;
 
 	// set initial frame size and format
 	config.frame_size = frameSize;
@@ -127,6 +183,8 @@ OBJ primTakePhoto(int argCount, OBJ *args) {
 
 	// take photo (return the framebuffer right before fb_get() to grab the current image)
 	if (fb) esp_camera_fb_return(fb);
+	fb = NULL;
+	if (heldFrameCount() >= frameBufferCount) return falseObj; // all frame buffers are held
 	fb = esp_camera_fb_get();
 
 	if (!fb) {
@@ -182,6 +240,183 @@ OBJ primSetEncoding(int argCount, OBJ *args) {
 	return falseObj;
 }
 
+// Frame primitives
+
+static const char *encodingName(pixformat_t format) {
+	if (PIXFORMAT_JPEG == format) return "jpeg";
+	if (PIXFORMAT_RGB565 == format) return "rgb565";
+	if (PIXFORMAT_GRAYSCALE == format) return "grayscale";
+	return "other";
+}
+
+OBJ primGrabFrame(int argCount, OBJ *args) {
+	// Capture a frame and return a handle for it, or false if no frame could be captured.
+	// In continuous capture mode, return the oldest frame in the driver's queue.
+
+	if (!cameraIsInitialized) initCamera();
+	if (!cameraIsInitialized) return falseObj;
+
+	if (fb) { // release the takePhoto frame so the driver can use its buffer
+		esp_camera_fb_return(fb);
+		fb = NULL;
+	}
+	if (heldFrameCount() >= frameBufferCount) return falseObj; // all frame buffers are held
+
+	int i;
+	for (i = 0; i < MAX_FRAMES; i++) {
+		if (!frames[i].fb) break;
+	}
+	if (i >= MAX_FRAMES) return falseObj; // no free entry
+
+	camera_fb_t *frame = esp_camera_fb_get();
+	if (!frame) return falseObj;
+
+	frameSerial = (frameSerial % 1000000) + 1;
+	frames[i].fb = frame;
+	frames[i].handle = (frameSerial * MAX_FRAMES) + i;
+	frames[i].timestamp = millisecs();
+	return int2obj(frames[i].handle);
+}
+
+OBJ primReleaseFrame(int argCount, OBJ *args) {
+	// Return the given frame to the driver. With no argument, release all frames.
+
+	if (argCount < 1) {
+		releaseAllFrames();
+		return falseObj;
+	}
+	FrameEntry *entry = frameFor(args[0]);
+	if (entry) releaseFrame(entry);
+	return falseObj;
+}
+
+OBJ primFrameInfo(int argCount, OBJ *args) {
+	// Return a list: byte count, width, height, encoding, and capture time (msecs).
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+
+	OBJ result = newObj(ListType, 6, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	tempGCRoot = result;
+	OBJ encoding = newString(strlen(encodingName(entry->fb->format)));
+	tempGCRoot = NULL;
+	if (!encoding) return fail(insufficientMemoryError);
+	strcpy(obj2str(encoding), encodingName(entry->fb->format));
+
+	FIELD(result, 0) = int2obj(5);
+	FIELD(result, 1) = int2obj(entry->fb->len);
+	FIELD(result, 2) = int2obj(entry->fb->width);
+	FIELD(result, 3) = int2obj(entry->fb->height);
+	FIELD(result, 4) = encoding;
+	FIELD(result, 5) = int2obj(entry->timestamp & 0x3FFFFFFF);
+	return result;
+}
+
+OBJ primFrameBytes(int argCount, OBJ *args) {
+	// Return a ByteArray containing count bytes of the frame starting at startIndex.
+	// Both are optional; the default is the entire frame.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+
+	int frameBytes = entry->fb->len;
+	int startIndex = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 1;
+	if ((startIndex < 1) || (startIndex > (frameBytes + 1))) return fail(indexOutOfRangeError);
+	int count = frameBytes - (startIndex - 1);
+	if ((argCount > 2) && isInt(args[2]) && (obj2int(args[2]) < count)) count = obj2int(args[2]);
+	if (count < 0) count = 0;
+
+	OBJ result = newObj(ByteArrayType, (count + 3) / 4, falseObj);
+	if (!result) return fail(insufficientMemoryError);
+	memcpy((uint8 *) &FIELD(result, 0), entry->fb->buf + (startIndex - 1), count);
+	setByteCountAdjust(result, count);
+	return result;
+}
+
+OBJ primReadFrameInto(int argCount, OBJ *args) {
+	// Copy frame bytes starting at startIndex into the given ByteArray.
+	// Return the number of bytes copied; zero means the end of the frame has been reached.
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	if (!IS_TYPE(args[2], ByteArrayType)) return fail(needsByteArray);
+
+	int frameBytes = entry->fb->len;
+	int startIndex = obj2int(args[1]);
+	if ((startIndex < 1) || (startIndex > (frameBytes + 1))) return fail(indexOutOfRangeError);
+	int count = frameBytes - (startIndex - 1);
+	if (count > BYTES(args[2])) count = BYTES(args[2]);
+	memcpy((uint8 *) &FIELD(args[2], 0), entry->fb->buf + (startIndex - 1), count);
+	return int2obj(count);
+}
+
+OBJ primFrameToFile(int argCount, OBJ *args) {
+	// Append the frame to the given file directly from the frame buffer.
+	// Return the number of bytes written.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+
+	char path[32];
+	char *fileName = obj2str(args[1]);
+	if (!fileName[0] || strstr(fileName, "ublockscode")) return falseObj;
+	snprintf(path, sizeof(path), ('/' == fileName[0]) ? "%s" : "/%s", fileName);
+	closeIfOpen(path);
+
+	File file = myFS.open(path, "a");
+	if (!file) return falseObj;
+	int byteCount = file.write(entry->fb->buf, entry->fb->len);
+	file.close();
+	processMessage();
+	return int2obj(byteCount);
+}
+
+OBJ primFrameToHttpClient(int argCount, OBJ *args) {
+	// Respond to the current HTTP request with the frame, streamed from the frame buffer.
+	// If the optional keepAlive argument is true, leave the connection open. Return the
+	// number of bytes sent or false if there is no HTTP client.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	FrameEntry *entry = frameFor(args[0]);
+	if (!entry) return falseObj;
+	int keepAlive = ((argCount > 1) && (trueObj == args[1]));
+
+	const char *contentType = (PIXFORMAT_JPEG == entry->fb->format) ? "image/jpeg" : "application/octet-stream";
+	int sent = httpRespondWithData(contentType, entry->fb->buf, entry->fb->len, keepAlive);
+	return (sent < 0) ? falseObj : int2obj(sent);
+}
+
+OBJ primStartCapture(int argCount, OBJ *args) {
+	// Start continuous capture with a queue of the given number of frames (2 to MAX_FRAMES).
+	// If the optional second argument is true, the driver replaces the oldest queued frame
+	// when the queue is full; otherwise new frames are dropped until a frame is released.
+	// Continuous capture works best with JPEG encoding.
+
+	int count = ((argCount > 0) && isInt(args[0])) ? obj2int(args[0]) : 2;
+	if (count < 2) count = 2;
+	if (count > MAX_FRAMES) count = MAX_FRAMES;
+	frameBufferCount = count;
+	grabMode = ((argCount > 1) && (trueObj == args[1])) ? CAMERA_GRAB_LATEST : CAMERA_GRAB_WHEN_EMPTY;
+
+	updateConfiguration();
+	if (!cameraIsInitialized) initCamera();
+	return falseObj;
+}
+
+OBJ primStopCapture(int argCount, OBJ *args) {
+	frameBufferCount = 1;
+	grabMode = CAMERA_GRAB_WHEN_EMPTY;
+	updateConfiguration();
+	return falseObj;
+}
+
 #else
 
 // stubs
@@ -189,6 +424,15 @@ OBJ primHasCamera(int argCount, OBJ *args) { return falseObj; }
 OBJ primTakePhoto(int argCount, OBJ *args) { return falseObj; }
 OBJ primSetSize(int argCount, OBJ *args) { return falseObj; }
 OBJ primSetEncoding(int argCount, OBJ *args) { return falseObj; }
+OBJ primGrabFrame(int argCount, OBJ *args) { return falseObj; }
+OBJ primReleaseFrame(int argCount, OBJ *args) { return falseObj; }
+OBJ primFrameInfo(int argCount, OBJ *args) { return falseObj; }
+OBJ primFrameBytes(int argCount, OBJ *args) { return falseObj; }
+OBJ primReadFrameInto(int argCount, OBJ *args) { return falseObj; }
+OBJ primFrameToFile(int argCount, OBJ *args) { return falseObj; }
+OBJ primFrameToHttpClient(int argCount, OBJ *args) { return falseObj; }
+OBJ primStartCapture(int argCount, OBJ *args) { return falseObj; }
+OBJ primStopCapture(int argCount, OBJ *args) { return falseObj; }
 
 #endif
 
@@ -199,6 +443,15 @@ static PrimEntry entries[] = {
 	{"takePhoto", primTakePhoto},
 	{"setSize", primSetSize},
 	{"setEncoding", primSetEncoding},
+	{"grabFrame", primGrabFrame},
+	{"releaseFrame", primReleaseFrame},
+	{"frameInfo", primFrameInfo},
+	{"frameBytes", primFrameBytes},
+	{"readFrameInto", primReadFrameInto},
+	{"frameToFile", primFrameToFile},
+	{"frameToHttpClient", primFrameToHttpClient},
+	{"startCapture", primStartCapture},
+	{"stopCapture", primStopCapture},
 };
 
 void addCameraPrims() {
@@ -0,0 +1,241 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// dataLog.c - Buffered binary data logging to rotating files
+// agent, October 2026
+
+/*
+Data Logging
+
+The data logger records timestamped values into a set of files on the board's file
+system, so a board can log hundreds of records per second without a connection to the
+IDE. Records have a fixed layout: a 4-byte timestamp in milliseconds followed by
+valueCount values of 2 or 4 bytes each, all little-endian and signed (16-bit values are
+clipped). Adding a record just copies it into a RAM buffer. The buffer is written to the
+current file in a single block when it is full, when its oldest record is flushMsecs old,
+or when the log is flushed or stopped. Flash file systems write large blocks much faster
+than many small ones.
+
+The files are named <baseName>0.bin, <baseName>1.bin, and so on, up to fileCount. When
+the current file is full, the logger moves on to the next one, replacing the oldest file
+once all of them have been used. Each file starts with a 16-byte header:
+
+	0	"MBLG"
+	4	format version (1)
+	5	values per record
+	6	bytes per value
+	7	zero
+	8	file sequence number (4 bytes)
+	12	bytes per record (4 bytes)
+
+Sequence numbers increase with each new file. When logging starts, it continues after
+the file with the highest sequence number, so restarting the board (or the program) does
+not overwrite the most recent data.
+
+The file system is reached through a DataLogDriver. Since a slow log may add no records
+for a long time, the VM loop calls dataLog_flushIfDue() as part of its background work.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "dataLog.h"
+
+static void putInt(uint8 *dst, int n, int byteCount) {
+	for (int i = 0; i < byteCount; i++) {
+		dst[i] = n & 0xFF;
+		n >>= 8;
+	}
+}
+
+static uint32 getInt(uint8 *src) {
+	return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32) src[3] << 24);
+}
+
+void dataLog_fileName(DataLog *log, int index, char *fileName, int size) {
+	snprintf(fileName, size, "%s%d.bin", log->baseName, index);
+}
+
+static void findNewestFile(DataLog *log, DataLogDriver *driver) {
+	// Record the sequence numbers of the existing log files and set fileIndex and
+	// sequence for the file after the newest one.
+
+	char fileName[32];
+	uint8 header[DATA_LOG_HEADER_BYTES];
+	uint32 newest = 0;
+	int newestIndex = -1;
+	for (int i = 0; i < log->fileCount; i++) {
+		log->sequences[i] = 0;
+		dataLog_fileName(log, i, fileName, sizeof(fileName));
+		int byteCount = driver->readHeader(fileName, header, DATA_LOG_HEADER_BYTES);
+		if ((DATA_LOG_HEADER_BYTES == byteCount) && (0 == memcmp(header, "MBLG", 4))) {
+			log->sequences[i] = getInt(&header[8]);
+			if (log->sequences[i] > newest) {
+				newest = log->sequences[i];
+				newestIndex = i;
+			}
+		}
+	}
+	log->fileIndex = (newestIndex + 1) % log->fileCount;
+	log->sequence = newest + 1;
+}
+
+static int openFile(DataLog *log, DataLogDriver *driver) {
+	// Create the current file and write its header.
+
+	char fileName[32];
+	uint8 header[DATA_LOG_HEADER_BYTES];
+
+	dataLog_fileName(log, log->fileIndex, fileName, sizeof(fileName));
+	log->sequences[log->fileIndex] = 0;
+	if (!driver->create(fileName)) return false;
+	log->fileOpen = true;
+	memset(header, 0, sizeof(header));
+	memcpy(header, "MBLG", 4);
+	header[4] = 1;
+	header[5] = log->valueCount;
+	header[6] = log->valueBytes;
+	putInt(&header[8], log->sequence, 4);
+	putInt(&header[12], log->recordBytes, 4);
+	log->fileBytes = driver->append(header, DATA_LOG_HEADER_BYTES);
+	if (DATA_LOG_HEADER_BYTES != log->fileBytes) {
+		driver->close();
+		log->fileOpen = false;
+		return false;
+	}
+	log->sequences[log->fileIndex] = log->sequence;
+	return true;
+}
+
+int dataLog_start(DataLog *log, char *baseName, int valueCount, int valueBytes, int fileCount, int maxFileBytes, int blockBytes, DataLogDriver *driver) {
+	// Start logging records of valueCount values. Return false if the arguments are out
+	// of range, there is not enough memory for the buffer, or the first file cannot be
+	// created.
+
+	dataLog_stop(log, driver);
+	if ((valueCount < 1) || (valueCount > DATA_LOG_MAX_VALUES)) return false;
+	if ((2 != valueBytes) && (4 != valueBytes)) return false;
+	if ((fileCount < 1) || (fileCount > DATA_LOG_MAX_FILES)) return false;
+	if (!baseName[0] || (strlen(baseName) >= sizeof(log->baseName))) return false;
+	int recordBytes = 4 + (valueCount * valueBytes);
+	blockBytes -= blockBytes % recordBytes; // whole records only
+	if ((blockBytes < recordBytes) || (maxFileBytes < (DATA_LOG_HEADER_BYTES + blockBytes))) return false;
+
+	log->buffer = (uint8 *) malloc(blockBytes);
+	if (!log->buffer) return false;
+	strcpy(log->baseName, baseName);
+	log->valueCount = valueCount;
+	log->valueBytes = valueBytes;
+	log->recordBytes = recordBytes;
+	log->fileCount = fileCount;
+	log->maxFileBytes = maxFileBytes;
+	log->flushMsecs = DATA_LOG_FLUSH_MSECS;
+	log->blockBytes = blockBytes;
+	log->bufferCount = 0;
+	log->recordsLogged = log->recordsDropped = log->blocksWritten = 0;
+
+	findNewestFile(log, driver);
+	if (!openFile(log, driver)) {
+		dataLog_stop(log, driver);
+		return false;
+	}
+	log->running = true;
+	return true;
+}
+
+int dataLog_add(DataLog *log, uint32 msecs, int *values, int count, DataLogDriver *driver) {
+	// Add a record to the buffer, flushing the buffer first if it is full. Missing values
+	// are recorded as zero and extra ones are ignored. Return false if not logging.
+
+	if (!log->running) return false;
+	if ((log->bufferCount + log->recordBytes) > log->blockBytes) dataLog_flush(log, driver);
+
+	uint8 *dst = &log->buffer[log->bufferCount];
+	putInt(dst, msecs, 4);
+	dst += 4;
+	for (int i = 0; i < log->valueCount; i++) {
+		int n = (i < count) ? values[i] : 0;
+		if (2 == log->valueBytes) {
+			if (n > 32767) n = 32767;
+			if (n < -32768) n = -32768;
+		}
+		putInt(dst, n, log->valueBytes);
+		dst += log->valueBytes;
+	}
+	if (0 == log->bufferCount) log->bufferStartMsecs = msecs;
+	log->bufferCount += log->recordBytes;
+	log->recordsLogged++;
+
+	dataLog_flushIfDue(log, msecs, driver);
+	return true;
+}
+
+int dataLog_flushIfDue(DataLog *log, uint32 msecs, DataLogDriver *driver) {
+	// Flush the buffer if its oldest record is flushMsecs old. Return false if the records
+	// could not be written.
+
+	if (!log->running || (0 == log->bufferCount)) return true;
+	if ((msecs - log->bufferStartMsecs) < log->flushMsecs) return true;
+	return dataLog_flush(log, driver);
+}
+
+int dataLog_flush(DataLog *log, DataLogDriver *driver) {
+	// Write the buffered records to the current file, moving on to the next file if they
+	// do not fit. Return false if the records could not be written; they are dropped, so
+	// logging can continue if the problem (such as a full file system) goes away.
+
+	if (!log->running || (0 == log->bufferCount)) return true;
+
+	if (log->fileOpen && ((log->fileBytes + log->bufferCount) > log->maxFileBytes)) {
+		driver->close();
+		log->fileOpen = false;
+		log->fileIndex = (log->fileIndex + 1) % log->fileCount;
+		log->sequence++;
+	}
+	int written = 0;
+	if (log->fileOpen || openFile(log, driver)) {
+		written = driver->append(log->buffer, log->bufferCount);
+		if (written < 0) written = 0;
+		log->fileBytes += written;
+		log->blocksWritten++;
+	}
+	if (written < log->bufferCount) {
+		log->recordsDropped += (log->bufferCount - written + log->recordBytes - 1) / log->recordBytes;
+	}
+	int ok = (written == log->bufferCount);
+	log->bufferCount = 0;
+	return ok;
+}
+
+void dataLog_stop(DataLog *log, DataLogDriver *driver) {
+	// Flush the buffer and close the current file.
+
+	dataLog_flush(log, driver);
+	if (log->fileOpen) driver->close();
+	log->fileOpen = false;
+	log->running = false;
+	free(log->buffer);
+	log->buffer = NULL;
+}
+
+int dataLog_filesInOrder(DataLog *log, int *indices) {
+	// Set indices to the indices of the existing log files, oldest first, and return the
+	// number of files. The indices array must have room for fileCount entries.
+
+	int count = 0;
+	for (int i = 0; i < log->fileCount; i++) {
+		if (!log->sequences[i]) continue;
+		int j = count++;
+		while ((j > 0) && (log->sequences[indices[j - 1]] > log->sequences[i])) {
+			indices[j] = indices[j - 1];
+			j--;
+		}
+		indices[j] = i;
+	}
+	return count;
+}
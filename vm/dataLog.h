@@ -0,0 +1,64 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// dataLog.h - Buffered binary data logging to rotating files
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DATA_LOG_MAX_VALUES 16			// values per record
+#define DATA_LOG_MAX_FILES 16
+#define DATA_LOG_HEADER_BYTES 16
+#define DATA_LOG_FLUSH_MSECS 5000		// default limit on how long a record waits in RAM
+
+// The driver does the file operations. readHeader() reads the first byteCount bytes of
+// the given file and returns the number of bytes read (zero if the file does not exist).
+// create() creates or truncates the given file and opens it for appending; append() writes
+// to that file and returns the number of bytes written; close() closes it.
+
+typedef struct {
+	int (*readHeader)(char *fileName, uint8 *buf, int byteCount);
+	int (*create)(char *fileName);
+	int (*append)(uint8 *data, int byteCount);
+	void (*close)(void);
+} DataLogDriver;
+
+typedef struct {
+	int running;
+	char baseName[20];				// files are named <baseName><index>.bin
+	int valueCount;
+	int valueBytes;					// 2 or 4
+	int recordBytes;				// 4-byte timestamp plus values
+	int fileCount;
+	int maxFileBytes;				// including the header
+	uint32 flushMsecs;				// flush once the oldest buffered record is this old
+	uint8 *buffer;
+	int blockBytes;					// buffer size
+	int bufferCount;				// bytes buffered
+	uint32 bufferStartMsecs;		// timestamp of the oldest buffered record
+	int fileOpen;
+	int fileIndex;					// file being written
+	int fileBytes;					// bytes in that file
+	uint32 sequence;				// sequence number of that file
+	uint32 sequences[DATA_LOG_MAX_FILES]; // sequence number of each file; zero if none
+	uint32 recordsLogged;
+	uint32 recordsDropped;			// records lost because a write failed
+	uint32 blocksWritten;
+} DataLog;
+
+int dataLog_start(DataLog *log, char *baseName, int valueCount, int valueBytes, int fileCount, int maxFileBytes, int blockBytes, DataLogDriver *driver);
+int dataLog_add(DataLog *log, uint32 msecs, int *values, int count, DataLogDriver *driver);
+int dataLog_flush(DataLog *log, DataLogDriver *driver);
+int dataLog_flushIfDue(DataLog *log, uint32 msecs, DataLogDriver *driver);
+void dataLog_stop(DataLog *log, DataLogDriver *driver);
+void dataLog_fileName(DataLog *log, int index, char *fileName, int size);
+int dataLog_filesInOrder(DataLog *log, int *indices);
+
+#ifdef __cplusplus
+}
+#endif
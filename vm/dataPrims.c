@@ -122,6 +122,48 @@ static uint8 * appendUTF8(uint8 *s, int unicode) {
 // First field is the item count (N). Items are stored in fields 2..N.
 // Fields N+1..end are available for adding additional items without growing.
 
+// Ranges:
+// The range primitive returns a Range object (see mem.h) rather than a List so that
+// iterating over a large range does not allocate memory proportional to its size.
+// Primitives that only read a list accept Ranges directly or via a temporary List;
+// primitives that modify a list first convert the Range into a List in place.
+// Primitives in other files use ensureList() or ensureListCopy() for list arguments.
+
+OBJ rangeToList(OBJ range, int replace) {
+	// Return a List containing the items of the given Range. If replace is true, all references
+	// to the Range are replaced with references to the new List (used before modifying it).
+
+	int count = RANGE_COUNT(range);
+	tempGCRoot = range; // record range in case allocation triggers GC that moves it
+	OBJ result = newObj(ListType, count + 1, zeroObj);
+	range = tempGCRoot; // restore range
+	tempGCRoot = NULL;
+	if (!result) return fail(insufficientMemoryError); // allocation failed
+
+	FIELD(result, 0) = int2obj(count);
+	for (int i = 1; i <= count; i++) FIELD(result, i) = rangeAt(range, i);
+	if (replace) replaceObj(range, result);
+	return result;
+}
+
+int ensureList(OBJ *args, int i) {
+	// If args[i] is a Range, replace it with an equivalent List everywhere so it can be
+	// modified. Return false if that failed.
+
+	if (!IS_TYPE(args[i], RangeType)) return true;
+	return rangeToList(args[i], true) != falseObj; // replaceObj() updates args[i]
+}
+
+int ensureListCopy(OBJ *args, int i) {
+	// If args[i] is a Range, replace args[i] (only) with a temporary List containing its items.
+	// Used by primitives that read a list but are not worth specializing for Ranges.
+	// Return false if that failed.
+
+	if (!IS_TYPE(args[i], RangeType)) return true;
+	args[i] = rangeToList(args[i], false);
+	return args[i] != falseObj;
+}
+
 OBJ primNewList(int argCount, OBJ *args) {
 	// Return a new List filled with zeros. Optional argument specifies size.
 
@@ -135,6 +177,7 @@ OBJ primNewList(int argCount, OBJ *args) {
 }
 
 OBJ primFillList(int argCount, OBJ *args) {
+	if (!ensureList(args, 0)) return falseObj;
 	OBJ obj = args[0];
 	OBJ value = args[1];
 
@@ -164,6 +207,8 @@ OBJ primAt(int argCount, OBJ *args) {
 	if (IS_TYPE(obj, ListType)) {
 		count = obj2int(FIELD(obj, 0));
 		if (count >= WORDS(obj)) count = WORDS(obj) - 1;
+	} else if (IS_TYPE(obj, RangeType)) {
+		count = RANGE_COUNT(obj);
 	} else if (IS_TYPE(obj, StringType)) {
 		count = stringSize(obj);
 	} else if (IS_TYPE(obj, ByteArrayType)) {
@@ -176,7 +221,7 @@ OBJ primAt(int argCount, OBJ *args) {
 		if ((i < 1) || (i > count)) return fail(indexOutOfRangeError);
 	} else if (matches("random", arg0)) {
 		if (count == 0) return fail(indexOutOfRangeError);
-		i = (rand() % count) + 1;
+		i = randomBelow(count) + 1;
 	} else if (matches("last", arg0)) {
 		i = count;
 	} else if (IS_TYPE(arg0, StringType)) {
@@ -189,6 +234,8 @@ OBJ primAt(int argCount, OBJ *args) {
 
 	if (IS_TYPE(obj, ListType)) {
 		return FIELD(obj, i);
+	} else if (IS_TYPE(obj, RangeType)) {
+		return rangeAt(obj, i);
 	} else if (IS_TYPE(obj, StringType)) {
 		char *start = obj2str(obj);
 		while (i-- > 1) { // find start of the ith Unicode character
@@ -209,6 +256,7 @@ OBJ primAt(int argCount, OBJ *args) {
 }
 
 OBJ primAtPut(int argCount, OBJ *args) {
+	if (!ensureList(args, 1)) return falseObj;
 	OBJ obj = args[1];
 	OBJ value = args[2];
 	int count, i;
@@ -266,6 +314,8 @@ OBJ primLength(int argCount, OBJ *args) {
 
 	if (IS_TYPE(obj, ListType)) {
 		return FIELD(obj, 0); // actual count stored in first field
+	} else if (IS_TYPE(obj, RangeType)) {
+		return FIELD(obj, 1);
 	} else if (IS_TYPE(obj, ByteArrayType)) {
 		return int2obj(BYTES(obj));
 	} else if (IS_TYPE(obj, StringType)) {
@@ -300,21 +350,19 @@ OBJ primRange(int argCount, OBJ *args) {
 		incr = -incr; // make the increment negative
 	}
 
-	OBJ result = newObj(ListType, count + 1, falseObj);
+	OBJ result = newObj(RangeType, 3, zeroObj);
 	if (!result) return result; // allocation failed
 
-	FIELD(result, 0) = int2obj(count);
-	int n = start;
-	for (int i = 0; i < count; i++) {
-		FIELD(result, i + 1) = int2obj(n);
-		n += incr;
-	}
+	FIELD(result, 0) = int2obj(start);
+	FIELD(result, 1) = int2obj(count);
+	FIELD(result, 2) = int2obj(incr);
 	return result;
 }
 
 OBJ primListAddLast(int argCount, OBJ *args) {
 	// Add the given item to the end of the List. Grow if necessary.
 
+	if (!ensureList(args, 1)) return falseObj;
 	OBJ list = args[1];
 	if (!IS_TYPE(list, ListType)) return fail(needsListError);
 
@@ -338,6 +386,7 @@ OBJ primListDelete(int argCount, OBJ *args) {
 	// Delete item(s) from the given List.
 
 	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureList(args, 1)) return falseObj;
 	if (!IS_TYPE(args[1], ListType)) return fail(needsListError);
 	OBJ list = args[1];
 	int count = obj2int(FIELD(list, 0));
@@ -373,6 +422,115 @@ OBJ primListDelete(int argCount, OBJ *args) {
 	return falseObj;
 }
 
+// In-place list operations
+//
+// These primitives modify a List in place rather than building a new one. They use spare
+// capacity (fields beyond the item count) when available and otherwise grow the List by
+// half its size, so building a large list in batches copies each item a constant number
+// of times on average.
+
+static OBJ growList(OBJ list, int neededCount) {
+	// Ensure that the given List has room for at least neededCount items. Return the
+	// (possibly relocated) List, or falseObj if there is not enough memory.
+
+	int capacity = WORDS(list) - 1;
+	if (neededCount <= capacity) return list;
+
+	int newCapacity = capacity + (capacity / 2);
+	if (newCapacity < neededCount) newCapacity = neededCount;
+	list = resizeObj(list, newCapacity + 1);
+	if ((WORDS(list) - 1) < neededCount) return falseObj; // allocation failed
+	return list;
+}
+
+static int listCount(OBJ list) {
+	int count = obj2int(FIELD(list, 0));
+	if (count >= WORDS(list)) count = WORDS(list) - 1;
+	return count;
+}
+
+static OBJ insertItems(OBJ *args, int listArg, int index, int itemsArg) {
+	// Insert the items of args[itemsArg] (a List or Range) into the List args[listArg] before
+	// the given index (one-based). An index of count + 1 appends the items.
+
+	if (!ensureList(args, listArg)) return falseObj;
+	OBJ list = args[listArg];
+	OBJ items = args[itemsArg];
+	if (!IS_TYPE(list, ListType)) return fail(needsListError);
+	if (!(IS_TYPE(items, ListType) || IS_TYPE(items, RangeType))) return fail(needsListError);
+
+	int count = listCount(list);
+	int addCount = IS_TYPE(items, RangeType) ? RANGE_COUNT(items) : listCount(items);
+	if ((index < 1) || (index > (count + 1))) return fail(indexOutOfRangeError);
+	if (0 == addCount) return falseObj;
+
+	int inserted = (list == items); // inserting a list into itself
+	list = growList(list, count + addCount);
+	if (!list) return falseObj;
+	items = inserted ? list : args[itemsArg]; // update after possible GC
+
+	// open a gap for the new items
+	OBJ *gap = &FIELD(list, index);
+	memmove(gap + addCount, gap, (count - index + 1) * sizeof(OBJ));
+
+	if (IS_TYPE(items, RangeType)) {
+		for (int i = 0; i < addCount; i++) gap[i] = rangeAt(items, i + 1);
+	} else if (inserted) {
+		// source items were split by the gap
+		int before = index - 1;
+		memcpy(gap, &FIELD(list, 1), before * sizeof(OBJ));
+		memcpy(gap + before, gap + addCount, (addCount - before) * sizeof(OBJ));
+	} else {
+		memcpy(gap, &FIELD(items, 1), addCount * sizeof(OBJ));
+	}
+	FIELD(list, 0) = int2obj(count + addCount);
+	return falseObj;
+}
+
+OBJ primListExtend(int argCount, OBJ *args) {
+	// Append all items of the second argument (a List) to the first List.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureList(args, 0)) return falseObj;
+	if (!IS_TYPE(args[0], ListType)) return fail(needsListError);
+	return insertItems(args, 0, listCount(args[0]) + 1, 1);
+}
+
+OBJ primListInsertRange(int argCount, OBJ *args) {
+	// Insert all items of a List into another List before the given index:
+	//	insertRange list index items
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	if (!isInt(args[1])) return fail(needsIntegerIndexError);
+	return insertItems(args, 0, obj2int(args[1]), 2);
+}
+
+OBJ primListDeleteRange(int argCount, OBJ *args) {
+	// Delete the items between the given indices (inclusive) from a List:
+	//	deleteRange list startIndex [endIndex]
+	// If endIndex is omitted, delete to the end of the List.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureList(args, 0)) return falseObj;
+	OBJ list = args[0];
+	if (!IS_TYPE(list, ListType)) return fail(needsListError);
+	if (!isInt(args[1]) || ((argCount > 2) && !isInt(args[2]))) return fail(needsIntegerIndexError);
+
+	int count = listCount(list);
+	int startIndex = obj2int(args[1]);
+	int endIndex = (argCount > 2) ? obj2int(args[2]) : count;
+	if (startIndex < 1) startIndex = 1;
+	if (endIndex > count) endIndex = count;
+	if (startIndex > endIndex) return falseObj; // nothing to delete
+
+	int deleteCount = (endIndex - startIndex) + 1;
+	OBJ *dst = &FIELD(list, startIndex);
+	memmove(dst, dst + deleteCount, (count - endIndex) * sizeof(OBJ));
+	for (int i = (count - deleteCount) + 1; i <= count; i++) FIELD(list, i) = zeroObj; // clear unused fields
+	FIELD(list, 0) = int2obj(count - deleteCount);
+	return falseObj;
+}
+
 OBJ primCopyFromTo(int argCount, OBJ *args) {
 	// Return a copy of the first argument (a string or list) between the indices give by the
 	// second and third arguments. If the optional third argument is not supplied it is taken
@@ -385,7 +543,21 @@ OBJ primCopyFromTo(int argCount, OBJ *args) {
 	if ((argCount > 2) && !isInt(args[2])) return fail(needsIntegerError);
 
 	OBJ src = args[0];
-	if (IS_TYPE(src, ListType)) {
+	if (IS_TYPE(src, RangeType)) { // return a subrange
+		int srcLen = RANGE_COUNT(src);
+		int endIndex = (argCount > 2) ? obj2int(args[2]) : srcLen;
+		if (endIndex > srcLen) endIndex = srcLen;
+		int resultLen = (endIndex - startIndex) + 1;
+		if (resultLen < 0) resultLen = 0;
+		OBJ result = newObj(RangeType, 3, zeroObj);
+		if (result) {
+			src = args[0]; // update src after possible GC
+			FIELD(result, 0) = (resultLen > 0) ? rangeAt(src, startIndex) : zeroObj;
+			FIELD(result, 1) = int2obj(resultLen);
+			FIELD(result, 2) = FIELD(src, 2);
+		}
+		return result;
+	} else if (IS_TYPE(src, ListType)) {
 		int srcLen = obj2int(FIELD(src, 0));
 		int endIndex = (argCount > 2) ? obj2int(args[2]) : srcLen;
 		if (endIndex > srcLen) endIndex = srcLen;
@@ -443,6 +615,10 @@ OBJ primJoin(int argCount, OBJ *args) {
 	OBJ arg, arg1 = args[0];
 	OBJ result = falseObj;
 
+	for (int i = 0; i < argCount; i++) {
+		if (!ensureListCopy(args, i)) return falseObj;
+	}
+	arg1 = args[0];
 	if (IS_TYPE(arg1, ListType)) {
 		for (int i = 0; i < argCount; i++) {
 			arg = args[i];
@@ -589,6 +765,7 @@ OBJ primSplit(int argCount, OBJ *args) {
 
 OBJ primJoinStrings(int argCount, OBJ *args) {
 	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	if (!IS_TYPE(args[0], ListType)) return fail(needsListError);
 
 	OBJ stringList = args[0];
@@ -643,6 +820,25 @@ OBJ primJoinStrings(int argCount, OBJ *args) {
 	return result;
 }
 
+static int findBytes(uint8 *target, int targetSize, uint8 *sought, int soughtSize, int startOffset) {
+	// Return the one-based index of the first occurrence of sought in target at or after
+	// startOffset, or -1 if not found.
+
+	int lastPotenialMatch = targetSize - soughtSize;
+	uint8 *soughtEnd = sought + soughtSize;
+	for (int i = startOffset - 1; i <= lastPotenialMatch; i++) {
+		uint8 *p1 = target + i;
+		uint8 *p2 = sought;
+		while (p2 < soughtEnd) {
+			if (*p1 != *p2) break;
+			p1++;
+			p2++;
+		}
+		if (p2 == soughtEnd) return i + 1; // found a match!
+	}
+	return -1;
+}
+
 OBJ primFind(int argCount, OBJ *args) {
 	// If both arguments are strings, return the index of next instance the second string
 	// in the first or -1 if not found. If the second argument is a list, return the index
@@ -656,12 +852,19 @@ OBJ primFind(int argCount, OBJ *args) {
 	if (startOffset < 1) startOffset = 1;
 
 	if (IS_TYPE(arg1, StringType)) { // search for substring in a string
-		if (!(IS_TYPE(arg0, StringType))) return fail(needsStringError);
+		if (!(IS_TYPE(arg0, StringType) || IS_TYPE(arg0, ByteArrayType))) return fail(needsStringError);
 		if (startOffset > stringSize(arg1)) return int2obj(-1); // not found
 		char *s = obj2str(arg1);
-		char *sought = obj2str(arg0);
-		if (0 == sought[0]) return int2obj(-1); // empty string
-		char *match = strstr(s + startOffset - 1, sought);
+		char *match = NULL;
+		if (IS_TYPE(arg0, ByteArrayType)) { // search for the bytes of a ByteArray
+			if (0 == BYTES(arg0)) return int2obj(-1); // empty byte array
+			int i = findBytes((uint8 *) s, stringSize(arg1), (uint8 *) &FIELD(arg0, 0), BYTES(arg0), startOffset);
+			if (i > 0) match = s + i - 1;
+		} else {
+			char *sought = obj2str(arg0);
+			if (0 == sought[0]) return int2obj(-1); // empty string
+			match = strstr(s + startOffset - 1, sought);
+		}
 		if (!match) return int2obj(-1);
 		// count the Unicode characters up to match
 		int charIndex = 1;
@@ -670,6 +873,14 @@ OBJ primFind(int argCount, OBJ *args) {
 			charIndex++;
 		}
 		return int2obj(charIndex);
+	} else if (IS_TYPE(arg1, RangeType)) { // search in a range
+		if (!isInt(arg0)) return int2obj(-1);
+		int offset = obj2int(arg0) - obj2int(FIELD(arg1, 0));
+		int step = obj2int(FIELD(arg1, 2));
+		if ((offset % step) != 0) return int2obj(-1);
+		int i = (offset / step) + 1;
+		if ((i < startOffset) || (i > RANGE_COUNT(arg1))) return int2obj(-1);
+		return int2obj(i);
 	} else if (IS_TYPE(arg1, ListType)) { // search in a list
 		int listCount = obj2int(FIELD(arg1, 0));
 		if (startOffset > listCount) return int2obj(-1); // not found
@@ -712,19 +923,7 @@ OBJ primFind(int argCount, OBJ *args) {
 			// a ByteArray can be searched for a String or ByteArray
 			return fail(nonComparableError);
 		}
-		int lastPotenialMatch = targetSize - soughtSize;
-		uint8 *soughtEnd = sought + soughtSize;
-		for (int i = startOffset - 1; i <= lastPotenialMatch; i++) {
-			uint8 *p1 = target + i;
-			uint8 *p2 = sought;
-			while (p2 < soughtEnd) {
-				if (*p1 != *p2) break;
-				p1++;
-				p2++;
-			}
-			if (p2 == soughtEnd) return int2obj(i + 1); // found a match!
-		}
-		return int2obj(-1);
+		return int2obj(findBytes(target, targetSize, sought, soughtSize, startOffset));
 	}
 	return int2obj(-1);
 }
@@ -750,6 +949,7 @@ OBJ primUnicodeString(int argCount, OBJ *args) {
 	// Return a string containing the given Unicode character(s).
 
 	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	OBJ arg = args[0];
 
 	if (isInt(arg) || IS_TYPE(arg, StringType)) { // convert a single integer to a Unicode character
@@ -801,6 +1001,7 @@ OBJ primNewByteArray(int argCount, OBJ *args) {
 
 OBJ primAsByteArray(int argCount, OBJ *args) {
 	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	OBJ arg = args[0];
 	OBJ result = falseObj;
 	int byteCount;
@@ -847,6 +1048,275 @@ OBJ primFreeMemory(int argCount, OBJ *args) {
 	return int2obj(wordsFree());
 }
 
+// Encoding and formatting
+//
+// These primitives return a new String (or ByteArray) or, if the optional destination
+// argument is a ByteArray, write their output into it and return the number of bytes
+// written. Reusing a destination buffer avoids allocation in loops.
+
+static uint8 * bytesOf(OBJ obj, int *byteCount) {
+	// Return a pointer to the bytes of a String or ByteArray and set byteCount.
+	// Return NULL if obj is neither.
+
+	if (IS_TYPE(obj, StringType)) {
+		*byteCount = stringSize(obj);
+		return (uint8 *) obj2str(obj);
+	} else if (IS_TYPE(obj, ByteArrayType)) {
+		*byteCount = BYTES(obj);
+		return (uint8 *) &FIELD(obj, 0);
+	}
+	*byteCount = 0;
+	return NULL;
+}
+
+static OBJ outputBuffer(int argCount, OBJ *args, int dstArg, int byteCount, int type) {
+	// Return the destination ByteArray args[dstArg], if supplied, or a new String or ByteArray
+	// (depending on type) with room for byteCount bytes. Return falseObj on failure.
+
+	if (argCount > dstArg) {
+		OBJ dst = args[dstArg];
+		if (!IS_TYPE(dst, ByteArrayType)) return fail(needsByteArray);
+		if (BYTES(dst) < byteCount) return fail(indexOutOfRangeError);
+		return dst;
+	}
+	if (StringType == type) return newString(byteCount);
+	OBJ result = newObj(ByteArrayType, (byteCount + 3) / 4, falseObj);
+	if (result) setByteCountAdjust(result, byteCount);
+	return result;
+}
+
+static OBJ outputBytes(int argCount, OBJ *args, int dstArg, const char *bytes, int byteCount) {
+	// Return a new String containing the given bytes or copy them into the destination
+	// ByteArray args[dstArg], if supplied, and return the byte count.
+
+	OBJ result = outputBuffer(argCount, args, dstArg, byteCount, StringType);
+	if (!result) return result;
+	memcpy(&FIELD(result, 0), bytes, byteCount);
+	return (argCount > dstArg) ? int2obj(byteCount) : result;
+}
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static int hexDigitValue(int ch) {
+	if (('0' <= ch) && (ch <= '9')) return ch - '0';
+	if (('A' <= ch) && (ch <= 'F')) return ch - 'A' + 10;
+	if (('a' <= ch) && (ch <= 'f')) return ch - 'a' + 10;
+	return -1;
+}
+
+static inline int isSeparator(int ch) {
+	// Characters ignored when decoding hex or base64.
+	return (' ' == ch) || ('\t' == ch) || ('\r' == ch) || ('\n' == ch) || (':' == ch);
+}
+
+OBJ primHexEncode(int argCount, OBJ *args) {
+	// Return a String with two hex digits for each byte of a ByteArray or String.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	int srcCount;
+	if (!bytesOf(args[0], &srcCount)) return fail(needsByteArray);
+
+	OBJ result = outputBuffer(argCount, args, 1, 2 * srcCount, StringType);
+	if (!result) return result;
+
+	uint8 *src = bytesOf(args[0], &srcCount); // update src after possible GC
+	char *dst = (char *) &FIELD(result, 0);
+	for (int i = 0; i < srcCount; i++) {
+		*dst++ = hexDigits[src[i] >> 4];
+		*dst++ = hexDigits[src[i] & 15];
+	}
+	return (argCount > 1) ? int2obj(2 * srcCount) : result;
+}
+
+OBJ primHexDecode(int argCount, OBJ *args) {
+	// Return a ByteArray containing the bytes encoded by a String of hex digit pairs.
+	// Spaces, line breaks, and colons between pairs are ignored.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	int srcCount;
+	uint8 *src = bytesOf(args[0], &srcCount);
+	if (!src) return fail(needsStringError);
+
+	int digitCount = 0;
+	for (int i = 0; i < srcCount; i++) {
+		if (hexDigitValue(src[i]) >= 0) {
+			digitCount++;
+		} else if (!isSeparator(src[i])) {
+			return fail(badEncodedData);
+		}
+	}
+	if (digitCount & 1) return fail(badEncodedData);
+
+	int byteCount = digitCount / 2;
+	OBJ result = outputBuffer(argCount, args, 1, byteCount, ByteArrayType);
+	if (!result) return result;
+
+	src = bytesOf(args[0], &srcCount); // update src after possible GC
+	uint8 *dst = (uint8 *) &FIELD(result, 0);
+	int high = -1;
+	for (int i = 0; i < srcCount; i++) {
+		int digit = hexDigitValue(src[i]);
+		if (digit < 0) continue;
+		if (high < 0) {
+			high = digit;
+		} else {
+			*dst++ = (high << 4) | digit;
+			high = -1;
+		}
+	}
+	return (argCount > 1) ? int2obj(byteCount) : result;
+}
+
+static const char base64Digits[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int base64DigitValue(int ch) {
+	// Return the value of a base64 digit. Accept both the standard and URL-safe alphabets.
+
+	if (('A' <= ch) && (ch <= 'Z')) return ch - 'A';
+	if (('a' <= ch) && (ch <= 'z')) return ch - 'a' + 26;
+	if (('0' <= ch) && (ch <= '9')) return ch - '0' + 52;
+	if (('+' == ch) || ('-' == ch)) return 62;
+	if (('/' == ch) || ('_' == ch)) return 63;
+	return -1;
+}
+
+OBJ primBase64Encode(int argCount, OBJ *args) {
+	// Return a String with the base64 encoding (with padding) of a ByteArray or String.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	int srcCount;
+	if (!bytesOf(args[0], &srcCount)) return fail(needsByteArray);
+
+	int resultCount = 4 * ((srcCount + 2) / 3);
+	OBJ result = outputBuffer(argCount, args, 1, resultCount, StringType);
+	if (!result) return result;
+
+	uint8 *src = bytesOf(args[0], &srcCount); // update src after possible GC
+	char *dst = (char *) &FIELD(result, 0);
+	int i = 0;
+	for (; (i + 3) <= srcCount; i += 3) {
+		uint32 n = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+		*dst++ = base64Digits[(n >> 18) & 63];
+		*dst++ = base64Digits[(n >> 12) & 63];
+		*dst++ = base64Digits[(n >> 6) & 63];
+		*dst++ = base64Digits[n & 63];
+	}
+	int remaining = srcCount - i;
+	if (remaining > 0) {
+		uint32 n = src[i] << 16;
+		if (remaining > 1) n |= src[i + 1] << 8;
+		*dst++ = base64Digits[(n >> 18) & 63];
+		*dst++ = base64Digits[(n >> 12) & 63];
+		*dst++ = (remaining > 1) ? base64Digits[(n >> 6) & 63] : '=';
+		*dst++ = '=';
+	}
+	return (argCount > 1) ? int2obj(resultCount) : result;
+}
+
+OBJ primBase64Decode(int argCount, OBJ *args) {
+	// Return a ByteArray containing the bytes encoded by a base64 String. Padding is optional
+	// and spaces and line breaks are ignored.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	int srcCount;
+	uint8 *src = bytesOf(args[0], &srcCount);
+	if (!src) return fail(needsStringError);
+
+	int digitCount = 0;
+	for (int i = 0; i < srcCount; i++) {
+		if (base64DigitValue(src[i]) >= 0) {
+			digitCount++;
+		} else if ('=' == src[i]) {
+			break; // padding ends the data
+		} else if (!isSeparator(src[i])) {
+			return fail(badEncodedData);
+		}
+	}
+	if (1 == (digitCount & 3)) return fail(badEncodedData); // a single leftover digit is not valid
+
+	int byteCount = (3 * digitCount) / 4;
+	OBJ result = outputBuffer(argCount, args, 1, byteCount, ByteArrayType);
+	if (!result) return result;
+
+	src = bytesOf(args[0], &srcCount); // update src after possible GC
+	uint8 *dst = (uint8 *) &FIELD(result, 0);
+	uint8 *end = dst + byteCount;
+	uint32 bits = 0;
+	int bitCount = 0;
+	for (int i = 0; (i < srcCount) && (dst < end); i++) {
+		int digit = base64DigitValue(src[i]);
+		if (digit < 0) continue;
+		bits = (bits << 6) | digit;
+		bitCount += 6;
+		if (bitCount >= 8) {
+			bitCount -= 8;
+			*dst++ = (bits >> bitCount) & 255;
+		}
+	}
+	return (argCount > 1) ? int2obj(byteCount) : result;
+}
+
+OBJ primFormatInt(int argCount, OBJ *args) {
+	// Return a String for an integer in the given radix (2-36, default 10), padded with
+	// leading zeros to at least the given number of digits. Negative numbers are shown with
+	// a minus sign in radix 10 and as unsigned 32-bit values in other radixes.
+	//	formatInt n [radix] [digits] [dst]
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!isInt(args[0])) return fail(needsIntegerError);
+	int n = obj2int(args[0]);
+	int radix = (argCount > 1) ? evalInt(args[1]) : 10;
+	int minDigits = (argCount > 2) ? evalInt(args[2]) : 1;
+	if ((radix < 2) || (radix > 36)) radix = 10;
+	if (minDigits > 32) minDigits = 32;
+
+	char buf[40];
+	char *p = &buf[sizeof(buf)]; // digits are generated from right to left
+	int isNegative = (n < 0) && (10 == radix);
+	uint32 value = isNegative ? -(uint32) n : (uint32) n;
+	int digitCount = 0;
+	do {
+		int digit = value % radix;
+		*--p = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+		value /= radix;
+		digitCount++;
+	} while (value > 0);
+	while (digitCount++ < minDigits) *--p = '0';
+	if (isNegative) *--p = '-';
+
+	return outputBytes(argCount, args, 3, p, &buf[sizeof(buf)] - p);
+}
+
+OBJ primFormatFixed(int argCount, OBJ *args) {
+	// Return a String for a fixed-point number with the given number of decimal places.
+	// For example, 12345 with two decimal places is "123.45" and -5 is "-0.05".
+	//	formatFixed n decimalPlaces [dst]
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!isInt(args[0])) return fail(needsIntegerError);
+	int n = obj2int(args[0]);
+	int places = evalInt(args[1]);
+	if (places < 0) places = 0;
+	if (places > 9) places = 9;
+
+	char buf[24];
+	char *p = &buf[sizeof(buf)]; // digits are generated from right to left
+	uint32 value = (n < 0) ? -(uint32) n : (uint32) n;
+	for (int i = 0; i < places; i++) {
+		*--p = '0' + (value % 10);
+		value /= 10;
+	}
+	if (places > 0) *--p = '.';
+	do {
+		*--p = '0' + (value % 10);
+		value /= 10;
+	} while (value > 0);
+	if (n < 0) *--p = '-';
+
+	return outputBytes(argCount, args, 2, p, &buf[sizeof(buf)] - p);
+}
+
 // Helper functions for convert primitive
 
 static OBJ stringToList(OBJ strObj) {
@@ -1008,10 +1478,27 @@ static OBJ singletonByteArray(OBJ anObj) {
 	return result;
 }
 
+static OBJ retypeByteArrayAsString(OBJ byteArrayObj) {
+	// Turn the given ByteArray into a String in place, without copying, and return it. All
+	// references to the ByteArray will see the String. The ByteArray is grown by one word if
+	// there is no room for the string terminator. Used when the caller gives up the ByteArray.
+
+	int byteCount = BYTES(byteArrayObj);
+	if (byteCount == (4 * WORDS(byteArrayObj))) { // no room for terminator
+		byteArrayObj = resizeObj(byteArrayObj, WORDS(byteArrayObj) + 1);
+		if ((4 * WORDS(byteArrayObj)) == byteCount) return falseObj; // allocation failed
+	}
+	*byteArrayObj = HEADER(StringType, WORDS(byteArrayObj)); // also clears byte count adjustment
+	char *s = (char *) &FIELD(byteArrayObj, 0);
+	memset(s + byteCount, 0, (4 * WORDS(byteArrayObj)) - byteCount); // terminator and padding
+	return byteArrayObj;
+}
+
 OBJ primConvertType(int argCount, OBJ *args) {
+	// Convert an object to the given type. If the optional third argument is true, the
+	// caller gives up the source object and a ByteArray may be converted to a String in place.
+
 	if (argCount < 2) return fail(notEnoughArguments);
-	OBJ srcObj = args[0];
-	int srcType = objType(srcObj);
 	char *dstTypeName = obj2str(args[1]);
 
 	int dstType = -1;
@@ -1022,6 +1509,14 @@ OBJ primConvertType(int argCount, OBJ *args) {
 	if (strcmp(dstTypeName, "byte array") == 0) dstType = ByteArrayType;
 	if (dstType < 0) return fail(unknownDatatype);
 
+	if (IS_TYPE(args[0], RangeType)) {
+		// a Range is already a list; for other types, convert a temporary List
+		if (ListType == dstType) return args[0];
+		if (!ensureListCopy(args, 0)) return falseObj;
+	}
+
+	OBJ srcObj = args[0];
+	int srcType = objType(srcObj);
 	char s[32];
 	char *srcStr;
 	OBJ result = srcObj; // default used when converting object to its current type
@@ -1115,7 +1610,11 @@ OBJ primConvertType(int argCount, OBJ *args) {
 			return int2obj(*((uint8 *) &FIELD(result, 0)));
 			break;
 		case StringType:
-			result = byteArrayToString(srcObj);
+			if ((argCount > 2) && (trueObj == args[2])) {
+				result = retypeByteArrayAsString(srcObj);
+			} else {
+				result = byteArrayToString(srcObj);
+			}
 			break;
 		case ListType:
 			result = byteArrayToList(srcObj);
@@ -1133,6 +1632,9 @@ static PrimEntry entries[] = {
 	{"range", primRange},
 	{"addLast", primListAddLast},
 	{"delete", primListDelete},
+	{"extend", primListExtend},
+	{"insertRange", primListInsertRange},
+	{"deleteRange", primListDeleteRange},
 	{"join", primJoin},
 	{"split", primSplit},
 	{"copyFromTo", primCopyFromTo},
@@ -1144,6 +1646,12 @@ static PrimEntry entries[] = {
 	{"asByteArray", primAsByteArray},
 	{"freeMemory", primFreeMemory},
 	{"convertType", primConvertType},
+	{"hexEncode", primHexEncode},
+	{"hexDecode", primHexDecode},
+	{"base64Encode", primBase64Encode},
+	{"base64Decode", primBase64Decode},
+	{"formatInt", primFormatInt},
+	{"formatFixed", primFormatFixed},
 };
 
 void addDataPrims() {
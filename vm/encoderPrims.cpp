@@ -4,15 +4,17 @@
 
 // Copyright 2024 John Maloney, Bernat Romagosa, and Jens Mönig
 
-// encoderPrims.cpp - Primitives to track quadrature encoders.
+// encoderPrims.cpp - Primitives to track quadrature encoders and pin events.
 // Russell Owen, August 2024
 
 #include <Arduino.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "mem.h"
 #include "interp.h"
+#include "pinEvents.h"
 
 /*
  * A quadrature incremental encoder
@@ -176,6 +178,45 @@ static OBJ primEncoderCount(int argCount, OBJ *args) {
 	return int2obj(result);
 }
 
+// Pin Events (see pinEvents.c)
+// The primitives are in pinEvents.c. As with the encoders, each slot has its own interrupt
+// handler. When capturing both edges, the handler reads the pin to learn which edge it was.
+
+static void recordPinEvent(int slot) {
+	PinEvents *pe = pinEvents_slot(slot);
+	int level = (PIN_EVENT_FALLING == pe->edges) ? 0 : 1;
+	if (PIN_EVENT_BOTH == pe->edges) level = digitalRead(pe->pin);
+	pinEvents_record(pe, level, microsecs());
+}
+
+static void pinEventHandler_0() { recordPinEvent(0); }
+static void pinEventHandler_1() { recordPinEvent(1); }
+static void pinEventHandler_2() { recordPinEvent(2); }
+static void pinEventHandler_3() { recordPinEvent(3); }
+static void pinEventHandler_4() { recordPinEvent(4); }
+static void pinEventHandler_5() { recordPinEvent(5); }
+static void pinEventHandler_6() { recordPinEvent(6); }
+static void pinEventHandler_7() { recordPinEvent(7); }
+
+static interruptHandler pinEventHandlers[PIN_EVENT_SLOTS] = {
+	pinEventHandler_0, pinEventHandler_1, pinEventHandler_2, pinEventHandler_3,
+	pinEventHandler_4, pinEventHandler_5, pinEventHandler_6, pinEventHandler_7,
+};
+
+static int attachPinEvents(int slot, int pin, int edges) {
+	int interrupt = digitalPinToInterrupt(pin);
+	if (interrupt == -1) return false; // pin does not support interrupts
+	int mode = (PIN_EVENT_RISING == edges) ? RISING : ((PIN_EVENT_FALLING == edges) ? FALLING : CHANGE);
+	attachInterrupt(interrupt, pinEventHandlers[slot], mode);
+	return true;
+}
+
+static void detachPinEvents(int pin) {
+	detachInterrupt(digitalPinToInterrupt(pin));
+}
+
+static PinEventDriver pinEventDriver = { attachPinEvents, detachPinEvents };
+
 // Primitives
 
 static PrimEntry entries[] = {
@@ -183,8 +224,16 @@ static PrimEntry entries[] = {
 	{"stop", primEncoderStop},
 	{"reset", primEncoderReset},
 	{"count", primEncoderCount},
+	{"pinEventsStart", primPinEventsStart},
+	{"pinEventsStop", primPinEventsStop},
+	{"pinEventCount", primPinEventCount},
+	{"pinEventIntervals", primPinEventIntervals},
+	{"pinPeriod", primPinPeriod},
+	{"pinPulseWidth", primPinPulseWidth},
+	{"pinFrequency", primPinFrequency},
 };
 
 void addEncoderPrims() {
+	pinEvents_setDriver(&pinEventDriver);
 	addPrimitiveSet(EncoderPrims, "encoder", sizeof(entries) / sizeof(PrimEntry), entries);
 }
@@ -251,6 +251,7 @@ static OBJ primAppendLine(int argCount, OBJ *args) {
 
 	if (argCount < 2) return fail(notEnoughArguments);
 	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	char *fileName = extractFilename(args[1]);
 	OBJ arg = args[0];
 
@@ -388,6 +389,168 @@ static OBJ primSystemInfo(int argCount, OBJ *args) {
 	return newStringFromBytes(result, strlen(result));
 }
 
+// Data Logging (see dataLog.c)
+// Records are buffered in RAM and written to the log files in blocks of the LittleFS
+// block size (less on the ESP8266, which has less RAM). The IDE downloads the log files
+// with the usual file transfer messages, so logging never waits for the serial port.
+
+#include "dataLog.h"
+
+#if defined(ESP8266)
+	#define DATA_LOG_BLOCK_BYTES 2048
+#else
+	#define DATA_LOG_BLOCK_BYTES 4096
+#endif
+
+static DataLog dataLog;
+static File logFile;
+static uint32 maxLogWriteUsecs = 0;
+
+static void logFilePath(char *fileName, char *path) {
+	snprintf(path, 32, "/%s", fileName);
+}
+
+static int logReadHeader(char *fileName, uint8 *buf, int byteCount) {
+	char path[32];
+	logFilePath(fileName, path);
+	if (!myFS.exists(path)) return 0; // avoids a LittleFS error message
+	File file = myFS.open(path, "r");
+	if (!file) return 0;
+	int result = file.read(buf, byteCount);
+	file.close();
+	return result;
+}
+
+static int logCreate(char *fileName) {
+	char path[32];
+	logFilePath(fileName, path);
+	closeIfOpen(path);
+	logFile = myFS.open(path, "w");
+	return logFile ? true : false;
+}
+
+static int logAppend(uint8 *data, int byteCount) {
+	uint32 startUsecs = microsecs();
+	int result = logFile.write(data, byteCount);
+	logFile.flush();
+	uint32 usecs = microsecs() - startUsecs;
+	if (usecs > maxLogWriteUsecs) maxLogWriteUsecs = usecs;
+	return result;
+}
+
+static void logClose() {
+	logFile.close();
+}
+
+static DataLogDriver logDriver = { logReadHeader, logCreate, logAppend, logClose };
+
+void flushDataLog() {
+	// Called before sending a file or the file list to the IDE and by flushLog.
+
+	dataLog_flush(&dataLog, &logDriver);
+}
+
+void checkDataLogFlush() {
+	dataLog_flushIfDue(&dataLog, millisecs(), &logDriver);
+}
+
+void stopDataLog() {
+	dataLog_stop(&dataLog, &logDriver);
+}
+
+static OBJ primStartLog(int argCount, OBJ *args) {
+	// Start logging records of the given number of values to files named <name>0.bin,
+	// <name>1.bin, etc. Optional arguments: the number of files (default: 4), the maximum
+	// size of a file in kilobytes (default: 64), and the bytes per value, 2 or 4 (default:
+	// 4). Return true if logging was started.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	char *baseName = obj2str(args[0]);
+	if ('/' == baseName[0]) baseName++; // skip leading "/"
+	int valueCount = obj2int(args[1]);
+	int fileCount = ((argCount > 2) && isInt(args[2])) ? obj2int(args[2]) : 4;
+	int fileKBytes = ((argCount > 3) && isInt(args[3])) ? obj2int(args[3]) : 64;
+	int valueBytes = ((argCount > 4) && isInt(args[4])) ? obj2int(args[4]) : 4;
+	if ((fileKBytes < 1) || (fileKBytes > 0x1FFFFF)) return fail(indexOutOfRangeError);
+
+	maxLogWriteUsecs = 0;
+	int ok = dataLog_start(&dataLog, baseName, valueCount, valueBytes,
+		fileCount, fileKBytes * 1024, DATA_LOG_BLOCK_BYTES, &logDriver);
+	return ok ? trueObj : falseObj;
+}
+
+static OBJ primLogRecord(int argCount, OBJ *args) {
+	// Add a record with the current time in milliseconds and the given integer values,
+	// either as separate arguments or as a list. Booleans are recorded as 1 or 0.
+
+	int values[DATA_LOG_MAX_VALUES];
+	int count = 0;
+	OBJ *items = args;
+	if ((1 == argCount) && !ensureListCopy(args, 0)) return falseObj;
+	if ((1 == argCount) && IS_TYPE(args[0], ListType)) {
+		argCount = obj2int(FIELD(args[0], 0));
+		items = &FIELD(args[0], 1);
+	}
+	for (int i = 0; (i < argCount) && (count < DATA_LOG_MAX_VALUES); i++) {
+		OBJ item = items[i];
+		if (isInt(item)) {
+			values[count++] = obj2int(item);
+		} else if (isBoolean(item)) {
+			values[count++] = (trueObj == item);
+		} else {
+			return fail(needsIntegerError);
+		}
+	}
+	dataLog_add(&dataLog, millisecs(), values, count, &logDriver);
+	return falseObj;
+}
+
+static OBJ primFlushLog(int argCount, OBJ *args) {
+	flushDataLog();
+	return falseObj;
+}
+
+static OBJ primStopLog(int argCount, OBJ *args) {
+	stopDataLog();
+	return falseObj;
+}
+
+static OBJ primLogFiles(int argCount, OBJ *args) {
+	// Return a list of the names of the log files, oldest first.
+
+	int indices[DATA_LOG_MAX_FILES];
+	int count = dataLog_filesInOrder(&dataLog, indices);
+	tempGCRoot = newObj(ListType, count + 1, zeroObj);
+	if (!tempGCRoot) return fail(insufficientMemoryError);
+	FIELD(tempGCRoot, 0) = int2obj(count);
+	for (int i = 0; i < count; i++) {
+		char fileName[32];
+		dataLog_fileName(&dataLog, indices[i], fileName, sizeof(fileName));
+		OBJ s = newStringFromBytes(fileName, strlen(fileName));
+		if (!s) break;
+		FIELD(tempGCRoot, i + 1) = s;
+	}
+	OBJ result = tempGCRoot;
+	tempGCRoot = NULL;
+	return result;
+}
+
+static OBJ primLogStats(int argCount, OBJ *args) {
+	// Return a list: records logged, records dropped, blocks written, and the longest
+	// block write in usecs.
+
+	OBJ result = newObj(ListType, 5, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(4);
+	FIELD(result, 1) = int2obj(dataLog.recordsLogged & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(dataLog.recordsDropped & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(dataLog.blocksWritten & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(maxLogWriteUsecs & 0x3FFFFFFF);
+	return result;
+}
+
 #else
 
 static OBJ primOpen(int argCount, OBJ *args) { return falseObj; }
@@ -406,6 +569,16 @@ static OBJ primStartFileList(int argCount, OBJ *args) { return falseObj; }
 static OBJ primNextFileInList(int argCount, OBJ *args) { return newString(0); }
 static OBJ primSystemInfo(int argCount, OBJ *args) { return falseObj; }
 
+void flushDataLog() { }
+void checkDataLogFlush() { }
+void stopDataLog() { }
+static OBJ primStartLog(int argCount, OBJ *args) { return falseObj; }
+static OBJ primLogRecord(int argCount, OBJ *args) { return falseObj; }
+static OBJ primFlushLog(int argCount, OBJ *args) { return falseObj; }
+static OBJ primStopLog(int argCount, OBJ *args) { return falseObj; }
+static OBJ primLogFiles(int argCount, OBJ *args) { return newObj(ListType, 1, zeroObj); }
+static OBJ primLogStats(int argCount, OBJ *args) { return falseObj; }
+
 #endif
 
 // Primitives
@@ -426,6 +599,12 @@ static PrimEntry entries[] = {
 	{"startList", primStartFileList},
 	{"nextInList", primNextFileInList},
 	{"systemInfo", primSystemInfo},
+	{"startLog", primStartLog},
+	{"logRecord", primLogRecord},
+	{"flushLog", primFlushLog},
+	{"stopLog", primStopLog},
+	{"logFiles", primLogFiles},
+	{"logStats", primLogStats},
 };
 
 void addFilePrims() {
@@ -186,6 +186,7 @@ void processFileMessage(int msgType, int dataSize, char *data) {
 		break;
 	case ListFilesMsg:
 		// format: no data (short message)
+		flushDataLog(); // so log file sizes are current
 		sendFileList();
 		break;
 	case StartReadingFileMsg:
@@ -194,6 +195,7 @@ void processFileMessage(int msgType, int dataSize, char *data) {
 		dataSize -= 4;
 		if (dataSize > 30) dataSize = 30;
 		strncat(fileName, &data[4], dataSize);
+		flushDataLog(); // include any buffered log records
 		sendFile(id, fileName);
 		break;
 	case StartWritingFileMsg:
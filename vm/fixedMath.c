@@ -0,0 +1,139 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// fixedMath.c - Integer sine, square root, and arctangent
+// agent, October 2026
+
+/*
+Integer versions of the MicroBlocks sine, square root, and arctangent functions for use
+in loops that process whole buffers. They use the same units as the misc:sin, misc:sqrt,
+and misc:atan2 primitives but avoid floating point, which is slow or emulated in software
+on many microcontrollers:
+
+	fixedSine: angle in hundredths of a degree -> sine * 16384, from a quarter-wave table
+		with linear interpolation (error at most 1)
+	fixedSqrt: integer square root rounded to the nearest integer (exact)
+	fixedAtan2: vector (x, y) -> angle in hundredths of a degree, -18000 to 18000, using
+		CORDIC vectoring (error at most 1)
+*/
+
+#include "fixedMath.h"
+
+// sine
+
+// sin(i * 90 / 256 degrees) * 16384 for i = 0..256
+static const unsigned short sineTable[257] = {
+	0, 101, 201, 302, 402, 503, 603, 704, 804, 904, 1005, 1105,
+	1205, 1306, 1406, 1506, 1606, 1706, 1806, 1906, 2006, 2105, 2205, 2305,
+	2404, 2503, 2603, 2702, 2801, 2900, 2999, 3098, 3196, 3295, 3393, 3492,
+	3590, 3688, 3786, 3883, 3981, 4078, 4176, 4273, 4370, 4467, 4563, 4660,
+	4756, 4852, 4948, 5044, 5139, 5235, 5330, 5425, 5520, 5614, 5708, 5803,
+	5897, 5990, 6084, 6177, 6270, 6363, 6455, 6547, 6639, 6731, 6823, 6914,
+	7005, 7096, 7186, 7276, 7366, 7456, 7545, 7635, 7723, 7812, 7900, 7988,
+	8076, 8163, 8250, 8337, 8423, 8509, 8595, 8680, 8765, 8850, 8935, 9019,
+	9102, 9186, 9269, 9352, 9434, 9516, 9598, 9679, 9760, 9841, 9921, 10001,
+	10080, 10159, 10238, 10316, 10394, 10471, 10549, 10625, 10702, 10778, 10853, 10928,
+	11003, 11077, 11151, 11224, 11297, 11370, 11442, 11514, 11585, 11656, 11727, 11797,
+	11866, 11935, 12004, 12072, 12140, 12207, 12274, 12340, 12406, 12472, 12537, 12601,
+	12665, 12729, 12792, 12854, 12916, 12978, 13039, 13100, 13160, 13219, 13279, 13337,
+	13395, 13453, 13510, 13567, 13623, 13678, 13733, 13788, 13842, 13896, 13949, 14001,
+	14053, 14104, 14155, 14206, 14256, 14305, 14354, 14402, 14449, 14497, 14543, 14589,
+	14635, 14680, 14724, 14768, 14811, 14854, 14896, 14937, 14978, 15019, 15059, 15098,
+	15137, 15175, 15213, 15250, 15286, 15322, 15357, 15392, 15426, 15460, 15493, 15525,
+	15557, 15588, 15619, 15649, 15679, 15707, 15736, 15763, 15791, 15817, 15843, 15868,
+	15893, 15917, 15941, 15964, 15986, 16008, 16029, 16049, 16069, 16088, 16107, 16125,
+	16143, 16160, 16176, 16192, 16207, 16221, 16235, 16248, 16261, 16273, 16284, 16295,
+	16305, 16315, 16324, 16332, 16340, 16347, 16353, 16359, 16364, 16369, 16373, 16376,
+	16379, 16381, 16383, 16384, 16384
+};
+
+int fixedSine(int hundredthsOfDegree) {
+	int angle = hundredthsOfDegree % 36000;
+	if (angle < 0) angle += 36000;
+
+	int negate = (angle >= 18000);
+	if (negate) angle -= 18000;
+	if (angle > 9000) angle = 18000 - angle; // sin(180 - a) = sin(a)
+
+	// angle is now 0..9000; find table entry and interpolate
+	int scaled = angle * 256; // position in table is scaled / 9000
+	int i = scaled / 9000;
+	int frac = scaled % 9000;
+	int result = sineTable[i];
+	if (frac) result += (((sineTable[i + 1] - result) * frac) + 4500) / 9000;
+	return negate ? -result : result;
+}
+
+// square root
+
+int fixedSqrt(int n) {
+	// Return the square root of |n| rounded to the nearest integer.
+
+	unsigned int value = (n < 0) ? -(unsigned int) n : (unsigned int) n;
+	unsigned int root = 0;
+	unsigned int bit = 1u << 30; // highest power of four <= 2^31
+	while (bit > value) bit >>= 2;
+	while (bit) {
+		if (value >= (root + bit)) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	// value is now n - root^2; round up if n >= (root + 0.5)^2, i.e. value > root
+	if (value > root) root++;
+	return (int) root;
+}
+
+// arctangent
+
+// atan(2^-i) in units of 1/256 of a hundredth of a degree
+static const int cordicAngles[16] = {
+	1152000, 680065, 359328, 182400, 91554, 45822, 22916, 11459,
+	5730, 2865, 1432, 716, 358, 179, 90, 45
+};
+
+int fixedAtan2(int y, int x) {
+	// Return the angle of the vector (x, y) in hundredths of a degree (-18000 to 18000).
+
+	if ((0 == x) && (0 == y)) return 0;
+
+	// normalize magnitude to 2^24..2^28 to keep precision and avoid overflow
+	while ((x > (1 << 27)) || (x < -(1 << 27)) || (y > (1 << 27)) || (y < -(1 << 27))) {
+		x >>= 1;
+		y >>= 1;
+	}
+	while ((x < (1 << 24)) && (x > -(1 << 24)) && (y < (1 << 24)) && (y > -(1 << 24))) {
+		x <<= 1;
+		y <<= 1;
+	}
+
+	// rotate into the right half-plane
+	int angle = 0;
+	if (x < 0) {
+		angle = (y >= 0) ? (18000 * 256) : (-18000 * 256);
+		x = -x;
+		y = -y;
+	}
+
+	// CORDIC vectoring: rotate (x, y) toward the x axis, accumulating the rotation
+	for (int i = 0; i < 16; i++) {
+		int dx = x >> i;
+		int dy = y >> i;
+		if (y > 0) {
+			x += dy;
+			y -= dx;
+			angle += cordicAngles[i];
+		} else {
+			x -= dy;
+			y += dx;
+			angle -= cordicAngles[i];
+		}
+	}
+	return (angle >= 0) ? ((angle + 128) >> 8) : -((-angle + 128) >> 8);
+}
@@ -0,0 +1,20 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// fixedMath.h - Integer sine, square root, and arctangent
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int fixedSine(int hundredthsOfDegree);
+int fixedSqrt(int n);
+int fixedAtan2(int y, int x);
+
+#ifdef __cplusplus
+}
+#endif
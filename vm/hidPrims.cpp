@@ -13,6 +13,7 @@
 
 #include "mem.h"
 #include "interp.h"
+#include "hidQueue.h"
 
 #if (defined(ARDUINO_ARCH_SAMD) || \
 	(defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)))
@@ -21,14 +22,102 @@
 #include "Mouse.h"
 
 #if defined(ARDUINO_ARCH_RP2040)
-	#define DELAY_IF_NEEDED() { taskSleep(12); } // workaround for issue with Pico HID library
+	// The Pico HID library drops reports sent before the previous one was taken by the host,
+	// so wait until TinyUSB is ready for the next report.
+	#include "tusb.h"
+	#define HID_READY() (tud_hid_ready())
 #else
-	#define DELAY_IF_NEEDED() { } // noop on SAM boards
+	#define HID_READY() (true) // SAM boards wait until each report is sent
 #endif
 
+#define MIN_REPORT_INTERVAL 1000 // usecs; the shortest USB HID polling interval
+
 char mouseInitialized = 0;
 char keyboardInitialized = 0;
 
+// Background report sender
+
+static HIDQueue hidQueue;
+static int hidQueueInitialized = false;
+
+static int hidReady() { return HID_READY(); }
+
+static void hidSend(HIDAction *action) {
+	switch (action->type) {
+	case hid_KeyPress:
+		Keyboard.press(action->key);
+		break;
+	case hid_KeyRelease:
+		Keyboard.release(action->key);
+		break;
+	case hid_ReleaseAllKeys:
+		Keyboard.releaseAll();
+		break;
+	case hid_MouseMove:
+		Mouse.move(action->dx, action->dy, 0);
+		break;
+	case hid_MouseScroll:
+		Mouse.move(0, 0, action->dx);
+		break;
+	case hid_MousePress:
+		Mouse.press(action->key);
+		break;
+	case hid_MouseRelease:
+		Mouse.release(action->key);
+		break;
+	}
+}
+
+static HIDSink usbSink = { hidReady, hidSend };
+
+static int initHIDQueue() {
+	// Allocate the queue on first use. Return false if there isn't enough memory.
+
+	if (!hidQueueInitialized) hidQueueInitialized = hidQueue_init(&hidQueue, MIN_REPORT_INTERVAL);
+	return hidQueueInitialized;
+}
+
+void sendQueuedHIDReports() {
+	// Called from the VM loop to send queued reports in the background.
+
+	if (hidQueueInitialized && hidQueue.count) hidQueue_run(&hidQueue, microsecs(), &usbSink);
+}
+
+void resetHID() {
+	// Discard queued reports and release all keys and mouse buttons (e.g. when stopping all tasks).
+
+	if (!hidQueueInitialized) return;
+	hidQueue_clear(&hidQueue);
+	if (keyboardInitialized) hidQueue_add(&hidQueue, hid_ReleaseAllKeys, 0, 0, 0);
+	if (mouseInitialized) hidQueue_add(&hidQueue, hid_MouseRelease, MOUSE_ALL, 0, 0);
+}
+
+static int hidRoom(int actionCount) {
+	// Return true if there is room to queue the given number of actions. Otherwise, fail
+	// rather than waiting for the host to take reports, which would block all tasks.
+
+	if (!initHIDQueue()) { fail(insufficientMemoryError); return false; }
+	if (hidQueue_space(&hidQueue) < actionCount) { fail(hidQueueFull); return false; }
+	return true;
+}
+
+static void queueAction(int type, int key, int dx, int dy) {
+	// Queue an action. The caller checks for room first with hidRoom().
+
+	hidQueue_add(&hidQueue, type, key, dx, dy);
+}
+
+static int modifierKey(int modifier) {
+	switch (modifier) {
+		case 1: return KEY_LEFT_SHIFT;
+		case 2: return KEY_LEFT_CTRL;
+		case 3: return KEY_LEFT_ALT; // option on Mac
+		case 4: return KEY_LEFT_GUI; // command on Mac
+		case 5: return KEY_RIGHT_ALT; // AltGr (option on Mac)
+	}
+	return 0;
+}
+
 void initMouse () {
 	if (!mouseInitialized) {
 		Mouse.begin();
@@ -50,115 +139,149 @@ OBJ primMouseMove(int argCount, OBJ *args) {
 	int deltaY = obj2int(args[1]);
 
 	if (deltaX > 127) deltaX = 127;
-	if (deltaX < -128) deltaX = -128;
+	if (deltaX < -127) deltaX = -127;
 	if (deltaY > 127) deltaY = 127;
-	if (deltaY < -128) deltaY = -128;
+	if (deltaY < -127) deltaY = -127;
 
-	Mouse.move(deltaX, deltaY);
-	DELAY_IF_NEEDED();
+	if (!hidRoom(1)) return falseObj;
+	queueAction(hid_MouseMove, 0, deltaX, deltaY);
 	return falseObj;
 }
 
+OBJ primMousePath(int argCount, OBJ *args) {
+	// Queue a sequence of relative mouse moves given as a list of alternating x and y
+	// deltas. Moves too large for a single report are split into steps. Return the number
+	// of moves queued; it is less than the number given if the queue filled up.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
+	OBJ path = args[0];
+	if (!IS_TYPE(path, ListType)) return fail(needsListError);
+	initMouse();
+	if (!initHIDQueue()) return fail(insufficientMemoryError);
+
+	int count = obj2int(FIELD(path, 0)) / 2;
+	int i;
+	for (i = 0; i < count; i++) {
+		OBJ dx = FIELD(path, (2 * i) + 1);
+		OBJ dy = FIELD(path, (2 * i) + 2);
+		if (!isInt(dx) || !isInt(dy)) return fail(needsIntegerError);
+		if (!hidQueue_mouseMove(&hidQueue, obj2int(dx), obj2int(dy))) break; // queue is full
+	}
+	return int2obj(i);
+}
+
 OBJ primMousePress(int argCount, OBJ *args) {
 	initMouse();
 	int button = obj2int(args[0]);
 
-	Mouse.press(button);
-	DELAY_IF_NEEDED();
+	if (!hidRoom(1)) return falseObj;
+	queueAction(hid_MousePress, button, 0, 0);
 	return falseObj;
 }
 
 OBJ primMouseRelease(int argCount, OBJ *args) {
 	initMouse();
 
-	for (int i = 1; i < 5; i++) {
-		Mouse.release(i);
-		DELAY_IF_NEEDED();
-	}
+	if (!hidRoom(1)) return falseObj;
+	queueAction(hid_MouseRelease, MOUSE_ALL, 0, 0);
 	return falseObj;
 }
 
 OBJ primMouseScroll(int argCount, OBJ *args) {
 	initMouse();
 	int delta = obj2int(args[0]);
-	Mouse.move(0, 0, delta);
-	DELAY_IF_NEEDED();
+	if (delta > 127) delta = 127;
+	if (delta < -127) delta = -127;
+
+	if (!hidRoom(1)) return falseObj;
+	queueAction(hid_MouseScroll, 0, delta, 0);
 	return falseObj;
 }
 
 OBJ primPressKey(int argCount, OBJ *args) {
 	initKeyboard();
 	OBJ key = args[0];
-	int modifier = (argCount > 1) ? obj2int(args[1]) : 0;
-	if (modifier) {
-		switch (modifier) {
-			case 1: // shift
-				Keyboard.press(KEY_LEFT_SHIFT);
-				break;
-			case 2: // control
-				Keyboard.press(KEY_LEFT_CTRL);
-				break;
-			case 3: // alt (option on Mac)
-				Keyboard.press(KEY_LEFT_ALT);
-				break;
-			case 4: // meta (command on Mac)
-				Keyboard.press(KEY_LEFT_GUI);
-				break;
-			case 5: // AltGr (option on Mac)
-				Keyboard.press(KEY_RIGHT_ALT);
-				break;
-		}
-		DELAY_IF_NEEDED();
-	}
+	int modifier = (argCount > 1) ? modifierKey(obj2int(args[1])) : 0;
 
 	// accept both characters and ASCII values
+	int ch = -1;
 	if (IS_TYPE(key, StringType)) {
-		Keyboard.write(obj2str(key)[0]);
+		ch = obj2str(key)[0];
 	} else if (isInt(key)) {
-		Keyboard.write(obj2int(key));
+		ch = obj2int(key);
+	}
+	if (!hidRoom(4)) return falseObj; // queue all the actions or none of them
+	if (modifier) queueAction(hid_KeyPress, modifier, 0, 0);
+	if (ch >= 0) {
+		queueAction(hid_KeyPress, ch, 0, 0);
+		queueAction(hid_KeyRelease, ch, 0, 0);
 	}
-	DELAY_IF_NEEDED();
 
-	if (modifier) Keyboard.releaseAll();
+	if (modifier) queueAction(hid_ReleaseAllKeys, 0, 0, 0);
 	return falseObj;
 }
 
+OBJ primTypeString(int argCount, OBJ *args) {
+	// Queue key strokes to type the given string, optionally holding a modifier key
+	// (same codes as pressKey). Return immediately; the reports are sent in the background.
+	// Return the number of characters queued; it is less than the string size if the queue filled up.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	initKeyboard();
+	if (!initHIDQueue()) return fail(insufficientMemoryError);
+
+	int modifier = ((argCount > 1) && isInt(args[1])) ? modifierKey(obj2int(args[1])) : 0;
+	return int2obj(hidQueue_typeString(&hidQueue, obj2str(args[0]), modifier));
+}
+
+OBJ primHIDQueueCount(int argCount, OBJ *args) {
+	// Return the number of reports waiting to be sent.
+
+	return int2obj(hidQueueInitialized ? hidQueue.count : 0);
+}
+
 OBJ primHoldKey(int argCount, OBJ *args) {
 	initKeyboard();
 	OBJ key = args[0];
+	if (!hidRoom(1)) return falseObj;
 
 	// accept both characters and ASCII values
 	if (IS_TYPE(key, StringType)) {
-		Keyboard.press(obj2str(key)[0]);
+		queueAction(hid_KeyPress, obj2str(key)[0], 0, 0);
 	} else if (isInt(key)) {
-		Keyboard.press(obj2int(key));
+		queueAction(hid_KeyPress, obj2int(key), 0, 0);
 	}
-	DELAY_IF_NEEDED();
 	return falseObj;
 }
 
 OBJ primReleaseKey(int argCount, OBJ *args) {
 	initKeyboard();
 	OBJ key = args[0];
+	if (!hidRoom(1)) return falseObj;
 
 	// accept both characters and ASCII values
 	if (IS_TYPE(key, StringType)) {
-		Keyboard.release(obj2str(key)[0]);
+		queueAction(hid_KeyRelease, obj2str(key)[0], 0, 0);
 	} else if (isInt(key)) {
-		Keyboard.release(obj2int(key));
+		queueAction(hid_KeyRelease, obj2int(key), 0, 0);
 	}
-	DELAY_IF_NEEDED();
 	return falseObj;
 }
 
 OBJ primReleaseAllKeys(int argCount, OBJ *args) {
-	Keyboard.releaseAll();
-	DELAY_IF_NEEDED();
+	initKeyboard();
+	if (!hidRoom(1)) return falseObj;
+	queueAction(hid_ReleaseAllKeys, 0, 0, 0);
 	return falseObj;
 }
 
 #else
 
+void sendQueuedHIDReports() { }
+void resetHID() { }
+
 // stubs
 OBJ primMouseMove(int argCount, OBJ *args) { return falseObj; }
 OBJ primMousePress(int argCount, OBJ *args) { return falseObj; }
@@ -168,6 +291,9 @@ OBJ primPressKey(int argCount, OBJ *args) { return falseObj; }
 OBJ primHoldKey(int argCount, OBJ *args) { return falseObj; }
 OBJ primReleaseKey(int argCount, OBJ *args) { return falseObj; }
 OBJ primReleaseAllKeys(int argCount, OBJ *args) { return falseObj; }
+OBJ primMousePath(int argCount, OBJ *args) { return falseObj; }
+OBJ primTypeString(int argCount, OBJ *args) { return falseObj; }
+OBJ primHIDQueueCount(int argCount, OBJ *args) { return zeroObj; }
 
 #endif
 
@@ -182,6 +308,9 @@ static PrimEntry entries[] = {
 	{"holdKey", primHoldKey},
 	{"releaseKey", primReleaseKey},
 	{"releaseKeys", primReleaseAllKeys},
+	{"mousePath", primMousePath},
+	{"typeString", primTypeString},
+	{"queueCount", primHIDQueueCount},
 };
 
 void addHIDPrims() {
@@ -0,0 +1,123 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// hidQueue.c - Queue and scheduler for keyboard and mouse reports
+// agent, October 2026
+
+/*
+HID Queue
+
+Keyboard and mouse primitives add actions to this queue and return at once. The VM loop
+calls hidQueue_run() in the background to send the queued actions, one HID report each,
+as fast as the USB stack accepts them: an action is sent only when the sink reports that
+the stack is ready and at least minInterval usecs have passed since the previous report.
+
+Typing a string queues a press and a release for every character, so repeated characters
+are seen as separate key strokes. A modifier key, if any, is held for the whole string.
+Long mouse moves are split into steps that fit into a report (-127 to 127).
+
+The queue is allocated when it is first initialized, so boards that never use the keyboard
+or mouse primitives don't spend RAM on it.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "hidQueue.h"
+
+int hidQueue_init(HIDQueue *q, uint32 minInterval) {
+	// Initialize the queue, allocating its actions if needed. Return false if that failed.
+
+	HIDAction *actions = q->actions;
+	if (!actions) actions = (HIDAction *) malloc(HID_QUEUE_SIZE * sizeof(HIDAction));
+	memset(q, 0, sizeof(HIDQueue));
+	q->actions = actions;
+	q->minInterval = minInterval;
+	return (actions != NULL);
+}
+
+void hidQueue_clear(HIDQueue *q) {
+	q->head = 0;
+	q->count = 0;
+}
+
+int hidQueue_space(HIDQueue *q) {
+	return q->actions ? (HID_QUEUE_SIZE - q->count) : 0;
+}
+
+int hidQueue_add(HIDQueue *q, int type, int key, int dx, int dy) {
+	// Add an action to the queue. Return false if the queue is full.
+
+	if (hidQueue_space(q) <= 0) return false;
+	HIDAction *action = &q->actions[(q->head + q->count) & (HID_QUEUE_SIZE - 1)];
+	action->type = type;
+	action->key = key;
+	action->dx = dx;
+	action->dy = dy;
+	q->count++;
+	return true;
+}
+
+int hidQueue_typeString(HIDQueue *q, const char *s, int modifierKey) {
+	// Queue key strokes for the ASCII characters of s (other characters are skipped). If
+	// modifierKey is not zero, hold that key while typing. Return the number of characters
+	// (not bytes) of the UTF-8 string s that were queued; it is less than the size of s if
+	// the queue filled up.
+
+	int reserved = modifierKey ? 2 : 0; // modifier press and final release
+	if (hidQueue_space(q) < (reserved + 2)) return 0;
+
+	if (modifierKey) hidQueue_add(q, hid_KeyPress, modifierKey, 0, 0);
+	const char *p = s;
+	int charCount = 0;
+	while (*p && (hidQueue_space(q) >= ((modifierKey ? 1 : 0) + 2))) {
+		int ch = *p++ & 0xFF;
+		if ((ch & 0xC0) != 0x80) charCount++; // not a UTF-8 continuation byte
+		if ((ch < 8) || (ch > 126)) continue; // not a typeable ASCII character
+		hidQueue_add(q, hid_KeyPress, ch, 0, 0);
+		hidQueue_add(q, hid_KeyRelease, ch, 0, 0);
+	}
+	if (modifierKey) hidQueue_add(q, hid_ReleaseAllKeys, 0, 0, 0);
+	return charCount;
+}
+
+int hidQueue_mouseMove(HIDQueue *q, int dx, int dy) {
+	// Queue a relative mouse move, split into steps that fit into a mouse report.
+	// Return false and queue nothing if there isn't room for all the steps.
+
+	int distance = (abs(dx) > abs(dy)) ? abs(dx) : abs(dy);
+	int steps = (distance + 126) / 127;
+	if (steps < 1) steps = 1;
+	if (hidQueue_space(q) < steps) return false;
+
+	int x = 0, y = 0;
+	for (int i = 1; i <= steps; i++) {
+		int nextX = (dx * i) / steps;
+		int nextY = (dy * i) / steps;
+		hidQueue_add(q, hid_MouseMove, 0, nextX - x, nextY - y);
+		x = nextX;
+		y = nextY;
+	}
+	return true;
+}
+
+int hidQueue_run(HIDQueue *q, uint32 now, HIDSink *sink) {
+	// Send queued actions while the USB stack is ready. Return the number of reports sent.
+
+	int sent = 0;
+	while (q->count > 0) {
+		if (q->reportsSent && ((now - q->lastSendTime) < q->minInterval)) break; // too soon
+		if (!sink->ready()) break;
+		sink->send(&q->actions[q->head]);
+		q->head = (q->head + 1) & (HID_QUEUE_SIZE - 1);
+		q->count--;
+		q->lastSendTime = now;
+		q->reportsSent++;
+		sent++;
+	}
+	return sent;
+}
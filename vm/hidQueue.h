@@ -0,0 +1,64 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// hidQueue.h - Queue and scheduler for keyboard and mouse reports
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued actions; each one produces one HID report
+
+enum {
+	hid_KeyPress = 1,
+	hid_KeyRelease = 2,
+	hid_ReleaseAllKeys = 3,
+	hid_MouseMove = 4,
+	hid_MouseScroll = 5,
+	hid_MousePress = 6,
+	hid_MouseRelease = 7
+};
+
+#define HID_QUEUE_SIZE 512 // must be a power of two
+
+typedef struct {
+	uint8 type;
+	uint8 key;		// character, key code, or mouse buttons
+	signed char dx;	// mouse x motion or scroll amount
+	signed char dy;	// mouse y motion
+} HIDAction;
+
+// The sink sends reports to the USB stack. ready() returns true if the stack can accept
+// a report now; send() sends the report for one action.
+
+typedef struct {
+	int (*ready)(void);
+	void (*send)(HIDAction *action);
+} HIDSink;
+
+typedef struct {
+	HIDAction *actions;		// HID_QUEUE_SIZE actions, allocated by hidQueue_init()
+	int head;				// index of the next action to send
+	int count;				// number of queued actions
+	uint32 minInterval;		// minimum usecs between reports
+	uint32 lastSendTime;	// usecs
+	uint32 reportsSent;
+} HIDQueue;
+
+int hidQueue_init(HIDQueue *q, uint32 minInterval);
+void hidQueue_clear(HIDQueue *q);
+int hidQueue_space(HIDQueue *q);
+
+int hidQueue_add(HIDQueue *q, int type, int key, int dx, int dy);
+int hidQueue_typeString(HIDQueue *q, const char *s, int modifierKey);
+int hidQueue_mouseMove(HIDQueue *q, int dx, int dy);
+
+int hidQueue_run(HIDQueue *q, uint32 now, HIDSink *sink);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,190 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// httpResponse.c - Incremental HTTP client response decoder
+// agent, October 2026
+
+/*
+HTTP Response Decoder
+
+The decoder turns the raw bytes of an HTTP/1.x response into body bytes. Raw bytes are
+read from the network directly into the caller's buffer and http_decode() is then called
+to decode them in place: the status line and headers are consumed, chunked transfer
+encoding is removed, and the body bytes are compacted at the start of the buffer. Since
+the decoded body is never longer than the raw input, no staging buffer is needed.
+
+The decoder honors Content-Length (bytes past the end of the body are ignored) and chunked
+transfer encoding. If neither is present, the body continues until the server closes the
+connection; the caller detects that case.
+
+Limitations:
+	* status, header, and chunk size lines longer than HTTP_LINE_SIZE are truncated
+	* only the first HTTP_HEADERS_SIZE bytes of headers are kept for http_header()
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "mem.h"
+#include "httpResponse.h"
+
+void http_initResponse(HttpResponse *r) {
+	memset(r, 0, sizeof(HttpResponse));
+	r->phase = http_StatusLine;
+	r->contentLength = -1;
+}
+
+int http_isDone(HttpResponse *r) {
+	return http_Done == r->phase;
+}
+
+// helper functions
+
+static int startsWith(const char *s, const char *prefix) {
+	// Case-insensitive prefix match.
+
+	return 0 == strncasecmp(s, prefix, strlen(prefix));
+}
+
+static char * skipSpaces(char *s) {
+	while ((' ' == *s) || ('\t' == *s)) s++;
+	return s;
+}
+
+static void recordHeader(HttpResponse *r) {
+	// Process a header line and, if there's room, append it to the headers buffer.
+
+	char *line = r->line;
+	if (startsWith(line, "content-length:")) {
+		r->contentLength = atoi(skipSpaces(line + 15));
+	} else if (startsWith(line, "transfer-encoding:")) {
+		if (strstr(line, "chunked") || strstr(line, "Chunked")) r->chunked = true;
+	}
+
+	int n = r->lineLength;
+	if ((r->headersLength + n + 2) <= HTTP_HEADERS_SIZE) {
+		memcpy(&r->headers[r->headersLength], line, n);
+		r->headersLength += n;
+		r->headers[r->headersLength++] = '\n';
+		r->headers[r->headersLength] = '\0';
+	}
+}
+
+static void lineDone(HttpResponse *r) {
+	// Process a complete line (without its line terminator) and advance the phase.
+
+	char *line = r->line;
+	switch (r->phase) {
+	case http_StatusLine:
+		if (startsWith(line, "HTTP/")) {
+			char *p = strchr(line, ' ');
+			if (p) r->status = atoi(skipSpaces(p));
+			r->phase = http_Headers;
+		} // otherwise, ignore junk before the status line
+		break;
+	case http_Headers:
+		if (r->lineLength > 0) {
+			recordHeader(r);
+		} else if ((100 <= r->status) && (r->status < 200)) {
+			r->phase = http_StatusLine; // skip interim response (e.g. "100 Continue")
+			r->headersLength = 0;
+		} else if (r->chunked) {
+			r->phase = http_ChunkSize;
+		} else if ((0 == r->contentLength) || (204 == r->status) || (304 == r->status)) {
+			r->phase = http_Done;
+		} else {
+			r->remaining = r->contentLength;
+			r->phase = http_Body;
+		}
+		break;
+	case http_ChunkSize:
+		if (0 == r->lineLength) break; // ignore blank line
+		r->remaining = strtol(line, NULL, 16); // stops at chunk extension, if any
+		r->phase = (r->remaining > 0) ? http_ChunkData : http_Trailers;
+		break;
+	case http_ChunkEnd:
+		r->phase = http_ChunkSize;
+		break;
+	case http_Trailers:
+		if (0 == r->lineLength) r->phase = http_Done;
+		break;
+	}
+	r->lineLength = 0;
+	r->line[0] = '\0';
+}
+
+static int addLineByte(HttpResponse *r, int ch) {
+	// Append a byte to the current line. Return true if the line is complete.
+
+	if ('\n' == ch) {
+		if ((r->lineLength > 0) && ('\r' == r->line[r->lineLength - 1])) r->lineLength--;
+		r->line[r->lineLength] = '\0';
+		return true;
+	}
+	if (r->lineLength < (HTTP_LINE_SIZE - 1)) {
+		r->line[r->lineLength++] = ch;
+	}
+	return false;
+}
+
+// decoding
+
+int http_decode(HttpResponse *r, unsigned char *buf, int count) {
+	// Decode count raw response bytes in place. Return the number of body bytes,
+	// which are stored at the start of buf.
+
+	unsigned char *src = buf;
+	unsigned char *end = buf + count;
+	unsigned char *dst = buf;
+
+	while ((src < end) && (http_Done != r->phase)) {
+		if ((http_Body == r->phase) || (http_ChunkData == r->phase)) {
+			int n = end - src;
+			if (((http_Body == r->phase) && (r->contentLength >= 0)) || (http_ChunkData == r->phase)) {
+				if (n > r->remaining) n = r->remaining;
+				r->remaining -= n;
+			}
+			if (dst != src) memmove(dst, src, n);
+			src += n;
+			dst += n;
+			r->bodyBytes += n;
+			if ((http_Body == r->phase) && (r->contentLength >= 0) && (0 == r->remaining)) {
+				r->phase = http_Done;
+			} else if ((http_ChunkData == r->phase) && (0 == r->remaining)) {
+				r->phase = http_ChunkEnd;
+			}
+		} else {
+			if (addLineByte(r, *src++)) lineDone(r);
+		}
+	}
+	return dst - buf;
+}
+
+// header access
+
+int http_header(HttpResponse *r, const char *name, char *value, int valueSize) {
+	// Copy the value of the first header with the given name (case-insensitive) into value.
+	// Return true if the header was found.
+
+	int nameLength = strlen(name);
+	char *line = r->headers;
+	value[0] = '\0';
+	while (*line) {
+		char *next = strchr(line, '\n');
+		if (!next) break;
+		if ((0 == strncasecmp(line, name, nameLength)) && (':' == line[nameLength])) {
+			char *start = skipSpaces(line + nameLength + 1);
+			int n = next - start;
+			if (n > (valueSize - 1)) n = valueSize - 1;
+			memcpy(value, start, n);
+			value[n] = '\0';
+			return true;
+		}
+		line = next + 1;
+	}
+	return false;
+}
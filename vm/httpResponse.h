@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// httpResponse.h - Incremental HTTP client response decoder
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decoder phases
+
+enum {
+	http_StatusLine = 0,
+	http_Headers = 1,
+	http_Body = 2,
+	http_ChunkSize = 3,
+	http_ChunkData = 4,
+	http_ChunkEnd = 5,
+	http_Trailers = 6,
+	http_Done = 7
+};
+
+#define HTTP_LINE_SIZE 128
+#define HTTP_HEADERS_SIZE 512
+
+typedef struct {
+	unsigned char phase;
+	unsigned char chunked;
+	int status;				// HTTP status code; 0 until the status line has been parsed
+	int contentLength;		// -1 if not specified by the server
+	int remaining;			// bytes remaining in the body (if contentLength >= 0) or current chunk
+	int bodyBytes;			// total body bytes decoded so far
+	int lineLength;
+	char line[HTTP_LINE_SIZE];
+	int headersLength;
+	char headers[HTTP_HEADERS_SIZE]; // header lines, each terminated by a newline
+} HttpResponse;
+
+void http_initResponse(HttpResponse *r);
+int http_decode(HttpResponse *r, unsigned char *buf, int count);
+int http_isDone(HttpResponse *r);
+int http_header(HttpResponse *r, const char *name, char *value, int valueSize);
+
+#ifdef __cplusplus
+}
+#endif
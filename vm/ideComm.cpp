@@ -94,16 +94,29 @@ static void flashUserLED() {
 	updateMicrobitDisplay();
 }
 
+#if defined(BLE_IDE) || defined(BLE_PICO)
+
+// IDE link receive buffer and send pacing (see bleLink.c)
+// SEND_WINDOW - maximum notifications in flight
+// CREDIT_TIME - msecs after which an in-flight notification is assumed to have been sent
+// (NimBLE reports sent notifications sooner; BTstack does not report them)
+
+#include "bleLink.h"
+
+#define SEND_WINDOW 6
+#define CREDIT_TIME 8
+
+static BLELink ideLink;
+
+#endif
+
 #if defined(BLE_IDE)
 
 // BLE Communications
 
 #include <NimBLEDevice.h>
 
-// BLE_SEND_MAX - maximum bytes to send in a single attribute write (max is 512)
-// INTER_SEND_TIME - don't send data more often than this to avoid NimBLE error & disconnect
-#define BLE_SEND_MAX 250
-#define INTER_SEND_TIME 20
+#define PREFERRED_MTU 517
 
 static BLEServer *pServer = NULL;
 static BLEService *pService = NULL;
@@ -115,14 +128,12 @@ static BLECharacteristic *pUARTRxCharacteristic;
 
 static bool bleRunning = false;
 static uint16_t connID = -1;
-static uint32 lastSendTime = 0;
 static int lastRC = 0;
 
-// incoming BLE buffer
-#define RECV_BUF_SIZE 1024
-static uint8_t bleRecvBuf[RECV_BUF_SIZE];
-static int bleBytesAvailable = 0;
-static int overRuns = 0;
+// Notifications reported sent by onStatus(), which may run in the NimBLE host task.
+// bleSendData() passes them on to ideLink from the VM task.
+static volatile uint32 notifiesCompleted = 0;
+static uint32 notifiesCredited = 0;
 
 static void updateConnectionState() {
 	if (USB_connected_to_IDE && !ideConnected()) {
@@ -155,44 +166,36 @@ static void updateConnectionState() {
 
 // BLE Operation
 
-static void bleReceiveData(const uint8_t *data, int byteCount) {
-	int available = RECV_BUF_SIZE - bleBytesAvailable;
-	if (byteCount > available) {
-		overRuns++;
-		byteCount = available;
-	}
+static int notifyIDE(const uint8 *data, int byteCount, void *context) {
+	// Send one notification. Return false if NimBLE is out of buffers.
 
-	memcpy(&bleRecvBuf[bleBytesAvailable], data, byteCount);
-	bleBytesAvailable += byteCount;
+	lastRC = 0; // will be set to non-zero if notify() call fails
+	pTxCharacteristic->setValue(data, byteCount);
+	pTxCharacteristic->notify();
+	return 0 == lastRC;
 }
 
 static int bleSendData(uint8_t *data, int byteCount) {
-	// do not send more often than INTER_SEND_TIME msecs
-	uint32 now = millisecs();
-	if (lastSendTime > now) lastSendTime = 0; // clock wrap
-	if ((now - lastSendTime) < INTER_SEND_TIME) return 0;
-
-	if (byteCount <= 0) return 0;
-
-	// send byteCount bytes
-	if (byteCount > BLE_SEND_MAX) byteCount = BLE_SEND_MAX;
-	lastRC = 0; // will be set to non-zero if notify() call fails
-	pTxCharacteristic->setValue(data, byteCount);
-	pTxCharacteristic->indicate();
-	if (lastRC != 0) {
-		byteCount = 0; // write+notify failed; retry later
+	while (notifiesCredited != notifiesCompleted) {
+		bleLink_sendComplete(&ideLink);
+		notifiesCredited++;
 	}
-
-	lastSendTime = now;
-	return byteCount;
+	if (byteCount <= 0) return 0;
+	return bleLink_send(&ideLink, data, byteCount, millisecs(), notifyIDE, NULL);
 }
 
 class MyServerCallbacks: public BLEServerCallbacks {
 	void onConnect(BLEServer* pServer, ble_gap_conn_desc* desc) {
 		connID = desc->conn_handle;
+		bleLink_reset(&ideLink);
+		notifiesCredited = notifiesCompleted;
+		bleLink_setMTU(&ideLink, pServer->getPeerMTU(connID));
 		lastRcvTime = microsecs();
 		BLE_connected_to_IDE = true;
 	}
+	void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+		if (desc->conn_handle == connID) bleLink_setMTU(&ideLink, MTU);
+	}
 	void onDisconnect(BLEServer* pServer, ble_gap_conn_desc* desc) {
 		connID = -1;
 		BLE_connected_to_IDE = false;
@@ -205,13 +208,16 @@ class MyCallbacks: public BLECharacteristicCallbacks {
 		// Handle incoming BLE data.
 
 		NimBLEAttValue value = pCharacteristic->getValue();
-		bleReceiveData(value.data(), value.length());
+		bleLink_received(&ideLink, value.data(), value.length());
 	}
 	void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) {
 		// Record the last return code. This is used to tell when a notify() has failed
-		// (because there are no buffers) so that it can be re-tried later.
+		// (because there are no buffers) so that it can be re-tried later. Count the
+		// notifications that were sent, so their credits are returned without waiting
+		// for CREDIT_TIME.
 
 		lastRC = code;
+		if ((SUCCESS_NOTIFY == s) && (pCharacteristic == pTxCharacteristic)) notifiesCompleted++;
 	}
 };
 
@@ -240,6 +246,8 @@ void BLE_start() {
 
 	// Create BLE Device
 	BLEDevice::init(bleDeviceName);
+	BLEDevice::setMTU(PREFERRED_MTU);
+	bleLink_init(&ideLink, SEND_WINDOW, CREDIT_TIME);
 
 	// Create BLE Server
 	pServer = BLEDevice::createServer();
@@ -328,16 +336,9 @@ static uint16_t txCharacteristic = 0;
 static uint16_t rxCharacteristic = 0;
 static uint16_t uartTxCharacteristic = 0;
 static uint16_t uartRxCharacteristic = 0;
-static uint32 lastSendTime = 0;
 
 #define BLE_BUF_MAX 250 // 360 works, 380 fails; making both charactistics dynamic allows larger buffers
 
-// incoming BLE buffer
-#define RECV_BUF_SIZE 1024
-static uint8_t bleRecvBuf[RECV_BUF_SIZE];
-static int bleBytesAvailable = 0;
-static int overRuns = 0;
-
 // Pico advertising
 
 static uint8_t adv_data[31]; // advertisting data is limited to 31 bytes on Pico
@@ -415,6 +416,7 @@ void BLE_resumeAdvertising() {
 static void deviceConnectedCallback(BLEStatus status, BLEDevice *device) {
 	if (BLE_STATUS_OK == status) {
 		connectionHandle = device->getHandle();
+		bleLink_reset(&ideLink);
 		BTstack.stopAdvertising();
 		lastRcvTime = microsecs();
 		BLE_connected_to_IDE = true;
@@ -439,13 +441,7 @@ void bleDisconnect() {
 
 static int gattWriteCallback(uint16_t attribute_handle, uint8_t *data, uint16_t byteCount) {
 	if (attribute_handle == rxCharacteristic) {
-		int available = RECV_BUF_SIZE - bleBytesAvailable;
-		if (byteCount > available) {
-			overRuns++;
-			byteCount = available;
-		}
-		memcpy(&bleRecvBuf[bleBytesAvailable], data, byteCount);
-		bleBytesAvailable += byteCount;
+		bleLink_received(&ideLink, data, byteCount);
 	}
 	if (attribute_handle == uartRxCharacteristic) {
 		BLE_UART_ReceiveCallback(data, byteCount);
@@ -467,13 +463,20 @@ static void updateConnectionState() {
 	}
 }
 
+static int notifyIDE(const uint8 *data, int byteCount, void *context) {
+	// Send one notification. Return false if BTstack is out of buffers.
+
+	return 0 == att_server_notify(connectionHandle, txCharacteristic, data, byteCount);
+}
+
 static int bleSendData(uint8_t *data, int byteCount) {
 	if (byteCount <= 0) return 0;
 
-	// send byteCount bytes
-	if (byteCount > BLE_BUF_MAX) byteCount = BLE_BUF_MAX;
-	int err = att_server_notify(connectionHandle, txCharacteristic, data, byteCount);
-	return err ? 0 : byteCount;
+	// limit the payload to both the negotiated MTU and the characteristic size
+	int mtu = att_server_get_mtu(connectionHandle);
+	if (mtu > (BLE_BUF_MAX + 3)) mtu = BLE_BUF_MAX + 3;
+	bleLink_setMTU(&ideLink, mtu);
+	return bleLink_send(&ideLink, data, byteCount, millisecs(), notifyIDE, NULL);
 }
 
 void BLE_start() {
@@ -482,6 +485,7 @@ void BLE_start() {
 
 	// Initialize three letter ID and name
 	initBLEDeviceName("Pico");
+	bleLink_init(&ideLink, SEND_WINDOW, CREDIT_TIME);
 
 	// add BLE service
 	BTstack.addGATTService(new UUID(MB_SERVICE_UUID));
@@ -542,19 +546,7 @@ int recvBytes(uint8 *buf, int count) {
 	}
 
 	// use BLE connection
-	bytesRead = (count < bleBytesAvailable) ? count : bleBytesAvailable;
-	if (bytesRead == 0) return 0;
-
-	memcpy(buf, bleRecvBuf, bytesRead); // copy bytes to buf
-
-	int remainingBytes = bleBytesAvailable - bytesRead;
-	if (remainingBytes > 0) {
-		// remove bytesRead bytes from bleRecvBuf
-		memcpy(bleRecvBuf, &bleRecvBuf[bytesRead], remainingBytes);
-	}
-	bleBytesAvailable = remainingBytes;
-
-	return bytesRead;
+	return bleLink_read(&ideLink, buf, count);
 }
 
 int sendBytes(uint8 *buf, int start, int end) {
@@ -9,6 +9,7 @@
 
 #define _DEFAULT_SOURCE // enable usleep() declaration from unistd.h
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,8 +23,10 @@
 
 #define USE_TASKS true
 
-// RECENT is a threshold for waking up tasks waiting on timers
+// RECENT is a threshold for the busy-wait used for very short waits.
 // The timer can be up to this many usecs past the wakeup time.
+// Tasks waiting on timers compare their 64-bit wakeTime with totalMicrosecs(),
+// so they wake correctly however long they wait or however late they are checked.
 
 #define RECENT 10000000
 
@@ -61,6 +64,49 @@ int failure() {
 	}
 #endif
 
+// Timed Wakeup
+
+// When a task starts waiting for the clock, scheduleWake() arms the platform's one-shot
+// wake timer for the earliest wake time. When it fires, the timer sets wakeDue and the VM
+// loop runs the tasks that are due before any other task and before its background work,
+// so they start at the next safe point (the end of the current task step) rather than when
+// the round-robin reaches them. On platforms without a wake timer, armWakeTimer() does
+// nothing and tasks are woken by the round-robin as before.
+//
+// Wake latency, the time from a task's wake time until it runs, is recorded for tuning.
+
+volatile int wakeDue = false;
+static uint64 armedWakeTime = 0; // time the wake timer is set for, or zero if not set
+
+uint32 wakeCount = 0;
+uint32 maxWakeLatency = 0;
+uint64 totalWakeLatency = 0;
+
+static void scheduleWake(uint64 wakeTime) {
+	// Arm the wake timer if no earlier wake is pending.
+
+	if (!armedWakeTime || (wakeTime < armedWakeTime)) {
+		armedWakeTime = wakeTime;
+		armWakeTimer(wakeTime);
+	}
+}
+
+static void wakeTask(Task *task, uint64 usecs) {
+	// Make a waiting task runnable and record how late it is.
+
+	uint32 latency = (uint32) (usecs - task->wakeTime);
+	wakeCount++;
+	totalWakeLatency += latency;
+	if (latency > maxWakeLatency) maxWakeLatency = latency;
+	task->status = running;
+}
+
+void clearWakeStats() {
+	wakeCount = 0;
+	maxWakeLatency = 0;
+	totalWakeLatency = 0;
+}
+
 // Printing
 
 #define PRINT_BUF_SIZE 1000
@@ -82,6 +128,8 @@ static void printObj(OBJ obj) {
 		snprintf(dst, n, "%s", obj2str(obj));
 	} else if (objType(obj) == ListType) {
 		snprintf(dst, n, "[%d item list]", obj2int(FIELD(obj, 0)));
+	} else if (objType(obj) == RangeType) {
+		snprintf(dst, n, "[%d item list]", RANGE_COUNT(obj));
 	} else if (objType(obj) == ByteArrayType) {
 		snprintf(dst, n, "(%d bytes)", BYTES(obj));
 	} else {
@@ -149,24 +197,18 @@ OBJ primBroadcastToIDEOnly(int argCount, OBJ *args) {
 
 // Timing Support
 
-static uint32 timerStart = 0;
+static uint64 timerStart = 0;
 
-void resetTimer() { timerStart = millisecs(); }
+void resetTimer() { timerStart = totalMicrosecs(); }
 
 static int timer() {
 	// Return the number of milliseconds since the timer was last reset.
-	// Note: The millisecond clock is the 32-bit microsecond clock divided by 1000,
-	// so it wraps around to zero when the microsecond clock wraps, which occurs
-	// about every 72 minutes and 35 seconds. That's the maximum duration that can
-	// be measured with this simple timer implementation.
-
-	const uint32 msecWrap = 4294967; // 2^32 / 1000, value at which the millisecond clock wraps
+	// The timer is based on the 64-bit microsecond clock, so it does not wrap when the
+	// 32-bit microsecond clock does. The result is limited to the largest positive
+	// integer (about 12 days).
 
-	uint32 now = millisecs();
-	if (now < timerStart) { // clock wrapped
-		return (msecWrap - timerStart) + now; // time to wrap + time since wrap
-	}
-	return now - timerStart;
+	uint64 msecs = (totalMicrosecs() - timerStart) / 1000;
+	return (msecs > 0x3FFFFFFF) ? 0x3FFFFFFF : (int) msecs;
 }
 
 static OBJ primMSecsSince(int argCount, OBJ *args) {
@@ -271,8 +313,8 @@ static OBJ primRandom(int argCount, OBJ *args) {
 		first = last;
 		last = tmp;
 	}
-	int range = (last + 1) - first; // if first == last range is 1 and first is returned
-	return int2obj(first + (rand() % range)); // result range is [first..last], inclusive
+	uint32 range = (uint32) last - (uint32) first + 1; // if first == last range is 1 and first is returned
+	return int2obj(first + (int) randomBelow(range)); // result range is [first..last], inclusive
 }
 
 static OBJ primMinimum(int argCount, OBJ *args) {
@@ -299,6 +341,25 @@ static OBJ primMaximum(int argCount, OBJ *args) {
 	return int2obj(result);
 }
 
+static inline int isBytes(OBJ obj) {
+	return IS_TYPE(obj, ByteArrayType) || IS_TYPE(obj, StringType);
+}
+
+static int compareBytes(OBJ obj1, OBJ obj2) {
+	// Compare the bytes of two ByteArrays or a ByteArray and a String. Return one of:
+	//	-1 (<), 0 (==), 1 (>)
+
+	int count1 = IS_TYPE(obj1, ByteArrayType) ? BYTES(obj1) : (int) strlen(obj2str(obj1));
+	int count2 = IS_TYPE(obj2, ByteArrayType) ? BYTES(obj2) : (int) strlen(obj2str(obj2));
+	int n = (count1 < count2) ? count1 : count2;
+	int result = memcmp(&FIELD(obj1, 0), &FIELD(obj2, 0), n);
+	if (result < 0) return -1;
+	if (result > 0) return 1;
+	if (count1 < count2) return -1;
+	if (count1 > count2) return 1;
+	return 0;
+}
+
 static inline int compareObjects(OBJ obj1, OBJ obj2) {
 	// Compare two objects with the given operator and return one of:
 	//	-1 (<), 0 (==), 1 (>)
@@ -308,6 +369,8 @@ static inline int compareObjects(OBJ obj1, OBJ obj2) {
 	int n1 = 0, n2 = 0;
 	if (IS_TYPE(obj1, StringType) && IS_TYPE(obj2, StringType)) {
 		return strcmp(obj2str(obj1), obj2str(obj2));
+	} else if (isBytes(obj1) && isBytes(obj2)) { // at least one is a ByteArray
+		return compareBytes(obj1, obj2);
 	} else if (IS_TYPE(obj1, StringType) && isInt(obj2)) {
 		n1 = strtol(obj2str(obj1), NULL, 10);
 		n2 = obj2int(obj2);
@@ -616,7 +679,7 @@ static void runTask(Task *task) {
 			errorCode = noError; // clear the error
 			if (taskSleepMSecs > 0) {
 				task->status = waiting_micros;
-				task->wakeTime = microsecs() + (taskSleepMSecs * 1000);
+				task->wakeTime = totalMicrosecs() + ((uint64) taskSleepMSecs * 1000);
 			}
 			goto suspend;
 		}
@@ -628,6 +691,7 @@ static void runTask(Task *task) {
 		errorCode = noError; // clear the error
 		goto suspend;
 	suspend:
+		if (waiting_micros == task->status) scheduleWake(task->wakeTime);
 		// save task state
 		task->ip = ip - task->code;
 		task->sp = sp - task->stack;
@@ -802,18 +866,14 @@ static void runTask(Task *task) {
 			DISPATCH();
 		}
 		task->status = waiting_micros;
-		task->wakeTime = (microsecs() + tmp) - 7; // adjusted for approximate scheduler overhead
+		task->wakeTime = (totalMicrosecs() + tmp) - 7; // adjusted for approximate scheduler overhead
 		goto suspend;
 	waitMillis_op:
 	 	tmp = evalInt(*(sp - 1)); // wait time in usecs
 	 	POP_ARGS_COMMAND();
 	 	if (tmp <= 0) { DISPATCH(); } // don't wait at all
-	 	if (tmp > 3600000) {
-	 		fail(waitTooLong);
-	 		goto error;
-	 	}
 		task->status = waiting_micros;
-		task->wakeTime = microsecs() + ((1000 * tmp) - 7);
+		task->wakeTime = totalMicrosecs() + ((1000 * (uint64) tmp) - 7);
 		goto suspend;
 	sendBroadcast_op:
 		primSendBroadcast(arg, sp - arg);
@@ -829,7 +889,7 @@ static void runTask(Task *task) {
 		// stack layout:
 		// *(sp - 1) the loop counter (decreases from N to 1); falseObj the very first time
 		// *(sp - 2) N, the total loop count or item count of a list, string or byte array
-		// *(sp - 3) the object being iterated over: an integer, list, string, or byte array
+		// *(sp - 3) the object being iterated over: an integer, list, range, string, or byte array
 
 		tmpObj = *(sp - 1); // loop counter, or falseObj the very first time
 		if (falseObj == tmpObj) { // first time: compute N, the total iterations (in tmp)
@@ -838,6 +898,8 @@ static void runTask(Task *task) {
 				tmp = obj2int(tmpObj);
 			} else if (IS_TYPE(tmpObj, ListType)) {
 				tmp = obj2int(FIELD(tmpObj, 0));
+			} else if (IS_TYPE(tmpObj, RangeType)) {
+				tmp = RANGE_COUNT(tmpObj);
 			} else if (IS_TYPE(tmpObj, StringType)) {
 				tmp = countUTF8(obj2str(tmpObj));
 			} else if (IS_TYPE(tmpObj, ByteArrayType)) {
@@ -860,6 +922,9 @@ static void runTask(Task *task) {
 			} else if (IS_TYPE(tmpObj, ListType)) {
 				// set the index variable to the next list item
 				*(fp + arg) = FIELD(tmpObj, tmp + 1); // skip count field
+			} else if (IS_TYPE(tmpObj, RangeType)) {
+				// set the index variable to the next range item (computed, not stored)
+				*(fp + arg) = rangeAt(tmpObj, tmp + 1);
 			} else if (IS_TYPE(tmpObj, StringType)) {
 				// set the index variable to the next character of a string
 				*(fp + arg) = charAt(tmpObj, tmp + 1);
@@ -949,6 +1014,8 @@ static void runTask(Task *task) {
 			*(sp - arg) = falseObj; // integer, not equal
 		} else if (IS_TYPE(tmpObj, StringType) && IS_TYPE(*(sp - 1), StringType)) {
 			*(sp - arg) = (stringsEqual(tmpObj, *(sp - 1)) ? trueObj : falseObj);
+		} else if (isBytes(tmpObj) && isBytes(*(sp - 1))) { // at least one is a ByteArray
+			*(sp - arg) = ((0 == compareBytes(tmpObj, *(sp - 1))) ? trueObj : falseObj);
 		} else {
 			*(sp - arg) = falseObj; // not comparable, so not equal
 		}
@@ -964,6 +1031,8 @@ static void runTask(Task *task) {
 			*(sp - arg) = trueObj; // integer, not equal
 		} else if (IS_TYPE(tmpObj, StringType) && IS_TYPE(*(sp - 1), StringType)) {
 			*(sp - arg) = (stringsEqual(tmpObj, *(sp - 1)) ? falseObj : trueObj);
+		} else if (isBytes(tmpObj) && isBytes(*(sp - 1))) { // at least one is a ByteArray
+			*(sp - arg) = ((0 == compareBytes(tmpObj, *(sp - 1))) ? falseObj : trueObj);
 		} else {
 			*(sp - arg) = trueObj; // not comparable, so not equal
 		}
@@ -1094,6 +1163,7 @@ static void runTask(Task *task) {
 					*(sp - arg) = strcmp(type, "string") == 0 ? trueObj : falseObj;
 					break;
 				case ListType:
+				case RangeType:
 					*(sp - arg) = strcmp(type, "list") == 0 ? trueObj : falseObj;
 					break;
 				case ByteArrayType:
@@ -1133,7 +1203,7 @@ static void runTask(Task *task) {
 		POP_ARGS_COMMAND();
 		// wait for data to be sent; prevents use in tight loop from clogging serial line
 		task->status = waiting_micros;
-		task->wakeTime = microsecs() + (extraByteDelay * (printBufferByteCount + 6));
+		task->wakeTime = totalMicrosecs() + (extraByteDelay * (printBufferByteCount + 6));
 		goto suspend;
 	logData_op:
 		if (!ideConnected()) {
@@ -1153,7 +1223,7 @@ static void runTask(Task *task) {
 		POP_ARGS_COMMAND();
 		// wait for data to be sent; prevents use in tight loop from clogging serial line
 		task->status = waiting_micros;
-		task->wakeTime = microsecs() + (extraByteDelay * (printBufferByteCount + 6));
+		task->wakeTime = totalMicrosecs() + (extraByteDelay * (printBufferByteCount + 6));
 		goto suspend;
 	boardType_op:
 		*(sp - arg) = primBoardType();
@@ -1337,6 +1407,11 @@ static void runTask(Task *task) {
 						for (int i = 1; i <= paramCount; i++) {
 							*sp++ = FIELD(params, i);
 						}
+					} else if (IS_TYPE(params, RangeType)) { // push the range items
+						paramCount = (RANGE_COUNT(params) & 0xFF);
+						for (int i = 1; i <= paramCount; i++) {
+							*sp++ = rangeAt(params, i);
+						}
 					} else { // fail: parameters must be a list
 						*sp++ = fail(needsListError);
 						DISPATCH();
@@ -1376,12 +1451,143 @@ static void runTask(Task *task) {
 
 #if !defined(EMSCRIPTEN)
 
+#ifdef GNUBLOCKS
+
+// Virtual Time (Linux VM)
+
+// When the Linux VM runs with a simulated clock, time advances only as the VM runs: each
+// task step takes VIRTUAL_TASK_STEP_USECS of virtual time. When all tasks are waiting, the
+// clock skips ahead to the earliest wake time instead of sleeping, so long waits take no
+// real time and runs are repeatable.
+
+#define VIRTUAL_TASK_STEP_USECS 10
+
+uint64 nextTaskWakeTime() {
+	// Return the earliest wake time of the tasks waiting on the clock, or zero if none.
+
+	uint64 nextWakeTime = 0;
+	for (int i = 0; i < taskCount; i++) {
+		Task *task = &tasks[i];
+		if ((waiting_micros == task->status) &&
+			(!nextWakeTime || (task->wakeTime < nextWakeTime))) {
+				nextWakeTime = task->wakeTime;
+		}
+	}
+	return nextWakeTime;
+}
+
+static void skipToNextWakeTime() {
+	uint64 nextWakeTime = nextTaskWakeTime();
+	if (nextWakeTime) {
+		setVirtualTime(nextWakeTime);
+	} else {
+		// no tasks; idle until the IDE sends something, letting virtual time pass as well
+		usleep(500);
+		advanceVirtualTime(500);
+	}
+}
+
+// VM Instances (see linux+pi/vmHost.c)
+
+static int savedTaskBytes(Task *task) {
+	// Return the number of bytes needed to save the given task: its fields plus the part
+	// of its stack in use.
+
+	return offsetof(Task, stack) + (task->sp * sizeof(OBJ));
+}
+
+void interpSaveState(VMState *state) {
+	memcpy(state->chunks, chunks, sizeof(chunks));
+	memcpy(state->vars, vars, sizeof(vars));
+	state->lastBroadcast = lastBroadcast;
+	state->timerStart = timerStart;
+	state->taskCount = taskCount;
+	state->armedWakeTime = armedWakeTime;
+
+	int byteCount = 0;
+	for (int i = 0; i < taskCount; i++) byteCount += savedTaskBytes(&tasks[i]);
+	if (byteCount > state->taskCapacity) {
+		uint8 *taskData = realloc(state->taskData, byteCount);
+		if (!taskData) vmPanic("Could not save VM instance tasks");
+		state->taskData = taskData;
+		state->taskCapacity = byteCount;
+	}
+	uint8 *dst = state->taskData;
+	for (int i = 0; i < taskCount; i++) {
+		int n = savedTaskBytes(&tasks[i]);
+		memcpy(dst, &tasks[i], n);
+		dst += n;
+	}
+}
+
+void interpRestoreState(VMState *state) {
+	memcpy(chunks, state->chunks, sizeof(chunks));
+	memcpy(vars, state->vars, sizeof(vars));
+	lastBroadcast = state->lastBroadcast;
+	timerStart = state->timerStart;
+	taskCount = state->taskCount;
+	armedWakeTime = state->armedWakeTime;
+	wakeDue = false;
+
+	uint8 *src = state->taskData;
+	for (int i = 0; i < taskCount; i++) {
+		memcpy(&tasks[i], src, offsetof(Task, stack));
+		int n = savedTaskBytes(&tasks[i]);
+		memcpy(&tasks[i], src, n);
+		src += n;
+	}
+	for (int i = taskCount; i < MAX_TASKS; i++) {
+		memset(&tasks[i], 0, offsetof(Task, stack)); // clear unused tasks
+	}
+}
+
+void interpClearState() {
+	wakeDue = false;
+	armedWakeTime = 0;
+}
+
+#endif
+
+static void runDueTasks() {
+	// Run the waiting tasks whose wake time has arrived, then arm the wake timer for the
+	// earliest remaining wake time.
+
+	wakeDue = false;
+	armedWakeTime = 0;
+	for (int i = 0; i < taskCount; i++) {
+		Task *task = &tasks[i];
+		if (waiting_micros == task->status) {
+			uint64 usecs = totalMicrosecs();
+			if (usecs >= task->wakeTime) {
+				wakeTask(task, usecs);
+				runTask(task);
+			}
+		}
+	}
+	uint64 nextWakeTime = 0;
+	for (int i = 0; i < taskCount; i++) {
+		Task *task = &tasks[i];
+		if ((waiting_micros == task->status) &&
+			(!nextWakeTime || (task->wakeTime < nextWakeTime))) {
+				nextWakeTime = task->wakeTime;
+		}
+	}
+	if (nextWakeTime) scheduleWake(nextWakeTime);
+}
+
 void vmLoop() {
 	// Run the next runnable task. Wake up any waiting tasks whose wakeup time has arrived.
 
 	int currentTaskIndex = 0;
 	int count = 0;
 	while (true) {
+#ifdef GNUBLOCKS
+		// the Linux wake timer only ends naps, so check the (fast) clock on every cycle
+		if (armedWakeTime && !useVirtualTime && !hostingVMs && (totalMicrosecs() >= armedWakeTime)) {
+			wakeDue = true;
+		}
+#endif
+		if (wakeDue) runDueTasks(); // run tasks whose wake time has arrived first
 		if (count-- < 0) {
 			// do background VM tasks once every N VM loop cycles
 			processMessage();
@@ -1393,12 +1599,17 @@ void vmLoop() {
 				cocubeSensorUpdate();
 			#endif
 			handleMicosecondClockWrap();
+			checkDataLogFlush();
 			count = 95; // must be under 30 when building on mbed to avoid serial errors
 		} else if ((count & 0xF) == 0) {
 			captureIncomingBytes();
 		}
+		sendQueuedHIDReports(); // send the next keyboard or mouse report when the host is ready
+		if (adcSampling) sampleADC(); // take any analog sample frames that are due
+		if (pulseTrainsActive) updatePulseTrains(); // take any pulse train steps that are due
+		if (audioPlaying) updateAudio(); // output any audio samples that are due
 		int runCount = 0;
-		uint32 usecs = 0; // compute times only the first time they are needed
+		uint64 usecs = 0; // compute times only the first time they are needed
 		for (int t = 0; t < taskCount; t++) {
 			currentTaskIndex++;
 			if (currentTaskIndex >= taskCount) currentTaskIndex = 0;
@@ -1410,9 +1621,9 @@ void vmLoop() {
 				runCount++;
 				break;
 			} else if (waiting_micros == task->status) {
-				if (!usecs) usecs = microsecs(); // get usecs
-				if ((usecs - task->wakeTime) < RECENT) {
-					task->status = running;
+				if (!usecs) usecs = totalMicrosecs(); // get usecs
+				if (usecs >= task->wakeTime) {
+					wakeTask(task, usecs);
 					runTask(task);
 					runCount++;
 					break;
@@ -1426,19 +1637,28 @@ void vmLoop() {
 		}
 
 #ifdef GNUBLOCKS
-		if (!runCount) { // no active tasks; consider taking a nap
-			if (!usecs) usecs = microsecs(); // get usecs
+		if (hostingVMs) {
+			// Running many VM instances; switch to another one when this one is idle or
+			// at the end of its time slice
+			if (useVirtualTime && runCount) advanceVirtualTime(VIRTUAL_TASK_STEP_USECS);
+			if (!runCount || (0 == count)) vmHost_switch(!runCount);
+		} else if (useVirtualTime) {
+			if (runCount) {
+				advanceVirtualTime(VIRTUAL_TASK_STEP_USECS);
+			} else {
+				skipToNextWakeTime();
+			}
+		} else if (!runCount) { // no active tasks; consider taking a nap
+			if (!usecs) usecs = totalMicrosecs(); // get usecs
 			int sleepUSecs = 500;
 			for (int i = 0; i < taskCount; i++) {
 				Task *task = &tasks[i];
-				if (waiting_micros == task->status) {
-					int usecsUntilWake = (task->wakeTime - usecs) - 5; // leave 5 extra usecs
-					if ((usecsUntilWake > 0) && (usecsUntilWake < sleepUSecs)) {
-						sleepUSecs = usecsUntilWake;
-					}
+				if ((waiting_micros == task->status) && (task->wakeTime > (usecs + 5))) {
+					uint64 usecsUntilWake = (task->wakeTime - usecs) - 5; // leave 5 extra usecs
+					if (usecsUntilWake < (uint64) sleepUSecs) sleepUSecs = usecsUntilWake;
 				}
 			}
-			if (sleepUSecs > 5) usleep(sleepUSecs); // nap a while to relinquish the CPU
+			if (sleepUSecs > 5) napUntilWake(sleepUSecs); // nap a while to relinquish the CPU
 		}
 #endif
 	}
@@ -1452,8 +1672,6 @@ void vmLoop() {
 
 #include <emscripten.h>
 
-#define CLOCK_MASK 0xFFFFFFFF
-
 int shouldYield = false;
 void EMSCRIPTEN_KEEPALIVE taskSleep(int msecs) { shouldYield = true; }
 
@@ -1468,7 +1686,7 @@ void interpretStep() {
 	while ((millisecs() < endTime) && !shouldYield) {
 		// Run the next runnable task. Wake up any waiting tasks whose wakeup time has arrived.
 		int runCount = 0;
-		uint32 usecs = microsecs(); // get usecs
+		uint64 usecs = totalMicrosecs(); // get usecs
 		for (int t = 0; t < taskCount; t++) {
 			currentTaskIndex++;
 			if (currentTaskIndex >= taskCount) currentTaskIndex = 0;
@@ -1480,7 +1698,7 @@ void interpretStep() {
 				runCount++;
 				break;
 			} else if (waiting_micros == task->status) {
-				if (((usecs - task->wakeTime) & CLOCK_MASK) < RECENT) task->status = running;
+				if (usecs >= task->wakeTime) wakeTask(task, usecs);
 			}
 			if (running == task->status) {
 				runTask(task);
@@ -1489,15 +1707,13 @@ void interpretStep() {
 			}
 		}
 		if (!runCount) { // no active tasks; consider taking a nap
-			usecs = microsecs(); // get usecs
+			usecs = totalMicrosecs(); // get usecs
 			int sleepUSecs = 100000;
 			for (int i = 0; i < taskCount; i++) {
 				Task *task = &tasks[i];
-				if (waiting_micros == task->status) {
-					int usecsUntilWake = (task->wakeTime - usecs) & CLOCK_MASK;
-					if ((usecsUntilWake > 0) && (usecsUntilWake < sleepUSecs)) {
-						sleepUSecs = usecsUntilWake;
-					}
+				if ((waiting_micros == task->status) && (task->wakeTime > usecs)) {
+					uint64 usecsUntilWake = task->wakeTime - usecs;
+					if (usecsUntilWake < (uint64) sleepUSecs) sleepUSecs = usecsUntilWake;
 				}
 			}
 			if (sleepUSecs > 2000) {
@@ -1523,7 +1739,7 @@ void runTasksUntilDone() {
 			count = 100; // reduce to 30 when building on mbed to avoid serial errors
 		}
 		hasActiveTasks = false;
-		uint32 usecs = 0; // compute times only the first time they are needed
+		uint64 usecs = 0; // compute times only the first time they are needed
 		for (int t = 0; t < taskCount; t++) {
 			Task *task = &tasks[t];
 			if (running == task->status) {
@@ -1533,8 +1749,8 @@ void runTasksUntilDone() {
 			} else if (unusedTask == task->status) {
 				continue;
 			} else if (waiting_micros == task->status) {
-				if (!usecs) usecs = microsecs(); // get usecs
-				if ((usecs - task->wakeTime) < RECENT) task->status = running;
+				if (!usecs) usecs = totalMicrosecs(); // get usecs
+				if (usecs >= task->wakeTime) task->status = running;
 			}
 			if (running == task->status) runTask(task);
 			hasActiveTasks = true;
@@ -68,7 +68,8 @@ extern CodeChunkRecord chunks[MAX_CHUNKS];
 // the top-level block of the task, as well as for the current function chunk when
 // inside a call to user-defined function. It also holds the task status, processor
 // state (instruction pointer (ip), stack pointer (sp), and frame pointer (fp)),
-// and the wakeTime (used when a task is waiting on the microsecond clock).
+// and the wakeTime (used when a task is waiting on the microsecond clock). The wakeTime
+// is a 64-bit value based on totalMicrosecs(), so it does not wrap.
 // In the current design, Tasks have a fixed-size stack built in. In the future,
 // this will become a reference to a growable stack object in memory.
 //
@@ -83,16 +84,16 @@ typedef enum {
 } MicroBlocksTaskStatus_t;
 
 #ifdef GNUBLOCKS
-	#define STACK_LIMIT 10000 // Task size is 6 + STACK_LIMIT words
+	#define STACK_LIMIT 10000 // Task size is 8 + STACK_LIMIT words
 #else
-	#define STACK_LIMIT 54 // Task size is 6 + STACK_LIMIT words
+	#define STACK_LIMIT 54 // Task size is 8 + STACK_LIMIT words
 #endif
 
 typedef struct {
 	uint8 status; // MicroBlocksTaskStatus_t, stored as a byte
 	uint8 taskChunkIndex; // chunk index of the top-level stack for this task
 	uint8 currentChunkIndex; // chunk index when inside a function
-	uint32 wakeTime;
+	uint64 wakeTime;
 	OBJ code;
 	int ip;
 	int sp;
@@ -110,6 +111,64 @@ extern int taskCount;
 
 extern int extraByteDelay;
 
+// VM Instances (Linux VM only)
+
+// The Linux VM can run many independent VM instances in one process (see linux+pi/vmHost.c).
+// The state of each inactive instance is kept in a VMState record. When switching instances,
+// each module saves its part of the state of the current instance and restores its part of
+// the state of the next one. Large memory areas are swapped by pointer; tasks and the code
+// store are copied, but only the parts in use. The ClearState functions reset a module's
+// part of the state for a new instance.
+
+#if defined(GNUBLOCKS) && !defined(EMSCRIPTEN)
+
+typedef struct {
+	// mem.c
+	OBJ *objstore;
+	OBJ memStart;
+	OBJ memEnd;
+	OBJ freeChunk;
+	// persist.c
+	int current;
+	int codeWords;			// words of the code store in use
+	int *codeStore;			// copy of the code store words in use
+	int codeCapacity;		// words allocated for codeStore
+	// interp.c
+	CodeChunkRecord chunks[MAX_CHUNKS];
+	OBJ vars[MAX_VARS];
+	OBJ lastBroadcast;
+	uint64 timerStart;
+	int taskCount;
+	uint8 *taskData;		// tasks, each with only the used part of its stack
+	int taskCapacity;		// bytes allocated for taskData
+	uint64 armedWakeTime;
+	// miscPrims.c
+	uint32 randomState[4];
+	// linuxIOPrims.c and linuxFilePrims.c
+	void *ioState;			// pin groups, ADC sampler, pulse trains, audio, and pin events
+	void *fileState;		// data log
+} VMState;
+
+void memSaveState(VMState *state);
+void memRestoreState(VMState *state);
+void persistSaveState(VMState *state);
+void persistRestoreState(VMState *state);
+void persistClearState();
+void interpSaveState(VMState *state);
+void interpRestoreState(VMState *state);
+void interpClearState();
+void miscSaveState(VMState *state);
+void miscRestoreState(VMState *state);
+void ioSaveState(VMState *state);
+void ioRestoreState(VMState *state);
+void ioClearState();
+void fileSaveState(VMState *state);
+void fileRestoreState(VMState *state);
+void fileClearState();
+uint64 nextTaskWakeTime();
+
+#endif
+
 // Serial Protocol Messages: IDE -> Board
 
 #define chunkCodeMsg			1	// bidirectional
@@ -179,7 +238,7 @@ extern int extraByteDelay;
 #define stackOverflow			26	// Insufficient stack space
 #define primitiveNotImplemented	27	// Primitive not implemented in this virtual machine
 #define notEnoughArguments		28	// Not enough arguments passed to primitive
-#define waitTooLong				29	// The maximum wait time is 3600000 milliseconds (one hour)
+#define waitTooLong				29	// Not used; older VMs limited waits to one hour (3600000 msecs)
 #define noWiFi					30	// This board does not support WiFi
 #define zeroDivide				31	// Division (or modulo) by zero is not defined
 #define argIndexOutOfRange		32	// Argument index out of range
@@ -204,6 +263,12 @@ extern int extraByteDelay;
 #define bad8BitBitmap			51	// Needs an 8-bit bitmap: a list containing the bitmap width and contents (a byte array)
 #define badColorPalette			52	// Needs a color palette: a list of positive 24-bit integers representing RGB values
 #define encoderNotStarted		53	// Encoder not started; pin may not support interrupts
+#define badEncodedData			54	// Invalid hex or base64 data
+#define badFrameHandle			55	// Invalid or released camera frame
+#define hidQueueFull			56	// Keyboard and mouse queue is full; wait until hidQueueCount is lower
+#define badPinEventPin			57	// Pin events need a pin number of 0 or more
+#define pinEventSlotsFull		58	// Pin events can be captured on at most 8 pins at once
+#define pinHasNoInterrupt		59	// That pin does not support interrupts
 #define sleepSignal				255	// Not a real error; used to make current task sleep
 
 // Runtime Operations
@@ -270,6 +335,23 @@ uint32 millisecs(void);
 uint32 seconds();
 void handleMicosecondClockWrap();
 
+#ifdef GNUBLOCKS
+// Virtual time (simulated clock) support; see linux.c
+extern int useVirtualTime;
+void advanceVirtualTime(uint64 usecs);
+void setVirtualTime(uint64 usecs);
+
+// Multiple VM instances support; see linux+pi/vmHost.c
+extern int hostingVMs;
+void vmHost_switch(int idle);
+
+// Set a pin, recording the given time in the pin log (see linux.c)
+void pinWriteAt(int pinNum, int value, uint64 usecs);
+
+// Report a change of a mock pin to the simulated pin event capture (see linuxIOPrims.c)
+void simulatePinEdge(int pinNum, int level, uint64 usecs);
+#endif
+
 int ideConnected();
 int recvBytes(uint8 *buf, int count);
 int sendBytes(uint8 *buf, int start, int end);
@@ -298,11 +380,46 @@ void resetRadio();
 void stopPWM();
 void stopServos();
 void stopTone();
+void resetHID();
+void stopPinEvents();
+void sendQueuedHIDReports();
 int readAnalogMicrophone();
 void setPicoEdSpeakerPin(int pin);
 void showMicroBitPixels(int microBitDisplayBits, int xPos, int yPos);
 void setAllNeoPixels(int pin, int ledCount, int color);
 
+// Timed analog sampling (see adcSampler.c). While adcSampling is true, the VM loop calls
+// sampleADC() on every cycle.
+extern int adcSampling;
+void sampleADC();
+
+// Pulse trains (see pulseTrain.c). Where no timer interrupt plays them, the VM loop calls
+// updatePulseTrains() on every cycle while pulseTrainsActive is true.
+extern int pulseTrainsActive;
+void updatePulseTrains();
+
+// Buffered audio output (see audioOut.c). While audioPlaying is true, the VM loop calls
+// updateAudio() on every cycle.
+extern int audioPlaying;
+void updateAudio();
+
+// Timed task wakeup (see interp.c). armWakeTimer() sets a one-shot timer that sets wakeDue
+// at the given time, if the platform has one. Wake latency statistics are kept for tuning.
+extern volatile int wakeDue;
+extern uint32 wakeCount;
+extern uint32 maxWakeLatency;
+extern uint64 totalWakeLatency;
+void armWakeTimer(uint64 wakeTime);
+void napUntilWake(int usecs);
+void clearWakeStats();
+
+// Data logging (see dataLog.c). flushDataLog() writes the buffered records to the log file;
+// stopDataLog() also closes it. The VM loop calls checkDataLogFlush() as part of its
+// background work so that records do not wait in RAM longer than DATA_LOG_FLUSH_MSECS.
+void flushDataLog();
+void checkDataLogFlush();
+void stopDataLog();
+
 // Primitives
 
 OBJ primNewList(int argCount, OBJ *args);
@@ -310,9 +427,18 @@ OBJ primFillList(int argCount, OBJ *args);
 OBJ primAt(int argCount, OBJ *args);
 OBJ primAtPut(int argCount, OBJ *args);
 OBJ primLength(int argCount, OBJ *args);
+OBJ rangeToList(OBJ range, int replace);
+int ensureList(OBJ *args, int i);
+int ensureListCopy(OBJ *args, int i);
+
+uint32 randomUint32();
+uint32 randomBelow(uint32 n);
+void setRandomSeed(uint32 seed);
 
 OBJ primHexToInt(int argCount, OBJ *args);
 
+int httpRespondWithData(const char *contentType, uint8 *data, int byteCount, int keepAlive);
+
 OBJ primBroadcastToIDEOnly(int argCount, OBJ *args);
 
 OBJ primAnalogPins(OBJ *args);
@@ -87,19 +87,97 @@ static uint32 lastMicrosecs = 0;
 
 uint64 totalMicrosecs() {
 	// Returns a 64-bit integer containing microseconds since start.
+	// Handles a wrap of the 32-bit clock that handleMicosecondClockWrap() has not yet
+	// seen, so the result never goes backward (task wake times depend on that).
+	// Also called from the pulse train timer interrupt on nRF5x boards; see below.
 
-	return ((uint64) microsecondHighBits << 32) | microsecs();
+	uint32 now = microsecs();
+	uint32 highBits = microsecondHighBits;
+	if (now < lastMicrosecs) highBits++; // clock wrapped since last check
+	return ((uint64) highBits << 32) | now;
 }
 
 void handleMicosecondClockWrap() {
 	// Increment microsecondHighBits if the microsecond clock has wrapped since the last
-	// time this function was called.
+	// time this function was called. Interrupts are disabled while the two variables are
+	// updated; an interrupt that called totalMicrosecs() between the two stores would see
+	// the wrap counted in microsecondHighBits but not in lastMicrosecs and count it again.
 
+	noInterrupts();
 	uint32 now = microsecs();
 	if (lastMicrosecs > now) microsecondHighBits++; // clock wrapped
 	lastMicrosecs = now;
+	interrupts();
+}
+
+// Wake Timer (see "Timed Wakeup" in interp.c)
+// On nRF52 boards, TIMER3 runs as a one-shot timer; on ESP32 boards, an esp_timer is used.
+// Other boards have no wake timer, so waiting tasks are woken by the VM loop's round-robin.
+// A timer that fires early is harmless: the VM loop re-arms it for the next wake time.
+
+#define MAX_WAKE_TIMER_USECS 1000000000
+
+#if defined(NRF52)
+
+extern "C" void TIMER3_IRQHandler() {
+	if (NRF_TIMER3->EVENTS_COMPARE[0]) {
+		NRF_TIMER3->EVENTS_COMPARE[0] = 0; // clear interrupt
+		wakeDue = true;
+	}
+}
+
+void armWakeTimer(uint64 wakeTime) {
+	int64_t usecs = (int64_t) (wakeTime - totalMicrosecs());
+	if (usecs < 2) { // already due
+		wakeDue = true;
+		return;
+	}
+	if (usecs > MAX_WAKE_TIMER_USECS) usecs = MAX_WAKE_TIMER_USECS;
+
+	NRF_TIMER3->TASKS_STOP = true;
+	NRF_TIMER3->TASKS_CLEAR = true;
+	NRF_TIMER3->MODE = 0; // timer (not counter) mode
+	NRF_TIMER3->BITMODE = 3; // 32-bit
+	NRF_TIMER3->PRESCALER = 4; // 1 MHz (16 MHz / 2^4)
+	NRF_TIMER3->CC[0] = (uint32) usecs;
+	NRF_TIMER3->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Msk; // one-shot
+	NRF_TIMER3->EVENTS_COMPARE[0] = 0;
+	NRF_TIMER3->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+	NVIC_EnableIRQ(TIMER3_IRQn);
+	NRF_TIMER3->TASKS_START = true;
+}
+
+#elif defined(ARDUINO_ARCH_ESP32)
+
+#include "esp_timer.h"
+
+static esp_timer_handle_t wakeTimer = NULL;
+
+static void wakeTimerCallback(void *arg) { wakeDue = true; }
+
+void armWakeTimer(uint64 wakeTime) {
+	if (!wakeTimer) {
+		esp_timer_create_args_t timerArgs = {};
+		timerArgs.callback = wakeTimerCallback;
+		timerArgs.name = "wake";
+		if (ESP_OK != esp_timer_create(&timerArgs, &wakeTimer)) return;
+	}
+	esp_timer_stop(wakeTimer); // fails harmlessly if the timer is not running
+	int64_t usecs = (int64_t) (wakeTime - totalMicrosecs());
+	if (usecs < 2) { // already due
+		wakeDue = true;
+		return;
+	}
+	if (usecs > MAX_WAKE_TIMER_USECS) usecs = MAX_WAKE_TIMER_USECS;
+	esp_timer_start_once(wakeTimer, usecs);
 }
 
+#else
+
+void armWakeTimer(uint64 wakeTime) { }
+
+#endif
+
 // Hardware Initialization
 
 	#if (defined(ARDUINO_SAMD_ZERO) || defined(ARDUINO_SAM_ZERO)) && defined(SERIAL_PORT_USBVIRTUAL)
@@ -1297,6 +1375,9 @@ const char * boardType() { return BOARD_TYPE; }
 
 // The current pin input/output mode is recorded in the currentMode[] array to
 // avoid calling pinMode() unless mode has actually changed. (This speeds up pin I/O.)
+// Mode changes are reported to the pin bus, so pin groups set their pin modes again.
+
+#include "pinBus.h"
 
 #define MODE_NOT_SET (-1)
 static char currentMode[TOTAL_PINS];
@@ -1306,6 +1387,7 @@ static char pwmRunning[TOTAL_PINS];
 	if ((newMode) != currentMode[pin]) { \
 		pinMode((pin), (PinMode) (newMode)); \
 		currentMode[pin] = newMode; \
+		pinBus_modeChanged(); \
 	} \
 }
 
@@ -1382,7 +1464,15 @@ static void initPins(void) {
   #define HAS_INPUT_PULLDOWN true
 #endif
 
+static void stopADCSampling(); // forward reference
+static void stopPulseTrains(); // forward reference
+static void stopAudio(); // forward reference
+
 void turnOffPins() {
+	pinBus_modeChanged();
+	stopADCSampling();
+	stopPulseTrains();
+	stopAudio();
 	for (int pin = 0; pin < TOTAL_PINS; pin++) {
 		int turnOffPin = ((OUTPUT == currentMode[pin]) || (INPUT_PULLUP == currentMode[pin]));
 		#if defined(HAS_INPUT_PULLDOWN)
@@ -1854,12 +1944,12 @@ OBJ primButtonB(OBJ *args) {
 // Random number generator seed
 
 static void initRandomSeed() {
-	// Initialize the random number generator with a random seed when started (if possible).
+	// Initialize the random number generators with a random seed when started (if possible).
 
 	#if defined(ESP8266)
-		randomSeed(RANDOM_REG32);
+		uint32 seed = RANDOM_REG32;
 	#elif defined(ARDUINO_ARCH_ESP32)
-		randomSeed(esp_random());
+		uint32 seed = esp_random();
 	#elif defined(NRF51) || defined(NRF52)
 		#define RNG_BASE 0x4000D000
 		#define RNG_START (RNG_BASE)
@@ -1874,11 +1964,9 @@ static void initRandomSeed() {
 			*((volatile int *) RNG_VALRDY) = 0;
 		}
 		*((int *) RNG_STOP) = true; // end random number generation
-		randomSeed(seed);
 	#elif defined(__ZEPHYR__)
 		unsigned long seed;
 		sys_rand_get(&seed, sizeof(seed));
-		randomSeed(seed);
 	#else
 		uint32 seed = 0;
 		for (int i = 0; i < ANALOG_PINS; i++) {
@@ -1886,8 +1974,9 @@ static void initRandomSeed() {
 			pinMode(p, INPUT);
 			seed = (seed << 1) ^ analogRead(p);
 		}
-		randomSeed(seed);
 	#endif
+	randomSeed(seed); // Arduino random(), used by some libraries
+	setRandomSeed(seed); // MicroBlocks random numbers
 }
 
 // Stop PWM
@@ -1951,7 +2040,14 @@ static void startServoToneTimer() {
 	servoToneTimerStarted = true;
 }
 
+static void outputTimerInterrupt(); // forward reference
+
 extern "C" void MB_TIMER_IRQHandler() {
+	if (MB_TIMER->EVENTS_COMPARE[1]) { // pulse trains (CC[1])
+		MB_TIMER->EVENTS_COMPARE[1] = 0; // clear interrupt
+		outputTimerInterrupt();
+	}
+
 	if (MB_TIMER->EVENTS_COMPARE[2]) { // tone waveform generator (CC[2])
 		uint32_t wakeTime = MB_TIMER->CC[2];
 		MB_TIMER->EVENTS_COMPARE[2] = 0; // clear interrupt
@@ -2778,6 +2874,557 @@ static OBJ primSquareWave(int argCount, OBJ *args) {
 	return isSupported ? trueObj : falseObj;
 }
 
+// Pin Groups and Bus Output (see pinBus.c)
+
+#define PIN_GROUP_COUNT 4
+
+static PinGroup pinGroups[PIN_GROUP_COUNT];
+
+static void busSetPin(int pin, int value) { primDigitalSet(pin, value); }
+
+static int busGetPin(int pin) {
+	OBJ pinArg = int2obj(pin);
+	return (trueObj == primDigitalRead(1, &pinArg));
+}
+
+#if defined(NRF52) && !defined(ARDUINO_NRF52_PRIMO)
+
+static int busMapPort(PinGroup *group) {
+	// Map the group onto one nRF52 GPIO port (P0 or P1).
+
+	NRF_GPIO_Type *port = NULL;
+	for (int i = 0; i < group->pinCount; i++) {
+		int pin = mapDigitalPinNum(group->pins[i]);
+		if (pin < 0) return false;
+		int hwPin = g_ADigitalPinMap[pin];
+		NRF_GPIO_Type *pinPort = (hwPin > 31) ? NRF_P1 : NRF_P0;
+		if (port && (pinPort != port)) return false; // pins on different ports
+		port = pinPort;
+		group->bitMasks[i] = 1 << (hwPin & 0x1F);
+	}
+	group->port = (void *) port;
+	return true;
+}
+
+static void busWritePort(PinGroup *group, uint32 setMask, uint32 clearMask) {
+	NRF_GPIO_Type *port = (NRF_GPIO_Type *) group->port;
+	port->OUTSET = setMask;
+	port->OUTCLR = clearMask;
+}
+
+static uint32 busReadPort(PinGroup *group) {
+	return ((NRF_GPIO_Type *) group->port)->IN;
+}
+
+static PinBusDriver busDriver = { busSetPin, busGetPin, busMapPort, busWritePort, busReadPort };
+
+#elif defined(RP2040_PHILHOWER)
+
+#include <hardware/structs/sio.h>
+
+static int busMapPort(PinGroup *group) {
+	// All RP2040 user GPIO pins (0-29) are in one SIO bank.
+
+	for (int i = 0; i < group->pinCount; i++) {
+		int pin = mapDigitalPinNum(group->pins[i]);
+		if ((pin < 0) || (pin > 29)) return false;
+		group->bitMasks[i] = 1 << pin;
+	}
+	return true;
+}
+
+static void busWritePort(PinGroup *group, uint32 setMask, uint32 clearMask) {
+	sio_hw->gpio_set = setMask;
+	sio_hw->gpio_clr = clearMask;
+}
+
+static uint32 busReadPort(PinGroup *group) {
+	return sio_hw->gpio_in;
+}
+
+static PinBusDriver busDriver = { busSetPin, busGetPin, busMapPort, busWritePort, busReadPort };
+
+#else
+
+// no port access; write and read the pins one at a time
+static PinBusDriver busDriver = { busSetPin, busGetPin, NULL, NULL, NULL };
+
+#endif
+
+static PinGroup * pinGroupArg(OBJ arg) {
+	// Return the pin group with the given id (1-PIN_GROUP_COUNT) or NULL.
+
+	if (!isInt(arg)) { fail(needsIntegerError); return NULL; }
+	int id = obj2int(arg);
+	if ((id < 1) || (id > PIN_GROUP_COUNT)) { fail(indexOutOfRangeError); return NULL; }
+	return &pinGroups[id - 1];
+}
+
+static uint8 * busDataArg(OBJ arg, int *count) {
+	// Return a pointer to the bytes of a ByteArray or String and set count.
+
+	if (IS_TYPE(arg, ByteArrayType)) {
+		*count = BYTES(arg);
+		return (uint8 *) &FIELD(arg, 0);
+	} else if (IS_TYPE(arg, StringType)) {
+		*count = strlen(obj2str(arg));
+		return (uint8 *) obj2str(arg);
+	}
+	fail(needsByteArray);
+	return NULL;
+}
+
+static OBJ primPinGroupDefine(int argCount, OBJ *args) {
+	// Define a pin group from a list of up to 32 pin numbers, least significant bit first.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	if (!ensureListCopy(args, 1)) return falseObj;
+	OBJ pinList = args[1];
+	if (!IS_TYPE(pinList, ListType)) return fail(needsListOfIntegers);
+	int count = obj2int(FIELD(pinList, 0));
+	if ((count < 1) || (count > PIN_GROUP_MAX_PINS)) return fail(indexOutOfRangeError);
+
+	int pins[PIN_GROUP_MAX_PINS];
+	for (int i = 0; i < count; i++) {
+		OBJ item = FIELD(pinList, i + 1);
+		if (!isInt(item)) return fail(needsListOfIntegers);
+		pins[i] = obj2int(item);
+	}
+	pinBus_define(group, pins, count, &busDriver);
+	return falseObj;
+}
+
+static OBJ primPinGroupWrite(int argCount, OBJ *args) {
+	// Write an integer to a pin group; bit i of the value goes to the group's ith pin.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	pinBus_write(group, obj2int(args[1]), &busDriver);
+	return falseObj;
+}
+
+static OBJ primPinGroupRead(int argCount, OBJ *args) {
+	// Read a pin group into an integer (at most 30 bits fit into an integer).
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return zeroObj;
+	return int2obj(pinBus_read(group, &busDriver) & 0x3FFFFFFF);
+}
+
+static OBJ primPinGroupWriteBytes(int argCount, OBJ *args) {
+	// Write each byte of a ByteArray or String to a pin group, pulsing the strobe pin
+	// after each byte. Optional last argument: the active strobe level (default: true).
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	PinGroup *group = pinGroupArg(args[0]);
+	if (!group) return falseObj;
+	int count;
+	uint8 *data = busDataArg(args[1], &count);
+	if (!data) return falseObj;
+	if (!isInt(args[2])) return fail(needsIntegerError);
+	int strobeLevel = (argCount > 3) ? (falseObj != args[3]) : true;
+	pinBus_writeBytes(group, data, count, obj2int(args[2]), strobeLevel, &busDriver);
+	return falseObj;
+}
+
+static OBJ primShiftOutBytes(int argCount, OBJ *args) {
+	// Shift out each byte of a ByteArray or String on a data pin, pulsing the clock pin
+	// after each bit. Optional last argument: most significant bit first (default: true).
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	if (!isInt(args[0]) || !isInt(args[1])) return fail(needsIntegerError);
+	int count;
+	uint8 *data = busDataArg(args[2], &count);
+	if (!data) return falseObj;
+	int msbFirst = (argCount > 3) ? (falseObj != args[3]) : true;
+	pinBus_shiftOut(obj2int(args[0]), obj2int(args[1]), data, count, msbFirst, &busDriver);
+	return falseObj;
+}
+
+// Timed Analog Sampling (see adcSampler.c)
+// Samples are taken by the VM loop at their scheduled times, so the sample rate is exact
+// over time, although each sample may be taken somewhat late while a task is running.
+
+#include "adcSampler.h"
+
+int adcSampling = false;
+
+static ADCSampler adcSampler;
+
+static int adcReadPin(int pin, uint64 sampleTime) {
+	OBJ pinArg = int2obj(pin);
+	return obj2int(primAnalogRead(1, &pinArg));
+}
+
+static ADCDriver adcDriver = { adcReadPin };
+
+void sampleADC() {
+	adcSampler_run(&adcSampler, totalMicrosecs(), &adcDriver);
+	adcSampling = adcSampler.running;
+}
+
+static void stopADCSampling() {
+	adcSampler_stop(&adcSampler);
+	adcSampling = false;
+}
+
+static OBJ primADCSample(int argCount, OBJ *args) {
+	// Start sampling a pin or a list of up to four pins. Arguments: pins, rate (sample
+	// frames per second), frames per buffer, and (optional) continuous. Return true if
+	// sampling started or false if there was not enough memory for the buffers.
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	int pins[ADC_MAX_CHANNELS];
+	int channelCount = 0;
+	if (!ensureListCopy(args, 0)) return falseObj;
+	OBJ pinArg = args[0];
+	if (isInt(pinArg)) {
+		pins[channelCount++] = obj2int(pinArg);
+	} else if (IS_TYPE(pinArg, ListType)) {
+		int count = obj2int(FIELD(pinArg, 0));
+		if ((count < 1) || (count > ADC_MAX_CHANNELS)) return fail(indexOutOfRangeError);
+		for (int i = 0; i < count; i++) {
+			OBJ item = FIELD(pinArg, i + 1);
+			if (!isInt(item)) return fail(needsListOfIntegers);
+			pins[channelCount++] = obj2int(item);
+		}
+	} else {
+		return fail(needsListOfIntegers);
+	}
+	if (!isInt(args[1]) || !isInt(args[2])) return fail(needsIntegerError);
+	int rate = obj2int(args[1]);
+	int frames = obj2int(args[2]);
+	if ((rate < 1) || (rate > ADC_MAX_RATE) || (frames < 1) ||
+		((2 * frames * channelCount) > ADC_MAX_BUFFER_BYTES)) return fail(indexOutOfRangeError);
+	int continuous = (argCount > 3) && (trueObj == args[3]);
+
+	adcSampling = adcSampler_start(&adcSampler, pins, channelCount, rate, frames, continuous, totalMicrosecs());
+	return adcSampling ? trueObj : falseObj;
+}
+
+static OBJ primADCDone(int argCount, OBJ *args) {
+	// Return true when a full buffer of samples is ready to be read.
+
+	return adcSampler_ready(&adcSampler) ? trueObj : falseObj;
+}
+
+static OBJ primADCRead(int argCount, OBJ *args) {
+	// Copy a full buffer of samples into a ByteArray as little-endian int16 values, channels
+	// interleaved, and return the number of bytes copied (zero if no buffer is ready).
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	return int2obj(adcSampler_read(&adcSampler, (uint8 *) &FIELD(buf, 0), BYTES(buf)));
+}
+
+static OBJ primADCStop(int argCount, OBJ *args) {
+	stopADCSampling();
+	return falseObj;
+}
+
+static OBJ primADCStats(int argCount, OBJ *args) {
+	// Return a list: frames taken, buffers dropped, the maximum sample lateness in usecs,
+	// and frames missed.
+
+	OBJ result = newObj(ListType, 5, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(4);
+	FIELD(result, 1) = int2obj(adcSampler.framesTaken & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(adcSampler.buffersDropped & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(adcSampler.maxLateUsecs & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(adcSampler.framesMissed & 0x3FFFFFFF);
+	return result;
+}
+
+// Pulse Trains (see pulseTrain.c)
+// On nRF5x boards, the steps are taken by the interrupt handler of the MicroBlocks timer,
+// using its spare compare register, CC[1], which it shares with audio output. On other
+// boards, they are taken by the VM loop.
+
+#include "pulseTrain.h"
+
+int pulseTrainsActive = false;
+
+static PulseTrain pulseTrains[PULSE_TRAIN_COUNT];
+
+static void pulseSetPins(PulseTrain *train, uint32 levels, uint32 changed, uint64 edgeTime) {
+	for (int i = 0; i < train->pinCount; i++) {
+		if ((changed >> i) & 1) digitalWrite(train->pins[i], (levels >> i) & 1);
+	}
+}
+
+static PulseDriver pulseDriver = { pulseSetPins };
+
+void updatePulseTrains() {
+	uint64 nextEdge;
+	int activeCount = pulseTrain_update(pulseTrains, PULSE_TRAIN_COUNT, totalMicrosecs(), &pulseDriver, &nextEdge);
+	pulseTrainsActive = (activeCount > 0);
+}
+
+#if defined(NRF51) || defined(NRF52)
+
+static void outputTimerInterrupt() {
+	// Take the pulse train steps that are due and set CC[1] to the time of the next one.
+	// If that is only a few usecs away, wait for it here, since a compare value that has
+	// already passed would not match again until the timer wraps.
+
+	uint64 nextEdge;
+	for (int i = 0; i < 8; i++) {
+		uint64 now = totalMicrosecs();
+		if (!pulseTrain_update(pulseTrains, PULSE_TRAIN_COUNT, now, &pulseDriver, &nextEdge)) return;
+		int usecsUntilNext = (int) ((uint32) nextEdge - microsecs());
+		if (usecsUntilNext > 3) {
+			MB_TIMER->CC[1] = (uint32) nextEdge;
+			return;
+		}
+		while ((int) ((uint32) nextEdge - microsecs()) > 0) { } // wait for it
+	}
+	MB_TIMER->CC[1] = microsecs() + 10; // very short steps; let other code run briefly
+}
+
+static void startPulseTimer() {
+	// Request a timer interrupt a few usecs from now to take the first steps.
+
+	MB_TIMER->INTENSET = TIMER_INTENSET_COMPARE1_Msk;
+	NVIC_EnableIRQ(MB_TIMER_IRQn);
+	MB_TIMER->CC[1] = microsecs() + 5;
+}
+
+#else
+
+static void startPulseTimer() { pulseTrainsActive = true; }
+
+#endif
+
+static void stopPulseTrains() {
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) pulseTrain_stop(&pulseTrains[i]);
+	pulseTrainsActive = false;
+}
+
+static int pulsePinsArg(OBJ arg, int *pins) {
+	// Set pins to the pin or list of pins in arg, mapped to hardware pin numbers. Return
+	// the pin count, or zero if a pin is not valid.
+
+	int count = 0;
+	if (isInt(arg)) {
+		pins[count++] = mapDigitalPinNum(obj2int(arg));
+	} else if (IS_TYPE(arg, ListType)) {
+		count = obj2int(FIELD(arg, 0));
+		if ((count < 1) || (count > PULSE_TRAIN_MAX_PINS)) { fail(indexOutOfRangeError); return 0; }
+		for (int i = 0; i < count; i++) {
+			OBJ item = FIELD(arg, i + 1);
+			if (!isInt(item)) { fail(needsListOfIntegers); return 0; }
+			pins[i] = mapDigitalPinNum(obj2int(item));
+		}
+	} else {
+		fail(needsListOfIntegers);
+		return 0;
+	}
+	for (int i = 0; i < count; i++) {
+		if (pins[i] < 0) return 0;
+	}
+	return count;
+}
+
+static int trainHasPin(PulseTrain *train, int pin) {
+	for (int i = 0; i < train->pinCount; i++) {
+		if (pin == train->pins[i]) return true;
+	}
+	return false;
+}
+
+static OBJ primPulsePlay(int argCount, OBJ *args) {
+	// Play a pulse train on a pin or a list of up to eight pins. The steps are either a
+	// ByteArray of four-byte steps (pin levels followed by a 24-bit duration in usecs, least
+	// significant byte first) or a list of integers (levels, usecs, levels, usecs, ...).
+	// Bit i of the levels is the level of the ith pin. Optional last argument: true to
+	// repeat until stopped or the number of times to play the steps (default: once).
+	// Return true if the train was started.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0) || !ensureListCopy(args, 1)) return falseObj;
+	int pins[PULSE_TRAIN_MAX_PINS];
+	int pinCount = pulsePinsArg(args[0], pins);
+	if (!pinCount) return falseObj;
+	OBJ steps = args[1];
+	int stepCount;
+	if (IS_TYPE(steps, ByteArrayType)) {
+		stepCount = BYTES(steps) / 4;
+	} else if (IS_TYPE(steps, ListType)) {
+		stepCount = obj2int(FIELD(steps, 0)) / 2;
+		for (int i = 1; i <= (2 * stepCount); i++) {
+			if (!isInt(FIELD(steps, i))) return fail(needsListOfIntegers);
+		}
+	} else {
+		return fail(needsByteArray);
+	}
+	if ((stepCount < 1) || (stepCount > PULSE_TRAIN_MAX_STEPS)) return fail(indexOutOfRangeError);
+	int repeatCount = 1;
+	if (argCount > 2) {
+		if (trueObj == args[2]) repeatCount = 0; // repeat until stopped
+		if (isInt(args[2])) repeatCount = obj2int(args[2]);
+		if (repeatCount < 0) return fail(indexOutOfRangeError);
+	}
+
+	// use the train already playing the first pin or an idle one
+	PulseTrain *train = NULL;
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		if (trainHasPin(&pulseTrains[i], pins[0])) train = &pulseTrains[i];
+	}
+	for (int i = 0; !train && (i < PULSE_TRAIN_COUNT); i++) {
+		if (!pulseTrains[i].active) train = &pulseTrains[i];
+	}
+	if (!train) return falseObj; // all trains are busy
+
+	if (!pulseTrain_load(train, pins, pinCount, stepCount)) return falseObj;
+	for (int i = 0; i < stepCount; i++) {
+		if (IS_TYPE(steps, ByteArrayType)) {
+			uint8 *p = (uint8 *) &FIELD(steps, 0) + (4 * i);
+			pulseTrain_setStep(train, i, p[0], p[1] | (p[2] << 8) | (p[3] << 16));
+		} else {
+			pulseTrain_setStep(train, i, obj2int(FIELD(steps, (2 * i) + 1)), obj2int(FIELD(steps, (2 * i) + 2)));
+		}
+	}
+	for (int i = 0; i < pinCount; i++) SET_MODE(pins[i], OUTPUT);
+	if (!pulseTrain_play(train, repeatCount, totalMicrosecs() + 20)) return falseObj;
+	startPulseTimer();
+	return trueObj;
+}
+
+static OBJ primPulseBusy(int argCount, OBJ *args) {
+	// Return true if a pulse train is playing on the given pin or, with no argument, on any pin.
+
+	int pin = ((argCount > 0) && isInt(args[0])) ? mapDigitalPinNum(obj2int(args[0])) : -1;
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		PulseTrain *train = &pulseTrains[i];
+		if (train->active && ((pin < 0) || trainHasPin(train, pin))) return trueObj;
+	}
+	return falseObj;
+}
+
+static OBJ primPulseStop(int argCount, OBJ *args) {
+	// Stop the pulse train playing on the given pin or, with no argument, all pulse trains.
+	// The pins keep their current levels.
+
+	if ((argCount < 1) || !isInt(args[0])) {
+		stopPulseTrains();
+		return falseObj;
+	}
+	int pin = mapDigitalPinNum(obj2int(args[0]));
+	for (int i = 0; i < PULSE_TRAIN_COUNT; i++) {
+		if (trainHasPin(&pulseTrains[i], pin)) pulseTrain_stop(&pulseTrains[i]);
+	}
+	return falseObj;
+}
+
+// Buffered Audio Output (see audioOut.c)
+// On ESP32 DAC pins (25 and 26), samples go to the DAC ring buffer, which is played by a
+// timer interrupt. On RP2040 (mbed), they go to the PWM set up by initDAC(). On other
+// boards, they are written to the pin with analogWrite() from the VM loop. (On nRF5x,
+// analogWrite() waits for the PWM period to end, so it is not called from the timer
+// interrupt that plays pulse trains.)
+
+#include "audioOut.h"
+
+int audioPlaying = false;
+
+static AudioOut audioOut;
+static int audioPin = -1;
+
+static int audioWritePWM(int sample, uint64 sampleTime) {
+	OBJ args[2] = { int2obj(audioPin), int2obj((sample + 32768) >> 6) }; // 10-bit value
+	primAnalogWrite(args);
+	return true;
+}
+
+static int audioWriteDAC(int sample, uint64 sampleTime) {
+	return writeDAC((sample + 32768) >> 8); // 8-bit value
+}
+
+static AudioDriver audioPWMDriver = { false, audioWritePWM };
+static AudioDriver audioDACDriver = { false, audioWriteDAC };
+static AudioDriver audioClockedDACDriver = { true, audioWriteDAC };
+static AudioDriver *audioDriver = &audioPWMDriver;
+
+void updateAudio() {
+	audioOut_run(&audioOut, totalMicrosecs(), audioDriver);
+	audioPlaying = audioOut.running;
+}
+
+static void stopAudio() {
+	audioOut_stop(&audioOut);
+	audioPlaying = false;
+}
+
+static OBJ primAudioStart(int argCount, OBJ *args) {
+	// Start audio output on a pin at the given sample rate. Optional last argument: bits
+	// per sample, 8 (unsigned) or 16 (signed, little-endian); default is 8. Return true if
+	// successful. Samples are then queued with audioQueue.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!isInt(args[0]) || !isInt(args[1])) return fail(needsIntegerError);
+	int pin = obj2int(args[0]);
+	int rate = obj2int(args[1]);
+	int bits = ((argCount > 2) && isInt(args[2])) ? obj2int(args[2]) : 8;
+	stopAudio();
+	if (!audioOut_start(&audioOut, rate, bits)) return fail(indexOutOfRangeError);
+
+	audioPin = pin;
+	audioDriver = &audioPWMDriver;
+	#if defined(ESP32) && !defined(ESP32_S3) && !defined(ESP32_C3)
+		initDAC(pin, rate);
+		if (dacChannel <= 1) audioDriver = &audioClockedDACDriver;
+	#elif defined(ARDUINO_ARCH_RP2040) && defined(ARDUINO_ARCH_MBED)
+		initDAC(pin, rate);
+		audioDriver = &audioDACDriver;
+	#endif
+	audioPlaying = true;
+	return trueObj;
+}
+
+static OBJ primAudioQueue(int argCount, OBJ *args) {
+	// Add a ByteArray of samples to the audio output queue. Return false if the queue is full.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	if (BYTES(buf) > AUDIO_MAX_BUFFER_BYTES) return fail(indexOutOfRangeError);
+	int ok = audioOut_queue(&audioOut, (uint8 *) &FIELD(buf, 0), BYTES(buf), totalMicrosecs());
+	return ok ? trueObj : falseObj;
+}
+
+static OBJ primAudioSpace(int argCount, OBJ *args) {
+	// Return the number of buffers that can be queued now.
+
+	return int2obj(audioOut_space(&audioOut));
+}
+
+static OBJ primAudioStop(int argCount, OBJ *args) {
+	stopAudio();
+	return falseObj;
+}
+
+static OBJ primAudioStats(int argCount, OBJ *args) {
+	// Return a list: samples played, buffers played, underruns, the maximum sample
+	// lateness in usecs, and samples dropped because they were late.
+
+	OBJ result = newObj(ListType, 6, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(5);
+	FIELD(result, 1) = int2obj(audioOut.samplesPlayed & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(audioOut.buffersPlayed & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(audioOut.underruns & 0x3FFFFFFF);
+	FIELD(result, 4) = int2obj(audioOut.maxLateUsecs & 0x3FFFFFFF);
+	FIELD(result, 5) = int2obj(audioOut.samplesDropped & 0x3FFFFFFF);
+	return result;
+}
+
 // forward to primitives that don't take argCount
 
 static OBJ primSetUserLED2(int argCount, OBJ *args) { primSetUserLED(args); return falseObj; }
@@ -2798,6 +3445,24 @@ static PrimEntry entries[] = {
 	{"analogWrite", primAnalogWrite2},
 	{"digitalRead", primDigitalRead},
 	{"digitalWrite", primDigitalWrite2},
+	{"pinGroupDefine", primPinGroupDefine},
+	{"pinGroupWrite", primPinGroupWrite},
+	{"pinGroupRead", primPinGroupRead},
+	{"pinGroupWriteBytes", primPinGroupWriteBytes},
+	{"shiftOutBytes", primShiftOutBytes},
+	{"adcSample", primADCSample},
+	{"adcDone", primADCDone},
+	{"adcRead", primADCRead},
+	{"adcStop", primADCStop},
+	{"adcStats", primADCStats},
+	{"pulsePlay", primPulsePlay},
+	{"pulseBusy", primPulseBusy},
+	{"pulseStop", primPulseStop},
+	{"audioStart", primAudioStart},
+	{"audioQueue", primAudioQueue},
+	{"audioSpace", primAudioSpace},
+	{"audioStop", primAudioStop},
+	{"audioStats", primAudioStats},
 };
 
 void addIOPrims() {
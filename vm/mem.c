@@ -80,8 +80,9 @@
 
 #define OBJSTORE_WORDS ((OBJSTORE_BYTES / 4) + 4)
 
-#if defined(ARDUINO_ARCH_ESP32)
-  static OBJ *objstore = NULL; // allocated from heap on ESP32
+#if defined(ARDUINO_ARCH_ESP32) || (defined(GNUBLOCKS) && !defined(EMSCRIPTEN))
+  #define HEAP_OBJSTORE true
+  static OBJ *objstore = NULL; // allocated from heap on ESP32 and Linux (one per VM instance)
 #else
   static OBJ objstore[OBJSTORE_WORDS];
 #endif
@@ -102,9 +103,10 @@ void memInit() {
 		vmPanic("MicroBlocks expects int, int*, and float to all be 32-bits");
 	}
 
-	#if defined(ARDUINO_ARCH_ESP32)
+	#if defined(HEAP_OBJSTORE)
+		// Note: on Linux, each call allocates a new object store for a new VM instance
 		objstore = (OBJ *) malloc(4 * OBJSTORE_WORDS);
-		if (!objstore) vmPanic("ESP32 could not allocate objectstore");
+		if (!objstore) vmPanic("Could not allocate objectstore");
 	#endif
 
 	// initialize object heap memory
@@ -121,7 +123,7 @@ void memClear() {
 	lastBroadcast = zeroObj;
 
 	// zero objectstore memory (not essential)
-	memset(objstore, 0, sizeof(objstore));
+	memset(objstore, 0, 4 * OBJSTORE_WORDS);
 
 	// create the free chunk (prefixed by a forwarding word)
 	objstore[0] = (OBJ) 0; // forwarding word
@@ -129,6 +131,27 @@ void memClear() {
 	freeChunk = (OBJ) &objstore[1];
 }
 
+#if defined(GNUBLOCKS) && !defined(EMSCRIPTEN)
+
+// VM instances (see linux+pi/vmHost.c)
+
+void memSaveState(VMState *state) {
+	state->objstore = objstore;
+	state->memStart = memStart;
+	state->memEnd = memEnd;
+	state->freeChunk = freeChunk;
+}
+
+void memRestoreState(VMState *state) {
+	objstore = state->objstore;
+	memStart = state->memStart;
+	memEnd = state->memEnd;
+	freeChunk = state->freeChunk;
+	tempGCRoot = NULL;
+}
+
+#endif
+
 int wordsFree() {
 	int result = WORDS(freeChunk) - 2;
 	return (result < 0) ? 0 : result;
@@ -193,13 +216,20 @@ OBJ resizeObj(OBJ oldObj, int wordCount) {
 	if (wordCount < copyCount) copyCount = wordCount; // new size is smaller
 	memcpy(result + 1, oldObj + 1, 4 * copyCount); // copy from the old to the new body
 
+	replaceObj(oldObj, result);
+	return result;
+}
+
+void replaceObj(OBJ oldObj, OBJ newObj) {
+	// Replace all references to oldObj with references to newObj, then free oldObj.
+
+	if ((oldObj < memStart) || (oldObj >= memEnd)) return; // object must be in object store
+
 	clearForwardingFields();
-	*(oldObj - 1) = (uint32) result; // point forwarding field of oldObj to result
+	*(oldObj - 1) = (uint32) newObj; // point forwarding field of oldObj to newObj
 	applyForwarding();
 	*(oldObj - 1) = 0; // clear forwarding field
 	*oldObj = HEADER(FREE_CHUNK, WORDS(oldObj)); // mark oldObj free
-
-	return result;
 }
 
 // String Primitives
@@ -229,6 +259,7 @@ char* obj2str(OBJ obj) {
 	if (isBoolean(obj)) return (char *) ((trueObj == obj) ? "true" : "false");
 	if (IS_TYPE(obj, StringType)) return (char *) &obj[HEADER_WORDS];
 	if (IS_TYPE(obj, ListType)) return (char *) "<List>";
+	if (IS_TYPE(obj, RangeType)) return (char *) "<List>";
 	if (IS_TYPE(obj, ByteArrayType)) return (char *) "<ByteArray>";
 	return (char *) "<Object>";
 }
@@ -263,6 +294,9 @@ void reportObj(const char *msg, OBJ obj) {
 	case ListType:
 		sprintf(s, "%s: List (%d fields)", msg, obj2int(FIELD(obj, 0)));
 		break;
+	case RangeType:
+		sprintf(s, "%s: Range (%d items)", msg, RANGE_COUNT(obj));
+		break;
 	default:
 		sprintf(s, "%s: <type %d> (%d fields)", msg, type, WORDS(obj));
 	}
@@ -72,7 +72,8 @@ typedef int * OBJ;
 #define IntegerType 2
 #define ByteArrayType 3
 #define StringType 4
-// types 5-7 reserved for future non-pointer objects
+#define RangeType 5
+// types 6-7 reserved for future non-pointer objects
 #define BinaryObjectTypes 7 // objects with type ID's <= 7 do not contain pointers
 #define ArrayType 8
 #define ListType 9
@@ -142,7 +143,25 @@ static inline int objType(OBJ obj) {
 
 #define FIELD(obj, i) (((OBJ *) obj)[HEADER_WORDS + (i)])
 
+// Ranges
+//
+// A Range is a compact, read-only stand-in for a List of evenly spaced integers. Its three
+// fields hold the first item, the item count, and the step, all as integer objects. A Range
+// is converted into a List when it is modified (see rangeToList() in dataPrims.c).
+
+#define RANGE_COUNT(obj) (obj2int(FIELD(obj, 1)))
+
+static inline OBJ rangeAt(OBJ range, int i) {
+	// Return the ith item (one-based) of the given range. Does not check the index.
+	return int2obj(obj2int(FIELD(range, 0)) + ((i - 1) * obj2int(FIELD(range, 2))));
+}
+
 // Global temporary GC root for use by primitives that do multiple allocations.
+//
+// The garbage collector compacts memory, moving objects, so a pointer into an object (such
+// as the bytes of a ByteArray) is only valid until the next allocation. Code that uses data
+// after its primitive returns, such as the VM loop or a timer interrupt, must not keep such
+// a pointer; it copies the data into a buffer of its own (allocated with malloc) instead.
 
 extern OBJ tempGCRoot;
 
@@ -155,6 +174,7 @@ void gc();
 
 OBJ newObj(int typeID, int wordCount, OBJ fill);
 OBJ resizeObj(OBJ obj, int wordCount);
+void replaceObj(OBJ oldObj, OBJ newObj);
 OBJ newString(int byteCount);
 OBJ newStringFromBytes(const char *bytes, int byteCount);
 char* obj2str(OBJ obj);
@@ -14,6 +14,8 @@
 
 #include "mem.h"
 #include "interp.h"
+#include "fixedMath.h"
+#include "timeSeries.h"
 #include "tinyJSON.h"
 #include "version.h"
 
@@ -162,6 +164,225 @@ OBJ primColorBrightness(int argCount, OBJ *args) {
 	return int2obj((int) (100.0 * v));
 }
 
+// Bulk color conversion
+//
+// These primitives convert many colors per call using integer math. Lists hold packed
+// 24-bit RGB integers or flat HSV triples (hue 0-359, saturation and brightness 0-100),
+// matching the single-color primitives above. ByteArrays hold three bytes per color,
+// either R, G, B or H, S, V with hue scaled to 0-255 for a full circle, as used by
+// LED strip and display buffers. Internally, hue uses 256 steps per 60-degree sector.
+
+#define HUE_STEPS 1536 // 6 sectors * 256 steps
+
+static uint32 hsvToRGB(int h, int s, int v) {
+	// Return packed RGB for hue h (0..HUE_STEPS-1), saturation s and value v (0..255).
+
+	int sector = h >> 8;
+	int f = h & 255;
+	int p = (v * (255 - s)) / 255;
+	int q = (v * (255 - ((s * f) / 255))) / 255;
+	int t = (v * (255 - ((s * (255 - f)) / 255))) / 255;
+	int r, g, b;
+
+	switch (sector) {
+	case 0: r = v; g = t; b = p; break;
+	case 1: r = q; g = v; b = p; break;
+	case 2: r = p; g = v; b = t; break;
+	case 3: r = p; g = q; b = v; break;
+	case 4: r = t; g = p; b = v; break;
+	default: r = v; g = p; b = q; break;
+	}
+	return (r << 16) | (g << 8) | b;
+}
+
+static void rgbToHSV(int r, int g, int b, int *h, int *s, int *v) {
+	// Convert r, g, b (0..255) to hue (0..HUE_STEPS-1), saturation and value (0..255).
+
+	int max = (r > g) ? ((r > b) ? r : b) : ((g > b) ? g : b);
+	int min = (r < g) ? ((r < b) ? r : b) : ((g < b) ? g : b);
+	int delta = max - min;
+
+	*v = max;
+	*s = (max > 0) ? ((255 * delta) / max) : 0;
+	if (0 == delta) { // gray; hue is arbitrarily chosen to be zero
+		*h = 0;
+		return;
+	}
+	int hue;
+	if (max == r) {
+		hue = (256 * (g - b)) / delta;
+		if (hue < 0) hue += HUE_STEPS;
+	} else if (max == g) {
+		hue = 512 + ((256 * (b - r)) / delta);
+	} else {
+		hue = 1024 + ((256 * (r - g)) / delta);
+	}
+	*h = hue % HUE_STEPS;
+}
+
+static inline int percentTo255(int percent) {
+	if (percent < 0) percent = 0;
+	if (percent > 100) percent = 100;
+	return ((255 * percent) + 50) / 100;
+}
+
+static OBJ colorListResult(int argCount, OBJ *args, int itemCount) {
+	// Return the destination List (args[1]) if supplied, otherwise a new List of itemCount items.
+
+	if (argCount > 1) {
+		if (!ensureList(args, 1)) return falseObj;
+		OBJ dst = args[1];
+		if (!IS_TYPE(dst, ListType)) return fail(needsListError);
+		if ((WORDS(dst) - 1) < itemCount) return fail(indexOutOfRangeError);
+		FIELD(dst, 0) = int2obj(itemCount);
+		return dst;
+	}
+	OBJ result = newObj(ListType, itemCount + 1, zeroObj);
+	if (result) FIELD(result, 0) = int2obj(itemCount);
+	return result;
+}
+
+static OBJ colorBytesResult(int argCount, OBJ *args, int byteCount) {
+	// Return the destination ByteArray (args[1]) if supplied, otherwise a new ByteArray.
+	// The destination may be the source, to convert in place.
+
+	if (argCount > 1) {
+		OBJ dst = args[1];
+		if (!IS_TYPE(dst, ByteArrayType)) return fail(needsByteArray);
+		if (BYTES(dst) < byteCount) return fail(indexOutOfRangeError);
+		return dst;
+	}
+	OBJ result = newObj(ByteArrayType, (byteCount + 3) / 4, falseObj);
+	if (result) setByteCountAdjust(result, byteCount);
+	return result;
+}
+
+static OBJ primHSVToRGB(int argCount, OBJ *args) {
+	// Convert HSV triples to RGB: a List of H, S, V triples becomes a List of packed RGB colors,
+	// a ByteArray of H, S, V bytes becomes a ByteArray of R, G, B bytes.
+	//	hsvToRGB src [dst]
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureList(args, 0)) return falseObj;
+
+	if (IS_TYPE(args[0], ListType)) {
+		int colorCount = obj2int(FIELD(args[0], 0)) / 3;
+		OBJ result = colorListResult(argCount, args, colorCount);
+		if (!result) return result;
+		OBJ src = args[0]; // update src after possible GC
+		for (int i = 0; i < colorCount; i++) {
+			int h = evalInt(FIELD(src, (3 * i) + 1)) % 360;
+			if (h < 0) h += 360;
+			int s = percentTo255(evalInt(FIELD(src, (3 * i) + 2)));
+			int v = percentTo255(evalInt(FIELD(src, (3 * i) + 3)));
+			FIELD(result, i + 1) = int2obj(hsvToRGB((h * HUE_STEPS) / 360, s, v));
+		}
+		return result;
+	} else if (IS_TYPE(args[0], ByteArrayType)) {
+		int byteCount = 3 * (BYTES(args[0]) / 3);
+		OBJ result = colorBytesResult(argCount, args, byteCount);
+		if (!result) return result;
+		uint8 *src = (uint8 *) &FIELD(args[0], 0);
+		uint8 *dst = (uint8 *) &FIELD(result, 0);
+		for (int i = 0; i < byteCount; i += 3) {
+			uint32 rgb = hsvToRGB(src[i] * 6, src[i + 1], src[i + 2]);
+			dst[i] = (rgb >> 16) & 255;
+			dst[i + 1] = (rgb >> 8) & 255;
+			dst[i + 2] = rgb & 255;
+		}
+		return result;
+	}
+	return fail(needsListError);
+}
+
+static OBJ primRGBToHSV(int argCount, OBJ *args) {
+	// Convert RGB colors to HSV: a List of packed RGB colors becomes a List of H, S, V triples,
+	// a ByteArray of R, G, B bytes becomes a ByteArray of H, S, V bytes.
+	//	rgbToHSV src [dst]
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	int h, s, v;
+	if (!ensureList(args, 0)) return falseObj;
+
+	if (IS_TYPE(args[0], ListType)) {
+		int colorCount = obj2int(FIELD(args[0], 0));
+		if ((argCount > 1) && (args[0] == args[1])) return fail(needsListError); // result is bigger
+		OBJ result = colorListResult(argCount, args, 3 * colorCount);
+		if (!result) return result;
+		OBJ src = args[0]; // update src after possible GC
+		for (int i = 0; i < colorCount; i++) {
+			int rgb = evalInt(FIELD(src, i + 1));
+			rgbToHSV((rgb >> 16) & 255, (rgb >> 8) & 255, rgb & 255, &h, &s, &v);
+			FIELD(result, (3 * i) + 1) = int2obj((h * 360) / HUE_STEPS);
+			FIELD(result, (3 * i) + 2) = int2obj(((100 * s) + 127) / 255);
+			FIELD(result, (3 * i) + 3) = int2obj(((100 * v) + 127) / 255);
+		}
+		return result;
+	} else if (IS_TYPE(args[0], ByteArrayType)) {
+		int byteCount = 3 * (BYTES(args[0]) / 3);
+		OBJ result = colorBytesResult(argCount, args, byteCount);
+		if (!result) return result;
+		uint8 *src = (uint8 *) &FIELD(args[0], 0);
+		uint8 *dst = (uint8 *) &FIELD(result, 0);
+		for (int i = 0; i < byteCount; i += 3) {
+			rgbToHSV(src[i], src[i + 1], src[i + 2], &h, &s, &v);
+			dst[i] = h / 6;
+			dst[i + 1] = s;
+			dst[i + 2] = v;
+		}
+		return result;
+	}
+	return fail(needsListError);
+}
+
+static OBJ primGradientFill(int argCount, OBJ *args) {
+	// Fill a List (with packed RGB colors) or a ByteArray (with R, G, B bytes) with a gradient
+	// that passes through the given list of RGB color stops, evenly spaced.
+	//	gradientFill dst stops
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureList(args, 0) || !ensureListCopy(args, 1)) return falseObj;
+	OBJ dst = args[0];
+	OBJ stops = args[1];
+	if (!IS_TYPE(stops, ListType)) return fail(needsListError);
+	int stopCount = obj2int(FIELD(stops, 0));
+	if (stopCount < 1) return falseObj;
+
+	int isList = IS_TYPE(dst, ListType);
+	int count;
+	if (isList) {
+		count = obj2int(FIELD(dst, 0));
+	} else if (IS_TYPE(dst, ByteArrayType)) {
+		count = BYTES(dst) / 3;
+	} else {
+		return fail(needsListError);
+	}
+
+	uint8 *bytes = (uint8 *) &FIELD(dst, 0);
+	for (int i = 0; i < count; i++) {
+		// position along the gradient in units of 1/256 of the distance between stops
+		int pos = (count > 1) ? ((i * (stopCount - 1) * 256) / (count - 1)) : 0;
+		int stop = pos >> 8;
+		int frac = pos & 255;
+		int c1 = evalInt(FIELD(stops, stop + 1));
+		int c2 = (stop + 1 < stopCount) ? evalInt(FIELD(stops, stop + 2)) : c1;
+		int rgb = 0;
+		for (int shift = 16; shift >= 0; shift -= 8) {
+			int a = (c1 >> shift) & 255;
+			int b = (c2 >> shift) & 255;
+			rgb |= (a + (((b - a) * frac) >> 8)) << shift;
+		}
+		if (isList) {
+			FIELD(dst, i + 1) = int2obj(rgb);
+		} else {
+			bytes[3 * i] = (rgb >> 16) & 255;
+			bytes[(3 * i) + 1] = (rgb >> 8) & 255;
+			bytes[(3 * i) + 2] = rgb & 255;
+		}
+	}
+	return falseObj;
+}
+
 static OBJ primSine(int argCount, OBJ *args) {
 	// Returns the sine of the given angle * 2^14 (i.e. a fixed point integer with 13 bits of
 	// fraction). The input is the angle in hundreths of a degree (e.g. 4500 means 45 degrees).
@@ -194,6 +415,114 @@ static OBJ primArctan(int argCount, OBJ *args) {
 	return int2obj((int) round(degreeHundredths));
 }
 
+// Vector math
+//
+// These primitives apply sine, square root, or arctangent to every element of a List,
+// Range, or ByteArray and store the results in a destination List or ByteArray. A
+// ByteArray, whether source or destination, holds 16-bit signed little-endian values;
+// results outside that range are clipped. They use the integer functions in fixedMath.c,
+// which give the same results as the scalar primitives above to within 1.
+
+static int vectorCount(OBJ obj) {
+	// Return the number of elements of obj or -1 if it is not a vector.
+
+	if (IS_TYPE(obj, ListType)) return obj2int(FIELD(obj, 0));
+	if (IS_TYPE(obj, RangeType)) return RANGE_COUNT(obj);
+	if (IS_TYPE(obj, ByteArrayType)) return BYTES(obj) / 2;
+	return -1;
+}
+
+static inline int vectorAt(OBJ obj, int i) {
+	// Return the ith (zero-based) element of a List, Range, or ByteArray as an integer.
+
+	if (IS_TYPE(obj, ByteArrayType)) {
+		uint8 *p = ((uint8 *) &FIELD(obj, 0)) + (2 * i);
+		return (short) (p[0] | (p[1] << 8));
+	}
+	if (IS_TYPE(obj, RangeType)) return obj2int(rangeAt(obj, i + 1));
+	OBJ item = FIELD(obj, i + 1);
+	return isInt(item) ? obj2int(item) : 0;
+}
+
+static int vectorDestination(OBJ dst, int count) {
+	// Return true if dst is a List or ByteArray with room for count results. The caller
+	// first converts a Range dst into a List with ensureList().
+
+	if (IS_TYPE(dst, ListType)) return (WORDS(dst) - 1) >= count;
+	if (IS_TYPE(dst, ByteArrayType)) return BYTES(dst) >= (2 * count);
+	return false;
+}
+
+static inline void vectorAtPut(OBJ dst, int i, int value) {
+	if (IS_TYPE(dst, ByteArrayType)) {
+		if (value > 32767) value = 32767;
+		if (value < -32768) value = -32768;
+		uint8 *p = ((uint8 *) &FIELD(dst, 0)) + (2 * i);
+		p[0] = value & 255;
+		p[1] = (value >> 8) & 255;
+	} else {
+		FIELD(dst, i + 1) = int2obj(value);
+	}
+}
+
+static void vectorSetCount(OBJ dst, int count) {
+	if (IS_TYPE(dst, ListType)) FIELD(dst, 0) = int2obj(count);
+}
+
+static OBJ primSineInto(int argCount, OBJ *args) {
+	// Store the fixed sine (see primSine) of each angle in src into dst.
+	//	sinInto src dst
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	int count = vectorCount(args[0]);
+	if (count < 0) return fail(needsListError);
+	if (!ensureList(args, 1)) return falseObj;
+	if (!vectorDestination(args[1], count)) return fail(indexOutOfRangeError);
+	OBJ src = args[0];
+	OBJ dst = args[1];
+
+	for (int i = 0; i < count; i++) vectorAtPut(dst, i, fixedSine(vectorAt(src, i)));
+	vectorSetCount(dst, count);
+	return falseObj;
+}
+
+static OBJ primSqrtInto(int argCount, OBJ *args) {
+	// Store the rounded square root of each element of src into dst.
+	//	sqrtInto src dst
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	int count = vectorCount(args[0]);
+	if (count < 0) return fail(needsListError);
+	if (!ensureList(args, 1)) return falseObj;
+	if (!vectorDestination(args[1], count)) return fail(indexOutOfRangeError);
+	OBJ src = args[0];
+	OBJ dst = args[1];
+
+	for (int i = 0; i < count; i++) vectorAtPut(dst, i, fixedSqrt(vectorAt(src, i)));
+	vectorSetCount(dst, count);
+	return falseObj;
+}
+
+static OBJ primArctanInto(int argCount, OBJ *args) {
+	// Store the angle (see primArctan) of each vector (xs[i], ys[i]) into dst.
+	//	atan2Into xs ys dst
+
+	if (argCount < 3) return fail(notEnoughArguments);
+	int count = vectorCount(args[0]);
+	int yCount = vectorCount(args[1]);
+	if ((count < 0) || (yCount < 0)) return fail(needsListError);
+	if (yCount < count) count = yCount;
+	if (!ensureList(args, 2)) return falseObj;
+	if (!vectorDestination(args[2], count)) return fail(indexOutOfRangeError);
+	OBJ xs = args[0];
+	OBJ ys = args[1];
+	OBJ dst = args[2];
+
+	for (int i = 0; i < count; i++) vectorAtPut(dst, i, fixedAtan2(vectorAt(ys, i), vectorAt(xs, i)));
+	vectorSetCount(dst, count);
+	return falseObj;
+}
+
 static OBJ primPressureToAltitude(int argCount, OBJ *args) {
 	// Computes the altitude difference (in millimeters) for a given pressure difference.
 	// dH = 44330 * [ 1 - ( p / p0 ) ^ ( 1 / 5.255) ]
@@ -230,6 +559,20 @@ static OBJ jsonValue(char *item) {
 	return newString(0); // json parse error or end
 }
 
+static char * jsonItem(OBJ json, OBJ path) {
+	// Return a pointer to the item at the given path, which is either a path string or a
+	// path compiled by jsonCompilePath, or NULL if not found.
+
+	if (IS_TYPE(path, ByteArrayType)) {
+		return tjr_atCompiledPath(obj2str(json), (unsigned char *) &FIELD(path, 0), BYTES(path));
+	}
+	return tjr_atPath(obj2str(json), obj2str(path));
+}
+
+static int isJSONPath(OBJ path) {
+	return IS_TYPE(path, StringType) || IS_TYPE(path, ByteArrayType);
+}
+
 static OBJ primConnectedToIDE(int argCount, OBJ *args) {
 	return ideConnected() ? trueObj : falseObj;
 }
@@ -241,12 +584,10 @@ static OBJ primJSONGet(int argCount, OBJ *args) {
 
 	if (argCount < 2) return fail(notEnoughArguments);
 	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
-	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
-	char *json = obj2str(args[0]);
-	char *path = obj2str(args[1]);
+	if (!isJSONPath(args[1])) return fail(needsStringError);
 	int i = ((argCount > 2) && isInt(args[2])) ? obj2int(args[2]) : -1;
 
-	char *item = tjr_atPath(json, path);
+	char *item = jsonItem(args[0], args[1]);
 	int itemType = tjr_type(item);
 	if ((tjr_Array == itemType) && (i > 0)) {
 		item++; // skip '['
@@ -267,11 +608,9 @@ static OBJ primJSONCount(int argCount, OBJ *args) {
 
 	if (argCount < 2) return fail(notEnoughArguments);
 	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
-	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
-	char *json = obj2str(args[0]);
-	char *path = obj2str(args[1]);
+	if (!isJSONPath(args[1])) return fail(needsStringError);
 
-	char *item = tjr_atPath(json, path);
+	char *item = jsonItem(args[0], args[1]);
 	return int2obj(tjr_count(item));
 }
 
@@ -280,13 +619,11 @@ static OBJ primJSONValueAt(int argCount, OBJ *args) {
 
 	if (argCount < 3) return fail(notEnoughArguments);
 	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
-	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+	if (!isJSONPath(args[1])) return fail(needsStringError);
 	if (!isInt(args[2])) return fail(needsIntegerError);
-	char *json = obj2str(args[0]);
-	char *path = obj2str(args[1]);
 	int i = obj2int(args[2]);
 
-	char *item = tjr_atPath(json, path);
+	char *item = jsonItem(args[0], args[1]);
 	return jsonValue(tjr_valueAt(item, i));
 }
 
@@ -295,19 +632,168 @@ static OBJ primJSONKeyAt(int argCount, OBJ *args) {
 
 	if (argCount < 3) return fail(notEnoughArguments);
 	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
-	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+	if (!isJSONPath(args[1])) return fail(needsStringError);
 	if (!isInt(args[2])) return fail(needsIntegerError);
-	char *json = obj2str(args[0]);
-	char *path = obj2str(args[1]);
 	int i = obj2int(args[2]);
 
 	char key[100];
 	key[0] = '\0';
-	char *item = tjr_atPath(json, path);
+	char *item = jsonItem(args[0], args[1]);
 	tjr_keyAt(item, i, key, sizeof(key));
 	return newStringFromBytes(key, strlen(key));
 }
 
+static OBJ primJSONCompilePath(int argCount, OBJ *args) {
+	// Return a compiled form of the given path (a ByteArray) that can be used in place
+	// of the path string by the other JSON primitives to avoid parsing it every time.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	int byteCount = tjr_compilePath(obj2str(args[0]), NULL, 0);
+	if (byteCount < 0) return fail(indexOutOfRangeError); // property name too long
+	OBJ result = newObj(ByteArrayType, (byteCount + 3) / 4, falseObj);
+	if (!result) return result; // allocation failed
+	setByteCountAdjust(result, byteCount);
+	tjr_compilePath(obj2str(args[0]), (unsigned char *) &FIELD(result, 0), byteCount);
+	return result;
+}
+
+// JSON Cursors
+//
+// A cursor iterates over the elements of an array or the properties of an object in a
+// single pass, so each step takes constant time rather than rescanning from the start.
+// A cursor is a List: [JSON string, offset of next entry (-1 at end), offset of current entry]
+// Offsets are used rather than pointers because the JSON string may be moved by the
+// garbage collector.
+
+static OBJ primJSONCursor(int argCount, OBJ *args) {
+	// Return a cursor for the array or object at the given path of a JSON string.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	if (!isJSONPath(args[1])) return fail(needsStringError);
+
+	int nextOffset = -1;
+	char *item = jsonItem(args[0], args[1]);
+	int itemType = tjr_type(item);
+	if ((tjr_Array == itemType) || (tjr_Object == itemType)) {
+		while (*item <= ' ') item++; // skip whitespace
+		nextOffset = (item + 1) - obj2str(args[0]); // skip '[' or '{'
+	}
+
+	OBJ cursor = newObj(ListType, 4, zeroObj);
+	if (!cursor) return cursor; // allocation failed
+	FIELD(cursor, 0) = int2obj(3);
+	FIELD(cursor, 1) = args[0];
+	FIELD(cursor, 2) = int2obj(nextOffset);
+	FIELD(cursor, 3) = int2obj(-1);
+	return cursor;
+}
+
+static int isJSONCursor(OBJ cursor) {
+	return IS_TYPE(cursor, ListType) && (WORDS(cursor) >= 4) && IS_TYPE(FIELD(cursor, 1), StringType);
+}
+
+static int jsonCursorOffset(OBJ cursor, int i) {
+	// Return the offset in cursor field i, -1 if it is -1 (none), or -2 after recording an
+	// error if it is not an integer within the cursor's string object. The cursor is a
+	// List, so a program can change it. An offset past the end of the string, but within
+	// the object, points at the null padding that ends it; checking against the object
+	// size avoids scanning the string on every step.
+
+	OBJ offsetObj = FIELD(cursor, i);
+	if (!isInt(offsetObj)) { fail(needsIntegerError); return -2; }
+	int offset = obj2int(offsetObj);
+	if (-1 == offset) return -1;
+	if ((offset < 0) || (offset >= (4 * WORDS(FIELD(cursor, 1))))) {
+		fail(indexOutOfRangeError);
+		return -2;
+	}
+	return offset;
+}
+
+static OBJ jsonValueAs(char *item, OBJ type) {
+	// Return the value at item. If type is "number" or "boolean", return an integer or boolean
+	// without allocating a string.
+
+	if (!item) return jsonValue(item);
+	int itemType = tjr_type(item);
+	if (IS_TYPE(type, StringType) && (0 == strcmp(obj2str(type), "number"))) {
+		if (tjr_String == itemType) {
+			while (*item != '"') item++;
+			return int2obj(tjr_readInteger(item + 1)); // number in quotes
+		}
+		if (tjr_True == itemType) return int2obj(1);
+		if (tjr_Number == itemType) return int2obj(tjr_readInteger(item));
+		return zeroObj;
+	}
+	if (IS_TYPE(type, StringType) && (0 == strcmp(obj2str(type), "boolean"))) {
+		if (tjr_True == itemType) return trueObj;
+		if (tjr_Number == itemType) return (tjr_readInteger(item) != 0) ? trueObj : falseObj;
+		return falseObj;
+	}
+	return jsonValue(item);
+}
+
+static OBJ primJSONNext(int argCount, OBJ *args) {
+	// Advance the cursor and return the next array element or object property value, or
+	// the empty string if there are no more entries. The optional second argument can be
+	// "number" or "boolean" to return the value as that type.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ cursor = args[0];
+	if (!isJSONCursor(cursor)) return fail(needsListError);
+	OBJ type = (argCount > 1) ? args[1] : falseObj;
+
+	int offset = jsonCursorOffset(cursor, 2);
+	if (-2 == offset) return falseObj; // bad offset
+	if (offset < 0) return newString(0); // at end
+
+	char *json = obj2str(FIELD(cursor, 1));
+	char *entry, *value;
+	char *next = tjr_cursorNext(json + offset, &entry, &value);
+	FIELD(cursor, 2) = int2obj(next ? (next - json) : -1);
+	FIELD(cursor, 3) = int2obj(next ? (entry - json) : -1);
+	if (!next) return newString(0);
+
+	return jsonValueAs(value, type);
+}
+
+static OBJ primJSONAtEnd(int argCount, OBJ *args) {
+	// Return true if the cursor has no more entries.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ cursor = args[0];
+	if (!isJSONCursor(cursor)) return fail(needsListError);
+
+	int offset = jsonCursorOffset(cursor, 2);
+	if (-2 == offset) return falseObj; // bad offset
+	if (offset < 0) return trueObj;
+	char *entry, *value;
+	return tjr_cursorNext(obj2str(FIELD(cursor, 1)) + offset, &entry, &value) ? falseObj : trueObj;
+}
+
+static OBJ primJSONCursorKey(int argCount, OBJ *args) {
+	// Return the property name of the object entry most recently returned by jsonNext.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ cursor = args[0];
+	if (!isJSONCursor(cursor)) return fail(needsListError);
+
+	char key[100];
+	key[0] = '\0';
+	int offset = jsonCursorOffset(cursor, 3);
+	if (-2 == offset) return falseObj; // bad offset
+	if (offset >= 0) {
+		char *entry = obj2str(FIELD(cursor, 1)) + offset;
+		char *afterName = tjr_endOfItem(entry);
+		while (*afterName && (*afterName <= ' ')) afterName++;
+		if (':' == *afterName) tjr_readStringInto(entry, key, sizeof(key)); // entry is a property name
+	}
+	return newStringFromBytes(key, strlen(key));
+}
+
 static OBJ primBMP680GasResistance(int argCount, OBJ *args) {
 	if (argCount < 3) return fail(notEnoughArguments);
 	int gas_res_adc = evalInt(args[0]);
@@ -341,6 +827,427 @@ static OBJ primBMP680GasResistance(int argCount, OBJ *args) {
 	return int2obj(calc_gas_res);
 }
 
+// Random Numbers
+//
+// MicroBlocks uses its own pseudo-random number generator (xoshiro128**) rather than the
+// C library's rand(). It is fast on 32-bit microcontrollers and gives the same sequence on
+// every platform for a given seed, so runs can be reproduced. Bounded values use Lemire's
+// multiply-and-reject method to avoid the bias of "rand() % n".
+
+static uint32 randomState[4] = { 0x9E3779B9, 0x243F6A88, 0xB7E15162, 0x5851F42D };
+
+static inline uint32 rotateLeft(uint32 x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+uint32 randomUint32() {
+	// Return the next 32-bit value from the xoshiro128** generator.
+
+	uint32 *s = randomState;
+	uint32 result = rotateLeft(s[1] * 5, 7) * 9;
+	uint32 t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotateLeft(s[3], 11);
+	return result;
+}
+
+uint32 randomBelow(uint32 n) {
+	// Return an unbiased random value in the range [0..n-1]. Return zero if n is zero.
+
+	uint64 m = (uint64) randomUint32() * n;
+	uint32 low = (uint32) m;
+	if (low < n) {
+		uint32 threshold = -n % n;
+		while (low < threshold) {
+			m = (uint64) randomUint32() * n;
+			low = (uint32) m;
+		}
+	}
+	return (uint32) (m >> 32);
+}
+
+void setRandomSeed(uint32 seed) {
+	// Initialize the generator state from the given seed using SplitMix32.
+	// Every seed, including zero, gives a valid (non-zero) state.
+
+	for (int i = 0; i < 4; i++) {
+		seed += 0x9E3779B9;
+		uint32 z = seed;
+		z = (z ^ (z >> 16)) * 0x85EBCA6B;
+		z = (z ^ (z >> 13)) * 0xC2B2AE35;
+		randomState[i] = z ^ (z >> 16);
+	}
+}
+
+#if defined(GNUBLOCKS) && !defined(EMSCRIPTEN)
+
+// Each VM instance has its own generator (see linux+pi/vmHost.c)
+
+void miscSaveState(VMState *state) {
+	memcpy(state->randomState, randomState, sizeof(randomState));
+}
+
+void miscRestoreState(VMState *state) {
+	memcpy(randomState, state->randomState, sizeof(randomState));
+}
+
+#endif
+
+static OBJ primRandomSeed(int argCount, OBJ *args) {
+	// Seed the random number generator so that the following random values are repeatable.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	setRandomSeed((uint32) evalInt(args[0]));
+	return falseObj;
+}
+
+static OBJ primRandomFill(int argCount, OBJ *args) {
+	// Fill a ByteArray with random bytes or a List with random integers. The optional
+	// second and third arguments give the (inclusive) range of values, defaulting to
+	// 0..255 for ByteArrays and 1..100 for Lists.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureList(args, 0)) return falseObj;
+	OBJ obj = args[0];
+	int isByteArray = IS_TYPE(obj, ByteArrayType);
+	int first = isByteArray ? 0 : 1;
+	int last = isByteArray ? 255 : 100;
+	if (argCount > 2) {
+		first = evalInt(args[1]);
+		last = evalInt(args[2]);
+	}
+	if (first > last) { // ensure first <= last
+		int tmp = first;
+		first = last;
+		last = tmp;
+	}
+	uint32 range = (uint32) last - (uint32) first + 1;
+
+	if (isByteArray) {
+		if ((first < 0) || (last > 255)) return fail(byteArrayStoreError);
+		uint8 *dst = (uint8 *) &FIELD(obj, 0);
+		int count = BYTES(obj);
+		if (256 == range) { // full byte range: use all four bytes of each random value
+			int i = 0;
+			for (; (i + 4) <= count; i += 4) {
+				uint32 r = randomUint32();
+				dst[i] = r & 255;
+				dst[i + 1] = (r >> 8) & 255;
+				dst[i + 2] = (r >> 16) & 255;
+				dst[i + 3] = (r >> 24) & 255;
+			}
+			for (; i < count; i++) dst[i] = randomUint32() & 255;
+		} else {
+			for (int i = 0; i < count; i++) dst[i] = first + randomBelow(range);
+		}
+	} else {
+		if (!IS_TYPE(obj, ListType)) return fail(needsListError);
+		int count = obj2int(FIELD(obj, 0));
+		for (int i = 1; i <= count; i++) {
+			FIELD(obj, i) = int2obj(first + (int) randomBelow(range));
+		}
+	}
+	return falseObj;
+}
+
+static OBJ primShuffle(int argCount, OBJ *args) {
+	// Shuffle the items of a List (or the bytes of a ByteArray) in place using Fisher-Yates.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!ensureList(args, 0)) return falseObj;
+	OBJ obj = args[0];
+
+	if (IS_TYPE(obj, ListType)) {
+		int count = obj2int(FIELD(obj, 0));
+		for (int i = count; i > 1; i--) {
+			int j = randomBelow(i) + 1;
+			OBJ tmp = FIELD(obj, i);
+			FIELD(obj, i) = FIELD(obj, j);
+			FIELD(obj, j) = tmp;
+		}
+	} else if (IS_TYPE(obj, ByteArrayType)) {
+		uint8 *bytes = (uint8 *) &FIELD(obj, 0);
+		for (int i = BYTES(obj) - 1; i > 0; i--) {
+			int j = randomBelow(i + 1);
+			uint8 tmp = bytes[i];
+			bytes[i] = bytes[j];
+			bytes[j] = tmp;
+		}
+	} else {
+		return fail(needsListError);
+	}
+	return falseObj;
+}
+
+// 64-bit Time
+
+// The milliseconds, microseconds, and timer blocks report 30-bit integers, so they wrap
+// around (microseconds every 18 minutes). These primitives report times as 8-byte
+// ByteArrays holding an unsigned, little-endian count of the microseconds or milliseconds
+// since the board started. They are based on totalMicrosecs() and do not wrap. A time
+// argument can also be a non-negative integer. Differences between times are reported as
+// integers, clamped to the integer range (about 12 days in milliseconds).
+
+static OBJ newTime64(uint64 t) {
+	OBJ result = newObj(ByteArrayType, 2, falseObj);
+	if (!result) return fail(insufficientMemoryError);
+	uint8 *bytes = (uint8 *) &FIELD(result, 0);
+	for (int i = 0; i < 8; i++) {
+		bytes[i] = t & 0xFF;
+		t >>= 8;
+	}
+	return result;
+}
+
+static int getTime64(OBJ obj, uint64 *result) {
+	// Set *result to the time represented by obj. Return false and record an error if obj
+	// is not a time.
+
+	if (isInt(obj) && (obj2int(obj) >= 0)) {
+		*result = obj2int(obj);
+		return true;
+	}
+	if (!IS_TYPE(obj, ByteArrayType) || (BYTES(obj) != 8)) {
+		fail(needsByteArray);
+		return false;
+	}
+	uint8 *bytes = (uint8 *) &FIELD(obj, 0);
+	uint64 t = 0;
+	for (int i = 7; i >= 0; i--) t = (t << 8) | bytes[i];
+	*result = t;
+	return true;
+}
+
+static OBJ clampedDifference(uint64 end, uint64 start) {
+	if (end >= start) {
+		uint64 delta = end - start;
+		return int2obj((delta > 0x3FFFFFFF) ? 0x3FFFFFFF : (int) delta);
+	}
+	uint64 delta = start - end;
+	return int2obj((delta > 0x40000000) ? -0x40000000 : -((int) delta));
+}
+
+static OBJ primMicros64(int argCount, OBJ *args) {
+	return newTime64(totalMicrosecs());
+}
+
+static OBJ primMillis64(int argCount, OBJ *args) {
+	return newTime64(totalMicrosecs() / 1000);
+}
+
+static OBJ primMicrosSince64(int argCount, OBJ *args) {
+	// Return the microseconds since a time reported by micros64.
+
+	uint64 start;
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!getTime64(args[0], &start)) return falseObj;
+	return clampedDifference(totalMicrosecs(), start);
+}
+
+static OBJ primMillisSince64(int argCount, OBJ *args) {
+	// Return the milliseconds since a time reported by millis64.
+
+	uint64 start;
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!getTime64(args[0], &start)) return falseObj;
+	return clampedDifference(totalMicrosecs() / 1000, start);
+}
+
+static OBJ primTime64Diff(int argCount, OBJ *args) {
+	// Return the first time minus the second, in the units of the times.
+
+	uint64 end, start;
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!getTime64(args[0], &end) || !getTime64(args[1], &start)) return falseObj;
+	return clampedDifference(end, start);
+}
+
+static OBJ primTime64Compare(int argCount, OBJ *args) {
+	// Return -1, 0, or 1 if the first time is before, equal to, or after the second.
+
+	uint64 t1, t2;
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!getTime64(args[0], &t1) || !getTime64(args[1], &t2)) return falseObj;
+	return int2obj((t1 < t2) ? -1 : ((t1 > t2) ? 1 : 0));
+}
+
+static OBJ primTime64Add(int argCount, OBJ *args) {
+	// Return a new time that is the given time plus an integer (which may be negative).
+	// The result is never less than zero.
+
+	uint64 t;
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!getTime64(args[0], &t)) return falseObj;
+	int delta = evalInt(args[1]);
+	if (delta >= 0) {
+		t += delta;
+	} else {
+		t = (t > (uint64) -delta) ? t + delta : 0;
+	}
+	return newTime64(t);
+}
+
+// Time Series
+
+// A time series (see timeSeries.c) is a ByteArray holding the recent values of a signal in
+// up to four tiers: the raw values and one, two, or three downsampled tiers. Adding a value
+// and reading a window statistic (min, max, mean, count, or last entry of a tier) take
+// constant time, so a program can graph or check sensor history without keeping Lists of
+// values and rescanning them.
+
+static TimeSeries *timeSeriesArg(OBJ obj) {
+	// Return the time series held in obj or record an error and return NULL.
+
+	if (!IS_TYPE(obj, ByteArrayType) || !ts_isValid((TimeSeries *) &FIELD(obj, 0), BYTES(obj))) {
+		fail(needsByteArray);
+		return NULL;
+	}
+	return (TimeSeries *) &FIELD(obj, 0);
+}
+
+static int optionalTier(int argCount, OBJ *args, int index) {
+	return ((argCount > index) && isInt(args[index])) ? obj2int(args[index]) : 0;
+}
+
+static OBJ primTimeSeries(int argCount, OBJ *args) {
+	// Return a new time series that holds up to capacity entries in each tier. Optional
+	// arguments: the bits per value, 16 (clipped) or 32 (default: 16), followed by the
+	// ratio of each downsampled tier to the tier before it. For example, with ratios 10
+	// and 6, values added once per second give 1-second, 10-second, and 1-minute tiers.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!isInt(args[0])) return fail(needsIntegerError);
+	int capacity = obj2int(args[0]);
+	int bits = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 16;
+	int ratios[TS_MAX_TIERS - 1];
+	int tierCount = 1;
+	for (int i = 2; i < argCount; i++) {
+		if (!isInt(args[i])) return fail(needsIntegerError);
+		if (tierCount >= TS_MAX_TIERS) return fail(indexOutOfRangeError);
+		ratios[tierCount++ - 1] = obj2int(args[i]);
+	}
+	int valueBytes = bits / 8;
+	if ((capacity < 1) || (capacity > TS_MAX_CAPACITY) || ((2 != valueBytes) && (4 != valueBytes))) {
+		return fail(indexOutOfRangeError);
+	}
+
+	int byteCount = ts_bytesNeeded(capacity, valueBytes, tierCount);
+	OBJ result = newObj(ByteArrayType, (byteCount + 3) / 4, falseObj);
+	if (!result) return fail(insufficientMemoryError);
+	if (!ts_init((TimeSeries *) &FIELD(result, 0), BYTES(result), capacity, valueBytes, tierCount, ratios)) {
+		return fail(indexOutOfRangeError);
+	}
+	return result;
+}
+
+static OBJ primTimeSeriesAdd(int argCount, OBJ *args) {
+	// Add an integer or a List of integers to a time series.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 1)) return falseObj;
+	TimeSeries *ts = timeSeriesArg(args[0]);
+	if (!ts) return falseObj;
+	OBJ value = args[1];
+	if (isInt(value)) {
+		ts_add(ts, obj2int(value));
+	} else if (IS_TYPE(value, ListType)) {
+		int count = obj2int(FIELD(value, 0));
+		for (int i = 1; i <= count; i++) {
+			if (!isInt(FIELD(value, i))) return fail(needsListOfIntegers);
+		}
+		for (int i = 1; i <= count; i++) ts_add(ts, obj2int(FIELD(value, i)));
+	} else {
+		return fail(needsIntegerError);
+	}
+	return falseObj;
+}
+
+static OBJ primTimeSeriesStat(int argCount, OBJ *args) {
+	// Return a statistic ("min", "max", "mean", "count", or "last") of the entries of
+	// a tier of a time series. Optional last argument: the tier (default: 0, raw values).
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	TimeSeries *ts = timeSeriesArg(args[0]);
+	if (!ts) return falseObj;
+	if (!IS_TYPE(args[1], StringType)) return fail(needsStringError);
+	char *statName = obj2str(args[1]);
+	int tier = optionalTier(argCount, args, 2);
+	if ((tier < 0) || (tier >= ts->tierCount)) return fail(indexOutOfRangeError);
+
+	int stat = -1;
+	if (strcmp(statName, "min") == 0) stat = TS_MIN;
+	if (strcmp(statName, "max") == 0) stat = TS_MAX;
+	if (strcmp(statName, "mean") == 0) stat = TS_MEAN;
+	if (strcmp(statName, "count") == 0) stat = TS_COUNT;
+	if (strcmp(statName, "last") == 0) stat = TS_LAST;
+	if (stat < 0) return zeroObj;
+	return int2obj(ts_stat(ts, tier, stat));
+}
+
+static OBJ primTimeSeriesExport(int argCount, OBJ *args) {
+	// Return a List of the entries of a tier of a time series, oldest first, reduced to at
+	// most width points by combining runs of adjacent entries. Optional arguments: the
+	// tier (default: 0) and the field, "mean", "min", or "max" (default: "mean").
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	TimeSeries *ts = timeSeriesArg(args[0]);
+	if (!ts) return falseObj;
+	if (!isInt(args[1])) return fail(needsIntegerError);
+	int width = obj2int(args[1]);
+	int tier = optionalTier(argCount, args, 2);
+	if ((width < 1) || (tier < 0) || (tier >= ts->tierCount)) return fail(indexOutOfRangeError);
+	int field = TS_FIELD_MEAN;
+	if ((argCount > 3) && IS_TYPE(args[3], StringType)) {
+		if (strcmp(obj2str(args[3]), "min") == 0) field = TS_FIELD_MIN;
+		if (strcmp(obj2str(args[3]), "max") == 0) field = TS_FIELD_MAX;
+	}
+
+	int count = ts_stat(ts, tier, TS_COUNT);
+	if (width > count) width = count;
+	OBJ result = newObj(ListType, width + 1, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	ts = timeSeriesArg(args[0]); // allocation may have moved the series
+
+	// export into the List's fields, then convert the values to integer objects in place
+	int *values = (int *) &FIELD(result, 1);
+	ts_export(ts, tier, field, width, values);
+	for (int i = 0; i < width; i++) FIELD(result, i + 1) = int2obj(values[i]);
+	FIELD(result, 0) = int2obj(width);
+	return result;
+}
+
+static OBJ primTimeSeriesClear(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	TimeSeries *ts = timeSeriesArg(args[0]);
+	if (!ts) return falseObj;
+	ts_clear(ts);
+	return falseObj;
+}
+
+// Task Wake Latency
+
+// The VM records how late tasks waiting on the clock start running after their wake time
+// (see "Timed Wakeup" in interp.c). These statistics help tune timing-critical scripts.
+
+static OBJ primWakeStats(int argCount, OBJ *args) {
+	// Return a list: the number of wakes and the mean and maximum wake latency in usecs.
+	// If the optional argument is true, clear the statistics after reading them.
+
+	OBJ result = newObj(ListType, 4, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	int mean = wakeCount ? (int) (totalWakeLatency / wakeCount) : 0;
+	FIELD(result, 0) = int2obj(3);
+	FIELD(result, 1) = int2obj(wakeCount & 0x3FFFFFFF);
+	FIELD(result, 2) = int2obj(mean & 0x3FFFFFFF);
+	FIELD(result, 3) = int2obj(maxWakeLatency & 0x3FFFFFFF);
+	if ((argCount > 0) && (trueObj == args[0])) clearWakeStats();
+	return result;
+}
+
 // Primitives
 
 static PrimEntry entries[] = {
@@ -352,9 +1259,15 @@ static PrimEntry entries[] = {
 	{"hue", primColorHue},
 	{"saturation", primColorSaturation},
 	{"brightness", primColorBrightness},
+	{"hsvToRGB", primHSVToRGB},
+	{"rgbToHSV", primRGBToHSV},
+	{"gradientFill", primGradientFill},
 	{"sin", primSine},
 	{"sqrt", primSqrt},
 	{"atan2", primArctan},
+	{"sinInto", primSineInto},
+	{"sqrtInto", primSqrtInto},
+	{"atan2Into", primArctanInto},
 	{"pressureToAltitude", primPressureToAltitude},
 	{"bme680GasResistance", primBMP680GasResistance},
 	{"connectedToIDE", primConnectedToIDE},
@@ -363,6 +1276,27 @@ static PrimEntry entries[] = {
 	{"jsonCount", primJSONCount},
 	{"jsonValueAt", primJSONValueAt},
 	{"jsonKeyAt", primJSONKeyAt},
+	{"jsonCompilePath", primJSONCompilePath},
+	{"jsonCursor", primJSONCursor},
+	{"jsonNext", primJSONNext},
+	{"jsonAtEnd", primJSONAtEnd},
+	{"jsonCursorKey", primJSONCursorKey},
+	{"randomSeed", primRandomSeed},
+	{"randomFill", primRandomFill},
+	{"shuffle", primShuffle},
+	{"micros64", primMicros64},
+	{"millis64", primMillis64},
+	{"microsSince64", primMicrosSince64},
+	{"millisSince64", primMillisSince64},
+	{"time64Diff", primTime64Diff},
+	{"time64Compare", primTime64Compare},
+	{"time64Add", primTime64Add},
+	{"timeSeries", primTimeSeries},
+	{"timeSeriesAdd", primTimeSeriesAdd},
+	{"timeSeriesStat", primTimeSeriesStat},
+	{"timeSeriesExport", primTimeSeriesExport},
+	{"timeSeriesClear", primTimeSeriesClear},
+	{"wakeStats", primWakeStats},
 };
 
 void addMiscPrims() {
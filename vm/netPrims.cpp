@@ -47,9 +47,15 @@
 #endif
 
 #include "interp.h" // must be included *after* ESP8266WiFi.h
+#include "httpResponse.h"
 
 #if defined(ESP8266) || defined(ARDUINO_ARCH_ESP32) || defined(USE_WIFI101) || defined(PICO_WIFI)
 
+#if defined(ESP8266) || defined(ARDUINO_ARCH_ESP32) || defined(RP2040_PHILHOWER)
+	#include "fileSys.h"
+	#define HAS_FILE_SYSTEM 1
+#endif
+
 static char connecting = false;
 static char serverStarted = false;
 static char allowBLE_and_WiFi = true;
@@ -424,9 +430,38 @@ static OBJ primRespondToHttpRequest(int argCount, OBJ *args) {
 	return falseObj;
 }
 
+int httpRespondWithData(const char *contentType, uint8 *data, int byteCount, int keepAlive) {
+	// Respond to the current HTTP request with the given data as the body, writing it
+	// directly from data. Used to stream large buffers owned by drivers (e.g. camera frames)
+	// without copying them into the object store. Return the number of body bytes sent or
+	// -1 if there is no client.
+
+	if (NO_WIFI() || !client) return -1;
+
+	client.print("HTTP/1.0 200 OK\r\n");
+	client.print("Access-Control-Allow-Origin: *\r\n");
+	if (keepAlive) client.print("Connection: keep-alive\r\n");
+	client.print("Content-Type: ");
+	client.print(contentType);
+	client.print("\r\nContent-Length: ");
+	client.print(byteCount);
+	client.print("\r\n\r\n"); // end of headers
+
+	int sent = 0;
+	while (sent < byteCount) {
+		int n = client.write(&data[sent], byteCount - sent);
+		if (n <= 0) break; // connection closed
+		sent += n;
+	}
+	delay(1); // allow some time for data to be sent
+	if (!keepAlive) client.stop(); // close the connection
+	return sent;
+}
+
 // HTTP Client
 
 WiFiClient httpClient;
+static HttpResponse httpResponse; // decoder state for the streaming response primitives
 
 static OBJ primHttpConnect(int argCount, OBJ *args) {
 	// Connect to an HTTP server and port.
@@ -501,6 +536,7 @@ Accept: */*\r\n",
 		strcat(request, "\r\n");
 		httpClient.write(request, strlen(request));
 	}
+	http_initResponse(&httpResponse); // start decoding a new response
 	return falseObj;
 }
 
@@ -519,10 +555,250 @@ static OBJ primHttpResponse(int argCount, OBJ *args) {
 	return result;
 }
 
+// Streaming HTTP Response
+
+static int readHttpBody(uint8 *buf, int bufSize) {
+	// Read and decode response bytes into buf until some body bytes arrive or no more data
+	// is available. Return the number of body bytes or -1 if the response is complete.
+
+	int bodyCount = 0;
+	while (!bodyCount && !http_isDone(&httpResponse)) {
+		int readCount = bufSize;
+		if ((http_Body == httpResponse.phase) && (httpResponse.contentLength >= 0) &&
+			(httpResponse.remaining < readCount)) {
+				readCount = httpResponse.remaining; // don't read past the end of the body
+		}
+		int byteCount = httpClient.read(buf, readCount);
+		if (byteCount <= 0) break;
+		bodyCount = http_decode(&httpResponse, buf, byteCount);
+	}
+	if (bodyCount) return bodyCount;
+	if (http_isDone(&httpResponse)) return -1;
+	if (!httpClient.connected() && !httpClient.available()) return -1; // closed by server
+	return 0;
+}
+
+static OBJ primHttpReadInto(int argCount, OBJ *args) {
+	// Read response body bytes into the given ByteArray, starting at the optional index.
+	// The status line and headers are consumed and chunked encoding is removed.
+	// Return the number of bytes stored (possibly zero) or -1 when the body is complete.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	int startIndex = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 1;
+	if ((startIndex < 1) || (startIndex > BYTES(buf))) return fail(indexOutOfRangeError);
+
+	uint8 *dst = (uint8 *) &FIELD(buf, 0) + (startIndex - 1);
+	return int2obj(readHttpBody(dst, BYTES(buf) - (startIndex - 1)));
+}
+
+static OBJ primHttpStatus(int argCount, OBJ *args) {
+	// Return the status code of the response, or zero if the status line has not arrived.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	return int2obj(httpResponse.status);
+}
+
+static OBJ primHttpContentLength(int argCount, OBJ *args) {
+	// Return the Content-Length of the response, or -1 if the server didn't provide one.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	return int2obj(httpResponse.contentLength);
+}
+
+static OBJ primHttpHeader(int argCount, OBJ *args) {
+	// Return the value of the response header with the given name or the empty string.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	char value[100];
+	http_header(&httpResponse, obj2str(args[0]), value, sizeof(value));
+	return newStringFromBytes(value, strlen(value));
+}
+
+#if defined(HAS_FILE_SYSTEM)
+
+static OBJ primHttpResponseToFile(int argCount, OBJ *args) {
+	// Append the available response body bytes to the given file without allocating objects.
+	// Return the number of bytes written or -1 when the body is complete.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+
+	char path[32];
+	char *fileName = obj2str(args[0]);
+	if (!fileName[0] || strstr(fileName, "ublockscode")) return falseObj;
+	snprintf(path, sizeof(path), ('/' == fileName[0]) ? "%s" : "/%s", fileName);
+	closeIfOpen(path);
+
+	uint8 buf[512];
+	int totalBytes = 0;
+	int byteCount = 0;
+	File file;
+	uint32 startMSecs = millisecs();
+	while ((millisecs() - startMSecs) < 20) { // limit time so other tasks can run
+		byteCount = readHttpBody(buf, sizeof(buf));
+		if (byteCount <= 0) break;
+		if (!file) file = myFS.open(path, "a");
+		if (!file) break;
+		file.write(buf, byteCount);
+		totalBytes += byteCount;
+	}
+	if (file) file.close();
+	if ((byteCount < 0) && !totalBytes) return int2obj(-1);
+	return int2obj(totalBytes);
+}
+
+#else
+
+static OBJ primHttpResponseToFile(int argCount, OBJ *args) { return fail(primitiveNotImplemented); }
+
+#endif
+
 // UDP
 
 WiFiUDP udp;
 
+// UDP Receive Queue
+//
+// Incoming packets are moved from the network stack into a byte ring buffer so that a
+// burst of packets is not lost between receive calls. Each record is a header followed by
+// the packet data:
+//
+//	<byte count (2 bytes)><port (2 bytes)><IP address (4 bytes)><data...>
+//
+// Packets that don't fit in the free space are dropped and counted. A packet too large for
+// the whole queue is left in the network stack as the pending packet and read directly
+// once the packets before it have been received; polling stops until then. A packet whose
+// result object can't be allocated is dropped, so it does not block later packets.
+
+#if defined(ESP8266)
+	#define UDP_QUEUE_SIZE 1024
+#else
+	#define UDP_QUEUE_SIZE 4096
+#endif
+#define UDP_RECORD_HEADER 8
+
+static uint8 udpQueue[UDP_QUEUE_SIZE];
+static int udpQueueHead = 0; // index of the first byte of the oldest record
+static int udpQueueCount = 0; // number of bytes in the queue
+
+static int udpPendingCount = 0; // byte count of the pending packet, if any
+static uint8 udpPendingHeader[UDP_RECORD_HEADER];
+
+static int udpReceivedCount = 0;
+static int udpDroppedCount = 0;
+static int udpTruncatedCount = 0;
+
+// Address of the sender of the last packet received
+static uint8 udpRemoteIP[4];
+static int udpRemotePortNum = 0;
+
+static void udpQueueCopyIn(uint8 *src, int count) {
+	int tail = (udpQueueHead + udpQueueCount) % UDP_QUEUE_SIZE;
+	int n = UDP_QUEUE_SIZE - tail;
+	if (n > count) n = count;
+	memcpy(&udpQueue[tail], src, n);
+	if (count > n) memcpy(udpQueue, src + n, count - n);
+	udpQueueCount += count;
+}
+
+static void udpQueueCopyOut(uint8 *dst, int count) {
+	// Remove count bytes from the head of the queue and copy them into dst, if not NULL.
+
+	int n = UDP_QUEUE_SIZE - udpQueueHead;
+	if (n > count) n = count;
+	if (dst) {
+		memcpy(dst, &udpQueue[udpQueueHead], n);
+		if (count > n) memcpy(dst + n, udpQueue, count - n);
+	}
+	udpQueueHead = (udpQueueHead + count) % UDP_QUEUE_SIZE;
+	udpQueueCount -= count;
+}
+
+static void udpMakeHeader(uint8 *header, int byteCount) {
+	// Fill in a record header for the packet just parsed.
+
+	IPAddress ip = udp.remoteIP();
+	int port = udp.remotePort();
+	header[0] = (byteCount >> 8) & 255;
+	header[1] = byteCount & 255;
+	header[2] = (port >> 8) & 255;
+	header[3] = port & 255;
+	for (int i = 0; i < 4; i++) header[4 + i] = ip[i];
+}
+
+static void udpPoll() {
+	// Move all waiting packets into the receive queue.
+
+	int byteCount;
+	while (!udpPendingCount && ((byteCount = udp.parsePacket()) > 0)) {
+		udpReceivedCount++;
+		if ((UDP_RECORD_HEADER + byteCount) > UDP_QUEUE_SIZE) {
+			// too large for the queue; leave it in the network stack
+			udpPendingCount = byteCount;
+			udpMakeHeader(udpPendingHeader, byteCount);
+			return;
+		}
+		if ((udpQueueCount + UDP_RECORD_HEADER + byteCount) > UDP_QUEUE_SIZE) {
+			udp.flush(); // no room; drop packet
+			udpDroppedCount++;
+			continue;
+		}
+		uint8 header[UDP_RECORD_HEADER];
+		udpMakeHeader(header, byteCount);
+		udpQueueCopyIn(header, UDP_RECORD_HEADER);
+
+		// read the packet directly into the queue, in two parts if it wraps
+		int tail = (udpQueueHead + udpQueueCount) % UDP_QUEUE_SIZE;
+		int n = UDP_QUEUE_SIZE - tail;
+		if (n > byteCount) n = byteCount;
+		udp.read((char *) &udpQueue[tail], n);
+		if (byteCount > n) udp.read((char *) udpQueue, byteCount - n);
+		udpQueueCount += byteCount;
+	}
+}
+
+static int udpNextPacketSize() {
+	// Return the size of the oldest received packet or -1 if there is none.
+
+	if (udpQueueCount < UDP_RECORD_HEADER) return udpPendingCount ? udpPendingCount : -1;
+	int i = udpQueueHead;
+	return (udpQueue[i] << 8) | udpQueue[(i + 1) % UDP_QUEUE_SIZE];
+}
+
+static void udpDequeuePacket(uint8 *dst, int dstSize) {
+	// Remove the oldest packet, copying up to dstSize bytes of its data into dst, if not
+	// NULL, and recording the address of its sender.
+
+	uint8 header[UDP_RECORD_HEADER];
+	int pending = (udpQueueCount < UDP_RECORD_HEADER);
+	if (pending) {
+		memcpy(header, udpPendingHeader, UDP_RECORD_HEADER);
+	} else {
+		udpQueueCopyOut(header, UDP_RECORD_HEADER);
+	}
+	int byteCount = (header[0] << 8) | header[1];
+	udpRemotePortNum = (header[2] << 8) | header[3];
+	memcpy(udpRemoteIP, &header[4], 4);
+
+	int n = (byteCount < dstSize) ? byteCount : dstSize;
+	if (pending) {
+		if (dst && (n > 0)) udp.read((char *) dst, n);
+		udp.flush(); // discard the rest
+		udpPendingCount = 0;
+	} else {
+		udpQueueCopyOut(dst, n);
+		if (byteCount > n) udpQueueCopyOut(NULL, byteCount - n); // discard the rest
+	}
+	if (dst && (byteCount > n)) udpTruncatedCount++;
+}
+
 static OBJ primUDPStart(int argCount, OBJ *args) {
 	if (NO_WIFI()) return fail(noWiFi);
 	if (!isConnectedToWiFi()) return falseObj;
@@ -540,9 +816,23 @@ static OBJ primUDPStop(int argCount, OBJ *args) {
 	if (!isConnectedToWiFi()) return falseObj;
 
 	udp.stop();
+	udpQueueHead = udpQueueCount = udpPendingCount = 0;
 	return falseObj;
 }
 
+static void udpSendData(OBJ data) {
+	if (isInt(data)) {
+		udp.print(obj2int(data));
+	} else if (isBoolean(data)) {
+		udp.print((trueObj == data) ? "true" : "false");
+	} else if (StringType == TYPE(data)) {
+		char *s = obj2str(data);
+		udp.write((uint8_t *) s, strlen(s));
+	} else if (ByteArrayType == TYPE(data)) {
+		udp.write((uint8_t *) &data[HEADER_WORDS], BYTES(data));
+	}
+}
+
 static OBJ primUDPSendPacket(int argCount, OBJ *args) {
 	if (NO_WIFI()) return fail(noWiFi);
 	if (!isConnectedToWiFi()) return fail(wifiNotConnected);
@@ -554,16 +844,7 @@ static OBJ primUDPSendPacket(int argCount, OBJ *args) {
 	if (port <= 0) return falseObj; // bad port number
 
 	udp.beginPacket(ipAddr, port);
-	if (isInt(data)) {
-		udp.print(obj2int(data));
-	} else if (isBoolean(data)) {
-		udp.print((trueObj == data) ? "true" : "false");
-	} else if (StringType == TYPE(data)) {
-		char *s = obj2str(data);
-		udp.write((uint8_t *) s, strlen(s));
-	} else if (ByteArrayType == TYPE(data)) {
-		udp.write((uint8_t *) &data[HEADER_WORDS], BYTES(data));
-	}
+	udpSendData(data);
 	udp.endPacket();
 	return falseObj;
 }
@@ -573,8 +854,9 @@ static OBJ primUDPReceivePacket(int argCount, OBJ *args) {
 	if (!isConnectedToWiFi()) return (OBJ) &noDataString;
 
 	int useBinary = ((argCount > 0) && (trueObj == args[0]));
-	int byteCount = udp.parsePacket();
-	if (!byteCount) return (OBJ) &noDataString;
+	udpPoll();
+	int byteCount = udpNextPacketSize();
+	if (byteCount < 0) return (OBJ) &noDataString;
 
 	OBJ result = falseObj;
 	if (useBinary) {
@@ -583,11 +865,109 @@ static OBJ primUDPReceivePacket(int argCount, OBJ *args) {
 	} else {
 		result = newString(byteCount);
 	}
-	if (falseObj == result) { // allocation failed
-		udp.flush(); // discard packet
-		result = (OBJ) &noDataString;
+	if (falseObj == result) { // allocation failed; drop the packet so it doesn't block later ones
+		udpDequeuePacket(NULL, 0);
+		udpDroppedCount++;
+		return (OBJ) &noDataString;
+	}
+	udpDequeuePacket((uint8 *) &FIELD(result, 0), byteCount);
+	return result;
+}
+
+static OBJ primUDPReceiveInto(int argCount, OBJ *args) {
+	// Copy the next packet into the given ByteArray and return its byte count or zero if no
+	// packet is available. Extra bytes of packets that don't fit are discarded. If the optional
+	// second argument is a ByteArray of at least six bytes, the sender's packed address is
+	// stored into it: <IP address (4 bytes)><port (2 bytes, big-endian)>
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (argCount < 1) return fail(notEnoughArguments);
+	OBJ buf = args[0];
+	if (!IS_TYPE(buf, ByteArrayType)) return fail(needsByteArray);
+	if (!isConnectedToWiFi()) return zeroObj;
+
+	udpPoll();
+	int byteCount = udpNextPacketSize();
+	if (byteCount < 0) return zeroObj;
+	if (byteCount > BYTES(buf)) byteCount = BYTES(buf);
+	udpDequeuePacket((uint8 *) &FIELD(buf, 0), byteCount);
+
+	if ((argCount > 1) && IS_TYPE(args[1], ByteArrayType) && (BYTES(args[1]) >= 6)) {
+		uint8 *addr = (uint8 *) &FIELD(args[1], 0);
+		memcpy(addr, udpRemoteIP, 4);
+		addr[4] = (udpRemotePortNum >> 8) & 255;
+		addr[5] = udpRemotePortNum & 255;
+	}
+	return int2obj(byteCount);
+}
+
+static OBJ primUDPPackAddress(int argCount, OBJ *args) {
+	// Return a six-byte ByteArray with the packed IP address and port for use with udpSendTo.
+	// Since MicroBlocks integers are 31 bits, an IPv4 address and port cannot be packed into one.
+
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!IS_TYPE(args[0], StringType)) return fail(needsStringError);
+	IPAddress ip;
+	if (!ip.fromString(obj2str(args[0]))) return falseObj; // bad IP address
+	int port = evalInt(args[1]);
+
+	OBJ result = newObj(ByteArrayType, 2, falseObj);
+	if (!result) return result; // allocation failed
+	setByteCountAdjust(result, 6);
+	uint8 *addr = (uint8 *) &FIELD(result, 0);
+	for (int i = 0; i < 4; i++) addr[i] = ip[i];
+	addr[4] = (port >> 8) & 255;
+	addr[5] = port & 255;
+	return result;
+}
+
+static OBJ primUDPSendTo(int argCount, OBJ *args) {
+	// Send a packet to a packed address created by udpPackAddress or filled in by udpReceiveInto.
+	// If the data is a List, each item is sent as a separate packet.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (!isConnectedToWiFi()) return fail(wifiNotConnected);
+	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
+	OBJ data = args[0];
+	if (!IS_TYPE(args[1], ByteArrayType) || (BYTES(args[1]) < 6)) return fail(needsByteArray);
+
+	uint8 *addr = (uint8 *) &FIELD(args[1], 0);
+	IPAddress ip(addr[0], addr[1], addr[2], addr[3]);
+	int port = (addr[4] << 8) | addr[5];
+	if (port <= 0) return falseObj; // bad port number
+
+	if (IS_TYPE(data, ListType)) {
+		int count = obj2int(FIELD(data, 0));
+		for (int i = 1; i <= count; i++) {
+			udp.beginPacket(ip, port);
+			udpSendData(FIELD(data, i));
+			udp.endPacket();
+		}
 	} else {
-		udp.read((char *) &FIELD(result, 0), byteCount);
+		udp.beginPacket(ip, port);
+		udpSendData(data);
+		udp.endPacket();
+	}
+	return falseObj;
+}
+
+static OBJ primUDPStats(int argCount, OBJ *args) {
+	// Return a list: [packets received, packets dropped, packets truncated, bytes queued].
+	// If the optional argument is true, reset the counters.
+
+	if (NO_WIFI()) return fail(noWiFi);
+	if (isConnectedToWiFi()) udpPoll();
+
+	OBJ result = newObj(ListType, 5, zeroObj);
+	if (!result) return result; // allocation failed
+	FIELD(result, 0) = int2obj(4);
+	FIELD(result, 1) = int2obj(udpReceivedCount);
+	FIELD(result, 2) = int2obj(udpDroppedCount);
+	FIELD(result, 3) = int2obj(udpTruncatedCount);
+	FIELD(result, 4) = int2obj(udpQueueCount);
+	if ((argCount > 0) && (trueObj == args[0])) {
+		udpReceivedCount = udpDroppedCount = udpTruncatedCount = 0;
 	}
 	return result;
 }
@@ -597,8 +977,7 @@ static OBJ primUDPRemoteIPAddress(int argCount, OBJ *args) {
 	if (!isConnectedToWiFi()) return fail(wifiNotConnected);
 
 	char s[100];
-	IPAddress ip = udp.remoteIP();
-	sprintf(s, "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+	sprintf(s, "%d.%d.%d.%d", udpRemoteIP[0], udpRemoteIP[1], udpRemoteIP[2], udpRemoteIP[3]);
 	return newStringFromBytes(s, strlen(s));
 }
 
@@ -606,7 +985,7 @@ static OBJ primUDPRemotePort(int argCount, OBJ *args) {
 	if (NO_WIFI()) return fail(noWiFi);
 	if (!isConnectedToWiFi()) return fail(wifiNotConnected);
 
-	return int2obj(udp.remotePort());
+	return int2obj(udpRemotePortNum);
 }
 
 // Websocket support for ESP32
@@ -700,6 +1079,8 @@ void getMACAddress(uint8 *sixBytes) {
 	memcpy(sixBytes, mac, 6);
 }
 
+int httpRespondWithData(const char *contentType, uint8 *data, int byteCount, int keepAlive) { return -1; }
+
 static OBJ primHasWiFi(int argCount, OBJ *args) { return falseObj; }
 static OBJ primAllowWiFiAndBLE(int argCount, OBJ *args) { return falseObj; }
 static OBJ primStartWiFi(int argCount, OBJ *args) { return fail(noWiFi); }
@@ -715,6 +1096,11 @@ static OBJ primHttpConnect(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primHttpIsConnected(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primHttpRequest(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primHttpResponse(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primHttpReadInto(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primHttpStatus(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primHttpContentLength(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primHttpHeader(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primHttpResponseToFile(int argCount, OBJ *args) { return fail(noWiFi); }
 
 static OBJ primUDPStart(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primUDPStop(int argCount, OBJ *args) { return fail(noWiFi); }
@@ -722,6 +1108,10 @@ static OBJ primUDPSendPacket(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primUDPReceivePacket(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primUDPRemoteIPAddress(int argCount, OBJ *args) { return fail(noWiFi); }
 static OBJ primUDPRemotePort(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primUDPReceiveInto(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primUDPPackAddress(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primUDPSendTo(int argCount, OBJ *args) { return fail(noWiFi); }
+static OBJ primUDPStats(int argCount, OBJ *args) { return fail(noWiFi); }
 
 #endif
 
@@ -995,6 +1385,11 @@ static PrimEntry entries[] = {
 	{"httpIsConnected", primHttpIsConnected},
 	{"httpRequest", primHttpRequest},
 	{"httpResponse", primHttpResponse},
+	{"httpReadInto", primHttpReadInto},
+	{"httpStatus", primHttpStatus},
+	{"httpContentLength", primHttpContentLength},
+	{"httpHeader", primHttpHeader},
+	{"httpResponseToFile", primHttpResponseToFile},
 
 	{"udpStart", primUDPStart},
 	{"udpStop", primUDPStop},
@@ -1002,6 +1397,10 @@ static PrimEntry entries[] = {
 	{"udpReceivePacket", primUDPReceivePacket},
 	{"udpRemoteIPAddress", primUDPRemoteIPAddress},
 	{"udpRemotePort", primUDPRemotePort},
+	{"udpReceiveInto", primUDPReceiveInto},
+	{"udpPackAddress", primUDPPackAddress},
+	{"udpSendTo", primUDPSendTo},
+	{"udpStats", primUDPStats},
 
 	{"webSocketStart", primWebSocketStart},
 	{"webSocketLastEvent", primWebSocketLastEvent},
@@ -1093,6 +1093,42 @@ void resumeCodeFileUpdates() {
 	#endif
 }
 
+#if defined(GNUBLOCKS) && !defined(EMSCRIPTEN)
+
+// VM instances (see linux+pi/vmHost.c)
+// All instances share the RAM code store. Only the words in use are saved. Since the saved
+// words are restored to the same addresses, the code pointers in the chunk table stay valid.
+
+void persistSaveState(VMState *state) {
+	int wordCount = freeStart - start0;
+	if (wordCount > state->codeCapacity) {
+		int *codeStore = realloc(state->codeStore, 4 * wordCount);
+		if (!codeStore) vmPanic("Could not save VM instance code");
+		state->codeStore = codeStore;
+		state->codeCapacity = wordCount;
+	}
+	memcpy(state->codeStore, start0, 4 * wordCount);
+	state->codeWords = wordCount;
+	state->current = current;
+}
+
+void persistRestoreState(VMState *state) {
+	int *oldFreeStart = freeStart;
+	memcpy(start0, state->codeStore, 4 * state->codeWords);
+	current = state->current;
+	freeStart = start0 + state->codeWords;
+	if (oldFreeStart > freeStart) flashErase(freeStart, oldFreeStart); // erase stale records
+}
+
+void persistClearState() {
+	// Erase the code store before loading the code of a new instance.
+
+	flashErase((int *) START, (int *) (START + HALF_SPACE));
+	freeStart = (int *) START;
+}
+
+#endif
+
 // testing
 
 static void dumpWords(int halfSpace, int count) {
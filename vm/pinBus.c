@@ -0,0 +1,154 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pinBus.c - Pin groups and parallel and shifted bus output
+// agent, October 2026
+
+/*
+Pin Bus
+
+A pin group is a list of up to 32 pins that are written or read together as the bits of
+an integer, least significant bit first, such as the eight data lines of a parallel LCD.
+Writing a byte array to a group with a strobe pin, or shifting it out over a data and
+clock pin, takes one primitive call rather than several primitive calls per byte.
+
+When a group is defined, the driver is asked to map all of its pins onto a single GPIO
+port. If it can, the group is written with one set and one clear of the port's output
+registers, using masks computed when the group was defined. If the pins are consecutive
+port bits in order, the value is simply shifted into place. Otherwise, the pins are
+written one at a time.
+
+Port writes do not set pin modes, so a port-mapped group remembers the direction it last
+set its pins to. Any later pin mode change, such as a digital read of one of its pins,
+makes the group set its pin modes again on its next access.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "pinBus.h"
+
+static uint32 modeChanges = 0; // incremented on every pin mode change
+
+void pinBus_modeChanged() {
+	modeChanges++;
+}
+
+static uint32 valueMask(PinGroup *group) {
+	return (group->pinCount >= 32) ? 0xFFFFFFFF : ((1U << group->pinCount) - 1);
+}
+
+int pinBus_define(PinGroup *group, int *pins, int pinCount, PinBusDriver *driver) {
+	// Initialize a pin group with the given pins. Return false if there are too many pins.
+
+	if ((pinCount < 1) || (pinCount > PIN_GROUP_MAX_PINS)) return false;
+	memset(group, 0, sizeof(PinGroup));
+	group->pinCount = pinCount;
+	memcpy(group->pins, pins, pinCount * sizeof(int));
+	group->shift = -1;
+
+	if (driver->mapPort && driver->mapPort(group)) {
+		group->usePort = true;
+		for (int i = 0; i < pinCount; i++) group->portMask |= group->bitMasks[i];
+
+		// check for consecutive port bits in order
+		uint32 first = group->bitMasks[0];
+		int shift = 0;
+		while ((shift < 32) && !((first >> shift) & 1)) shift++;
+		int consecutive = (first == (1U << shift)) && ((shift + pinCount) <= 32);
+		for (int i = 1; consecutive && (i < pinCount); i++) {
+			if (group->bitMasks[i] != (first << i)) consecutive = false;
+		}
+		if (consecutive) group->shift = shift;
+	}
+	return true;
+}
+
+static void setDirection(PinGroup *group, int direction, uint32 value, PinBusDriver *driver) {
+	// Set the pin modes of a port-mapped group by accessing each pin once the slow way.
+	// Skip this if the pins are already in the given direction and no pin mode has changed.
+
+	if ((direction == group->direction) && (modeChanges == group->modeChanges)) return;
+	for (int i = 0; i < group->pinCount; i++) {
+		if (pinBus_Output == direction) {
+			driver->setPin(group->pins[i], (value >> i) & 1);
+		} else {
+			driver->getPin(group->pins[i]);
+		}
+	}
+	group->direction = direction;
+	group->modeChanges = modeChanges;
+}
+
+void pinBus_write(PinGroup *group, uint32 value, PinBusDriver *driver) {
+	if (!group->usePort) {
+		for (int i = 0; i < group->pinCount; i++) {
+			driver->setPin(group->pins[i], (value >> i) & 1);
+		}
+		return;
+	}
+	setDirection(group, pinBus_Output, value, driver);
+	uint32 setMask = 0;
+	if (group->shift >= 0) {
+		setMask = (value & valueMask(group)) << group->shift;
+	} else {
+		for (int i = 0; i < group->pinCount; i++) {
+			if ((value >> i) & 1) setMask |= group->bitMasks[i];
+		}
+	}
+	driver->writePort(group, setMask, group->portMask & ~setMask);
+}
+
+uint32 pinBus_read(PinGroup *group, PinBusDriver *driver) {
+	uint32 result = 0;
+	if (!group->usePort) {
+		for (int i = 0; i < group->pinCount; i++) {
+			if (driver->getPin(group->pins[i])) result |= (1U << i);
+		}
+		return result;
+	}
+	setDirection(group, pinBus_Input, 0, driver);
+	uint32 portBits = driver->readPort(group);
+	if (group->shift >= 0) return (portBits >> group->shift) & valueMask(group);
+	for (int i = 0; i < group->pinCount; i++) {
+		if (portBits & group->bitMasks[i]) result |= (1U << i);
+	}
+	return result;
+}
+
+void pinBus_writeBytes(PinGroup *group, uint8 *data, int count, int strobePin, int strobeLevel, PinBusDriver *driver) {
+	// Write each byte to the group, then pulse the strobe pin to the given level and back.
+	// The strobe pin is left at the inactive level.
+
+	driver->setPin(strobePin, !strobeLevel);
+	for (int i = 0; i < count; i++) {
+		pinBus_write(group, data[i], driver);
+		driver->setPin(strobePin, strobeLevel);
+		driver->setPin(strobePin, !strobeLevel);
+	}
+}
+
+void pinBus_shiftOut(int dataPin, int clockPin, uint8 *data, int count, int msbFirst, PinBusDriver *driver) {
+	// Shift out the bits of each byte on dataPin, pulsing clockPin high after each bit.
+	// The data and clock pins are written as a two-pin group (bit 0 is data, bit 1 is
+	// clock), so they use port masks when possible. The clock is left low.
+
+	int pins[2] = {dataPin, clockPin};
+	PinGroup group;
+	pinBus_define(&group, pins, 2, driver);
+
+	int bit = 0;
+	for (int i = 0; i < count; i++) {
+		int byte = data[i];
+		for (int j = 0; j < 8; j++) {
+			bit = msbFirst ? ((byte >> (7 - j)) & 1) : ((byte >> j) & 1);
+			pinBus_write(&group, bit, driver); // set data, clock low
+			pinBus_write(&group, bit | 2, driver); // clock high
+		}
+	}
+	pinBus_write(&group, bit, driver); // clock low
+}
@@ -0,0 +1,61 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pinBus.h - Pin groups and parallel and shifted bus output
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_GROUP_MAX_PINS 32
+
+typedef struct {
+	int pinCount;
+	int pins[PIN_GROUP_MAX_PINS];		// pin numbers, least significant bit first
+	int usePort;						// true if the group is accessed with port masks
+	int direction;						// current pin modes of a port-mapped group (see below)
+	uint32 modeChanges;					// pin mode change count when direction was set
+	void *port;							// driver data, such as the port address
+	int shift;							// if >= 0, bit i is port bit (shift + i)
+	uint32 portMask;					// all pins of the group
+	uint32 bitMasks[PIN_GROUP_MAX_PINS];	// port mask for each bit
+} PinGroup;
+
+enum {
+	pinBus_Unused = 0,
+	pinBus_Output = 1,
+	pinBus_Input = 2
+};
+
+// The driver does the pin I/O. setPin() and getPin() set the pin mode as needed.
+// The port functions are optional. If the driver can access all pins of a group with a
+// single port, mapPort() fills in the group's port and bitMasks and returns true. Then
+// writePort() sets and clears the given port bits and readPort() returns the port bits.
+// The pin modes of a port-mapped group are set with setPin() or getPin() when the group's
+// direction changes or when any pin mode has changed since they were set. The platform
+// calls pinBus_modeChanged() whenever it changes the mode of a pin, including when a pin
+// of a group is used with a plain digital read or write.
+
+typedef struct {
+	void (*setPin)(int pin, int value);
+	int (*getPin)(int pin);
+	int (*mapPort)(PinGroup *group);
+	void (*writePort)(PinGroup *group, uint32 setMask, uint32 clearMask);
+	uint32 (*readPort)(PinGroup *group);
+} PinBusDriver;
+
+void pinBus_modeChanged();
+int pinBus_define(PinGroup *group, int *pins, int pinCount, PinBusDriver *driver);
+void pinBus_write(PinGroup *group, uint32 value, PinBusDriver *driver);
+uint32 pinBus_read(PinGroup *group, PinBusDriver *driver);
+
+void pinBus_writeBytes(PinGroup *group, uint8 *data, int count, int strobePin, int strobeLevel, PinBusDriver *driver);
+void pinBus_shiftOut(int dataPin, int clockPin, uint8 *data, int count, int msbFirst, PinBusDriver *driver);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,319 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pinEvents.c - Interrupt-safe edge counting and timestamps for input pins
+// agent, October 2026
+
+/*
+Pin Events
+
+A pin interrupt handler calls pinEvents_record() on each rising and/or falling edge of an
+input pin. It counts the edges and keeps the times of the most recent ones in a small
+ring, so a program can measure a frequency, an RPM, or a pulse width without polling the
+pin in a loop and missing edges.
+
+The interrupt handler is the only writer. It stores an edge before incrementing the
+count, and readers never disable interrupts: pinEvents_snapshot() copies the newest edges,
+then checks the count again. Edges that arrived during the copy overwrote only older
+entries unless there were too many of them, in which case the copy is retried.
+
+Period, frequency, and pulse width are computed from a snapshot. Period and frequency
+use the recent edges in the same direction as the newest edge, so they work whether
+rising, falling, or both edges are captured. They are zero once the signal has stopped
+for more than two periods. Pulse widths need both edges.
+
+Times are 32-bit microsecond clock values. Only differences of recent times are used, so
+the clock may wrap.
+
+The pin event primitives at the end of this file are shared by the board and Linux VMs.
+Each board attaches its interrupt handlers through a PinEventDriver; the Linux VM has none
+and records simulated edges with pinEvents_forPin().
+*/
+
+#include <string.h>
+
+#include "mem.h"
+#include "interp.h"
+#include "pinEvents.h"
+
+#define SNAPSHOT_TRIES 4
+
+void pinEvents_start(PinEvents *pe, int pin, int edges) {
+	// Start capturing the given edges, clearing any earlier ones. The caller attaches the
+	// interrupt handler after this, unless it is already attached.
+
+	pe->edges = 0; // ignore edges until ready
+	pe->pin = pin;
+	pe->count = 0;
+	memset((void *) pe->times, 0, sizeof(pe->times));
+	memset((void *) pe->levels, 0, sizeof(pe->levels));
+	pe->edges = edges & PIN_EVENT_BOTH;
+}
+
+void pinEvents_stop(PinEvents *pe) {
+	// Stop capturing. The caller detaches the interrupt handler before this.
+
+	pe->edges = 0;
+	pe->pin = -1;
+}
+
+void pinEvents_record(PinEvents *pe, int level, uint32 usecs) {
+	// Record an edge that left the pin at the given level. Called from an interrupt handler.
+	// When capturing both edges, an edge to the level that the pin already had is ignored;
+	// it comes from a glitch shorter than the interrupt latency.
+
+	level = (level != 0);
+	if (!(pe->edges & (level ? PIN_EVENT_RISING : PIN_EVENT_FALLING))) return;
+	uint32 count = pe->count;
+	if ((PIN_EVENT_BOTH == pe->edges) && count &&
+		(level == pe->levels[(count - 1) % PIN_EVENT_HISTORY])) {
+			return;
+	}
+	int i = count % PIN_EVENT_HISTORY;
+	pe->times[i] = usecs;
+	pe->levels[i] = level;
+	pe->count = count + 1; // publish the edge
+}
+
+int pinEvents_snapshot(PinEvents *pe, uint32 *times, uint8 *levels, uint32 *count) {
+	// Copy the newest edges (up to PIN_EVENT_HISTORY - 1 of them), oldest first, and set
+	// count to the number of edges captured. Return the number of edges copied.
+	//
+	// The k-th edge that arrives during the copy overwrites the entry PIN_EVENT_HISTORY
+	// edges older than itself, so the copied entries are intact unless more than
+	// (PIN_EVENT_HISTORY - n) edges arrived.
+
+	for (int tries = 0; tries < SNAPSHOT_TRIES; tries++) {
+		uint32 c = pe->count;
+		int n = (c < (PIN_EVENT_HISTORY - 1)) ? c : (PIN_EVENT_HISTORY - 1);
+		for (int i = 0; i < n; i++) {
+			int j = (c - n + i) % PIN_EVENT_HISTORY;
+			times[i] = pe->times[j];
+			levels[i] = pe->levels[j];
+		}
+		if ((pe->count - c) <= (uint32) (PIN_EVENT_HISTORY - n)) {
+			*count = c;
+			return n;
+		}
+	}
+	*count = pe->count; // edges arriving faster than they can be copied
+	return 0;
+}
+
+static int sameDirectionSpan(PinEvents *pe, uint32 now, uint32 *span) {
+	// Find the recent edges in the same direction as the newest edge. Set span to the time
+	// from the oldest to the newest of them and return the number of periods it covers,
+	// or zero if there are too few edges or the signal has stopped.
+
+	uint32 times[PIN_EVENT_HISTORY];
+	uint8 levels[PIN_EVENT_HISTORY];
+	uint32 count;
+	int n = pinEvents_snapshot(pe, times, levels, &count);
+	if (n < 2) return 0;
+
+	int newest = n - 1;
+	int oldest = newest;
+	int periods = 0;
+	for (int i = newest - 1; i >= 0; i--) {
+		if (levels[i] == levels[newest]) {
+			oldest = i;
+			periods++;
+		}
+	}
+	if (!periods) return 0;
+	*span = times[newest] - times[oldest];
+	if (!*span) return 0;
+
+	// stopped if no edge for two average periods
+	uint64 sinceLast = now - times[newest];
+	if ((sinceLast * periods) > (2 * (uint64) *span)) return 0;
+	return periods;
+}
+
+int pinEvents_period(PinEvents *pe, uint32 now) {
+	// Return the average period of the signal in usecs, or zero if unknown.
+
+	uint32 span;
+	int periods = sameDirectionSpan(pe, now, &span);
+	if (!periods) return 0;
+	return (span + (periods / 2)) / periods;
+}
+
+int pinEvents_frequency(PinEvents *pe, int scale, uint32 now) {
+	// Return the frequency of the signal in cycles per second times scale (for example,
+	// scale 1000 gives millihertz and scale 60 gives cycles per minute), or zero if
+	// unknown. The result is clipped to 0x3FFFFFFF.
+
+	uint32 span;
+	int periods = sameDirectionSpan(pe, now, &span);
+	if (!periods || (scale <= 0)) return 0;
+	uint64 result = (((uint64) periods * 1000000 * scale) + (span / 2)) / span;
+	return (result > 0x3FFFFFFF) ? 0x3FFFFFFF : (int) result;
+}
+
+int pinEvents_width(PinEvents *pe, int level) {
+	// Return the width in usecs of the most recent complete pulse at the given level
+	// (1 for high, 0 for low), or zero if there is none. Needs both edges.
+
+	uint32 times[PIN_EVENT_HISTORY];
+	uint8 levels[PIN_EVENT_HISTORY];
+	uint32 count;
+	int n = pinEvents_snapshot(pe, times, levels, &count);
+
+	level = (level != 0);
+	for (int i = n - 1; i > 0; i--) {
+		if ((levels[i] != level) && (levels[i - 1] == level)) return times[i] - times[i - 1];
+	}
+	return 0;
+}
+
+// Slots
+
+static PinEvents slots[PIN_EVENT_SLOTS];
+static int slotsInitialized = false;
+static PinEventDriver *driver = NULL;
+
+void pinEvents_setDriver(PinEventDriver *d) {
+	driver = d;
+}
+
+static int pinEventSlot(int pin) {
+	// Return the index of the slot capturing the given pin, or -1 if none.
+
+	if (!slotsInitialized) {
+		for (int i = 0; i < PIN_EVENT_SLOTS; i++) slots[i].pin = -1;
+		slotsInitialized = true;
+	}
+	for (int i = 0; i < PIN_EVENT_SLOTS; i++) {
+		if (pin == slots[i].pin) return i;
+	}
+	return -1;
+}
+
+PinEvents * pinEvents_slot(int slot) {
+	return &slots[slot];
+}
+
+PinEvents * pinEvents_forPin(int pin) {
+	// Return the slot capturing the given pin, or NULL if none.
+
+	if (!slotsInitialized || (pin < 0)) return NULL;
+	int slot = pinEventSlot(pin);
+	return (slot < 0) ? NULL : &slots[slot];
+}
+
+void stopPinEvents() {
+	// Detach the interrupt handlers and free all slots. Called when all tasks are stopped.
+
+	if (!slotsInitialized) return;
+	for (int i = 0; i < PIN_EVENT_SLOTS; i++) {
+		if (slots[i].pin < 0) continue;
+		if (driver) driver->detach(slots[i].pin);
+		pinEvents_stop(&slots[i]);
+	}
+}
+
+// Primitives
+
+static PinEvents * pinEventsArg(OBJ *args) {
+	// Return the PinEvents for the pin given by the first argument, or NULL if that pin is
+	// not being captured.
+
+	return isInt(args[0]) ? pinEvents_forPin(obj2int(args[0])) : NULL;
+}
+
+static int edgesArg(OBJ arg) {
+	if (IS_TYPE(arg, StringType)) {
+		char *s = obj2str(arg);
+		if (0 == strcmp(s, "rising")) return PIN_EVENT_RISING;
+		if (0 == strcmp(s, "falling")) return PIN_EVENT_FALLING;
+	}
+	return PIN_EVENT_BOTH;
+}
+
+OBJ primPinEventsStart(int argCount, OBJ *args) {
+	// Start capturing the rising, falling, or both (default) edges of the given pin.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	if (!isInt(args[0])) return fail(needsIntegerError);
+	int pin = obj2int(args[0]);
+	int edges = (argCount > 1) ? edgesArg(args[1]) : PIN_EVENT_BOTH;
+	if (pin < 0) return fail(badPinEventPin);
+
+	int slot = pinEventSlot(pin);
+	if (slot >= 0) {
+		if (driver) driver->detach(pin);
+	} else {
+		slot = pinEventSlot(-1); // find an unused slot
+		if (slot < 0) return fail(pinEventSlotsFull);
+	}
+	pinEvents_start(&slots[slot], pin, edges);
+	if (driver && !driver->attach(slot, pin, edges)) {
+		pinEvents_stop(&slots[slot]);
+		return fail(pinHasNoInterrupt);
+	}
+	return falseObj;
+}
+
+OBJ primPinEventsStop(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	if (pe) {
+		if (driver) driver->detach(pe->pin);
+		pinEvents_stop(pe);
+	}
+	return falseObj;
+}
+
+OBJ primPinEventCount(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	return int2obj(pe ? (pe->count & 0x3FFFFFFF) : 0);
+}
+
+OBJ primPinEventIntervals(int argCount, OBJ *args) {
+	// Return a list of the usecs between the recent edges, oldest first.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	uint32 times[PIN_EVENT_HISTORY];
+	uint8 levels[PIN_EVENT_HISTORY];
+	uint32 count;
+	int n = pe ? pinEvents_snapshot(pe, times, levels, &count) : 0;
+	int intervalCount = (n > 1) ? (n - 1) : 0;
+
+	OBJ result = newObj(ListType, intervalCount + 1, zeroObj);
+	if (!result) return fail(insufficientMemoryError);
+	FIELD(result, 0) = int2obj(intervalCount);
+	for (int i = 0; i < intervalCount; i++) {
+		FIELD(result, i + 1) = int2obj((times[i + 1] - times[i]) & 0x3FFFFFFF);
+	}
+	return result;
+}
+
+OBJ primPinPeriod(int argCount, OBJ *args) {
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	return int2obj(pe ? pinEvents_period(pe, microsecs()) : 0);
+}
+
+OBJ primPinPulseWidth(int argCount, OBJ *args) {
+	// Return the width of the most recent high (default) or low pulse in usecs.
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	int level = (argCount > 1) ? (falseObj != args[1]) : 1;
+	return int2obj(pe ? pinEvents_width(pe, level) : 0);
+}
+
+OBJ primPinFrequency(int argCount, OBJ *args) {
+	// Return the frequency in Hz, multiplied by the optional scale (e.g. 60 for RPM).
+
+	if (argCount < 1) return fail(notEnoughArguments);
+	PinEvents *pe = pinEventsArg(args);
+	int scale = ((argCount > 1) && isInt(args[1])) ? obj2int(args[1]) : 1;
+	return int2obj(pe ? pinEvents_frequency(pe, scale, microsecs()) : 0);
+}
@@ -0,0 +1,67 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pinEvents.h - Interrupt-safe edge counting and timestamps for input pins
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_EVENT_SLOTS 8
+#define PIN_EVENT_HISTORY 16		// edge times kept per pin
+
+// edges to capture
+#define PIN_EVENT_RISING 1
+#define PIN_EVENT_FALLING 2
+#define PIN_EVENT_BOTH 3
+
+// pinEvents_record() is called by an interrupt handler, so the fields it changes are
+// volatile. It writes the edge into the ring before incrementing count, so a reader can
+// detect edges that arrived while it was copying (see pinEvents_snapshot()).
+
+typedef struct {
+	int pin;						// -1 when not in use
+	int edges;						// PIN_EVENT_RISING, PIN_EVENT_FALLING, or PIN_EVENT_BOTH
+	volatile uint32 count;			// edges captured; the newest is at (count - 1) % PIN_EVENT_HISTORY
+	volatile uint32 times[PIN_EVENT_HISTORY];	// microsecs() at each edge
+	volatile uint8 levels[PIN_EVENT_HISTORY];	// pin level after each edge
+} PinEvents;
+
+void pinEvents_start(PinEvents *pe, int pin, int edges);
+void pinEvents_stop(PinEvents *pe);
+void pinEvents_record(PinEvents *pe, int level, uint32 usecs);
+int pinEvents_snapshot(PinEvents *pe, uint32 *times, uint8 *levels, uint32 *count);
+int pinEvents_period(PinEvents *pe, uint32 now);
+int pinEvents_width(PinEvents *pe, int level);
+int pinEvents_frequency(PinEvents *pe, int scale, uint32 now);
+
+// Slots and primitives (requires mem.h)
+
+// A board's driver attaches an interrupt handler that calls pinEvents_record() for the
+// given slot on the given edges of the pin, returning false if the pin does not support
+// interrupts, and detaches it again.
+
+typedef struct {
+	int (*attach)(int slot, int pin, int edges);
+	void (*detach)(int pin);
+} PinEventDriver;
+
+void pinEvents_setDriver(PinEventDriver *driver);
+PinEvents * pinEvents_slot(int slot);
+PinEvents * pinEvents_forPin(int pin);
+
+OBJ primPinEventsStart(int argCount, OBJ *args);
+OBJ primPinEventsStop(int argCount, OBJ *args);
+OBJ primPinEventCount(int argCount, OBJ *args);
+OBJ primPinEventIntervals(int argCount, OBJ *args);
+OBJ primPinPeriod(int argCount, OBJ *args);
+OBJ primPinPulseWidth(int argCount, OBJ *args);
+OBJ primPinFrequency(int argCount, OBJ *args);
+
+#ifdef __cplusplus
+}
+#endif
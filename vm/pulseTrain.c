@@ -0,0 +1,127 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pulseTrain.c - Timed pulse and waveform generation from step lists
+// agent, October 2026
+
+/*
+Pulse Trains
+
+A pulse train plays a list of steps on up to eight pins. Each step sets the levels of the
+pins and holds them for a given number of microseconds, so a train can send an IR remote
+code, a burst of servo or stepper pulses, or any other timed waveform. Several trains can
+play at once on different pins, and a train can repeat a given number of times or until
+it is stopped. The pins of a train change together, so a train on several pins can drive
+stepper phases or other signals that must stay in step.
+
+Step times are computed from the start time by adding step durations, so timing errors
+do not accumulate. pulseTrain_update() takes all the steps that are due, in time order,
+and returns the time of the next step. It is called from a hardware timer interrupt
+where available, or from the VM loop otherwise.
+
+A train copies its steps into a buffer of its own, outside the object heap (see mem.h).
+
+Pins are set through the PulseDriver passed to pulseTrain_update(), so the same step
+timing drives the pins of a board and the simulated pins of the Linux VM.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "pulseTrain.h"
+
+#define MAX_STEPS_PER_UPDATE 64 // limits the time spent in one update when steps are very short
+
+int pulseTrain_load(PulseTrain *train, int *pins, int pinCount, int stepCount) {
+	// Stop the train and set its pins and step count. The steps must then be set with
+	// pulseTrain_setStep(). Return false if the arguments are out of range or there is not
+	// enough memory for the steps.
+
+	train->active = false;
+	if ((pinCount < 1) || (pinCount > PULSE_TRAIN_MAX_PINS)) return false;
+	if ((stepCount < 1) || (stepCount > PULSE_TRAIN_MAX_STEPS)) return false;
+	if (stepCount != train->stepCount) {
+		free(train->steps);
+		train->steps = (uint32 *) malloc(stepCount * sizeof(uint32));
+		train->stepCount = train->steps ? stepCount : 0;
+		if (!train->steps) return false;
+	}
+	memset(train->steps, 0, stepCount * sizeof(uint32));
+	train->pinCount = pinCount;
+	memcpy(train->pins, pins, pinCount * sizeof(int));
+	return true;
+}
+
+void pulseTrain_setStep(PulseTrain *train, int index, int levels, int usecs) {
+	if ((index < 0) || (index >= train->stepCount)) return;
+	if (usecs < 0) usecs = 0;
+	if (usecs > PULSE_TRAIN_MAX_DURATION) usecs = PULSE_TRAIN_MAX_DURATION;
+	train->steps[index] = ((uint32) usecs << 8) | (levels & 0xFF);
+}
+
+int pulseTrain_play(PulseTrain *train, int repeatCount, uint64 startTime) {
+	// Start playing the train's steps at startTime. Return false if the train repeats
+	// forever but its steps take no time.
+
+	train->active = false;
+	if (!train->steps) return false;
+	if (repeatCount <= 0) {
+		uint32 totalUsecs = 0;
+		for (int i = 0; i < train->stepCount; i++) totalUsecs |= train->steps[i] >> 8;
+		if (!totalUsecs) return false;
+		repeatCount = 0;
+	}
+	train->repeatCount = repeatCount;
+	train->passes = 0;
+	train->stepIndex = 0;
+	train->levels = ~train->steps[0]; // the first step sets all pins
+	train->nextEdge = startTime;
+	train->active = true; // set last, since an interrupt may check it at any time
+	return true;
+}
+
+void pulseTrain_stop(PulseTrain *train) {
+	train->active = false;
+}
+
+static void takeStep(PulseTrain *train, PulseDriver *driver) {
+	if (train->stepIndex >= train->stepCount) { // end of a pass
+		train->passes++;
+		if (train->repeatCount && (train->passes >= train->repeatCount)) {
+			train->active = false; // done; the pins keep the levels of the last step
+			return;
+		}
+		train->stepIndex = 0;
+	}
+	uint32 step = train->steps[train->stepIndex++];
+	uint32 levels = step & 0xFF;
+	uint32 changed = (levels ^ train->levels) & ((1 << train->pinCount) - 1);
+	if (changed) driver->setPins(train, levels, changed, train->nextEdge);
+	train->levels = levels;
+	train->nextEdge += step >> 8;
+}
+
+int pulseTrain_update(PulseTrain *trains, int count, uint64 now, PulseDriver *driver, uint64 *nextEdge) {
+	// Take the steps of all trains that are due by the given time, in time order. Return
+	// the number of trains still playing and set nextEdge to the time of the next step.
+	// If there were too many steps to take at once, nextEdge may already have passed.
+
+	for (int n = 0; n <= MAX_STEPS_PER_UPDATE; n++) {
+		PulseTrain *next = NULL;
+		int activeCount = 0;
+		for (int i = 0; i < count; i++) {
+			PulseTrain *train = &trains[i];
+			if (!train->active) continue;
+			activeCount++;
+			if (!next || (train->nextEdge < next->nextEdge)) next = train;
+		}
+		if (next) *nextEdge = next->nextEdge;
+		if (!next || (next->nextEdge > now) || (n == MAX_STEPS_PER_UPDATE)) return activeCount;
+		takeStep(next, driver);
+	}
+	return 0; // not reached
+}
@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// pulseTrain.h - Timed pulse and waveform generation from step lists
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PULSE_TRAIN_COUNT 4
+#define PULSE_TRAIN_MAX_PINS 8
+#define PULSE_TRAIN_MAX_STEPS 1024
+#define PULSE_TRAIN_MAX_DURATION 0xFFFFFF	// usecs per step (about 16.7 seconds)
+
+// A step sets the levels of the train's pins (bit i is the level of pin i) and holds them
+// for a duration. Steps are stored as (duration << 8) | levels.
+
+typedef struct {
+	volatile int active;		// cleared before changing a train that an interrupt may be playing
+	int pinCount;
+	int pins[PULSE_TRAIN_MAX_PINS];
+	uint32 *steps;
+	int stepCount;
+	int stepIndex;				// next step
+	int repeatCount;			// number of passes to play, or 0 to repeat until stopped
+	int passes;					// passes completed
+	uint32 levels;				// current pin levels
+	uint64 nextEdge;			// time of the next step in usecs
+} PulseTrain;
+
+// The driver sets the levels of the pins whose bits are set in changed. edgeTime is the
+// scheduled time of the change; a simulated driver can record it.
+
+typedef struct {
+	void (*setPins)(PulseTrain *train, uint32 levels, uint32 changed, uint64 edgeTime);
+} PulseDriver;
+
+int pulseTrain_load(PulseTrain *train, int *pins, int pinCount, int stepCount);
+void pulseTrain_setStep(PulseTrain *train, int index, int levels, int usecs);
+int pulseTrain_play(PulseTrain *train, int repeatCount, uint64 startTime);
+void pulseTrain_stop(PulseTrain *train);
+int pulseTrain_update(PulseTrain *trains, int count, uint64 now, PulseDriver *driver, uint64 *nextEdge);
+
+#ifdef __cplusplus
+}
+#endif
@@ -360,6 +360,7 @@ static OBJ primPacketReceive(int argCount, OBJ *args) {
 
 	if (BLE_connected_to_IDE) return fail(cannotUseWithBLE);
 
+	if ((argCount > 0) && !ensureList(args, 0)) return falseObj;
 	if ((argCount > 0) && IS_TYPE(args[0], ListType) && (obj2int(FIELD(args[0], 0)) >= 32)) {
 		OBJ arg0 = args[0];
 		uint8_t packet[32];
@@ -380,6 +381,7 @@ static OBJ primPacketSend(int argCount, OBJ *args) {
 
 	if (BLE_connected_to_IDE) return fail(cannotUseWithBLE);
 
+	if ((argCount > 0) && !ensureListCopy(args, 0)) return falseObj;
 	if ((argCount > 0) && IS_TYPE(args[0], ListType) && (obj2int(FIELD(args[0], 0)) >= 32)) {
 		OBJ arg0 = args[0];
 		uint8_t packet[32];
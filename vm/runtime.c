@@ -515,10 +515,13 @@ static void softReset(int clearMemoryFlag) {
 	stopPWM();
 	stopServos();
 	stopTone();
+	resetHID();
+	stopPinEvents();
 	#if !defined(DATABOT)
 		turnOffInternalNeoPixels();
 	#endif
 	turnOffPins();
+	stopDataLog();
 	if (clearMemoryFlag) {
 		memClear();
 		outputString("Memory cleared");
@@ -636,19 +639,20 @@ static void sendValueMessage(uint8 msgType, uint8 chunkOrVarIndex, OBJ value) {
 		data[0] = 3; // data type (3 is boolean)
 		data[1] = (trueObj == value) ? 1 : 0;
 		sendMessage(msgType, chunkOrVarIndex, 2, data);
-	} else if (IS_TYPE(value, ListType)) {
+	} else if (IS_TYPE(value, ListType) || IS_TYPE(value, RangeType)) {
 		data[0] = 4; // data type (4 is list)
 		// Note: xxx Does not handle sublists.
+		int isRange = IS_TYPE(value, RangeType);
 		char *dst = &data[1];
 		// total items in list (16-bit, little endian)
-		int itemCount = obj2int(FIELD(value, 0));
+		int itemCount = isRange ? RANGE_COUNT(value) : obj2int(FIELD(value, 0));
 		*dst++ = itemCount & 0xFF;
 		*dst++ = (itemCount >> 8) & 0xFF;
 		int sendCount = 32; // send up to this many items
 		if (itemCount < sendCount) sendCount = itemCount;
 		*dst++ = sendCount;
 		for (int i = 0; i < sendCount; i++) {
-			OBJ item = FIELD(value, i + 1);
+			OBJ item = isRange ? rangeAt(value, i + 1) : FIELD(value, i + 1);
 			int type = objType(item);
 			if (IntegerType == type) { // integer (32-bit signed, little-endian)
 				*dst++ = 1; // item type (1 is integer)
@@ -673,9 +677,9 @@ static void sendValueMessage(uint8 msgType, uint8 chunkOrVarIndex, OBJ value) {
 			} else if (BooleanType == type) {
 				*dst++ = 3; // item type (3 is boolean)
 				*dst++ = (trueObj == item) ? 1 : 0;
-			} else if (ListType == type) { // sublist within a list; send item count only
+			} else if ((ListType == type) || (RangeType == type)) { // sublist; send item count only
 				*dst++ = 4; // item type (4 is list)
-				int n = obj2int(FIELD(item, 0)); // item count of sublist
+				int n = (RangeType == type) ? RANGE_COUNT(item) : obj2int(FIELD(item, 0)); // item count of sublist
 				*dst++ = n & 0xFF;
 				*dst++ = (n >> 8) & 0xFF;
 				*dst++ = 0; // send zero items of sublists
@@ -216,6 +216,7 @@ static OBJ primI2cRead(int argCount, OBJ *args) {
 	// max of 32). This operation is usually preceded by an I2C write to request some data.
 
 	if ((argCount < 2) || !isInt(args[0])) return zeroObj;
+	if (!ensureList(args, 1)) return zeroObj;
 	int deviceID = obj2int(args[0]);
 	OBJ obj = args[1];
 	int count = 0;
@@ -261,6 +262,7 @@ static OBJ primI2cWrite(int argCount, OBJ *args) {
 	// The list should contain integers in the range 0..255.
 
 	if ((argCount < 2) || !isInt(args[0])) return zeroObj;
+	if (!ensureListCopy(args, 1)) return falseObj;
 	int deviceID = obj2int(args[0]);
 	OBJ data = args[1];
 	int stop = ((argCount < 3) || (trueObj == args[2]));
@@ -344,6 +344,7 @@ static OBJ primSerialReadInto(int argCount, OBJ *args) {
 static OBJ primSerialWrite(int argCount, OBJ *args) {
 	if (argCount < 1) return fail(notEnoughArguments);
 	if (!isOpen) return fail(serialPortNotOpen);
+	if (!ensureListCopy(args, 0)) return falseObj;
 	OBJ arg = args[0];
 
 	if (isInt(arg)) { // single byte
@@ -381,6 +382,7 @@ static OBJ primSetPins(int argCount, OBJ *args) {
 static OBJ primSerialWriteBytes(int argCount, OBJ *args) {
 	if (!isOpen) return fail(serialPortNotOpen);
 	if (argCount < 2) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 0)) return falseObj;
 
 	OBJ buf = args[0];
 	int startIndex = obj2int(args[1]) - 1; // convert 0-based index
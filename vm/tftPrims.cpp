@@ -1740,6 +1740,7 @@ static OBJ primDrawBitmap(int argCount, OBJ *args) {
 	uint32 palette[256];
 
 	if (argCount < 4) return fail(notEnoughArguments);
+	if (!ensureListCopy(args, 1)) return falseObj;
 	OBJ bitmapObj = args[0]; // bitmap: a two-item list of [width (int), pixels (byte array)]
 	OBJ paletteObj = args[1]; // palette: a list of RGB values
 	int dstX = obj2int(args[2]);
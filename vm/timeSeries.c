@@ -0,0 +1,299 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// timeSeries.c - Fixed-capacity time series with incremental downsampling
+// agent, October 2026
+
+/*
+Time Series
+
+A time series holds the most recent values of a signal, such as a sensor reading taken
+once per second, in up to four tiers of increasing duration. Tier 0 holds the raw
+values. Each higher tier holds one entry per ratio entries of the tier below it, with the
+mean, minimum, and maximum of those entries. For example, with ratios of 10 and 6 and one
+value added per second, the tiers hold 1-second, 10-second, and 1-minute entries. Every
+tier holds up to capacity entries; when a tier is full, each new entry replaces the oldest.
+
+The window statistics of each tier (minimum, maximum, mean, count, and last entry) cover
+all of its entries and are kept up to date as entries are added, so reading them takes
+constant time. The sum of the means is updated as entries come and go. The minimum and
+maximum come from monotonic deques: the minimum deque holds the indices of the entries
+that could still become the window minimum, in order of age, so its first entry is the
+minimum. Each entry enters and leaves a deque at most once, so adding a value takes
+constant amortized time.
+
+Exporting a tier copies its entries, oldest first, reduced to a given number of points
+(such as the width of a display) by combining runs of adjacent entries. Exporting takes
+time proportional to the number of entries in the tier.
+
+Values are stored as 16-bit (clipped) or 32-bit signed integers. Means are rounded to the
+nearest integer.
+
+A series has no pointers, so it is kept in a ByteArray rather than outside the heap.
+Since a program can change the bytes of that ByteArray, ts_isValid() checks the header
+before each operation and stored indices are reduced modulo the capacity before use.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "timeSeries.h"
+
+#define TS_MAGIC 0x72655354 // 'TSer'
+
+// Helper functions
+
+static long long getSum(uint32 *words) {
+	return (long long) (((uint64) words[1] << 32) | words[0]);
+}
+
+static void setSum(uint32 *words, long long n) {
+	words[0] = (uint32) n;
+	words[1] = (uint32) ((uint64) n >> 32);
+}
+
+static int roundedDiv(long long sum, int n) {
+	if (sum >= 0) return (int) ((sum + (n / 2)) / n);
+	return (int) -((-sum + (n / 2)) / n);
+}
+
+static int fieldCount(int tier) {
+	return (0 == tier) ? 1 : 3; // tier 0 holds raw values; others hold mean, min, max
+}
+
+static int tierBytes(int capacity, int valueBytes, int tier) {
+	int valueBytesTotal = ((capacity * fieldCount(tier) * valueBytes) + 3) & ~3;
+	return valueBytesTotal + (capacity * 4); // plus two deques of 16-bit indices
+}
+
+static int getField(TimeSeries *ts, int tier, int index, int field) {
+	uint8 *data = (uint8 *) ts + ts->tiers[tier].dataOffset;
+	int i = (0 == tier) ? index : ((3 * index) + field);
+	if (2 == ts->valueBytes) return ((short *) data)[i];
+	return ((int *) data)[i];
+}
+
+static void setEntry(TimeSeries *ts, int tier, int index, int mean, int min, int max) {
+	uint8 *data = (uint8 *) ts + ts->tiers[tier].dataOffset;
+	if (0 == tier) {
+		if (2 == ts->valueBytes) ((short *) data)[index] = mean; else ((int *) data)[index] = mean;
+		return;
+	}
+	int i = 3 * index;
+	if (2 == ts->valueBytes) {
+		short *p = (short *) data;
+		p[i] = mean; p[i + 1] = min; p[i + 2] = max;
+	} else {
+		int *p = (int *) data;
+		p[i] = mean; p[i + 1] = min; p[i + 2] = max;
+	}
+}
+
+static unsigned short *minDeque(TimeSeries *ts, int tier) {
+	uint8 *data = (uint8 *) ts + ts->tiers[tier].dataOffset;
+	int valueBytesTotal = ((ts->capacity * fieldCount(tier) * ts->valueBytes) + 3) & ~3;
+	return (unsigned short *) (data + valueBytesTotal);
+}
+
+static unsigned short *maxDeque(TimeSeries *ts, int tier) {
+	return minDeque(ts, tier) + ts->capacity;
+}
+
+static void accumulate(TimeSeries *ts, int tier, int mean, int min, int max);
+
+static void addEntry(TimeSeries *ts, int tier, int mean, int min, int max) {
+	// Add an entry to the given tier, replacing the oldest entry if the tier is full, and
+	// pass it on to the next tier.
+
+	TSTier *t = &ts->tiers[tier];
+	int capacity = ts->capacity;
+	unsigned short *mins = minDeque(ts, tier);
+	unsigned short *maxs = maxDeque(ts, tier);
+
+	if (t->count >= capacity) { // remove the oldest entry
+		if (t->minCount && ((mins[t->minHead] % capacity) == t->head)) {
+			t->minHead = (t->minHead + 1) % capacity;
+			t->minCount--;
+		}
+		if (t->maxCount && ((maxs[t->maxHead] % capacity) == t->head)) {
+			t->maxHead = (t->maxHead + 1) % capacity;
+			t->maxCount--;
+		}
+		setSum(t->windowSum, getSum(t->windowSum) - getField(ts, tier, t->head, TS_FIELD_MEAN));
+		t->head = (t->head + 1) % capacity;
+		t->count--;
+	}
+
+	int index = (t->head + t->count) % capacity;
+	setEntry(ts, tier, index, mean, min, max);
+	t->count++;
+	setSum(t->windowSum, getSum(t->windowSum) + mean);
+	t->last = mean;
+
+	// drop entries that can no longer be the window minimum or maximum
+	while (t->minCount && (getField(ts, tier, mins[(t->minHead + t->minCount - 1) % capacity] % capacity, TS_FIELD_MIN) >= min)) {
+		t->minCount--;
+	}
+	mins[(t->minHead + t->minCount++) % capacity] = index;
+	while (t->maxCount && (getField(ts, tier, maxs[(t->maxHead + t->maxCount - 1) % capacity] % capacity, TS_FIELD_MAX) <= max)) {
+		t->maxCount--;
+	}
+	maxs[(t->maxHead + t->maxCount++) % capacity] = index;
+
+	if ((tier + 1) < ts->tierCount) accumulate(ts, tier + 1, mean, min, max);
+}
+
+static void accumulate(TimeSeries *ts, int tier, int mean, int min, int max) {
+	// Combine an entry of the tier below into the next entry of the given tier.
+
+	TSTier *t = &ts->tiers[tier];
+	if (0 == t->pending) {
+		t->pendingMin = min;
+		t->pendingMax = max;
+		setSum(t->pendingSum, 0);
+	}
+	if (min < t->pendingMin) t->pendingMin = min;
+	if (max > t->pendingMax) t->pendingMax = max;
+	setSum(t->pendingSum, getSum(t->pendingSum) + mean);
+	t->pending++;
+	if (t->pending >= t->ratio) {
+		t->pending = 0;
+		addEntry(ts, tier, roundedDiv(getSum(t->pendingSum), t->ratio), t->pendingMin, t->pendingMax);
+	}
+}
+
+// Creating and checking
+
+int ts_bytesNeeded(int capacity, int valueBytes, int tierCount) {
+	int result = sizeof(TimeSeries);
+	for (int i = 0; i < tierCount; i++) result += tierBytes(capacity, valueBytes, i);
+	return result;
+}
+
+int ts_init(TimeSeries *ts, int byteCount, int capacity, int valueBytes, int tierCount, int *ratios) {
+	// Initialize an empty series in the given memory. ratios holds the ratio of each tier
+	// after the first. Return false if the arguments are out of range or the series does
+	// not fit in byteCount bytes.
+
+	if ((capacity < 1) || (capacity > TS_MAX_CAPACITY)) return false;
+	if ((2 != valueBytes) && (4 != valueBytes)) return false;
+	if ((tierCount < 1) || (tierCount > TS_MAX_TIERS)) return false;
+	for (int i = 1; i < tierCount; i++) {
+		if ((ratios[i - 1] < 1) || (ratios[i - 1] > TS_MAX_RATIO)) return false;
+	}
+	if (byteCount < ts_bytesNeeded(capacity, valueBytes, tierCount)) return false;
+
+	memset(ts, 0, sizeof(TimeSeries));
+	ts->capacity = capacity;
+	ts->valueBytes = valueBytes;
+	ts->tierCount = tierCount;
+	int offset = sizeof(TimeSeries);
+	for (int i = 0; i < tierCount; i++) {
+		ts->tiers[i].ratio = (0 == i) ? 1 : ratios[i - 1];
+		ts->tiers[i].dataOffset = offset;
+		offset += tierBytes(capacity, valueBytes, i);
+	}
+	ts->magic = TS_MAGIC;
+	return true;
+}
+
+int ts_isValid(TimeSeries *ts, int byteCount) {
+	// Return true if the given memory holds a series that is safe to use.
+
+	if (byteCount < (int) sizeof(TimeSeries)) return false;
+	if (TS_MAGIC != ts->magic) return false;
+	int capacity = ts->capacity;
+	if ((capacity < 1) || (capacity > TS_MAX_CAPACITY)) return false;
+	if ((2 != ts->valueBytes) && (4 != ts->valueBytes)) return false;
+	if ((ts->tierCount < 1) || (ts->tierCount > TS_MAX_TIERS)) return false;
+	if (byteCount < ts_bytesNeeded(capacity, ts->valueBytes, ts->tierCount)) return false;
+	int offset = sizeof(TimeSeries);
+	for (int i = 0; i < ts->tierCount; i++) {
+		TSTier *t = &ts->tiers[i];
+		if (t->dataOffset != offset) return false;
+		if ((t->ratio < 1) || (t->ratio > TS_MAX_RATIO) || (t->pending < 0) || (t->pending >= t->ratio)) return false;
+		if ((t->head < 0) || (t->head >= capacity) || (t->count < 0) || (t->count > capacity)) return false;
+		if ((t->minHead < 0) || (t->minHead >= capacity) || (t->minCount < 0) || (t->minCount > t->count)) return false;
+		if ((t->maxHead < 0) || (t->maxHead >= capacity) || (t->maxCount < 0) || (t->maxCount > t->count)) return false;
+		offset += tierBytes(capacity, ts->valueBytes, i);
+	}
+	return true;
+}
+
+void ts_clear(TimeSeries *ts) {
+	// Remove all entries, keeping the capacity and tiers.
+
+	for (int i = 0; i < ts->tierCount; i++) {
+		TSTier *t = &ts->tiers[i];
+		t->head = t->count = t->last = 0;
+		setSum(t->windowSum, 0);
+		t->minHead = t->minCount = t->maxHead = t->maxCount = 0;
+		t->pending = t->pendingMin = t->pendingMax = 0;
+		setSum(t->pendingSum, 0);
+	}
+}
+
+// Adding values
+
+void ts_add(TimeSeries *ts, int value) {
+	if (2 == ts->valueBytes) {
+		if (value > 32767) value = 32767;
+		if (value < -32768) value = -32768;
+	}
+	addEntry(ts, 0, value, value, value);
+}
+
+// Statistics and export
+
+int ts_stat(TimeSeries *ts, int tier, int stat) {
+	// Return a statistic of the entries in the given tier. Return zero if the tier is empty.
+
+	if ((tier < 0) || (tier >= ts->tierCount)) return 0;
+	TSTier *t = &ts->tiers[tier];
+	if ((TS_COUNT == stat) || (0 == t->count)) return (TS_COUNT == stat) ? t->count : 0;
+	int capacity = ts->capacity;
+	switch (stat) {
+	case TS_MIN:
+		return getField(ts, tier, minDeque(ts, tier)[t->minHead] % capacity, TS_FIELD_MIN);
+	case TS_MAX:
+		return getField(ts, tier, maxDeque(ts, tier)[t->maxHead] % capacity, TS_FIELD_MAX);
+	case TS_MEAN:
+		return roundedDiv(getSum(t->windowSum), t->count);
+	case TS_LAST:
+		return t->last;
+	}
+	return 0;
+}
+
+int ts_export(TimeSeries *ts, int tier, int field, int width, int *out) {
+	// Copy the given field of the entries of the given tier into out, oldest first, and
+	// return the number of points. If there are more than width entries, combine runs of
+	// adjacent entries so that there are width points. out must have room for width points.
+
+	if ((tier < 0) || (tier >= ts->tierCount) || (width < 1)) return 0;
+	TSTier *t = &ts->tiers[tier];
+	int capacity = ts->capacity;
+	int count = t->count;
+	if (count <= width) {
+		for (int i = 0; i < count; i++) out[i] = getField(ts, tier, (t->head + i) % capacity, field);
+		return count;
+	}
+	for (int p = 0; p < width; p++) {
+		int start = (int) (((long long) p * count) / width);
+		int end = (int) (((long long) (p + 1) * count) / width);
+		long long sum = 0;
+		int result = getField(ts, tier, (t->head + start) % capacity, field);
+		for (int i = start; i < end; i++) {
+			int v = getField(ts, tier, (t->head + i) % capacity, field);
+			sum += v;
+			if ((TS_FIELD_MIN == field) && (v < result)) result = v;
+			if ((TS_FIELD_MAX == field) && (v > result)) result = v;
+		}
+		out[p] = (TS_FIELD_MEAN == field) ? roundedDiv(sum, end - start) : result;
+	}
+	return width;
+}
@@ -0,0 +1,66 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Copyright 2026 agent
+
+// timeSeries.h - Fixed-capacity time series with incremental downsampling
+// agent, October 2026
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TS_MAX_TIERS 4
+#define TS_MAX_CAPACITY 16384
+#define TS_MAX_RATIO 1000
+
+// statistics
+#define TS_MIN 0
+#define TS_MAX 1
+#define TS_MEAN 2
+#define TS_COUNT 3
+#define TS_LAST 4
+
+// export fields
+#define TS_FIELD_MEAN 0
+#define TS_FIELD_MIN 1
+#define TS_FIELD_MAX 2
+
+// A series is a single block of memory (such as the body of a ByteArray) with this header
+// followed by the data of each tier. It contains no pointers, so it can be moved.
+// 64-bit sums are stored as two words, since the block may be only word-aligned.
+
+typedef struct {
+	int ratio;					// entries of the previous tier per entry (tier 0: 1)
+	int dataOffset;				// byte offset of this tier's data from the start of the series
+	int head;					// index of the oldest entry
+	int count;					// entries in the ring
+	int last;					// mean of the newest entry
+	uint32 windowSum[2];		// sum of the means of the entries in the ring
+	int minHead, minCount;		// deque of entry indices with increasing minimums
+	int maxHead, maxCount;		// deque of entry indices with decreasing maximums
+	int pending;				// inputs accumulated toward the next entry
+	int pendingMin, pendingMax;
+	uint32 pendingSum[2];
+} TSTier;
+
+typedef struct {
+	uint32 magic;
+	int capacity;				// entries per tier
+	int valueBytes;				// 2 or 4
+	int tierCount;
+	TSTier tiers[TS_MAX_TIERS];
+} TimeSeries;
+
+int ts_bytesNeeded(int capacity, int valueBytes, int tierCount);
+int ts_init(TimeSeries *ts, int byteCount, int capacity, int valueBytes, int tierCount, int *ratios);
+int ts_isValid(TimeSeries *ts, int byteCount);
+void ts_clear(TimeSeries *ts);
+void ts_add(TimeSeries *ts, int value);
+int ts_stat(TimeSeries *ts, int tier, int stat);
+int ts_export(TimeSeries *ts, int tier, int field, int width, int *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -38,6 +38,10 @@ TJR also supports enumeration of object properties and array elements, so one ca
 complete traversal of the entire JSON structure if needed. However, using paths to access
 parts of the structure is often sufficient.
 
+A path that is used repeatedly can be compiled once with tjr_compilePath() and then used
+with tjr_atCompiledPath(). A compiled path stores array indices as binary numbers and
+property names with their lengths, so the path string is not parsed on every lookup.
+
 Limitations:
 	* assumes input is legal JSON
 	* each property name component of a path must be under 100 characters long
@@ -324,3 +328,91 @@ char * tjr_nextProperty(char *p, char *propertyName, int propertyNameSize) {
 	if (':' == *p) p = tjr_skipWhitespace(p + 1); // skip colon
 	return p;
 }
+
+char * tjr_cursorNext(char *p, char **entry, char **value) {
+	// Support for iterating over an array or object in a single pass. The first time, p should
+	// point just after the opening '[' or '{'; after that, it should be the value returned by
+	// the previous call. Set entry to the next array element or object property name and value
+	// to the element or property value. Return a pointer to use for the following call or NULL
+	// when there are no more entries.
+
+	if (!p) return NULL;
+	p = tjr_skipWhitespace(p);
+	if (',' == *p) p = tjr_skipWhitespace(p + 1); // skip comma
+	if (!*p || (']' == *p) || ('}' == *p)) return NULL;
+	*entry = *value = p;
+	if ('"' == *p) { // string element or property name
+		p = tjr_skip(p);
+		if (':' != *p) return p; // string array element
+		p = tjr_skip(p); // skip colon
+		*value = p;
+	}
+	return tjr_skip(p); // skip value
+}
+
+// compiled paths
+
+int tjr_compilePath(char *pathString, unsigned char *dst, int dstSize) {
+	// Compile the given dot-delimited path into dst and return the number of bytes used
+	// or -1 if dst is too small. If dst is NULL, just return the size of the compiled path.
+	// Each path component is compiled as either:
+	//	a property name: <name length (1-255)><name bytes>
+	//	an array index: <0><index (two bytes, most significant first)>
+
+	int count = 0;
+	char *propName = pathString;
+	while (*propName) {
+		char *nextDot = strchr(propName, '.');
+		int propNameLen = nextDot ? (nextDot - propName) : strlen(propName);
+		if (isDigit(*propName)) {
+			int index = tjr_readInteger(propName);
+			if (index > 0xFFFF) index = 0xFFFF;
+			if (dst) {
+				if ((count + 3) > dstSize) return -1;
+				dst[count] = 0;
+				dst[count + 1] = (index >> 8) & 0xFF;
+				dst[count + 2] = index & 0xFF;
+			}
+			count += 3;
+		} else if (propNameLen > 0) {
+			if (propNameLen > 255) return -1;
+			if (dst) {
+				if ((count + 1 + propNameLen) > dstSize) return -1;
+				dst[count] = propNameLen;
+				memcpy(&dst[count + 1], propName, propNameLen);
+			}
+			count += 1 + propNameLen;
+		}
+		if (!nextDot) break;
+		propName += propNameLen + 1; // advance to start of next path component
+	}
+	return count;
+}
+
+char * tjr_atCompiledPath(char *p, unsigned char *path, int pathSize) {
+	// Return a pointer to the value at the given compiled path or NULL if not found.
+
+	char s[100];
+	unsigned char *end = path + pathSize;
+	while (p && (path < end)) {
+		int len = *path++;
+		if (0 == len) { // array index
+			if ((path + 2) > end) return NULL;
+			p = tjr_atIndex(tjr_skipWhitespace(p), (path[0] << 8) | path[1]);
+			path += 2;
+		} else { // property name
+			if ((path + len) > end) return NULL;
+			p = tjr_skipWhitespace(p);
+			if ('{' != *p) return NULL;
+			p++; // skip '{'
+			while (1) {
+				p = tjr_nextProperty(p, s, sizeof(s));
+				if (!p) return NULL; // no more properties
+				if ((strlen(s) == len) && (0 == memcmp(s, path, len))) break;
+				p = tjr_skip(p); // skip value
+			}
+			path += len;
+		}
+	}
+	return p;
+}
@@ -43,6 +43,12 @@ char * tjr_atIndex(char *p, int index);
 
 char * tjr_nextElement(char *p);
 char * tjr_nextProperty(char *p, char *propertyName, int propertyNameSize);
+char * tjr_cursorNext(char *p, char **entry, char **value);
+
+// Compiled paths
+
+int tjr_compilePath(char *pathString, unsigned char *dst, int dstSize);
+char * tjr_atCompiledPath(char *p, unsigned char *path, int pathSize);
 
 #ifdef __cplusplus
 }